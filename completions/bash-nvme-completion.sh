@@ -132,24 +132,28 @@ nvme_list_opts () {
 		opts+=" --log-id= -i --log-len= -l --namespace-id= -n \
 			--aen= -a --lpo= -O --lsp= -s --lsi= -S \
 			--rae -r --uuid-index= -U --csi= -y --ot -O \
-			--raw-binary -b"
+			--raw-binary -b --xfer-len= -x --output-file= -f \
+			--queue-depth= -q"
 			;;
 		"supported-log-pages")
 		opts+=" --output-format= -o --human-readable -H"
 			;;
 		"telemetry-log")
 		opts+=" --output-file= -O --host-generate= -g \
-			--controller-init -c --data-area= -d"
+			--controller-init -c --data-area= -d \
+			--previous= -p --compress="
 			;;
 		"fw-log")
-		opts+=" --raw-binary -b --output-format= -o"
+		opts+=" --raw-binary -b --output-format= -o --all-devices \
+			--device-regex= --subsys-nqn= --jobs="
 			;;
 		"changed-ns-list-log")
 		opts+=" --output-format= -o --raw-binary -b"
 			;;
 		"smart-log")
 		opts+=" --namespace-id= -n --raw-binary -b \
-			--output-format= -o --verbose -v"
+			--output-format= -o --verbose -v --all-devices \
+			--device-regex= --subsys-nqn= --jobs="
 			;;
 		"ana-log")
 		opts+=" --output-format -o"
@@ -161,14 +165,16 @@ nvme_list_opts () {
 		opts+=" --raw-binary -b --log-entries= -e \
 			--output-format= -o --valid-entry -V --sqid= -S \
 			--status= -s --lba= -l --namespace-id= -n --trtype= -t \
-			--csi= -c --opcode= -O"
+			--csi= -c --opcode= -O --state-file= --all-devices \
+			--device-regex= --subsys-nqn= --jobs="
 			;;
 		"effects-log")
 		opts+=" --output-format= -o --human-readable -H \
 			--raw-binary -b --timeout="
 			;;
 		"endurance-log")
-		opts+=" --output-format= -o --group-id -g"
+		opts+=" --output-format= -o --group-id -g --all-devices \
+			--device-regex= --subsys-nqn= --jobs="
 			;;
 		"predictable-lat-log")
 		opts+=" --nvmset-id= -i --raw-binary -b \
@@ -180,7 +186,8 @@ nvme_list_opts () {
 			;;
 		"persistent-event-log")
 		opts+=" --action= -a --log-len= -l \
-			--raw-binary -b --output-format= -o"
+			--raw-binary -b --chunk-size= -c --state-file= \
+			--output-format= -o"
 			;;
 		"endurance-event-agg-log")
 		opts+=" --log-entries= -e --rae -r \
@@ -232,7 +239,8 @@ nvme_list_opts () {
 			--ses= -s --pil= -p -pi= -i --ms= -m --reset -r"
 			;;
 		"fw-commit")
-		opts+=" --slot= -s --action= -a --bpid= -b --timeout="
+		opts+=" --slot= -s --action= -a --bpid= -b --model= -M \
+			--jobs= -j --timeout="
 		case $opt in
 			--action|-a)
 			vals+=" replace replace-and-activate set-active \
@@ -242,7 +250,8 @@ nvme_list_opts () {
 		esac
 			;;
 		"fw-download")
-		opts+=" --fw= -f --xfer= -x --offset= -O --timeout="
+		opts+=" --fw= -f --xfer= -x --offset= -O --queue-depth= -q \
+			--model= -M --jobs= -j --timeout="
 			;;
 		"capacity-mgmt")
 		opts+=" --operation= -O --element-id= -i --cap-lower= -l \
@@ -302,6 +311,7 @@ nvme_list_opts () {
 		"dsm")
 		opts+=" --namespace-id= -n --ctx-attrs= -a --blocks= -b \
 			--slbs= -s --ad -d --idw -w --idr -r --cdw11= -c \
+			--range-file= -f --range-format= -F --queue-depth= -q \
 			--timeout="
 			;;
 		"copy")
@@ -311,7 +321,8 @@ nvme_list_opts () {
 			--ref-tag= -r --expected-ref-tag= -R \
 			--app-tag= -a --expected-app-tag= -A \
 			--app-tag-mask= -m --expected-app-tag-mask= -M \
-			--dir-type= -T --dir-spec= -S --format= -F --timeout="
+			--dir-type= -T --dir-spec= -S --format= -F \
+			--range-file= -i --queue-depth= -q --timeout="
 			;;
 		"flush")
 		opts+=" --namespace-id= -n"
@@ -323,7 +334,10 @@ nvme_list_opts () {
 			--app-tag= -a --limited-retry -l \
 			--force-unit-access -f --storage-tag-check -C \
 			--dir-type= -T --dir-spec= -S --dsm= -D --show-command -V \
-			--dry-run -w --latency -t --timeout="
+			--dry-run -w --latency -t --timeout= \
+			--queue-depth= -q --xfer-size= -x \
+			--pattern= -P --pattern-seed= -e --pattern-data= -u \
+			--host-pi -H"
 			;;
 		"read")
 		opts+=" --start-block= -s --block-count= -c --block-size= -b --data-size= -z \
@@ -332,7 +346,10 @@ nvme_list_opts () {
 			--app-tag= -a --limited-retry -l \
 			--force-unit-access -f --storage-tag-check -C \
 			--dir-type= -T --dir-spec= -S --dsm= -D --show-command -V \
-			--dry-run -w --latency -t --timeout="
+			--dry-run -w --latency -t --timeout= \
+			--queue-depth= -q --xfer-size= -x \
+			--pattern= -P --pattern-seed= -e --pattern-data= -u \
+			--host-pi -H"
 			;;
 		"write")
 		opts+=" --start-block= -s --block-count= -c --block-size= -b --data-size= -z \
@@ -341,7 +358,10 @@ nvme_list_opts () {
 			--app-tag= -a --limited-retry -l \
 			--force-unit-access -f --storage-tag-check -C \
 			--dir-type= -T --dir-spec= -S --dsm= -D --show-command -V \
-			--dry-run -w --latency -t --timeout="
+			--dry-run -w --latency -t --timeout= \
+			--queue-depth= -q --xfer-size= -x \
+			--pattern= -P --pattern-seed= -e --pattern-data= -u \
+			--host-pi -H"
 			;;
 		"write-zeroes")
 		opts+=" --namespace-id= -n --start-block= -s \
@@ -350,19 +370,23 @@ nvme_list_opts () {
 			--app-tag-mask= -m --app-tag= -a \
 			--storage-tag= -S --storage-tag-check -C \
 			--dir-type= -T --dir-spec= -S --namespace-zeroes -Z \
-			--timeout="
+			--range= -R --to-end -e --queue-depth= -q \
+			--checkpoint= -k --timeout="
 			;;
 		"write-uncor")
 		opts+=" --namespace-id= -n --start-block= -s \
 			--block-count= -c --dir-type= -T --dir-spec= -S \
-			--timeout="
+			--range= -R --to-end -e --queue-depth= -q \
+			--checkpoint= -k --timeout="
 			;;
 		"verify")
 		opts+=" --namespace-id= -n --start-block= -s \
 			--block-count= -c --limited-retry -l \
 			--force-unit-access -f --prinfo= -p --ref-tag= -r \
 			--app-tag= -a --app-tag-mask= -m \
-			--storage-tag= -S --storage-tag-check -C --timeout="
+			--storage-tag= -S --storage-tag-check -C \
+			--range= -R --to-end -e --queue-depth= -q \
+			--checkpoint= -k --timeout="
 			;;
 		"sanitize")
 		opts+=" --no-dealloc -d --oipbp -i --owpass= -n \
@@ -465,6 +489,20 @@ nvme_list_opts () {
 		"show-topology")
 		opts+=" --output-format= -o --verbose -v --ranking= -r"
 			;;
+		"export")
+		opts+=" --output-file= -O --socket= -S --stat-interval= -i \
+			--smart-interval= -s --count= -c"
+			;;
+		"bench")
+		opts+=" --namespace-id= -n --pattern= -p --read-pct= -r \
+			--block-size= -b --queue-depth= -q --runtime= -t \
+			--ramp= -R --start-block= -s --size= -z --force"
+			;;
+		"snapshot")
+		opts+=" --output-dir= -d --all-devices --device-regex= \
+			--subsys-nqn= --jobs= --queue-depth= -q \
+			--vendor-log-size= --no-telemetry"
+			;;
 		"nvme-mi-recv")
 		opts+=" --opcode= -O --namespace-id= -n --data-len= -l \
 			--nmimt= -m --nmd0= -0 --nmd1= -1 --input-file= -i"
@@ -1198,7 +1236,7 @@ plugin_solidigm_opts () {
 			;;
 		"vs-internal-log")
 		opts+=" --type= -t --namespace-id= -n \
-		--file-prefix= -p --verbose -v"
+		--file-prefix= -p --verbose -v --compress="
 			;;
 		"latency-tracking-log")
 		opts+=" --enable -e --disable -d \
@@ -1591,7 +1629,8 @@ plugin_ocp_opts () {
 
 	case "$1" in
 		"smart-add-log")
-		opts+=" --output-format= -o"
+		opts+=" --output-format= -o --all-devices --device-regex= \
+			--subsys-nqn= --jobs="
 			;;
 		"latency-monitor-log")
 		opts+=" --output-format= -o"
@@ -1608,7 +1647,8 @@ plugin_ocp_opts () {
 		"internal-log")
 		opts+=" --telemetry-log= -l --string-log= -s \
 			--output-file= -f --output-format= -o \
-			--data-area= -a --telemetry-type= -t"
+			--data-area= -a --telemetry-type= -t \
+			--compress="
 			;;
 		"clear-fw-activate-history")
 		opts+=" --no-uuid -n"
@@ -1807,7 +1847,8 @@ _nvme_subcmds () {
 		show-hostnqn tls-key dir-receive dir-send virt-mgmt \
 		rpmb boot-part-log fid-support-effects-log \
 		supported-log-pages lockdown media-unit-stat-log \
-		supported-cap-config-log dim show-topology list-endgrp \
+		supported-cap-config-log dim show-topology export bench snapshot \
+		list-endgrp \
 		nvme-mi-recv nvme-mi-send get-reg set-reg mgmt-addr-list-log \
 		rotational-media-info-log changed-alloc-ns-list-log \
 		io-mgmt-recv io-mgmt-send dispersed-ns-participating-nss-log \
@@ -230,7 +230,7 @@ static void hook_connected(struct libnvmf_context *fctx,
 	}
 
 #ifdef CONFIG_JSONC
-	if (hfd->flags == JSON) {
+	if (hfd->flags & JSON) {
 		struct json_object *root;
 
 		root = json_create_object();
@@ -238,7 +238,10 @@ static void hook_connected(struct libnvmf_context *fctx,
 		json_object_add_value_string(root, "device",
 			libnvme_ctrl_get_name(c));
 
-		json_print_object(root, NULL);
+		if (hfd->flags & NDJSON)
+			json_print_object_plain(root);
+		else
+			json_print_object(root, NULL);
 		printf("\n");
 		json_free_object(root);
 	}
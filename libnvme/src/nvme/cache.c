@@ -0,0 +1,350 @@
+// SPDX-License-Identifier: LGPL-2.1-or-later
+/*
+ * This file is part of libnvme.
+ *
+ * Cache of identify data and log pages which do not change while the
+ * controller runs the same firmware.
+ */
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
+
+#include <ccan/array_size/array_size.h>
+
+#include <libnvme.h>
+
+#include "cleanup.h"
+#include "private.h"
+#include "compiler-attributes.h"
+
+/*
+ * Only data which changes with the firmware alone is kept. The Command
+ * Effects and FID Supported and Effects logs are fixed by the firmware
+ * as well, whatever features are set. Identify Controller is the
+ * exception: the unallocated NVM capacity changes with namespace
+ * management, which drops the cache, and a few fields such as VWCI
+ * change without any command of this host.
+ */
+static const struct {
+	__u8 opcode;
+	__u8 id;	/* CNS or LID */
+} cache_static[] = {
+	{ nvme_admin_identify, NVME_IDENTIFY_CNS_CTRL },
+	{ nvme_admin_identify, NVME_IDENTIFY_CNS_UUID_LIST },
+	{ nvme_admin_get_log_page, NVME_LOG_LID_SUPPORTED_LOG_PAGES },
+	{ nvme_admin_get_log_page, NVME_LOG_LID_CMD_EFFECTS },
+	{ nvme_admin_get_log_page, NVME_LOG_LID_FID_SUPPORTED_EFFECTS },
+};
+
+static bool cache_is_static(struct libnvme_passthru_cmd *cmd)
+{
+	int i;
+
+	if (!cmd->addr || !cmd->data_len || cmd->metadata_len)
+		return false;
+
+	for (i = 0; i < ARRAY_SIZE(cache_static); i++)
+		if (cmd->opcode == cache_static[i].opcode &&
+		    (cmd->cdw10 & 0xff) == cache_static[i].id)
+			return true;
+
+	return false;
+}
+
+/* the key of a controller is made of sysfs attributes, not to be parsed */
+static void cache_sanitize(char *s)
+{
+	for (; *s; s++)
+		if (*s == '/' || *s == '-' || *s <= ' ' || *s > '~')
+			*s = '_';
+}
+
+/*
+ * A controller is known by its serial number, controller ID and firmware
+ * revision. The kernel updates the firmware revision when a new image is
+ * activated, so an activation starts a new cache. Multipath namespace
+ * heads, which may be served by any controller of the subsystem, and
+ * handles without sysfs attributes are not cached.
+ */
+static char *cache_key_new(struct libnvme_transport_handle *hdl)
+{
+	__cleanup_free char *dir = NULL;
+	__cleanup_free char *sn = NULL;
+	__cleanup_free char *cntlid = NULL;
+	__cleanup_free char *fr = NULL;
+	const char *name;
+	char *key;
+	int ret;
+
+	if (hdl->type != LIBNVME_TRANSPORT_HANDLE_TYPE_DIRECT)
+		return NULL;
+
+	name = libnvme_basename(hdl->name);
+	if (S_ISBLK(hdl->stat.st_mode))
+		ret = asprintf(&dir, "%s/%s/device", libnvme_ns_sysfs_dir(), name);
+	else if (!strncmp(name, "ng", 2))
+		return NULL;
+	else
+		ret = asprintf(&dir, "%s/%s", libnvme_ctrl_sysfs_dir(), name);
+	if (ret < 0)
+		return NULL;
+
+	sn = libnvme_get_attr(dir, "serial");
+	cntlid = libnvme_get_attr(dir, "cntlid");
+	fr = libnvme_get_attr(dir, "firmware_rev");
+	if (!sn || !cntlid || !fr)
+		return NULL;
+
+	cache_sanitize(sn);
+	cache_sanitize(cntlid);
+	cache_sanitize(fr);
+
+	if (asprintf(&key, "%s-%s-%s", sn, cntlid, fr) < 0)
+		return NULL;
+
+	return key;
+}
+
+/*
+ * The key is set up with the cache directory, before any command can be
+ * submitted. Commands may be submitted from several threads at once, which
+ * only ever read it.
+ */
+static const char *cache_key(struct libnvme_transport_handle *hdl)
+{
+	return hdl->cache_key;
+}
+
+static char *cache_path(struct libnvme_transport_handle *hdl,
+		struct libnvme_passthru_cmd *cmd)
+{
+	__u32 cdw10 = cmd->cdw10;
+	const char *key;
+	char *path;
+
+	key = cache_key(hdl);
+	if (!key)
+		return NULL;
+
+	/* retaining an asynchronous event does not change the data */
+	if (cmd->opcode == nvme_admin_get_log_page)
+		cdw10 &= ~(1 << NVME_LOG_CDW10_RAE_SHIFT);
+
+	if (asprintf(&path, "%s/%s/%02x-%08x-%08x-%08x-%08x-%08x-%08x-%x",
+		     hdl->cache_dir, key, cmd->opcode, cmd->nsid, cdw10,
+		     cmd->cdw11, cmd->cdw12, cmd->cdw13, cmd->cdw14,
+		     cmd->data_len) < 0)
+		return NULL;
+
+	return path;
+}
+
+int __libnvme_cache_get(struct libnvme_transport_handle *hdl,
+		struct libnvme_passthru_cmd *cmd)
+{
+	__cleanup_free char *path = NULL;
+	struct stat st;
+	ssize_t len;
+	int fd;
+
+	if (hdl->ctx->dry_run || !cache_is_static(cmd))
+		return -ENOENT;
+
+	path = cache_path(hdl, cmd);
+	if (!path)
+		return -ENOENT;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return -errno;
+
+	if (fstat(fd, &st) || st.st_size != cmd->data_len) {
+		close(fd);
+		return -ENOENT;
+	}
+
+	len = read(fd, (void *)(uintptr_t)cmd->addr, cmd->data_len);
+	close(fd);
+	if (len != (ssize_t)cmd->data_len)
+		return -ENOENT;
+
+	libnvme_msg(hdl->ctx, LIBNVME_LOG_DEBUG, "%s: cached %s\n",
+		    hdl->name, path);
+	cmd->result = 0;
+
+	return 0;
+}
+
+static void cache_store(struct libnvme_transport_handle *hdl,
+		struct libnvme_passthru_cmd *cmd)
+{
+	__cleanup_free char *path = NULL;
+	__cleanup_free char *tmp = NULL;
+	char *p;
+	int fd;
+
+	path = cache_path(hdl, cmd);
+	if (!path || asprintf(&tmp, "%s.XXXXXX", path) < 0)
+		return;
+
+	mkdir(hdl->cache_dir, 0755);
+	p = strrchr(tmp, '/');
+	*p = '\0';
+	mkdir(tmp, 0755);
+	*p = '/';
+
+	/* readers see the whole page or none */
+	fd = mkstemp(tmp);
+	if (fd < 0)
+		return;
+
+	if (write(fd, (void *)(uintptr_t)cmd->addr, cmd->data_len) !=
+	    (ssize_t)cmd->data_len || rename(tmp, path))
+		unlink(tmp);
+	close(fd);
+}
+
+static int cache_remove_dir(const char *path)
+{
+	__cleanup_free char *file = NULL;
+	struct dirent *entry;
+	DIR *d;
+
+	d = opendir(path);
+	if (!d)
+		return errno == ENOENT ? 0 : -errno;
+
+	while ((entry = readdir(d))) {
+		if (entry->d_name[0] == '.' &&
+		    (!entry->d_name[1] ||
+		     (entry->d_name[1] == '.' && !entry->d_name[2])))
+			continue;
+		free(file);
+		if (asprintf(&file, "%s/%s", path, entry->d_name) < 0) {
+			file = NULL;
+			break;
+		}
+		unlink(file);
+	}
+	closedir(d);
+
+	if (rmdir(path) && errno != ENOENT)
+		return -errno;
+
+	return 0;
+}
+
+__libnvme_public int libnvme_transport_handle_drop_cache(
+		struct libnvme_transport_handle *hdl)
+{
+	__cleanup_free char *prefix = NULL;
+	__cleanup_free char *path = NULL;
+	struct dirent *entry;
+	const char *key;
+	int err = 0;
+	DIR *d;
+
+	if (!hdl->cache_dir)
+		return 0;
+
+	key = cache_key(hdl);
+	if (!key)
+		return 0;
+
+	/*
+	 * A new image may be activated on every controller of the
+	 * subsystem, which share the serial number.
+	 */
+	prefix = strdup(key);
+	if (!prefix)
+		return -ENOMEM;
+	*strchr(prefix, '-') = '\0';
+
+	d = opendir(hdl->cache_dir);
+	if (!d)
+		return errno == ENOENT ? 0 : -errno;
+
+	while ((entry = readdir(d))) {
+		size_t len = strlen(prefix);
+
+		if (strncmp(entry->d_name, prefix, len) ||
+		    entry->d_name[len] != '-')
+			continue;
+		free(path);
+		if (asprintf(&path, "%s/%s", hdl->cache_dir,
+			     entry->d_name) < 0) {
+			path = NULL;
+			err = -ENOMEM;
+			break;
+		}
+		err = cache_remove_dir(path);
+		if (err)
+			break;
+	}
+	closedir(d);
+
+	return err;
+}
+
+void __libnvme_cache_put(struct libnvme_transport_handle *hdl,
+		struct libnvme_passthru_cmd *cmd, int err)
+{
+	if (hdl->ctx->dry_run)
+		return;
+
+	/* a committed image may be activated without a reset */
+	if (cmd->opcode == nvme_admin_fw_commit && err >= 0) {
+		libnvme_transport_handle_drop_cache(hdl);
+		return;
+	}
+
+	/* creating or deleting a namespace changes the capacity left */
+	if (cmd->opcode == nvme_admin_ns_mgmt && !err) {
+		libnvme_transport_handle_drop_cache(hdl);
+		return;
+	}
+
+	if (!err && cache_is_static(cmd))
+		cache_store(hdl, cmd);
+}
+
+__libnvme_public int libnvme_transport_handle_set_cache_dir(
+		struct libnvme_transport_handle *hdl, const char *dir)
+{
+	char *cache_dir = NULL;
+	char *key = NULL;
+
+	if (dir) {
+		cache_dir = strdup(dir);
+		if (!cache_dir)
+			return -ENOMEM;
+		key = cache_key_new(hdl);
+	}
+
+	free(hdl->cache_dir);
+	free(hdl->cache_key);
+	hdl->cache_dir = cache_dir;
+	hdl->cache_key = key;
+
+	return 0;
+}
+
+void __libnvme_cache_init(struct libnvme_transport_handle *hdl)
+{
+	char *dir = getenv("LIBNVME_CACHE_DIR");
+
+	if (dir && *dir)
+		libnvme_transport_handle_set_cache_dir(hdl, dir);
+}
+
+void __libnvme_cache_free(struct libnvme_transport_handle *hdl)
+{
+	free(hdl->cache_dir);
+	free(hdl->cache_key);
+}
@@ -1346,12 +1346,219 @@ static int nvmf_connect_disc_entry(libnvme_host_t h,
  */
 #define DISCOVERY_HEADER_LEN 20
 
+/*
+ * The last discovery log of every discovery controller is kept, in the
+ * global context and, if the transport handle has a cache directory, on
+ * disk for the next process. The log only has to be read again when the
+ * Generation Counter in its header moved.
+ */
+static char *discovery_log_key(libnvme_ctrl_t c,
+			       const struct libnvmf_discovery_args *args)
+{
+	libnvme_subsystem_t s = c->s;
+	const char *hostnqn = NULL;
+	char *key;
+
+	/* without an address the controller can't be told apart */
+	if (!c->transport || !c->traddr)
+		return NULL;
+
+	if (s && s->h)
+		hostnqn = libnvme_host_get_hostnqn(s->h);
+
+	if (asprintf(&key, "%s %s %s %s %s %s %s %u", c->transport, c->traddr,
+		     c->trsvcid ?: "none", c->host_traddr ?: "none",
+		     c->host_iface ?: "none", c->subsysnqn ?: "none",
+		     hostnqn ?: "none", args->lsp) < 0)
+		return NULL;
+
+	return key;
+}
+
+/* FNV-1a, the key itself is stored in the file */
+static char *discovery_log_path(struct libnvme_transport_handle *hdl,
+				const char *key)
+{
+	__u64 hash = 0xcbf29ce484222325ULL;
+	char *path;
+
+	if (!hdl || !hdl->cache_dir)
+		return NULL;
+
+	for (; *key; key++)
+		hash = (hash ^ (unsigned char)*key) * 0x100000001b3ULL;
+
+	if (asprintf(&path, "%s/discovery-%016" PRIx64, hdl->cache_dir,
+		     (uint64_t)hash) < 0)
+		return NULL;
+
+	return path;
+}
+
+static struct libnvmf_discovery_log_entry *discovery_log_find(
+		struct libnvme_global_ctx *ctx, const char *key)
+{
+	struct libnvmf_discovery_log_entry *e;
+
+	list_for_each(&ctx->discovery_logs, e, entry)
+		if (!strcmp(e->key, key))
+			return e;
+
+	return NULL;
+}
+
+static void discovery_log_free_entry(struct libnvmf_discovery_log_entry *e)
+{
+	list_del(&e->entry);
+	free(e->key);
+	libnvme_free(e->log);
+	free(e);
+}
+
+void __libnvmf_free_discovery_logs(struct libnvme_global_ctx *ctx)
+{
+	struct libnvmf_discovery_log_entry *e, *_e;
+
+	list_for_each_safe(&ctx->discovery_logs, e, _e, entry)
+		discovery_log_free_entry(e);
+}
+
+static void discovery_log_remember(struct libnvme_global_ctx *ctx,
+				   const char *key,
+				   struct nvmf_discovery_log *log, size_t len)
+{
+	struct libnvmf_discovery_log_entry *e;
+
+	e = discovery_log_find(ctx, key);
+	if (e)
+		discovery_log_free_entry(e);
+
+	e = calloc(1, sizeof(*e));
+	if (!e)
+		return;
+	e->key = strdup(key);
+	e->log = libnvme_alloc(len);
+	if (!e->key || !e->log) {
+		free(e->key);
+		libnvme_free(e->log);
+		free(e);
+		return;
+	}
+	memcpy(e->log, log, len);
+	e->len = len;
+	list_add(&ctx->discovery_logs, &e->entry);
+}
+
+static struct nvmf_discovery_log *discovery_log_load(
+		struct libnvme_transport_handle *hdl, const char *key,
+		size_t len)
+{
+	__cleanup_free char *path = NULL;
+	__cleanup_free char *line = NULL;
+	struct nvmf_discovery_log *log;
+	size_t size = 0;
+	FILE *f;
+
+	path = discovery_log_path(hdl, key);
+	if (!path)
+		return NULL;
+
+	f = fopen(path, "r");
+	if (!f)
+		return NULL;
+
+	log = libnvme_alloc(len);
+	if (!log || getline(&line, &size, f) < 0)
+		goto err;
+
+	line[strcspn(line, "\n")] = '\0';
+	if (strcmp(line, key) || fread(log, 1, len, f) != len ||
+	    fgetc(f) != EOF)
+		goto err;
+	fclose(f);
+
+	return log;
+
+err:
+	libnvme_free(log);
+	fclose(f);
+	return NULL;
+}
+
+static void discovery_log_store(struct libnvme_transport_handle *hdl,
+				const char *key,
+				struct nvmf_discovery_log *log, size_t len)
+{
+	__cleanup_free char *path = NULL;
+	__cleanup_free char *tmp = NULL;
+	FILE *f;
+	int fd;
+
+	path = discovery_log_path(hdl, key);
+	if (!path || asprintf(&tmp, "%s.XXXXXX", path) < 0)
+		return;
+
+	mkdir(hdl->cache_dir, 0755);
+	fd = mkstemp(tmp);
+	if (fd < 0)
+		return;
+
+	f = fdopen(fd, "w");
+	if (!f) {
+		close(fd);
+		unlink(tmp);
+		return;
+	}
+
+	fprintf(f, "%s\n", key);
+	if (fwrite(log, 1, len, f) != len || fclose(f) || rename(tmp, path))
+		unlink(tmp);
+}
+
+/*
+ * Returns a copy of the last log read from the controller if it has the
+ * generation counter and number of records of @hdr.
+ */
+static struct nvmf_discovery_log *discovery_log_lookup(libnvme_ctrl_t c,
+		struct libnvme_transport_handle *hdl, const char *key,
+		struct nvmf_discovery_log *hdr)
+{
+	size_t len = sizeof(*hdr) +
+		sizeof(*hdr->entries) * le64_to_cpu(hdr->numrec);
+	struct libnvmf_discovery_log_entry *e;
+	struct nvmf_discovery_log *log;
+
+	e = discovery_log_find(c->ctx, key);
+	if (e) {
+		if (e->len != len || e->log->genctr != hdr->genctr ||
+		    e->log->numrec != hdr->numrec)
+			return NULL;
+		log = libnvme_alloc(len);
+		if (log)
+			memcpy(log, e->log, len);
+		return log;
+	}
+
+	log = discovery_log_load(hdl, key, len);
+	if (!log)
+		return NULL;
+	if (log->genctr != hdr->genctr || log->numrec != hdr->numrec) {
+		libnvme_free(log);
+		return NULL;
+	}
+
+	discovery_log_remember(c->ctx, key, log, len);
+
+	return log;
+}
+
 static int nvme_discovery_log(libnvme_ctrl_t ctrl,
 			      const struct libnvmf_discovery_args *args,
 			      struct nvmf_discovery_log **logp)
 {
 	struct libnvme_global_ctx *ctx = ctrl->ctx;
-	struct nvmf_discovery_log *log;
+	struct nvmf_discovery_log *log, *cached;
+	__cleanup_free char *key = NULL;
 	int retries = 0;
 	int err;
 	const char *name = libnvme_ctrl_get_name(ctrl);
@@ -1379,6 +1586,19 @@ static int nvme_discovery_log(libnvme_ctrl_t ctrl,
 		goto out_free_log;
 	}
 
+	key = ctx->dry_run ? NULL : discovery_log_key(ctrl, args);
+	if (key && le64_to_cpu(log->numrec)) {
+		cached = discovery_log_lookup(ctrl, hdl, key, log);
+		if (cached) {
+			libnvme_msg(ctx, LIBNVME_LOG_DEBUG,
+				 "%s: genctr %" PRIu64 " unchanged, using the last log\n",
+				 name, le64_to_cpu(log->genctr));
+			libnvme_free(log);
+			*logp = cached;
+			return 0;
+		}
+	}
+
 	do {
 		size_t entries_size;
 
@@ -1440,6 +1660,13 @@ static int nvme_discovery_log(libnvme_ctrl_t ctrl,
 			 name, numrec, le64_to_cpu(log->numrec));
 		err = -EBADSLT;
 	} else {
+		if (key && numrec) {
+			size_t len = sizeof(*log) +
+				sizeof(*log->entries) * numrec;
+
+			discovery_log_remember(ctx, key, log, len);
+			discovery_log_store(hdl, key, log, len);
+		}
 		*logp = log;
 		return 0;
 	}
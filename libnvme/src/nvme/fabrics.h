@@ -177,6 +177,11 @@ struct libnvmf_uri;
  * Issues the three-phase Get Log Page protocol against @ctrl, validates
  * generation-counter atomicity, and normalises each log entry.
  *
+ * The last log read from a discovery controller is kept in the global
+ * context and, if the transport handle of @ctrl has a cache directory,
+ * on disk. When the generation counter in the header is unchanged, that
+ * log is returned without reading the records again.
+ *
  * Return: 0 on success, or a negative error code on failure.
  */
 int libnvmf_get_discovery_log(libnvme_ctrl_t ctrl,
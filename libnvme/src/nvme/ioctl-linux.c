@@ -52,6 +52,7 @@ __libnvme_public int libnvme_reset_subsystem(
 	ret = ioctl(hdl->fd, LIBNVME_IOCTL_SUBSYS_RESET);
 	if (ret < 0)
 		return -errno;
+	libnvme_transport_handle_drop_cache(hdl);
 	return ret;
 }
 
@@ -66,6 +67,7 @@ __libnvme_public int libnvme_reset_ctrl(struct libnvme_transport_handle *hdl)
 	ret = ioctl(hdl->fd, LIBNVME_IOCTL_RESET);
 	if (ret < 0)
 		return -errno;
+	libnvme_transport_handle_drop_cache(hdl);
 	return ret;
 }
 
@@ -235,13 +237,9 @@ do_ioctl32:
 	return libnvme_submit_passthru32(hdl, LIBNVME_IOCTL_ADMIN_CMD, cmd);
 }
 
-__libnvme_public int libnvme_submit_admin_passthru(
-		struct libnvme_transport_handle *hdl,
+static int __submit_admin_passthru(struct libnvme_transport_handle *hdl,
 		struct libnvme_passthru_cmd *cmd)
 {
-	if (!hdl)
-		return -ENODEV;
-
 	if (hdl->uring_enabled)
 		return libnvme_submit_admin_passthru_async(hdl, cmd);
 
@@ -259,3 +257,25 @@ __libnvme_public int libnvme_submit_admin_passthru(
 
 	return -ENOTSUP;
 }
+
+__libnvme_public int libnvme_submit_admin_passthru(
+		struct libnvme_transport_handle *hdl,
+		struct libnvme_passthru_cmd *cmd)
+{
+	int err;
+
+	if (!hdl)
+		return -ENODEV;
+
+	/* queued commands complete later, their data is not cached */
+	if (!hdl->cache_dir || hdl->uring_enabled)
+		return __submit_admin_passthru(hdl, cmd);
+
+	if (!__libnvme_cache_get(hdl, cmd))
+		return 0;
+
+	err = __submit_admin_passthru(hdl, cmd);
+	__libnvme_cache_put(hdl, cmd, err);
+
+	return err;
+}
@@ -65,6 +65,9 @@ __libnvme_public struct libnvme_global_ctx *libnvme_create_global_ctx(
 
 	list_head_init(&ctx->hosts);
 	list_head_init(&ctx->endpoints);
+#ifdef CONFIG_FABRICS
+	list_head_init(&ctx->discovery_logs);
+#endif
 
 	ctx->ioctl_probing = true;
 	ctx->mi_probe_enabled = libnvme_mi_probe_enabled_default();
@@ -86,6 +89,7 @@ __libnvme_public void libnvme_free_global_ctx(struct libnvme_global_ctx *ctx)
 	freeifaddrs(ctx->ifaddrs_cache); /* NULL-safe */
 	ctx->ifaddrs_cache = NULL;
 	free(ctx->options);
+	__libnvmf_free_discovery_logs(ctx);
 #endif
 
 	libnvme_for_each_host_safe(ctx, h, _h)
@@ -242,6 +246,7 @@ __libnvme_public int libnvme_open(
 		if (!strcmp(name, "NVME_TEST_FD64"))
 			hdl->ioctl_admin_state = IOCTL_STATE_IOCTL64;
 
+		__libnvme_cache_init(hdl);
 		*hdlp = hdl;
 		return 0;
 	}
@@ -256,6 +261,7 @@ __libnvme_public int libnvme_open(
 		return ret;
 	}
 
+	__libnvme_cache_init(hdl);
 	*hdlp = hdl;
 
 	return 0;
@@ -267,6 +273,7 @@ __libnvme_public void libnvme_close(struct libnvme_transport_handle *hdl)
 		return;
 
 	free(hdl->name);
+	__libnvme_cache_free(hdl);
 
 	switch (hdl->type) {
 	case LIBNVME_TRANSPORT_HANDLE_TYPE_DIRECT:
@@ -230,6 +230,48 @@ void libnvme_transport_handle_set_decide_retry(
 void libnvme_transport_handle_set_timeout(struct libnvme_transport_handle *hdl,
 		__u32 timeout_ms);
 
+/**
+ * libnvme_transport_handle_set_cache_dir() - Cache static controller data
+ * @hdl:	Transport handle to configure
+ * @dir:	Directory to keep the cache in, NULL disables the cache
+ *
+ * Keeps the data of admin commands which only changes with the firmware
+ * in @dir and returns it from there instead of submitting the command
+ * again: Identify Controller, the Identify UUID List and the Supported
+ * Log Pages, Commands Supported and Effects and FID Supported and Effects
+ * log pages. The data is stored per controller, keyed by the serial
+ * number, controller ID and firmware revision the kernel reports in
+ * sysfs; handles without those attributes are not cached. A successful
+ * Firmware Commit or Namespace Management command or a reset through
+ * @hdl drops the cached data of the subsystem.
+ *
+ * Identify Controller fields which change at runtime are returned as
+ * they were cached: the unallocated NVM capacity after namespaces were
+ * created or deleted through another handle or by another host, and
+ * VWCI. Use libnvme_transport_handle_drop_cache() before reading them.
+ *
+ * Handles opened with libnvme_open() use the directory named by the
+ * LIBNVME_CACHE_DIR environment variable, if set. Commands may be
+ * submitted through @hdl from several threads, but not while the cache
+ * directory is changed.
+ *
+ * Return: 0 on success, -ENOMEM if @dir could not be copied.
+ */
+int libnvme_transport_handle_set_cache_dir(struct libnvme_transport_handle *hdl,
+		const char *dir);
+
+/**
+ * libnvme_transport_handle_drop_cache() - Drop cached static controller data
+ * @hdl:	Transport handle
+ *
+ * Removes the data cached for the subsystem of @hdl, see
+ * libnvme_transport_handle_set_cache_dir(). Does nothing if no cache is
+ * set up.
+ *
+ * Return: 0 on success, a negative errno otherwise.
+ */
+int libnvme_transport_handle_drop_cache(struct libnvme_transport_handle *hdl);
+
 /**
  * libnvme_set_probe_enabled() - enable/disable the probe for new MI endpoints
  * @ctx:	&struct libnvme_global_ctx object
@@ -340,6 +340,34 @@ __libnvme_public int libnvme_get_telemetry_max(
 	return err;
 }
 
+/* last block of data area @da, the areas include the ones below them */
+static int nvme_telemetry_dalb(struct nvme_telemetry_log *telem,
+		enum nvme_telemetry_da da, size_t *dalb)
+{
+	switch (da) {
+	case NVME_TELEMETRY_DA_1:
+		*dalb = le16_to_cpu(telem->dalb1);
+		break;
+	case NVME_TELEMETRY_DA_2:
+		*dalb = le16_to_cpu(telem->dalb2);
+		break;
+	case NVME_TELEMETRY_DA_3:
+		/* dalb3 >= dalb2 >= dalb1 */
+		*dalb = le16_to_cpu(telem->dalb3);
+		break;
+	case NVME_TELEMETRY_DA_4:
+		*dalb = le32_to_cpu(telem->dalb4);
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	if (*dalb == 0)
+		return -ENOENT;
+
+	return 0;
+}
+
 __libnvme_public int libnvme_get_telemetry_log(
 		struct libnvme_transport_handle *hdl, bool create, bool ctrl,
 		bool rae, size_t max_data_tx, enum nvme_telemetry_da da,
@@ -384,26 +412,9 @@ __libnvme_public int libnvme_get_telemetry_log(
 		return 0;
 	}
 
-	switch (da) {
-	case NVME_TELEMETRY_DA_1:
-		dalb = le16_to_cpu(telem->dalb1);
-		break;
-	case NVME_TELEMETRY_DA_2:
-		dalb = le16_to_cpu(telem->dalb2);
-		break;
-	case NVME_TELEMETRY_DA_3:
-		/* dalb3 >= dalb2 >= dalb1 */
-		dalb = le16_to_cpu(telem->dalb3);
-		break;
-	case NVME_TELEMETRY_DA_4:
-		dalb = le32_to_cpu(telem->dalb4);
-		break;
-	default:
-		return -EINVAL;
-	}
-
-	if (dalb == 0)
-		return -ENOENT;
+	err = nvme_telemetry_dalb(telem, da, &dalb);
+	if (err)
+		return err;
 
 	*size = (dalb + 1) * xfer;
 	tmp = libnvme_realloc(log, *size);
@@ -424,6 +435,96 @@ __libnvme_public int libnvme_get_telemetry_log(
 	return 0;
 }
 
+/*
+ * The data of a log only changes along with its data generation number.
+ * An 8 bit number easily matches the one of another log, so the log
+ * identifier, the IEEE OUI and the reason identifier have to match as
+ * well, and the data area sizes are compared to be on the safe side.
+ */
+static bool nvme_telemetry_same_gen(struct nvme_telemetry_log *a,
+		struct nvme_telemetry_log *b, bool ctrl)
+{
+	if (a->lpi != b->lpi || memcmp(a->ieee, b->ieee, sizeof(a->ieee)) ||
+	    memcmp(a->rsnident, b->rsnident, sizeof(a->rsnident)))
+		return false;
+
+	if (ctrl ? a->ctrldgn != b->ctrldgn : a->hostdgn != b->hostdgn)
+		return false;
+
+	return a->dalb1 == b->dalb1 && a->dalb2 == b->dalb2 &&
+	       a->dalb3 == b->dalb3 && a->dalb4 == b->dalb4;
+}
+
+__libnvme_public int libnvme_update_telemetry_log(
+		struct libnvme_transport_handle *hdl, bool ctrl, bool rae,
+		size_t max_data_tx, enum nvme_telemetry_da da,
+		struct nvme_telemetry_log **log, size_t *size, size_t *offset)
+{
+	static const __u32 xfer = NVME_LOG_TELEM_BLOCK_SIZE;
+	__cleanup_libnvme_free struct nvme_telemetry_log *hdr = NULL;
+	__cleanup_libnvme_free void *buf = NULL;
+	struct nvme_telemetry_log *old = *log;
+	struct libnvme_passthru_cmd cmd;
+	size_t dalb = 0, len, start = xfer;
+	int err;
+
+	if (old && *size < xfer)
+		return -EINVAL;
+
+	hdr = libnvme_alloc(xfer);
+	if (!hdr)
+		return -ENOMEM;
+
+	/* retain the event until the last read, as libnvme_get_log() does */
+	if (ctrl)
+		nvme_init_get_log_telemetry_ctrl(&cmd, 0, hdr, xfer);
+	else
+		nvme_init_get_log_telemetry_host(&cmd, 0, hdr, xfer);
+	err = libnvme_get_log(hdl, &cmd, true, xfer);
+	if (err)
+		return err;
+
+	if (!ctrl || hdr->ctrlavail) {
+		err = nvme_telemetry_dalb(hdr, da, &dalb);
+		if (err)
+			return err;
+	}
+
+	len = (dalb + 1) * xfer;
+	buf = libnvme_alloc(len);
+	if (!buf)
+		return -ENOMEM;
+
+	memcpy(buf, hdr, xfer);
+	if (old && nvme_telemetry_same_gen(old, hdr, ctrl)) {
+		start = *size < len ? *size : len;
+		memcpy(buf + xfer, (void *)old + xfer, start - xfer);
+	}
+
+	if (start < len) {
+		if (ctrl)
+			nvme_init_get_log_telemetry_ctrl(&cmd, start,
+				buf + start, len - start);
+		else
+			nvme_init_get_log_telemetry_host(&cmd, start,
+				buf + start, len - start);
+		err = libnvme_get_log(hdl, &cmd, rae, max_data_tx);
+	} else if (ctrl && !rae) {
+		nvme_init_get_log_telemetry_ctrl(&cmd, 0, hdr, xfer);
+		err = libnvme_get_log(hdl, &cmd, false, xfer);
+	}
+	if (err)
+		return err;
+
+	libnvme_free(old);
+	*log = buf;
+	buf = NULL;
+	*size = len;
+	*offset = start;
+
+	return 0;
+}
+
 static int nvme_check_get_telemetry_log(struct libnvme_transport_handle *hdl,
 		bool create, bool ctrl, bool rae,
 		struct nvme_telemetry_log **log, enum nvme_telemetry_da da,
@@ -547,6 +648,216 @@ __libnvme_public int libnvme_get_ana_log_len(
 	return 0;
 }
 
+/* the ANA Group ID is a dword, but a controller with that many is broken */
+#define ANA_CACHE_MAX_GRPID	(1 << 20)
+#define ANA_CACHE_RETRIES	10
+
+__libnvme_public int libnvme_ana_cache_new(
+		struct libnvme_transport_handle *hdl,
+		struct libnvme_ana_cache **cache)
+{
+	__cleanup_libnvme_free struct nvme_id_ctrl *ctrl = NULL;
+	struct libnvme_passthru_cmd cmd;
+	struct libnvme_ana_cache *c;
+	__u32 anagrpmax;
+	int ret;
+
+	ctrl = libnvme_alloc(sizeof(*ctrl));
+	if (!ctrl)
+		return -ENOMEM;
+
+	nvme_init_identify_ctrl(&cmd, ctrl);
+	ret = libnvme_exec_admin_passthru(hdl, &cmd);
+	if (ret)
+		return ret;
+
+	if (!NVME_CMIC_MULTI_ANA(ctrl->cmic))
+		return -ENOTSUP;
+
+	anagrpmax = le32_to_cpu(ctrl->anagrpmax);
+	if (anagrpmax >= ANA_CACHE_MAX_GRPID)
+		return -ERANGE;
+
+	c = calloc(1, sizeof(*c) + anagrpmax + 1);
+	if (!c)
+		return -ENOMEM;
+
+	c->hdl = hdl;
+	c->anagrpmax = anagrpmax;
+	c->len = libnvme_get_ana_log_len_from_id_ctrl(ctrl, true);
+	c->log = libnvme_alloc(c->len);
+	if (!c->log) {
+		free(c);
+		return -ENOMEM;
+	}
+	c->stale = true;
+
+	*cache = c;
+	return 0;
+}
+
+__libnvme_public void libnvme_ana_cache_free(struct libnvme_ana_cache *cache)
+{
+	if (!cache)
+		return;
+
+	libnvme_free(cache->log);
+	free(cache);
+}
+
+static void ana_cache_fill(struct libnvme_ana_cache *cache, __u32 len)
+{
+	__u8 *desc = (__u8 *)cache->log->descs;
+	__u8 *end = (__u8 *)cache->log + len;
+	__u16 ngrps = le16_to_cpu(cache->log->ngrps);
+
+	memset(cache->states, 0, cache->anagrpmax + 1);
+	while (ngrps-- && desc + sizeof(*cache->log->descs) <= end) {
+		struct nvme_ana_group_desc group;
+		__u32 grpid;
+
+		/* the descriptors are only 4-byte aligned */
+		memcpy(&group, desc, sizeof(group));
+		grpid = le32_to_cpu(group.grpid);
+		if (grpid && grpid <= cache->anagrpmax)
+			cache->states[grpid] = group.state & 0xf;
+
+		desc += sizeof(group) + le32_to_cpu(group.nnsids) * sizeof(__le32);
+	}
+
+	cache->chgcnt = le64_to_cpu(cache->log->chgcnt);
+}
+
+__libnvme_public int libnvme_ana_cache_refresh(
+		struct libnvme_ana_cache *cache, bool *changed)
+{
+	struct libnvme_passthru_cmd cmd;
+	struct nvme_ana_log hdr;
+	__u32 len;
+	int ret;
+
+	if (changed)
+		*changed = false;
+
+	/*
+	 * The kernel reads the log itself on an ANA change, so the event
+	 * is retained, and a header is all it takes to see if the groups
+	 * changed since the last read.
+	 */
+	if (!cache->stale) {
+		nvme_init_get_log_ana(&cmd, NVME_LOG_ANA_LSP_RGO_GROUPS_ONLY, 0,
+				      &hdr, sizeof(hdr));
+		ret = libnvme_get_log(cache->hdl, &cmd, true,
+				      NVME_LOG_PAGE_PDU_SIZE);
+		if (ret)
+			return ret;
+
+		if (le64_to_cpu(hdr.chgcnt) == cache->chgcnt)
+			return 0;
+	}
+
+	len = cache->len;
+	ret = libnvme_get_ana_log_atomic(cache->hdl, true, true, cache->log,
+					 &len, ANA_CACHE_RETRIES);
+	if (ret) {
+		cache->stale = true;
+		return ret;
+	}
+
+	ana_cache_fill(cache, len);
+	cache->stale = false;
+	if (changed)
+		*changed = true;
+
+	return 0;
+}
+
+__libnvme_public void libnvme_ana_cache_invalidate(
+		struct libnvme_ana_cache *cache)
+{
+	cache->stale = true;
+}
+
+static bool aen_is_ana_change(__u32 aen)
+{
+	return (aen & 0x7) == NVME_AER_NOTICE &&
+		((aen >> 8) & 0xff) == NVME_AER_NOTICE_ANA;
+}
+
+__libnvme_public bool libnvme_ana_cache_handle_aen(
+		struct libnvme_ana_cache *cache, __u32 aen)
+{
+	if (!aen_is_ana_change(aen))
+		return false;
+
+	cache->stale = true;
+	return true;
+}
+
+__libnvme_public bool libnvme_ana_cache_handle_uevent(
+		struct libnvme_ana_cache *cache, const char *buf, size_t len)
+{
+	const char *end = buf + len;
+	const char *name = NULL;
+	size_t name_len = 0;
+	bool ana = false;
+	__u32 aen;
+
+	/* netlink messages separate the variables with NULs, sysfs with \n */
+	while (buf < end) {
+		const char *eol = buf;
+		char var[64];
+		size_t n;
+
+		while (eol < end && *eol && *eol != '\n')
+			eol++;
+		n = eol - buf;
+
+		if (n > 8 && !strncmp(buf, "DEVNAME=", 8)) {
+			name = buf + 8;
+			name_len = n - 8;
+		} else if (n < sizeof(var) && !strncmp(buf, "NVME_AEN=", 9)) {
+			memcpy(var, buf, n);
+			var[n] = '\0';
+			if (sscanf(var, "NVME_AEN=%x", &aen) == 1 &&
+			    aen_is_ana_change(aen))
+				ana = true;
+		}
+
+		buf = eol + 1;
+	}
+
+	if (!ana)
+		return false;
+
+	/* a netlink socket sees the events of all controllers */
+	if (name) {
+		const char *hdl_name = libnvme_basename(cache->hdl->name);
+
+		if (strlen(hdl_name) != name_len ||
+		    strncmp(hdl_name, name, name_len))
+			return false;
+	}
+
+	cache->stale = true;
+	return true;
+}
+
+__libnvme_public int libnvme_ana_cache_get_state(
+		struct libnvme_ana_cache *cache, __u32 grpid)
+{
+	if (grpid > cache->anagrpmax || !cache->states[grpid])
+		return -ENOENT;
+
+	return cache->states[grpid];
+}
+
+__libnvme_public __u64 libnvme_ana_cache_get_chgcnt(
+		struct libnvme_ana_cache *cache)
+{
+	return cache->chgcnt;
+}
+
 __libnvme_public int libnvme_get_logical_block_size(
 		struct libnvme_transport_handle *hdl, __u32 nsid, int *blksize)
 {
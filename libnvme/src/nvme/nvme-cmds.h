@@ -115,6 +115,35 @@ int libnvme_get_telemetry_log(struct libnvme_transport_handle *hdl, bool create,
 		enum nvme_telemetry_da da, struct nvme_telemetry_log **log,
 		size_t *size);
 
+/**
+ * libnvme_update_telemetry_log() - Bring a telemetry log up to date
+ * @hdl:	Transport handle
+ * @ctrl:	Get controller Initiated log
+ * @rae:	Retain asynchronous events
+ * @max_data_tx: Set the max data transfer size to be used retrieving telemetry.
+ * @da:		Log page data area, valid values: &enum nvme_telemetry_da.
+ * @log:	Log of an earlier call or of libnvme_get_telemetry_log(), or
+ *		NULL. On success, freed and set to the updated log.
+ * @size:	Size of @log, on success set to the size of the updated log.
+ * @offset:	On success, set to the offset of the data read from the
+ *		controller. The data between the header and @offset was
+ *		taken from @log, @offset equals @size if none was read.
+ *
+ * Reads the header of the log and compares its log identifier, IEEE OUI,
+ * reason identifier and data generation number with the ones of @log.
+ * Only if they differ all of data area @da is read, otherwise just the
+ * blocks of @da beyond the end of @log, which are there when @log holds a
+ * smaller data area. A new host-initiated log is
+ * not created. @log is left untouched on error.
+ *
+ * Return: 0 on success, the nvme command status if a response was
+ * received (see &enum nvme_status_field) or a negative error otherwise.
+ */
+int libnvme_update_telemetry_log(struct libnvme_transport_handle *hdl,
+		bool ctrl, bool rae, size_t max_data_tx,
+		enum nvme_telemetry_da da, struct nvme_telemetry_log **log,
+		size_t *size, size_t *offset);
+
 /**
  * libnvme_get_ctrl_telemetry() - Get controller telemetry log
  * @hdl:	Transport handle
@@ -215,6 +244,95 @@ libnvme_get_ana_log_atomic(struct libnvme_transport_handle *hdl, bool rae,
 int libnvme_get_ana_log_len(struct libnvme_transport_handle *hdl,
 		size_t *analen);
 
+struct libnvme_ana_cache;
+
+/**
+ * libnvme_ana_cache_new() - Create a cache of the ANA group states
+ * @hdl:	Transport handle of the controller
+ * @cache:	On success, set to the new cache
+ *
+ * The cache maps each ANA group ID of the controller to its ANA state,
+ * so the state of a path is looked up without a command. It is filled
+ * by the first libnvme_ana_cache_refresh(). Free it with
+ * libnvme_ana_cache_free() before closing @hdl.
+ *
+ * Return: 0 on success, the nvme command status if a response was
+ * received (see &enum nvme_status_field) or a negative error otherwise:
+ * -ENOTSUP if the controller does not report ANA.
+ */
+int libnvme_ana_cache_new(struct libnvme_transport_handle *hdl,
+		struct libnvme_ana_cache **cache);
+
+/**
+ * libnvme_ana_cache_free() - Free an ANA state cache
+ * @cache:	Cache created by libnvme_ana_cache_new(), may be NULL
+ */
+void libnvme_ana_cache_free(struct libnvme_ana_cache *cache);
+
+/**
+ * libnvme_ana_cache_refresh() - Bring an ANA state cache up to date
+ * @cache:	ANA state cache
+ * @changed:	If not NULL, set to true if the ANA states were read again
+ *
+ * Reads only the header of the ANA log page, and the whole log page if
+ * its change count differs from the cached one or the cache was
+ * invalidated. Asynchronous events are retained.
+ *
+ * Return: 0 on success, the nvme command status if a response was
+ * received (see &enum nvme_status_field) or a negative error otherwise.
+ */
+int libnvme_ana_cache_refresh(struct libnvme_ana_cache *cache, bool *changed);
+
+/**
+ * libnvme_ana_cache_invalidate() - Read the whole ANA log on the next refresh
+ * @cache:	ANA state cache
+ */
+void libnvme_ana_cache_invalidate(struct libnvme_ana_cache *cache);
+
+/**
+ * libnvme_ana_cache_handle_aen() - Invalidate an ANA state cache on an ANA change
+ * @cache:	ANA state cache
+ * @aen:	Asynchronous event completion dword 0
+ *
+ * Return: true if @aen is an Asymmetric Namespace Access Change notice,
+ * in which case @cache is invalidated.
+ */
+bool libnvme_ana_cache_handle_aen(struct libnvme_ana_cache *cache, __u32 aen);
+
+/**
+ * libnvme_ana_cache_handle_uevent() - Invalidate an ANA state cache on a uevent
+ * @cache:	ANA state cache
+ * @buf:	Uevent read from the uevent file of the controller in sysfs
+ *		or from a kobject uevent netlink socket
+ * @len:	Length of @buf
+ *
+ * Looks for an NVME_AEN variable of an ANA change in @buf. If @buf
+ * names a device, it must be the controller of @cache.
+ *
+ * Return: true if @buf reports an ANA change of the controller, in
+ * which case @cache is invalidated.
+ */
+bool libnvme_ana_cache_handle_uevent(struct libnvme_ana_cache *cache,
+		const char *buf, size_t len);
+
+/**
+ * libnvme_ana_cache_get_state() - Cached ANA state of an ANA group
+ * @cache:	ANA state cache
+ * @grpid:	ANA group ID, see libnvme_path_get_grpid()
+ *
+ * Return: The &enum nvme_ana_state of @grpid as of the last refresh,
+ * or -ENOENT if the controller did not report the group.
+ */
+int libnvme_ana_cache_get_state(struct libnvme_ana_cache *cache, __u32 grpid);
+
+/**
+ * libnvme_ana_cache_get_chgcnt() - Change count of the cached ANA states
+ * @cache:	ANA state cache
+ *
+ * Return: The change count of the ANA log page at the last full read.
+ */
+__u64 libnvme_ana_cache_get_chgcnt(struct libnvme_ana_cache *cache);
+
 /**
  * libnvme_get_logical_block_size() - Retrieve block size
  * @hdl:	Transport handle
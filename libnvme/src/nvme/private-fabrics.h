@@ -107,6 +107,20 @@ struct libnvmf_uri { // !generate-accessors
 	char *fragment;
 };
 
+/**
+ * struct libnvmf_discovery_log_entry - Last discovery log of a discovery ctrl
+ * @entry:	Entry in &libnvme_global_ctx.discovery_logs
+ * @key:	Address of the discovery controller, host NQN and LSP
+ * @log:	Log page as read from the controller, header and records
+ * @len:	Size of @log in bytes
+ */
+struct libnvmf_discovery_log_entry {
+	struct list_node entry;
+	char *key;
+	struct nvmf_discovery_log *log;
+	size_t len;
+};
+
 /**
  * libnvmf_exat_len() - Return length rounded up by 4
  * @val_len: Value length
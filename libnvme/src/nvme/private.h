@@ -196,6 +196,10 @@ struct libnvme_transport_handle {
 	enum ioctl_state ioctl_io_state;
 	bool uring_enabled;
 
+	/* static data cache, see cache.c */
+	char *cache_dir;
+	char *cache_key;
+
 #ifdef CONFIG_MI
 	/* mi */
 	struct libnvme_mi_ep *ep;
@@ -206,6 +210,17 @@ struct libnvme_transport_handle {
 	struct libnvme_log *log;
 };
 
+/* ANA group states of a controller, see libnvme_ana_cache_refresh() */
+struct libnvme_ana_cache {
+	struct libnvme_transport_handle *hdl;
+	struct nvme_ana_log *log;
+	__u32 len;
+	__u32 anagrpmax;
+	__u64 chgcnt;
+	bool stale;
+	__u8 states[];	/* indexed by ANA group ID, 0 if unknown */
+};
+
 enum libnvme_stat_group {
 	READ = 0,
 	WRITE,
@@ -435,6 +450,7 @@ struct libnvme_global_ctx { // !generate-python:alias=GlobalCtx
 #ifdef CONFIG_FABRICS
 	struct libnvme_fabric_options *options;
 	struct ifaddrs *ifaddrs_cache; /* init with libnvmf_getifaddrs() */
+	struct list_head discovery_logs; /* last log per discovery ctrl */
 #endif
 
 	enum libnvme_io_uring_state uring_state;
@@ -458,6 +474,13 @@ void __libnvme_submit_exit(struct libnvme_transport_handle *hdl,
 bool __libnvme_decide_retry(struct libnvme_transport_handle *hdl,
 		struct libnvme_passthru_cmd *cmd, int err);
 
+void __libnvme_cache_init(struct libnvme_transport_handle *hdl);
+void __libnvme_cache_free(struct libnvme_transport_handle *hdl);
+int __libnvme_cache_get(struct libnvme_transport_handle *hdl,
+		struct libnvme_passthru_cmd *cmd);
+void __libnvme_cache_put(struct libnvme_transport_handle *hdl,
+		struct libnvme_passthru_cmd *cmd, int err);
+
 struct libnvme_transport_handle *__libnvme_open(struct libnvme_global_ctx *ctx,
 		const char *name);
 struct libnvme_transport_handle *__libnvme_create_transport_handle(
@@ -478,6 +501,7 @@ struct libnvme_ctrl *libnvme_lookup_ctrl(struct libnvme_subsystem *s,
 bool traddr_is_hostname(struct libnvme_global_ctx *ctx,
 		const char *transport, const char *traddr);
 void libnvmf_default_config(struct libnvme_fabrics_config *cfg);
+void __libnvmf_free_discovery_logs(struct libnvme_global_ctx *ctx);
 libnvme_ctrl_t libnvme_ctrl_find(libnvme_subsystem_t s,
 		const struct libnvme_ctrl_params *params, libnvme_ctrl_t p);
 void libnvmf_read_sysfs_fabrics_attrs(struct libnvme_global_ctx *ctx,
@@ -615,6 +615,124 @@ static void test_buffer_too_short(void)
 	free(log);
 }
 
+#define ANA_CHANGE_AEN	(NVME_LOG_LID_ANA << 16 | NVME_AER_NOTICE_ANA << 8 | \
+			 NVME_AER_NOTICE)
+
+static void test_cache(void)
+{
+	struct nvme_id_ctrl id = {};
+	struct nvme_ana_log header;
+	struct nvme_ana_group_desc groups[2];
+	__u8 log_page[sizeof(header) + sizeof(groups)];
+	__u32 len_dwords = sizeof(log_page) / 4;
+	struct mock_cmd mock_identify = {
+		.opcode = nvme_admin_identify,
+		.data_len = sizeof(id),
+		.cdw10 = NVME_IDENTIFY_CNS_CTRL,
+		.out_data = &id,
+	};
+	struct mock_cmd mock_log = {
+		.opcode = nvme_admin_get_log_page,
+		.data_len = len_dwords * 4,
+		.cdw10 = (len_dwords - 1) << 16 /* NUMDL */
+		       | 1 << 15 /* RAE */
+		       | NVME_LOG_ANA_LSP_RGO_GROUPS_ONLY << 8 /* LSP */
+		       | NVME_LOG_LID_ANA, /* LID */
+		.out_data = log_page,
+	};
+	struct mock_cmd mock_header = {
+		.opcode = nvme_admin_get_log_page,
+		.data_len = sizeof(header),
+		.cdw10 = (sizeof(header) / 4 - 1) << 16 /* NUMDL */
+		       | 1 << 15 /* RAE */
+		       | NVME_LOG_ANA_LSP_RGO_GROUPS_ONLY << 8 /* LSP */
+		       | NVME_LOG_LID_ANA, /* LID */
+		.out_data = &header,
+	};
+	struct mock_cmd mock_refresh[] = { mock_header, mock_log };
+	static const char other_uevent[] =
+		"ACTION=change\0DEVNAME=nvme1\0NVME_AEN=0x000c0302";
+	static const char uevent[] =
+		"ACTION=change\nDEVNAME=NVME_TEST_FD\nNVME_AEN=0x000c0302\n";
+	struct libnvme_ana_cache *cache;
+	bool changed;
+
+	id.cmic = 1 << NVME_CMIC_MULTI_ANA_SHIFT;
+	id.anagrpmax = cpu_to_le32(8);
+	id.nanagrpid = cpu_to_le32(ARRAY_SIZE(groups));
+	set_mock_admin_cmds(&mock_identify, 1);
+	check(!libnvme_ana_cache_new(test_hdl, &cache), "cache creation failed");
+	end_mock_cmds();
+
+	arbitrary(&header, sizeof(header));
+	header.ngrps = cpu_to_le16(ARRAY_SIZE(groups));
+	arbitrary(groups, sizeof(groups));
+	groups[0].grpid = cpu_to_le32(3);
+	groups[0].nnsids = cpu_to_le32(0);
+	groups[0].state = NVME_ANA_STATE_OPTIMIZED;
+	groups[1].grpid = cpu_to_le32(8);
+	groups[1].nnsids = cpu_to_le32(0);
+	groups[1].state = NVME_ANA_STATE_INACCESSIBLE;
+	memcpy(log_page, &header, sizeof(header));
+	memcpy(log_page + sizeof(header), groups, sizeof(groups));
+
+	/* the first refresh reads the whole log page */
+	set_mock_admin_cmds(&mock_log, 1);
+	check(!libnvme_ana_cache_refresh(cache, &changed), "refresh failed");
+	end_mock_cmds();
+	check(changed, "states not read");
+	check(libnvme_ana_cache_get_chgcnt(cache) == le64_to_cpu(header.chgcnt),
+	      "incorrect chgcnt");
+	check(libnvme_ana_cache_get_state(cache, 3) == NVME_ANA_STATE_OPTIMIZED,
+	      "incorrect state of group 3");
+	check(libnvme_ana_cache_get_state(cache, 8) ==
+	      NVME_ANA_STATE_INACCESSIBLE, "incorrect state of group 8");
+	check(libnvme_ana_cache_get_state(cache, 1) == -ENOENT,
+	      "unknown group 1 found");
+	check(libnvme_ana_cache_get_state(cache, 9) == -ENOENT,
+	      "group 9 beyond ANAGRPMAX found");
+
+	/* the same change count, only the header is read */
+	set_mock_admin_cmds(&mock_header, 1);
+	check(!libnvme_ana_cache_refresh(cache, &changed), "refresh failed");
+	end_mock_cmds();
+	check(!changed, "states read again");
+
+	/* a new change count, the whole log page is read again */
+	header.chgcnt = cpu_to_le64(le64_to_cpu(header.chgcnt) + 1);
+	groups[0].state = NVME_ANA_STATE_CHANGE;
+	memcpy(log_page, &header, sizeof(header));
+	memcpy(log_page + sizeof(header), groups, sizeof(groups));
+	set_mock_admin_cmds(mock_refresh, ARRAY_SIZE(mock_refresh));
+	check(!libnvme_ana_cache_refresh(cache, &changed), "refresh failed");
+	end_mock_cmds();
+	check(changed, "states not read");
+	check(libnvme_ana_cache_get_state(cache, 3) == NVME_ANA_STATE_CHANGE,
+	      "incorrect state of group 3");
+
+	/* an ANA change notice skips the header */
+	check(!libnvme_ana_cache_handle_aen(cache, NVME_AER_NOTICE),
+	      "namespace change handled");
+	check(libnvme_ana_cache_handle_aen(cache, ANA_CHANGE_AEN),
+	      "ANA change not handled");
+	set_mock_admin_cmds(&mock_log, 1);
+	check(!libnvme_ana_cache_refresh(cache, &changed), "refresh failed");
+	end_mock_cmds();
+	check(changed, "states not read");
+
+	/* and so does its uevent, unless it is for another controller */
+	check(!libnvme_ana_cache_handle_uevent(cache, other_uevent,
+					       sizeof(other_uevent)),
+	      "uevent of another controller handled");
+	check(libnvme_ana_cache_handle_uevent(cache, uevent, strlen(uevent)),
+	      "uevent not handled");
+	set_mock_admin_cmds(&mock_log, 1);
+	check(!libnvme_ana_cache_refresh(cache, NULL), "refresh failed");
+	end_mock_cmds();
+
+	libnvme_ana_cache_free(cache);
+}
+
 static void run_test(const char *test_name, void (*test_fn)(void))
 {
 	printf("Running test %s...", test_name);
@@ -646,6 +764,7 @@ int main(void)
 	RUN_TEST(buffer_too_short_chgcnt_change);
 	RUN_TEST(chgcnt_max_retries);
 	RUN_TEST(buffer_too_short);
+	RUN_TEST(cache);
 
 	libnvme_free_global_ctx(ctx);
 }
@@ -0,0 +1,262 @@
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libnvme.h>
+
+#include "mock.h"
+#include "util.h"
+
+static struct libnvme_transport_handle *test_hdl;
+static char sysfs_dir[] = "/tmp/libnvme-sysfs-XXXXXX";
+static char cache_dir[] = "/tmp/libnvme-cache-XXXXXX";
+
+static void write_attr(const char *dir, const char *attr, const char *val)
+{
+	char path[PATH_MAX];
+	FILE *f;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, attr);
+	f = fopen(path, "w");
+	check(f, "failed to create %s: %m", path);
+	fprintf(f, "%s\n", val);
+	fclose(f);
+}
+
+/* what the kernel shows in /sys/class/nvme/<ctrl> */
+static void make_sysfs(void)
+{
+	char path[PATH_MAX];
+
+	check(mkdtemp(sysfs_dir), "mkdtemp failed: %m");
+	snprintf(path, sizeof(path), "mkdir -p %s/sys/class/nvme/NVME_TEST_FD",
+		 sysfs_dir);
+	check(!system(path), "failed to create the sysfs directory");
+	snprintf(path, sizeof(path), "%s/sys/class/nvme/NVME_TEST_FD",
+		 sysfs_dir);
+
+	write_attr(path, "serial", "SN-1234");
+	write_attr(path, "cntlid", "1");
+	write_attr(path, "firmware_rev", "1.0");
+
+	check(!setenv("LIBNVME_SYSFS_PATH", sysfs_dir, 1), "setenv failed");
+}
+
+static void identify_ctrl(struct nvme_id_ctrl *id, const struct mock_cmd *mock)
+{
+	struct libnvme_passthru_cmd cmd;
+	int err;
+
+	set_mock_admin_cmds(mock, mock ? 1 : 0);
+	nvme_init_identify_ctrl(&cmd, id);
+	err = libnvme_exec_admin_passthru(test_hdl, &cmd);
+	end_mock_cmds();
+	check(err == 0, "identify returned error %d", err);
+}
+
+static void test_static(void)
+{
+	struct nvme_id_ctrl expected_id, id = {};
+	struct mock_cmd mock_admin_cmd = {
+		.opcode = nvme_admin_identify,
+		.data_len = sizeof(expected_id),
+		.cdw10 = NVME_IDENTIFY_CNS_CTRL,
+		.out_data = &expected_id,
+	};
+
+	arbitrary(&expected_id, sizeof(expected_id));
+	identify_ctrl(&id, &mock_admin_cmd);
+	cmp(&id, &expected_id, sizeof(id), "incorrect identify data");
+
+	/* the second time the data comes from the cache, without an ioctl */
+	memset(&id, 0, sizeof(id));
+	identify_ctrl(&id, NULL);
+	cmp(&id, &expected_id, sizeof(id), "incorrect cached identify data");
+}
+
+static void test_dynamic(void)
+{
+	struct nvme_smart_log expected_log, log = {};
+	struct mock_cmd mock_admin_cmd = {
+		.opcode = nvme_admin_get_log_page,
+		.nsid = NVME_NSID_ALL,
+		.data_len = sizeof(expected_log),
+		.cdw10 = (sizeof(expected_log) / 4 - 1) << 16 |
+			 NVME_LOG_LID_SMART,
+		.out_data = &expected_log,
+	};
+	struct libnvme_passthru_cmd cmd;
+	int i, err;
+
+	/* the SMART log changes all the time, it is always read */
+	for (i = 0; i < 2; i++) {
+		arbitrary(&expected_log, sizeof(expected_log));
+		set_mock_admin_cmds(&mock_admin_cmd, 1);
+		nvme_init_get_log_smart(&cmd, NVME_NSID_ALL, &log);
+		err = libnvme_exec_admin_passthru(test_hdl, &cmd);
+		end_mock_cmds();
+		check(err == 0, "get log returned error %d", err);
+		cmp(&log, &expected_log, sizeof(log), "incorrect SMART log");
+	}
+}
+
+static void test_error(void)
+{
+	struct nvme_id_ns id = {};
+	struct mock_cmd mock_admin_cmd = {
+		.opcode = nvme_admin_identify,
+		.nsid = 1,
+		.data_len = sizeof(id),
+		.cdw10 = NVME_IDENTIFY_CNS_NS,
+		.err = NVME_SC_INVALID_NS,
+	};
+	struct libnvme_passthru_cmd cmd;
+	int i, err;
+
+	/* failed commands are not cached, nor is the namespace data */
+	for (i = 0; i < 2; i++) {
+		set_mock_admin_cmds(&mock_admin_cmd, 1);
+		nvme_init_identify_ns(&cmd, 1, &id);
+		err = libnvme_exec_admin_passthru(test_hdl, &cmd);
+		end_mock_cmds();
+		check(err == NVME_SC_INVALID_NS, "got error %d", err);
+	}
+}
+
+static void test_fw_commit(void)
+{
+	struct nvme_id_ctrl expected_id, id = {};
+	struct mock_cmd mock_admin_cmds[] = {
+		{
+			.opcode = nvme_admin_fw_commit,
+			.cdw10 = NVME_FW_COMMIT_CA_REPLACE_AND_ACTIVATE_IMMEDIATE
+				<< NVME_FW_COMMIT_CDW10_CA_SHIFT | 1,
+		},
+		{
+			.opcode = nvme_admin_identify,
+			.data_len = sizeof(expected_id),
+			.cdw10 = NVME_IDENTIFY_CNS_CTRL,
+			.out_data = &expected_id,
+		},
+	};
+	struct libnvme_passthru_cmd cmd;
+	int err;
+
+	/* fill the cache */
+	identify_ctrl(&id, NULL);
+
+	set_mock_admin_cmds(mock_admin_cmds, 1);
+	nvme_init_fw_commit(&cmd, 1,
+			NVME_FW_COMMIT_CA_REPLACE_AND_ACTIVATE_IMMEDIATE, false);
+	err = libnvme_exec_admin_passthru(test_hdl, &cmd);
+	end_mock_cmds();
+	check(err == 0, "fw commit returned error %d", err);
+
+	/* the new image may report other data */
+	arbitrary(&expected_id, sizeof(expected_id));
+	identify_ctrl(&id, &mock_admin_cmds[1]);
+	cmp(&id, &expected_id, sizeof(id), "incorrect identify data");
+}
+
+static void test_ns_mgmt(void)
+{
+	struct nvme_id_ctrl expected_id, id = {};
+	struct mock_cmd mock_admin_cmds[] = {
+		{
+			.opcode = nvme_admin_ns_mgmt,
+			.nsid = 1,
+			.cdw10 = NVME_NS_MGMT_SEL_DELETE,
+		},
+		{
+			.opcode = nvme_admin_identify,
+			.data_len = sizeof(expected_id),
+			.cdw10 = NVME_IDENTIFY_CNS_CTRL,
+			.out_data = &expected_id,
+		},
+	};
+	struct libnvme_passthru_cmd cmd;
+	int err;
+
+	/* fill the cache */
+	identify_ctrl(&id, NULL);
+
+	set_mock_admin_cmds(mock_admin_cmds, 1);
+	nvme_init_ns_mgmt_delete(&cmd, 1);
+	err = libnvme_exec_admin_passthru(test_hdl, &cmd);
+	end_mock_cmds();
+	check(err == 0, "ns mgmt returned error %d", err);
+
+	/* the unallocated capacity changed */
+	arbitrary(&expected_id, sizeof(expected_id));
+	identify_ctrl(&id, &mock_admin_cmds[1]);
+	cmp(&id, &expected_id, sizeof(id), "incorrect identify data");
+}
+
+static void test_drop(void)
+{
+	struct nvme_id_ctrl expected_id, id = {};
+	struct mock_cmd mock_admin_cmd = {
+		.opcode = nvme_admin_identify,
+		.data_len = sizeof(expected_id),
+		.cdw10 = NVME_IDENTIFY_CNS_CTRL,
+		.out_data = &expected_id,
+	};
+	int err;
+
+	err = libnvme_transport_handle_drop_cache(test_hdl);
+	check(err == 0, "drop cache returned error %d", err);
+
+	arbitrary(&expected_id, sizeof(expected_id));
+	identify_ctrl(&id, &mock_admin_cmd);
+	cmp(&id, &expected_id, sizeof(id), "incorrect identify data");
+}
+
+static void cleanup(void)
+{
+	char cmd[2 * PATH_MAX];
+
+	snprintf(cmd, sizeof(cmd), "rm -rf %s %s", sysfs_dir, cache_dir);
+	check(!system(cmd), "failed to remove %s and %s", sysfs_dir,
+	      cache_dir);
+}
+
+static void run_test(const char *test_name, void (*test_fn)(void))
+{
+	printf("Running test %s...", test_name);
+	fflush(stdout);
+	test_fn();
+	puts(" OK");
+}
+
+#define RUN_TEST(name) run_test(#name, test_ ## name)
+
+int main(void)
+{
+	struct libnvme_global_ctx *ctx;
+
+	/* before libnvme looks up the sysfs directories */
+	make_sysfs();
+	check(mkdtemp(cache_dir), "mkdtemp failed: %m");
+
+	ctx = libnvme_create_global_ctx(stdout, LIBNVME_DEFAULT_LOGLEVEL);
+
+	set_mock_fd(LIBNVME_TEST_FD);
+	check(!libnvme_open(ctx, "NVME_TEST_FD", &test_hdl),
+	      "opening test link failed");
+	check(!libnvme_transport_handle_set_cache_dir(test_hdl, cache_dir),
+	      "setting the cache directory failed");
+
+	RUN_TEST(static);
+	RUN_TEST(dynamic);
+	RUN_TEST(error);
+	RUN_TEST(fw_commit);
+	RUN_TEST(ns_mgmt);
+	RUN_TEST(drop);
+
+	libnvme_close(test_hdl);
+	libnvme_free_global_ctx(ctx);
+	cleanup();
+}
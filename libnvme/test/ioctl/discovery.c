@@ -420,6 +420,90 @@ static void test_genctr_error(libnvme_ctrl_t c)
 	check(!log, "unexpected log page returned");
 }
 
+static void test_cached(libnvme_ctrl_t c)
+{
+	struct nvmf_disc_log_entry entries[2];
+	struct nvmf_disc_log_entry log_entries[2];
+	struct nvmf_discovery_log header = {
+		.genctr = cpu_to_le64(1),
+		.numrec = cpu_to_le64(ARRAY_SIZE(entries)),
+	};
+	struct mock_cmd mock_admin_cmds[] = {
+		{
+			.opcode = nvme_admin_get_log_page,
+			.data_len = HEADER_LEN,
+			.cdw10 = (HEADER_LEN / 4 - 1) << 16 /* NUMDL */
+			       | NVME_LOG_LID_DISCOVERY, /* LID */
+			.out_data = &header,
+		},
+		{
+			.opcode = nvme_admin_get_log_page,
+			.data_len = sizeof(entries),
+			.cdw10 = (sizeof(entries) / 4 - 1) << 16 /* NUMDL */
+			       | NVME_LOG_LID_DISCOVERY, /* LID */
+			.cdw12 = sizeof(header), /* LPOL */
+			.out_data = log_entries,
+		},
+		{
+			.opcode = nvme_admin_get_log_page,
+			.data_len = HEADER_LEN,
+			.cdw10 = (HEADER_LEN / 4 - 1) << 16 /* NUMDL */
+			       | NVME_LOG_LID_DISCOVERY, /* LID */
+			.out_data = &header,
+		},
+	};
+	char cache_dir[] = "/tmp/libnvme-discovery-XXXXXX";
+	struct nvmf_discovery_log *log = NULL;
+	struct libnvme_global_ctx *ctx2;
+	char cmd[64];
+
+	c->transport = "tcp";
+	c->traddr = "192.168.1.1";
+	c->trsvcid = "8009";
+	c->subsysnqn = NVME_DISC_SUBSYS_NAME;
+	check(mkdtemp(cache_dir), "mkdtemp failed");
+	check(!libnvme_transport_handle_set_cache_dir(test_hdl, cache_dir),
+	      "setting the cache directory failed");
+
+	arbitrary_entries(ARRAY_SIZE(entries), entries, log_entries);
+	set_mock_admin_cmds(mock_admin_cmds, ARRAY_SIZE(mock_admin_cmds));
+	check(fetch_discovery_log(c, &log, 1) == 0, "discovery failed");
+	end_mock_cmds();
+	cmp(log->entries, entries, sizeof(entries), "incorrect entries");
+	free(log);
+
+	/* the generation counter did not move, only the header is read */
+	set_mock_admin_cmds(mock_admin_cmds, 1);
+	check(fetch_discovery_log(c, &log, 1) == 0, "discovery failed");
+	end_mock_cmds();
+	cmp(log, &header, HEADER_LEN, "incorrect header");
+	cmp(log->entries, entries, sizeof(entries), "incorrect cached entries");
+	free(log);
+
+	/* a new context finds the log in the cache directory */
+	ctx2 = libnvme_create_global_ctx(stdout, LIBNVME_DEFAULT_LOGLEVEL);
+	c->ctx = ctx2;
+	set_mock_admin_cmds(mock_admin_cmds, 1);
+	check(fetch_discovery_log(c, &log, 1) == 0, "discovery failed");
+	end_mock_cmds();
+	cmp(log->entries, entries, sizeof(entries), "incorrect stored entries");
+	free(log);
+
+	/* a new generation is read in full */
+	header.genctr = cpu_to_le64(2);
+	arbitrary_entries(ARRAY_SIZE(entries), entries, log_entries);
+	set_mock_admin_cmds(mock_admin_cmds, ARRAY_SIZE(mock_admin_cmds));
+	check(fetch_discovery_log(c, &log, 1) == 0, "discovery failed");
+	end_mock_cmds();
+	cmp(log->entries, entries, sizeof(entries), "incorrect new entries");
+	free(log);
+
+	libnvme_free_global_ctx(ctx2);
+	libnvme_transport_handle_set_cache_dir(test_hdl, NULL);
+	snprintf(cmd, sizeof(cmd), "rm -rf %s", cache_dir);
+	check(!system(cmd), "failed to remove %s", cache_dir);
+}
+
 static void run_test(struct libnvme_global_ctx *ctx, const char *test_name,
 		void (*test_fn)(libnvme_ctrl_t))
 {
@@ -452,6 +536,7 @@ int main(void)
 	RUN_TEST(header_error);
 	RUN_TEST(entries_error);
 	RUN_TEST(genctr_error);
+	RUN_TEST(cached);
 
 	libnvme_free_global_ctx(ctx);
 }
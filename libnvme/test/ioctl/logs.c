@@ -1,5 +1,9 @@
 // SPDX-License-Identifier: LGPL-2.1-or-later
 
+#include <string.h>
+
+#include <ccan/endian/endian.h>
+
 #include <libnvme.h>
 
 #include "mock.h"
@@ -343,6 +347,172 @@ static void test_get_log_telemetry_ctrl(void)
 	cmp(&log, &expected_log, sizeof(log), "incorrect log data");
 }
 
+#define TELEM_BLOCK NVME_LOG_TELEM_BLOCK_SIZE
+
+static struct mock_cmd telemetry_host_cmd(__u64 offset, __u32 len, bool rae,
+					  const void *data)
+{
+	struct mock_cmd cmd = {
+		.opcode = nvme_admin_get_log_page,
+		.nsid = NVME_NSID_NONE,
+		.data_len = len,
+		.cdw10 = (NVME_LOG_LID_TELEMETRY_HOST << 0) |
+			 (NVME_LOG_TELEM_HOST_LSP_RETAIN << 8) |
+			 (!!rae << 15) |
+			 (((len >> 2) - 1) << 16),
+		.cdw12 = offset & 0xffffffff,
+		.cdw13 = offset >> 32,
+		.out_data = data,
+	};
+
+	return cmd;
+}
+
+static void test_update_telemetry_log(void)
+{
+	__u8 data[4 * TELEM_BLOCK], hdr_new[TELEM_BLOCK];
+	struct nvme_telemetry_log *hdr = (void *)data;
+	struct nvme_telemetry_log *log = NULL;
+	struct mock_cmd mock_admin_cmds[2];
+	size_t size = 0, offset;
+	int err;
+
+	arbitrary(data, sizeof(data));
+	hdr->dalb1 = cpu_to_le16(1);
+	hdr->dalb2 = cpu_to_le16(2);
+	hdr->dalb3 = cpu_to_le16(3);
+	hdr->hostdgn = 5;
+
+	/* nothing cached, the header and data area 1 are read */
+	mock_admin_cmds[0] = telemetry_host_cmd(0, TELEM_BLOCK, true, data);
+	mock_admin_cmds[1] = telemetry_host_cmd(TELEM_BLOCK, TELEM_BLOCK, false,
+						data + TELEM_BLOCK);
+	set_mock_admin_cmds(mock_admin_cmds, 2);
+	err = libnvme_update_telemetry_log(test_hdl, false, false, 4096,
+					   NVME_TELEMETRY_DA_1, &log, &size,
+					   &offset);
+	end_mock_cmds();
+	check(err == 0, "update returned error %d", err);
+	check(size == 2 * TELEM_BLOCK && offset == TELEM_BLOCK,
+	      "got size %zu offset %zu", size, offset);
+	cmp(log, data, size, "incorrect log data");
+
+	/* same generation, only the blocks of data area 3 beyond are read */
+	mock_admin_cmds[1] = telemetry_host_cmd(2 * TELEM_BLOCK,
+						2 * TELEM_BLOCK, false,
+						data + 2 * TELEM_BLOCK);
+	set_mock_admin_cmds(mock_admin_cmds, 2);
+	err = libnvme_update_telemetry_log(test_hdl, false, false, 4096,
+					   NVME_TELEMETRY_DA_3, &log, &size,
+					   &offset);
+	end_mock_cmds();
+	check(err == 0, "update returned error %d", err);
+	check(size == 4 * TELEM_BLOCK && offset == 2 * TELEM_BLOCK,
+	      "got size %zu offset %zu", size, offset);
+	cmp(log, data, size, "incorrect log data");
+
+	/* nothing changed, only the header is read */
+	set_mock_admin_cmds(mock_admin_cmds, 1);
+	err = libnvme_update_telemetry_log(test_hdl, false, false, 4096,
+					   NVME_TELEMETRY_DA_3, &log, &size,
+					   &offset);
+	end_mock_cmds();
+	check(err == 0, "update returned error %d", err);
+	check(size == 4 * TELEM_BLOCK && offset == size,
+	      "got size %zu offset %zu", size, offset);
+	cmp(log, data, size, "incorrect log data");
+
+	/* a new generation is read in full */
+	memcpy(hdr_new, data, sizeof(hdr_new));
+	((struct nvme_telemetry_log *)hdr_new)->hostdgn = 6;
+	arbitrary(data + TELEM_BLOCK, sizeof(data) - TELEM_BLOCK);
+	mock_admin_cmds[0] = telemetry_host_cmd(0, TELEM_BLOCK, true, hdr_new);
+	mock_admin_cmds[1] = telemetry_host_cmd(TELEM_BLOCK, 3 * TELEM_BLOCK,
+						false, data + TELEM_BLOCK);
+	set_mock_admin_cmds(mock_admin_cmds, 2);
+	err = libnvme_update_telemetry_log(test_hdl, false, false, 4096,
+					   NVME_TELEMETRY_DA_3, &log, &size,
+					   &offset);
+	end_mock_cmds();
+	check(err == 0, "update returned error %d", err);
+	check(size == 4 * TELEM_BLOCK && offset == TELEM_BLOCK,
+	      "got size %zu offset %zu", size, offset);
+	cmp(log, hdr_new, TELEM_BLOCK, "incorrect log header");
+	cmp((__u8 *)log + TELEM_BLOCK, data + TELEM_BLOCK,
+	    size - TELEM_BLOCK, "incorrect log data");
+
+	/* a failed read leaves the log alone */
+	mock_admin_cmds[0].err = NVME_SC_INTERNAL;
+	set_mock_admin_cmds(mock_admin_cmds, 1);
+	err = libnvme_update_telemetry_log(test_hdl, false, false, 4096,
+					   NVME_TELEMETRY_DA_3, &log, &size,
+					   &offset);
+	end_mock_cmds();
+	check(err == NVME_SC_INTERNAL, "update returned %d", err);
+	check(size == 4 * TELEM_BLOCK, "size changed to %zu", size);
+	cmp(log, hdr_new, TELEM_BLOCK, "log header changed");
+
+	libnvme_free(log);
+}
+
+static void test_update_telemetry_log_other(void)
+{
+	__u8 data[2 * TELEM_BLOCK], hdr_new[TELEM_BLOCK];
+	struct nvme_telemetry_log *hdr = (void *)data;
+	struct nvme_telemetry_log *new = (void *)hdr_new;
+	struct nvme_telemetry_log *log = NULL;
+	struct mock_cmd mock_admin_cmds[2];
+	size_t size = 0, offset;
+	int i, err;
+
+	arbitrary(data, sizeof(data));
+	hdr->lpi = NVME_LOG_LID_TELEMETRY_HOST;
+	hdr->dalb1 = cpu_to_le16(1);
+	hdr->dalb2 = cpu_to_le16(1);
+	hdr->dalb3 = cpu_to_le16(1);
+	hdr->hostdgn = 5;
+
+	mock_admin_cmds[0] = telemetry_host_cmd(0, TELEM_BLOCK, true, data);
+	mock_admin_cmds[1] = telemetry_host_cmd(TELEM_BLOCK, TELEM_BLOCK, false,
+						data + TELEM_BLOCK);
+	set_mock_admin_cmds(mock_admin_cmds, 2);
+	err = libnvme_update_telemetry_log(test_hdl, false, false, 4096,
+					   NVME_TELEMETRY_DA_1, &log, &size,
+					   &offset);
+	end_mock_cmds();
+	check(err == 0, "update returned error %d", err);
+
+	/*
+	 * The same generation number of the controller log, of another
+	 * drive or of another reason is no reason to keep the data area.
+	 */
+	for (i = 0; i < 3; i++) {
+		memcpy(hdr_new, data, sizeof(hdr_new));
+		if (i == 0)
+			new->lpi = NVME_LOG_LID_TELEMETRY_CTRL;
+		else if (i == 1)
+			new->ieee[0]++;
+		else
+			new->rsnident[0]++;
+		memcpy(data, hdr_new, sizeof(hdr_new));
+		arbitrary(data + TELEM_BLOCK, TELEM_BLOCK);
+
+		mock_admin_cmds[0] = telemetry_host_cmd(0, TELEM_BLOCK, true,
+							hdr_new);
+		set_mock_admin_cmds(mock_admin_cmds, 2);
+		err = libnvme_update_telemetry_log(test_hdl, false, false,
+						   4096, NVME_TELEMETRY_DA_1,
+						   &log, &size, &offset);
+		end_mock_cmds();
+		check(err == 0, "update returned error %d", err);
+		check(size == 2 * TELEM_BLOCK && offset == TELEM_BLOCK,
+		      "got size %zu offset %zu", size, offset);
+		cmp(log, data, size, "incorrect log data");
+	}
+
+	libnvme_free(log);
+}
+
 static void test_get_log_endurance_group(void)
 {
 	struct nvme_endurance_group_log expected_log, log = {};
@@ -1121,6 +1291,8 @@ int main(void)
 	RUN_TEST(get_log_create_telemetry_host);
 	RUN_TEST(get_log_telemetry_host);
 	RUN_TEST(get_log_telemetry_ctrl);
+	RUN_TEST(update_telemetry_log);
+	RUN_TEST(update_telemetry_log_other);
 	RUN_TEST(get_log_endurance_group);
 	RUN_TEST(get_log_predictable_lat_nvmset);
 	RUN_TEST(get_log_predictable_lat_event);
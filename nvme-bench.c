@@ -0,0 +1,505 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * nvme-bench.c - latency and IOPS benchmark on NVMe passthru commands
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Reads and writes are issued as IO passthru commands, below the block
+ * layer. The IO passthru path in libnvme is synchronous, so the queue
+ * depth is made up of one worker thread per outstanding command. Every
+ * worker times its own commands and records the latency into per thread
+ * histograms, which are merged once the run is over. Commands completed
+ * during the ramp time are not accounted.
+ */
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <libnvme.h>
+
+#include "common.h"
+#include "nvme-cmds.h"
+#include "nvme-print.h"
+#include "nvme.h"
+#include "util/histogram.h"
+#include "util/json.h"
+#include "util/sighdl.h"
+
+#define NSEC_PER_SEC	1000000000ULL
+
+enum bench_pattern {
+	BENCH_PATTERN_RAND,
+	BENCH_PATTERN_SEQ,
+};
+
+static OPT_VALS(bench_patterns) = {
+	VAL_BYTE("rand", BENCH_PATTERN_RAND),
+	VAL_BYTE("seq", BENCH_PATTERN_SEQ),
+	VAL_END()
+};
+
+enum bench_dir {
+	BENCH_READ,
+	BENCH_WRITE,
+	BENCH_NR_DIRS,
+};
+
+static const char * const bench_dir_names[BENCH_NR_DIRS] = {
+	[BENCH_READ]	= "read",
+	[BENCH_WRITE]	= "write",
+};
+
+static const double bench_percentiles[] = {
+	1, 10, 50, 90, 99, 99.9, 99.99, 99.999,
+};
+
+struct bench_ctx {
+	struct libnvme_transport_handle *hdl;
+	__u32 nsid;
+	__u64 slba;
+	__u32 nlb;
+	__u64 nr_slots;
+	__u32 data_len;
+	__u32 metadata_len;
+	enum bench_pattern pattern;
+	unsigned int read_pct;
+	void *wbuf;
+
+	__u64 ramp_end;
+	__u64 end;
+	__u64 seq_next;
+	bool stop;
+};
+
+struct bench_worker {
+	struct bench_ctx *ctx;
+	pthread_t thread;
+	bool started;
+	void *buf;
+	void *mbuf;
+	__u64 rng;
+	int err;
+	struct histogram hist[BENCH_NR_DIRS];
+};
+
+static __u64 bench_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+/* xorshift64*, good enough to spread offsets and mix reads and writes */
+static __u64 bench_rand(__u64 *state)
+{
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+	return *state * 0x2545f4914f6cdd1dULL;
+}
+
+static void *bench_worker_fn(void *arg)
+{
+	struct bench_worker *w = arg;
+	struct bench_ctx *ctx = w->ctx;
+	struct libnvme_passthru_cmd cmd;
+	enum bench_dir dir;
+	__u64 slot, start, end;
+	int err;
+
+	while (!__atomic_load_n(&ctx->stop, __ATOMIC_RELAXED) &&
+	       !nvme_sigint_received) {
+		start = bench_now_ns();
+		if (start >= ctx->end)
+			break;
+
+		if (ctx->pattern == BENCH_PATTERN_SEQ)
+			slot = __atomic_fetch_add(&ctx->seq_next, 1,
+						  __ATOMIC_RELAXED);
+		else
+			slot = bench_rand(&w->rng);
+		slot %= ctx->nr_slots;
+
+		if (ctx->read_pct == 100)
+			dir = BENCH_READ;
+		else if (!ctx->read_pct)
+			dir = BENCH_WRITE;
+		else
+			dir = bench_rand(&w->rng) % 100 < ctx->read_pct ?
+				BENCH_READ : BENCH_WRITE;
+
+		nvme_init_io(&cmd,
+			     dir == BENCH_READ ? nvme_cmd_read : nvme_cmd_write,
+			     ctx->nsid, ctx->slba + slot * ctx->nlb,
+			     dir == BENCH_READ ? w->buf : ctx->wbuf,
+			     ctx->data_len, w->mbuf, ctx->metadata_len);
+		cmd.cdw12 = NVME_FIELD_ENCODE(ctx->nlb - 1,
+				NVME_IOCS_COMMON_CDW12_NLB_SHIFT,
+				NVME_IOCS_COMMON_CDW12_NLB_MASK);
+
+		start = bench_now_ns();
+		err = libnvme_exec_io_passthru(ctx->hdl, &cmd);
+		end = bench_now_ns();
+		if (err) {
+			w->err = err;
+			__atomic_store_n(&ctx->stop, true, __ATOMIC_RELAXED);
+			break;
+		}
+
+		if (start >= ctx->ramp_end)
+			hist_record(&w->hist[dir], end - start);
+	}
+
+	return NULL;
+}
+
+static void bench_show_dir_normal(enum bench_dir dir,
+				  const struct histogram *h, __u32 bs,
+				  double secs)
+{
+	unsigned int i;
+
+	printf("%s: IOPS %.0f, BW %.1f MiB/s, %" PRIu64 " I/Os\n",
+	       bench_dir_names[dir], h->total / secs,
+	       h->total * bs / secs / (1024 * 1024), h->total);
+	printf("  lat (usec): min %.2f, avg %.2f, max %.2f\n",
+	       h->min / 1000.0, hist_mean(h) / 1000.0, h->max / 1000.0);
+	printf("  percentiles (usec):\n");
+	for (i = 0; i < ARRAY_SIZE(bench_percentiles); i++)
+		printf("    %7.3fth: %.2f\n", bench_percentiles[i],
+		       hist_percentile(h, bench_percentiles[i]) / 1000.0);
+}
+
+static struct json_object *bench_dir_json(const struct histogram *h,
+					  __u32 bs, double secs)
+{
+	struct json_object *r = json_create_object();
+	struct json_object *lat = json_create_object();
+	struct json_object *pcts = json_create_object();
+	char key[16];
+	unsigned int i;
+
+	json_object_add_value_uint64(r, "ios", h->total);
+	json_object_add_value_double(r, "iops", h->total / secs);
+	json_object_add_value_double(r, "bw_bytes", h->total * bs / secs);
+
+	json_object_add_value_uint64(lat, "min", h->min);
+	json_object_add_value_double(lat, "mean", hist_mean(h));
+	json_object_add_value_uint64(lat, "max", h->max);
+	for (i = 0; i < ARRAY_SIZE(bench_percentiles); i++) {
+		snprintf(key, sizeof(key), "%.3f", bench_percentiles[i]);
+		json_object_add_value_uint64(pcts, key,
+			hist_percentile(h, bench_percentiles[i]));
+	}
+	json_object_add_value_object(lat, "percentiles", pcts);
+	json_object_add_value_object(r, "lat_ns", lat);
+
+	return r;
+}
+
+static void bench_show(struct bench_ctx *ctx, const char *dev,
+		       struct histogram *hist, double secs,
+		       unsigned int depth, nvme_print_flags_t flags)
+{
+	__u32 bs = ctx->data_len;
+	struct json_object *r;
+	int dir;
+
+	if (flags & JSON) {
+		r = json_create_object();
+		json_object_add_value_string(r, "device", dev);
+		json_object_add_value_uint(r, "nsid", ctx->nsid);
+		json_object_add_value_string(r, "pattern",
+			ctx->pattern == BENCH_PATTERN_SEQ ? "seq" : "rand");
+		json_object_add_value_uint(r, "read_pct", ctx->read_pct);
+		json_object_add_value_uint(r, "block_size", bs);
+		json_object_add_value_uint(r, "queue_depth", depth);
+		json_object_add_value_double(r, "runtime", secs);
+		for (dir = 0; dir < BENCH_NR_DIRS; dir++) {
+			if (!hist[dir].total)
+				continue;
+			json_object_add_value_object(r, bench_dir_names[dir],
+				bench_dir_json(&hist[dir], bs, secs));
+		}
+		json_print_object(r, NULL);
+		printf("\n");
+		json_free_object(r);
+		return;
+	}
+
+	printf("%s: nsid %u, %s, %u%% reads, bs %u, qd %u, runtime %.1f s\n",
+	       dev, ctx->nsid,
+	       ctx->pattern == BENCH_PATTERN_SEQ ? "seq" : "rand",
+	       ctx->read_pct, bs, depth, secs);
+	for (dir = 0; dir < BENCH_NR_DIRS; dir++) {
+		if (!hist[dir].total)
+			continue;
+		bench_show_dir_normal(dir, &hist[dir], bs, secs);
+	}
+}
+
+static int bench_ns_format(struct libnvme_transport_handle *hdl, __u32 nsid,
+			   unsigned int *lbs, __u16 *ms, bool *extended,
+			   __u64 *nsze)
+{
+	__cleanup_libnvme_free struct nvme_id_ns *ns = NULL;
+	__u8 lba_index;
+	int err;
+
+	ns = libnvme_alloc(sizeof(*ns));
+	if (!ns)
+		return -ENOMEM;
+
+	err = nvme_identify_ns(hdl, nsid, ns);
+	if (err) {
+		nvme_show_err(err, "identify namespace");
+		return err;
+	}
+
+	nvme_id_ns_flbas_to_lbaf_inuse(ns->flbas, &lba_index);
+	*lbs = 1 << ns->lbaf[lba_index].ds;
+	*ms = le16_to_cpu(ns->lbaf[lba_index].ms);
+	*extended = NVME_FLBAS_META_EXT(ns->flbas);
+	*nsze = le64_to_cpu(ns->nsze);
+
+	return 0;
+}
+
+int bench_cmd_option(int argc, char **argv, struct command *acmd,
+		     struct plugin *plugin)
+{
+	const char *desc = "Measure latency and IOPS of read and/or write "
+		"commands on a namespace. Commands are sent as IO passthru, "
+		"bypassing the block layer. Latencies are collected in a "
+		"histogram and reported as percentiles.";
+	const char *pattern = "access pattern: rand|seq";
+	const char *read_pct = "percentage of reads, the rest are writes (0-100)";
+	const char *block_size = "bytes per command, multiple of the LBA data size";
+	const char *queue_depth = "number of commands kept in flight";
+	const char *runtime = "measured run time in seconds";
+	const char *ramp = "seconds to run before measuring";
+	const char *start_block = "first LBA of the tested range";
+	const char *size = "size of the tested range in bytes (default: up to the end of the namespace)";
+	const char *force = "do not warn before writing to the namespace";
+
+	__cleanup_nvme_transport_handle struct libnvme_transport_handle *hdl = NULL;
+	__cleanup_nvme_global_ctx struct libnvme_global_ctx *ctx = NULL;
+	__cleanup_free struct bench_worker *workers = NULL;
+	__cleanup_free struct histogram *hist = NULL;
+	__cleanup_libnvme_free void *wbuf = NULL;
+	struct bench_ctx bctx = { 0 };
+	nvme_print_flags_t flags;
+	unsigned int lbs, i;
+	__u64 nsze, now, rng;
+	bool extended;
+	double secs;
+	__u16 ms;
+	int err;
+	int dir;
+
+	struct config {
+		__u32	nsid;
+		__u8	pattern;
+		__u32	read_pct;
+		__u64	block_size;
+		__u32	queue_depth;
+		__u32	runtime;
+		__u32	ramp;
+		__u64	start_block;
+		__u64	size;
+		bool	force;
+	};
+
+	struct config cfg = {
+		.nsid		= 0,
+		.pattern	= BENCH_PATTERN_RAND,
+		.read_pct	= 100,
+		.block_size	= 4096,
+		.queue_depth	= 1,
+		.runtime	= 10,
+		.ramp		= 0,
+		.start_block	= 0,
+		.size		= 0,
+		.force		= false,
+	};
+
+	NVME_ARGS(opts,
+		  OPT_UINT("namespace-id",  'n', &cfg.nsid,        namespace_id_desired),
+		  OPT_BYTE("pattern",       'p', &cfg.pattern,     pattern, bench_patterns),
+		  OPT_UINT("read-pct",      'r', &cfg.read_pct,    read_pct),
+		  OPT_SUFFIX("block-size",  'b', &cfg.block_size,  block_size),
+		  OPT_UINT("queue-depth",   'q', &cfg.queue_depth, queue_depth),
+		  OPT_UINT("runtime",       't', &cfg.runtime,     runtime),
+		  OPT_UINT("ramp",          'R', &cfg.ramp,        ramp),
+		  OPT_SUFFIX("start-block", 's', &cfg.start_block, start_block),
+		  OPT_SUFFIX("size",        'z', &cfg.size,        size),
+		  OPT_FLAG("force",           0, &cfg.force,       force));
+
+	err = parse_and_open(&ctx, &hdl, argc, argv, desc, opts);
+	if (err)
+		return err;
+
+	err = validate_output_format(nvme_args.output_format, &flags);
+	if (err < 0 || (flags != NORMAL && !(flags & JSON))) {
+		nvme_show_error("Invalid output format");
+		return -EINVAL;
+	}
+
+	if (cfg.read_pct > 100) {
+		nvme_show_error("read percentage must be between 0 and 100");
+		return -EINVAL;
+	}
+	if (!cfg.queue_depth || !cfg.runtime) {
+		nvme_show_error("queue depth and runtime must not be zero");
+		return -EINVAL;
+	}
+
+	if (!cfg.nsid) {
+		err = libnvme_get_nsid(hdl, &cfg.nsid);
+		if (err < 0) {
+			nvme_show_error("get-namespace-id: %s", libnvme_strerror(-err));
+			return err;
+		}
+	}
+
+	err = bench_ns_format(hdl, cfg.nsid, &lbs, &ms, &extended, &nsze);
+	if (err)
+		return err;
+
+	if (extended)
+		lbs += ms;
+	if (!cfg.block_size || cfg.block_size % lbs ||
+	    cfg.block_size / lbs > 0x10000) {
+		nvme_show_error("block size must be a multiple of %u bytes", lbs);
+		return -EINVAL;
+	}
+	if (cfg.start_block >= nsze) {
+		nvme_show_error("start block beyond namespace size");
+		return -EINVAL;
+	}
+
+	bctx.hdl = hdl;
+	bctx.nsid = cfg.nsid;
+	bctx.slba = cfg.start_block;
+	bctx.nlb = cfg.block_size / lbs;
+	bctx.nr_slots = (nsze - cfg.start_block) / bctx.nlb;
+	if (cfg.size)
+		bctx.nr_slots = min(bctx.nr_slots, cfg.size / cfg.block_size);
+	bctx.data_len = cfg.block_size;
+	bctx.metadata_len = !extended ? bctx.nlb * ms : 0;
+	bctx.pattern = cfg.pattern;
+	bctx.read_pct = cfg.read_pct;
+	if (!bctx.nr_slots) {
+		nvme_show_error("tested range is smaller than the block size");
+		return -EINVAL;
+	}
+
+	if (cfg.read_pct < 100 && !cfg.force) {
+		fprintf(stderr,
+			"You are about to write to %s, namespace %#x.\n"
+			"WARNING: This will overwrite data on the namespace.\n"
+			"You have 10 seconds to press Ctrl-C to cancel this operation.\n\n"
+			"Use the force [--force] option to suppress this warning.\n",
+			libnvme_transport_handle_get_name(hdl), cfg.nsid);
+		sleep(10);
+		if (nvme_sigint_received)
+			return -EINTR;
+	}
+
+	hist = calloc(BENCH_NR_DIRS, sizeof(*hist));
+	workers = calloc(cfg.queue_depth, sizeof(*workers));
+	if (!hist || !workers)
+		return -ENOMEM;
+
+	if (cfg.read_pct < 100) {
+		wbuf = libnvme_alloc(bctx.data_len);
+		if (!wbuf)
+			return -ENOMEM;
+		rng = bench_now_ns() | 1;
+		for (i = 0; i < bctx.data_len / sizeof(__u64); i++)
+			((__u64 *)wbuf)[i] = bench_rand(&rng);
+		bctx.wbuf = wbuf;
+	}
+
+	now = bench_now_ns();
+	bctx.ramp_end = now + cfg.ramp * NSEC_PER_SEC;
+	bctx.end = bctx.ramp_end + cfg.runtime * NSEC_PER_SEC;
+
+	for (i = 0; i < cfg.queue_depth; i++) {
+		struct bench_worker *w = &workers[i];
+
+		w->ctx = &bctx;
+		w->rng = (now + i) * 0x9e3779b97f4a7c15ULL | 1;
+		for (dir = 0; dir < BENCH_NR_DIRS; dir++)
+			hist_init(&w->hist[dir]);
+
+		w->buf = libnvme_alloc(bctx.data_len);
+		if (!w->buf) {
+			err = -ENOMEM;
+			break;
+		}
+		if (bctx.metadata_len) {
+			w->mbuf = libnvme_alloc(bctx.metadata_len);
+			if (!w->mbuf) {
+				err = -ENOMEM;
+				break;
+			}
+		}
+
+		err = -pthread_create(&w->thread, NULL, bench_worker_fn, w);
+		if (err)
+			break;
+		w->started = true;
+	}
+	if (err)
+		__atomic_store_n(&bctx.stop, true, __ATOMIC_RELAXED);
+
+	for (dir = 0; dir < BENCH_NR_DIRS; dir++)
+		hist_init(&hist[dir]);
+
+	for (i = 0; i < cfg.queue_depth; i++) {
+		struct bench_worker *w = &workers[i];
+
+		if (w->started) {
+			pthread_join(w->thread, NULL);
+			for (dir = 0; dir < BENCH_NR_DIRS; dir++)
+				hist_merge(&hist[dir], &w->hist[dir]);
+			if (w->err && !err)
+				err = w->err;
+		}
+		libnvme_free(w->buf);
+		libnvme_free(w->mbuf);
+	}
+	now = min(bench_now_ns(), bctx.end);
+
+	if (err) {
+		nvme_show_err(err, "bench");
+		return err;
+	}
+
+	if (now <= bctx.ramp_end) {
+		nvme_show_error("interrupted before the ramp time was over");
+		return -EINTR;
+	}
+
+	secs = (double)(now - bctx.ramp_end) / NSEC_PER_SEC;
+	bench_show(&bctx, libnvme_transport_handle_get_name(hdl), hist, secs,
+		   cfg.queue_depth, flags);
+
+	return 0;
+}
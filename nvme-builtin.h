@@ -126,6 +126,9 @@ COMMAND_LIST(
 	ENTRY("rpmb", "Replay Protection Memory Block commands", rpmb_cmd)
 	ENTRY("lockdown", "Submit a Lockdown command,return result", lockdown_cmd)
 	ENTRY("show-topology", "Show the topology", show_topology_cmd)
+	ENTRY("export", "Export block stats and SMART logs in OpenMetrics format", export_cmd)
+	ENTRY("bench", "Measure read/write latency and IOPS with passthru commands", bench_cmd)
+	ENTRY("snapshot", "Collect identify data and log pages into an archive per controller", snapshot_cmd)
 	ENTRY("io-mgmt-recv", "I/O Management Receive", io_mgmt_recv)
 	ENTRY("io-mgmt-send", "I/O Management Send", io_mgmt_send)
 #ifdef CONFIG_MI
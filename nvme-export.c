@@ -0,0 +1,759 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * nvme-export.c - OpenMetrics exporter for NVMe block stats and SMART logs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * The exporter keeps the topology and the controller handles open for its
+ * whole lifetime. Block layer stats are sampled from sysfs at one rate and
+ * the SMART / Health Information log is fetched at another (usually much
+ * lower) rate. After every stat sample the metrics document is rendered
+ * in OpenMetrics text format and either atomically replaces a file (for
+ * the node_exporter textfile collector), is served on a unix socket or is
+ * written to stdout.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <libnvme.h>
+
+#include "common.h"
+#include "logging.h"
+#include "nvme-cmds.h"
+#include "nvme-print.h"
+#include "nvme.h"
+#include "util/sighdl.h"
+#include "util/types.h"
+
+#define EXPORT_PREFIX		"nvme_"
+#define EXPORT_SECTOR_SIZE	512
+
+enum export_stat {
+	EXPORT_STAT_READ_IOS,
+	EXPORT_STAT_WRITE_IOS,
+	EXPORT_STAT_READ_BYTES,
+	EXPORT_STAT_WRITE_BYTES,
+	EXPORT_STAT_READ_TIME,
+	EXPORT_STAT_WRITE_TIME,
+	EXPORT_STAT_IO_TIME,
+	EXPORT_STAT_INFLIGHTS,
+};
+
+struct export_stat_metric {
+	const char *name;
+	const char *type;
+	const char *help;
+	enum export_stat stat;
+};
+
+static const struct export_stat_metric export_stat_metrics[] = {
+	{ "read_ios", "counter", "Number of read I/Os completed",
+	  EXPORT_STAT_READ_IOS },
+	{ "write_ios", "counter", "Number of write I/Os completed",
+	  EXPORT_STAT_WRITE_IOS },
+	{ "read_bytes", "counter", "Number of bytes read",
+	  EXPORT_STAT_READ_BYTES },
+	{ "write_bytes", "counter", "Number of bytes written",
+	  EXPORT_STAT_WRITE_BYTES },
+	{ "read_time_seconds", "counter", "Time spent on read I/Os",
+	  EXPORT_STAT_READ_TIME },
+	{ "write_time_seconds", "counter", "Time spent on write I/Os",
+	  EXPORT_STAT_WRITE_TIME },
+	{ "io_time_seconds", "counter", "Time spent doing I/Os",
+	  EXPORT_STAT_IO_TIME },
+	{ "inflight_ios", "gauge", "Number of I/Os currently in flight",
+	  EXPORT_STAT_INFLIGHTS },
+};
+
+enum export_smart_fmt {
+	EXPORT_SMART_U8,
+	EXPORT_SMART_TEMP,
+	EXPORT_SMART_LE32,
+	EXPORT_SMART_U128,
+};
+
+struct export_smart_metric {
+	const char *name;
+	const char *type;
+	const char *help;
+	size_t offset;
+	enum export_smart_fmt fmt;
+};
+
+#define SMART_FIELD(f) offsetof(struct nvme_smart_log, f)
+
+static const struct export_smart_metric export_smart_metrics[] = {
+	{ "critical_warning", "gauge", "Critical warning bits",
+	  SMART_FIELD(critical_warning), EXPORT_SMART_U8 },
+	{ "temperature_celsius", "gauge", "Composite temperature",
+	  SMART_FIELD(temperature), EXPORT_SMART_TEMP },
+	{ "available_spare_percent", "gauge", "Available spare",
+	  SMART_FIELD(avail_spare), EXPORT_SMART_U8 },
+	{ "available_spare_threshold_percent", "gauge",
+	  "Available spare threshold",
+	  SMART_FIELD(spare_thresh), EXPORT_SMART_U8 },
+	{ "percentage_used", "gauge", "Percentage used",
+	  SMART_FIELD(percent_used), EXPORT_SMART_U8 },
+	{ "data_units_read", "counter", "Data units (1000 * 512 bytes) read",
+	  SMART_FIELD(data_units_read), EXPORT_SMART_U128 },
+	{ "data_units_written", "counter",
+	  "Data units (1000 * 512 bytes) written",
+	  SMART_FIELD(data_units_written), EXPORT_SMART_U128 },
+	{ "host_read_commands", "counter", "Host read commands",
+	  SMART_FIELD(host_reads), EXPORT_SMART_U128 },
+	{ "host_write_commands", "counter", "Host write commands",
+	  SMART_FIELD(host_writes), EXPORT_SMART_U128 },
+	{ "controller_busy_time_minutes", "counter", "Controller busy time",
+	  SMART_FIELD(ctrl_busy_time), EXPORT_SMART_U128 },
+	{ "power_cycles", "counter", "Power cycles",
+	  SMART_FIELD(power_cycles), EXPORT_SMART_U128 },
+	{ "power_on_hours", "counter", "Power on hours",
+	  SMART_FIELD(power_on_hours), EXPORT_SMART_U128 },
+	{ "unsafe_shutdowns", "counter", "Unsafe shutdowns",
+	  SMART_FIELD(unsafe_shutdowns), EXPORT_SMART_U128 },
+	{ "media_errors", "counter", "Media and data integrity errors",
+	  SMART_FIELD(media_errors), EXPORT_SMART_U128 },
+	{ "error_log_entries", "counter", "Number of error log entries",
+	  SMART_FIELD(num_err_log_entries), EXPORT_SMART_U128 },
+	{ "warning_temperature_time_minutes", "counter",
+	  "Warning composite temperature time",
+	  SMART_FIELD(warning_temp_time), EXPORT_SMART_LE32 },
+	{ "critical_temperature_time_minutes", "counter",
+	  "Critical composite temperature time",
+	  SMART_FIELD(critical_comp_time), EXPORT_SMART_LE32 },
+};
+
+struct export_ctrl {
+	libnvme_ctrl_t c;
+	struct nvme_smart_log *smart;
+	bool smart_valid;
+};
+
+struct export_ctx {
+	struct libnvme_global_ctx *ctx;
+	struct export_ctrl *ctrls;
+	int nr_ctrls;
+	char *doc;
+	size_t doc_len;
+};
+
+static unsigned long long export_now_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static unsigned long long export_ns_stat(libnvme_ns_t n, enum export_stat stat)
+{
+	switch (stat) {
+	case EXPORT_STAT_READ_IOS:
+		return libnvme_ns_get_read_ios(n);
+	case EXPORT_STAT_WRITE_IOS:
+		return libnvme_ns_get_write_ios(n);
+	case EXPORT_STAT_READ_BYTES:
+		return libnvme_ns_get_read_sectors(n) * EXPORT_SECTOR_SIZE;
+	case EXPORT_STAT_WRITE_BYTES:
+		return libnvme_ns_get_write_sectors(n) * EXPORT_SECTOR_SIZE;
+	case EXPORT_STAT_READ_TIME:
+		return libnvme_ns_get_read_ticks(n);
+	case EXPORT_STAT_WRITE_TIME:
+		return libnvme_ns_get_write_ticks(n);
+	case EXPORT_STAT_IO_TIME:
+		return libnvme_ns_get_io_ticks(n);
+	case EXPORT_STAT_INFLIGHTS:
+		return libnvme_ns_get_inflights(n);
+	}
+
+	return 0;
+}
+
+static unsigned long long export_path_stat(libnvme_path_t p,
+		enum export_stat stat)
+{
+	switch (stat) {
+	case EXPORT_STAT_READ_IOS:
+		return libnvme_path_get_read_ios(p);
+	case EXPORT_STAT_WRITE_IOS:
+		return libnvme_path_get_write_ios(p);
+	case EXPORT_STAT_READ_BYTES:
+		return libnvme_path_get_read_sectors(p) * EXPORT_SECTOR_SIZE;
+	case EXPORT_STAT_WRITE_BYTES:
+		return libnvme_path_get_write_sectors(p) * EXPORT_SECTOR_SIZE;
+	case EXPORT_STAT_READ_TIME:
+		return libnvme_path_get_read_ticks(p);
+	case EXPORT_STAT_WRITE_TIME:
+		return libnvme_path_get_write_ticks(p);
+	case EXPORT_STAT_IO_TIME:
+		return libnvme_path_get_io_ticks(p);
+	case EXPORT_STAT_INFLIGHTS:
+		return libnvme_path_get_inflights(p);
+	}
+
+	return 0;
+}
+
+static bool export_stat_is_time(enum export_stat stat)
+{
+	return stat == EXPORT_STAT_READ_TIME ||
+		stat == EXPORT_STAT_WRITE_TIME ||
+		stat == EXPORT_STAT_IO_TIME;
+}
+
+static void export_print_value(FILE *f, enum export_stat stat,
+		unsigned long long val)
+{
+	/* the block layer accounts the I/O time in milliseconds */
+	if (export_stat_is_time(stat))
+		fprintf(f, " %llu.%03llu\n", val / 1000, val % 1000);
+	else
+		fprintf(f, " %llu\n", val);
+}
+
+static void export_print_family(FILE *f, const char *kind, const char *name,
+		const char *type, const char *help)
+{
+	fprintf(f, "# TYPE " EXPORT_PREFIX "%s_%s %s\n", kind, name, type);
+	fprintf(f, "# HELP " EXPORT_PREFIX "%s_%s %s\n", kind, name, help);
+}
+
+static void export_print_sample(FILE *f, const char *kind, const char *name,
+		const char *type)
+{
+	fprintf(f, EXPORT_PREFIX "%s_%s%s", kind, name,
+		strcmp(type, "counter") ? "" : "_total");
+}
+
+/* label values are quoted, with backslash, quote and newline escaped */
+static void export_print_label(FILE *f, const char *sep, const char *name,
+		const char *val)
+{
+	fprintf(f, "%s%s=\"", sep, name);
+	for (; val && *val; val++) {
+		switch (*val) {
+		case '\\':
+			fputs("\\\\", f);
+			break;
+		case '"':
+			fputs("\\\"", f);
+			break;
+		case '\n':
+			fputs("\\n", f);
+			break;
+		default:
+			fputc(*val, f);
+			break;
+		}
+	}
+	fputc('"', f);
+}
+
+static void export_print_ns_labels(FILE *f, libnvme_ns_t n,
+		libnvme_subsystem_t s)
+{
+	char nsid[16];
+
+	snprintf(nsid, sizeof(nsid), "%u", libnvme_ns_get_nsid(n));
+	export_print_label(f, "{", "device", libnvme_ns_get_name(n));
+	export_print_label(f, ",", "nsid", nsid);
+	export_print_label(f, ",", "subsystem", libnvme_subsystem_get_name(s));
+	fputc('}', f);
+}
+
+/*
+ * Namespaces which are reachable over multiple paths are accounted on the
+ * namespace head, whereas the per path stats are available on the paths.
+ * Otherwise the namespaces are only reachable through their controller.
+ */
+static void export_render_ns_stat(FILE *f, struct libnvme_global_ctx *ctx,
+		const struct export_stat_metric *m)
+{
+	libnvme_host_t h;
+	libnvme_subsystem_t s;
+	libnvme_ctrl_t c;
+	libnvme_ns_t n;
+
+	libnvme_for_each_host(ctx, h) {
+		libnvme_for_each_subsystem(h, s) {
+			if (nvme_is_multipath(s)) {
+				libnvme_subsystem_for_each_ns(s, n) {
+					export_print_sample(f, "namespace",
+							    m->name, m->type);
+					export_print_ns_labels(f, n, s);
+					export_print_value(f, m->stat,
+						export_ns_stat(n, m->stat));
+				}
+				continue;
+			}
+
+			libnvme_subsystem_for_each_ctrl(s, c) {
+				libnvme_ctrl_for_each_ns(c, n) {
+					export_print_sample(f, "namespace",
+							    m->name, m->type);
+					export_print_ns_labels(f, n, s);
+					export_print_value(f, m->stat,
+						export_ns_stat(n, m->stat));
+				}
+			}
+		}
+	}
+}
+
+static void export_render_path_stat(FILE *f, struct libnvme_global_ctx *ctx,
+		const struct export_stat_metric *m)
+{
+	libnvme_host_t h;
+	libnvme_subsystem_t s;
+	libnvme_ns_t n;
+	libnvme_path_t p;
+
+	libnvme_for_each_host(ctx, h) {
+		libnvme_for_each_subsystem(h, s) {
+			libnvme_subsystem_for_each_ns(s, n) {
+				libnvme_namespace_for_each_path(n, p) {
+					export_print_sample(f, "path",
+							    m->name, m->type);
+					export_print_label(f, "{", "device",
+						libnvme_path_get_name(p));
+					export_print_label(f, ",", "ctrl",
+						libnvme_ctrl_get_name(
+							libnvme_path_get_ctrl(p)));
+					export_print_label(f, ",", "ana_state",
+						libnvme_path_get_ana_state(p));
+					fputc('}', f);
+					export_print_value(f, m->stat,
+						export_path_stat(p, m->stat));
+				}
+			}
+		}
+	}
+}
+
+static void export_render_smart(FILE *f, struct export_ctx *ectx,
+		const struct export_smart_metric *m)
+{
+	struct export_ctrl *ec;
+	__u8 *field;
+	int i;
+
+	for (i = 0; i < ectx->nr_ctrls; i++) {
+		ec = &ectx->ctrls[i];
+		if (!ec->smart_valid)
+			continue;
+
+		field = (__u8 *)ec->smart + m->offset;
+
+		export_print_sample(f, "smart", m->name, m->type);
+		export_print_label(f, "{", "ctrl", libnvme_ctrl_get_name(ec->c));
+		export_print_label(f, ",", "serial",
+				   libnvme_ctrl_get_serial(ec->c));
+		export_print_label(f, ",", "model",
+				   libnvme_ctrl_get_model(ec->c));
+		fputc('}', f);
+
+		switch (m->fmt) {
+		case EXPORT_SMART_U8:
+			fprintf(f, " %u\n", *field);
+			break;
+		case EXPORT_SMART_TEMP:
+			fprintf(f, " %ld\n",
+				kelvin_to_celsius(field[1] << 8 | field[0]));
+			break;
+		case EXPORT_SMART_LE32:
+			fprintf(f, " %u\n", le32_to_cpu(*(__le32 *)field));
+			break;
+		case EXPORT_SMART_U128:
+			fprintf(f, " %s\n",
+				uint128_t_to_string(le128_to_cpu(field)));
+			break;
+		}
+	}
+}
+
+static int export_render(struct export_ctx *ectx)
+{
+	const struct export_stat_metric *sm;
+	const struct export_smart_metric *hm;
+	char *doc = NULL;
+	size_t len = 0;
+	FILE *f;
+	int i;
+
+	f = open_memstream(&doc, &len);
+	if (!f)
+		return -errno;
+
+	for (i = 0; i < ARRAY_SIZE(export_stat_metrics); i++) {
+		sm = &export_stat_metrics[i];
+		export_print_family(f, "namespace", sm->name, sm->type, sm->help);
+		export_render_ns_stat(f, ectx->ctx, sm);
+	}
+
+	for (i = 0; i < ARRAY_SIZE(export_stat_metrics); i++) {
+		sm = &export_stat_metrics[i];
+		export_print_family(f, "path", sm->name, sm->type, sm->help);
+		export_render_path_stat(f, ectx->ctx, sm);
+	}
+
+	for (i = 0; i < ARRAY_SIZE(export_smart_metrics); i++) {
+		hm = &export_smart_metrics[i];
+		export_print_family(f, "smart", hm->name, hm->type, hm->help);
+		export_render_smart(f, ectx, hm);
+	}
+
+	fprintf(f, "# EOF\n");
+
+	if (fclose(f)) {
+		free(doc);
+		return -errno;
+	}
+
+	free(ectx->doc);
+	ectx->doc = doc;
+	ectx->doc_len = len;
+
+	return 0;
+}
+
+static void export_update_stat(struct libnvme_global_ctx *ctx)
+{
+	libnvme_host_t h;
+	libnvme_subsystem_t s;
+	libnvme_ctrl_t c;
+	libnvme_ns_t n;
+	libnvme_path_t p;
+
+	/*
+	 * The exported counters are absolute, computing rates is left to
+	 * the consumer of the metrics. A namespace which vanished in the
+	 * meantime just keeps its last sampled values.
+	 */
+	libnvme_for_each_host(ctx, h) {
+		libnvme_for_each_subsystem(h, s) {
+			libnvme_subsystem_for_each_ns(s, n) {
+				libnvme_ns_update_stat(n, false);
+				libnvme_namespace_for_each_path(n, p)
+					libnvme_path_update_stat(p, false);
+			}
+			libnvme_subsystem_for_each_ctrl(s, c) {
+				libnvme_ctrl_for_each_ns(c, n)
+					libnvme_ns_update_stat(n, false);
+			}
+		}
+	}
+}
+
+static void export_update_smart(struct export_ctx *ectx)
+{
+	struct libnvme_transport_handle *hdl;
+	struct export_ctrl *ec;
+	int i, err;
+
+	for (i = 0; i < ectx->nr_ctrls; i++) {
+		ec = &ectx->ctrls[i];
+
+		/* the handle is opened once and cached by the ctrl object */
+		hdl = libnvme_ctrl_get_transport_handle(ec->c);
+		if (!hdl) {
+			ec->smart_valid = false;
+			continue;
+		}
+
+		err = nvme_get_log_smart(hdl, NVME_NSID_ALL, ec->smart);
+		if (err)
+			nvme_show_err(err, "smart log (%s)",
+				      libnvme_ctrl_get_name(ec->c));
+		ec->smart_valid = !err;
+	}
+}
+
+static int export_init_ctrls(struct export_ctx *ectx)
+{
+	libnvme_host_t h;
+	libnvme_subsystem_t s;
+	libnvme_ctrl_t c;
+	int i = 0;
+
+	libnvme_for_each_host(ectx->ctx, h)
+		libnvme_for_each_subsystem(h, s)
+			libnvme_subsystem_for_each_ctrl(s, c)
+				ectx->nr_ctrls++;
+
+	ectx->ctrls = calloc(ectx->nr_ctrls ? ectx->nr_ctrls : 1,
+			     sizeof(*ectx->ctrls));
+	if (!ectx->ctrls)
+		return -ENOMEM;
+
+	libnvme_for_each_host(ectx->ctx, h) {
+		libnvme_for_each_subsystem(h, s) {
+			libnvme_subsystem_for_each_ctrl(s, c) {
+				ectx->ctrls[i].c = c;
+				ectx->ctrls[i].smart =
+					libnvme_alloc(sizeof(struct nvme_smart_log));
+				if (!ectx->ctrls[i].smart)
+					return -ENOMEM;
+				i++;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static void export_free(struct export_ctx *ectx)
+{
+	int i;
+
+	for (i = 0; i < ectx->nr_ctrls; i++)
+		libnvme_free(ectx->ctrls[i].smart);
+	free(ectx->ctrls);
+	free(ectx->doc);
+	libnvme_free_global_ctx(ectx->ctx);
+}
+
+/*
+ * Replace @path atomically, a reader such as the node_exporter textfile
+ * collector either sees the previous or the new document but never a
+ * partially written one.
+ */
+static int export_write_file(const char *path, const char *doc, size_t len)
+{
+	__cleanup_free char *tmp = NULL;
+	__cleanup_fd int fd = -1;
+	ssize_t ret;
+	size_t off = 0;
+
+	if (asprintf(&tmp, "%s.%d.tmp", path, getpid()) < 0)
+		return -ENOMEM;
+
+	fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		return -errno;
+
+	while (off < len) {
+		ret = write(fd, doc + off, len - off);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			ret = -errno;
+			unlink(tmp);
+			return ret;
+		}
+		off += ret;
+	}
+
+	if (rename(tmp, path) < 0) {
+		ret = -errno;
+		unlink(tmp);
+		return ret;
+	}
+
+	return 0;
+}
+
+static int export_open_socket(const char *path)
+{
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	int fd;
+
+	if (strlen(path) >= sizeof(addr.sun_path))
+		return -ENAMETOOLONG;
+	strcpy(addr.sun_path, path);
+
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		return -errno;
+
+	unlink(path);
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+	    listen(fd, 8) < 0) {
+		close(fd);
+		return -errno;
+	}
+
+	return fd;
+}
+
+static void export_serve_client(int sock, struct export_ctx *ectx)
+{
+	size_t off = 0;
+	ssize_t ret;
+	int fd;
+
+	fd = accept4(sock, NULL, NULL, SOCK_CLOEXEC);
+	if (fd < 0)
+		return;
+
+	while (ectx->doc && off < ectx->doc_len) {
+		ret = send(fd, ectx->doc + off, ectx->doc_len - off,
+			   MSG_NOSIGNAL);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		off += ret;
+	}
+
+	close(fd);
+}
+
+static int export_publish(struct export_ctx *ectx, const char *file)
+{
+	int err;
+
+	if (!file) {
+		fwrite(ectx->doc, 1, ectx->doc_len, stdout);
+		fflush(stdout);
+		return 0;
+	}
+
+	err = export_write_file(file, ectx->doc, ectx->doc_len);
+	if (err)
+		nvme_show_error("failed to write %s: %s", file,
+				libnvme_strerror(-err));
+	return err;
+}
+
+int export_cmd_option(int argc, char **argv, struct command *acmd,
+		      struct plugin *plugin)
+{
+	const char *desc = "Export block layer stats and SMART / Health "
+		"Information log pages of all NVMe devices in OpenMetrics "
+		"text format. The controllers are kept open between samples.";
+	const char *file = "atomically replace FILE with the metrics after each sample";
+	const char *socket = "serve the latest metrics on unix socket PATH";
+	const char *stat_interval = "block stats sampling interval in seconds";
+	const char *smart_interval = "SMART log sampling interval in seconds";
+	const char *count = "exit after this many block stats samples (0 = run until interrupted)";
+
+	struct export_ctx ectx = { 0 };
+	unsigned long long now, next_stat, next_smart, next;
+	unsigned int samples = 0;
+	int sock = -1, timeout, err;
+	struct pollfd pfd;
+
+	struct config {
+		char		*file;
+		char		*socket;
+		unsigned int	stat_interval;
+		unsigned int	smart_interval;
+		unsigned int	count;
+	};
+
+	struct config cfg = {
+		.file		= NULL,
+		.socket		= NULL,
+		.stat_interval	= 15,
+		.smart_interval	= 60,
+		.count		= 0,
+	};
+
+	NVME_ARGS(opts,
+		  OPT_FILE("output-file",     'O', &cfg.file,           file),
+		  OPT_STRING("socket",        'S', "PATH", &cfg.socket, socket),
+		  OPT_UINT("stat-interval",   'i', &cfg.stat_interval,  stat_interval),
+		  OPT_UINT("smart-interval",  's', &cfg.smart_interval, smart_interval),
+		  OPT_UINT("count",           'c', &cfg.count,          count));
+
+	err = argconfig_parse(argc, argv, desc, opts);
+	if (err)
+		return err;
+
+	if (!cfg.stat_interval || !cfg.smart_interval) {
+		nvme_show_error("sampling intervals must be at least 1 second");
+		return -EINVAL;
+	}
+
+	ectx.ctx = libnvme_create_global_ctx(stderr, log_level);
+	if (!ectx.ctx) {
+		nvme_show_error("Failed to create global context");
+		return -ENOMEM;
+	}
+
+	err = libnvme_scan_topology(ectx.ctx, NULL, NULL);
+	if (err < 0) {
+		nvme_show_error("Failed to scan topology: %s",
+				libnvme_strerror(-err));
+		goto out;
+	}
+
+	err = export_init_ctrls(&ectx);
+	if (err)
+		goto out;
+
+	if (cfg.socket) {
+		sock = export_open_socket(cfg.socket);
+		if (sock < 0) {
+			err = sock;
+			nvme_show_error("failed to listen on %s: %s",
+					cfg.socket, libnvme_strerror(-err));
+			goto out;
+		}
+	}
+
+	next_stat = next_smart = export_now_ms();
+	while (!nvme_sigint_received) {
+		now = export_now_ms();
+
+		if (now >= next_smart) {
+			export_update_smart(&ectx);
+			next_smart = now + cfg.smart_interval * 1000ULL;
+		}
+
+		if (now >= next_stat) {
+			export_update_stat(ectx.ctx);
+			err = export_render(&ectx);
+			if (err)
+				break;
+
+			if (cfg.file || !cfg.socket) {
+				err = export_publish(&ectx, cfg.file);
+				if (err)
+					break;
+			}
+
+			next_stat = now + cfg.stat_interval * 1000ULL;
+			if (cfg.count && ++samples >= cfg.count)
+				break;
+		}
+
+		now = export_now_ms();
+		next = next_stat < next_smart ? next_stat : next_smart;
+		timeout = next > now ? next - now : 0;
+
+		/* a signal interrupts poll(), the loop condition handles it */
+		pfd.fd = sock;
+		pfd.events = POLLIN;
+		if (poll(&pfd, sock >= 0, timeout) > 0 && pfd.revents & POLLIN)
+			export_serve_client(sock, &ectx);
+	}
+
+	if (sock >= 0) {
+		close(sock);
+		unlink(cfg.socket);
+	}
+out:
+	export_free(&ectx);
+	return err;
+}
@@ -0,0 +1,238 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * nvme-ioq.c - in-order passthru queue for large transfers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * The IO passthru path in libnvme is synchronous, so queue depth is
+ * provided by a small pool of threads each blocking in the passthru
+ * ioctl. Submitted requests are put on a FIFO the workers pull from;
+ * completion is tracked per slot so the caller can consume the results
+ * in submission order regardless of the order the device finishes them.
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+#include <libnvme.h>
+
+#include "nvme-ioq.h"
+
+struct nvme_ioq {
+	struct libnvme_transport_handle *hdl;
+	pthread_mutex_t lock;
+	pthread_cond_t work;
+	pthread_cond_t done;
+	pthread_t *workers;
+	unsigned int nr_workers;
+	bool stop;
+
+	struct nvme_ioq_req *fifo_head;
+	struct nvme_ioq_req *fifo_tail;
+
+	struct nvme_ioq_req *reqs;
+	unsigned int nr_reqs;
+	unsigned int head;
+	unsigned int tail;
+	unsigned int pending;
+};
+
+static void *nvme_ioq_worker(void *arg)
+{
+	struct nvme_ioq *q = arg;
+	struct nvme_ioq_req *req;
+	int err;
+
+	pthread_mutex_lock(&q->lock);
+	for (;;) {
+		while (!q->fifo_head && !q->stop)
+			pthread_cond_wait(&q->work, &q->lock);
+		if (!q->fifo_head)
+			break;
+
+		req = q->fifo_head;
+		q->fifo_head = req->fifo_next;
+		if (!q->fifo_head)
+			q->fifo_tail = NULL;
+		pthread_mutex_unlock(&q->lock);
+
+		if (req->admin)
+			err = libnvme_exec_admin_passthru(q->hdl, &req->cmd);
+		else
+			err = libnvme_exec_io_passthru(q->hdl, &req->cmd);
+
+		pthread_mutex_lock(&q->lock);
+		req->err = err;
+		req->state = NVME_IOQ_DONE;
+		pthread_cond_broadcast(&q->done);
+	}
+	pthread_mutex_unlock(&q->lock);
+
+	return NULL;
+}
+
+void nvme_ioq_close(struct nvme_ioq *q)
+{
+	unsigned int i;
+
+	if (!q)
+		return;
+
+	pthread_mutex_lock(&q->lock);
+	q->stop = true;
+	pthread_cond_broadcast(&q->work);
+	pthread_mutex_unlock(&q->lock);
+
+	for (i = 0; i < q->nr_workers; i++)
+		pthread_join(q->workers[i], NULL);
+
+	for (i = 0; i < q->nr_reqs; i++) {
+		libnvme_free(q->reqs[i].buf);
+		libnvme_free(q->reqs[i].mbuf);
+	}
+
+	pthread_cond_destroy(&q->done);
+	pthread_cond_destroy(&q->work);
+	pthread_mutex_destroy(&q->lock);
+	free(q->workers);
+	free(q->reqs);
+	free(q);
+}
+
+int nvme_ioq_open(struct libnvme_transport_handle *hdl, unsigned int depth,
+		  size_t size, size_t msize, struct nvme_ioq **qp)
+{
+	struct nvme_ioq *q;
+	unsigned int i;
+	int err;
+
+	if (!depth)
+		return -EINVAL;
+
+	q = calloc(1, sizeof(*q));
+	if (!q)
+		return -ENOMEM;
+
+	q->hdl = hdl;
+	pthread_mutex_init(&q->lock, NULL);
+	pthread_cond_init(&q->work, NULL);
+	pthread_cond_init(&q->done, NULL);
+
+	q->nr_reqs = depth + 1;
+	q->reqs = calloc(q->nr_reqs, sizeof(*q->reqs));
+	q->workers = calloc(depth, sizeof(*q->workers));
+	if (!q->reqs || !q->workers) {
+		err = -ENOMEM;
+		goto err;
+	}
+
+	for (i = 0; i < q->nr_reqs; i++) {
+		struct nvme_ioq_req *req = &q->reqs[i];
+
+		if (size) {
+			req->buf = libnvme_alloc(size);
+			if (!req->buf) {
+				err = -ENOMEM;
+				goto err;
+			}
+		}
+		if (msize) {
+			req->mbuf = libnvme_alloc(msize);
+			if (!req->mbuf) {
+				err = -ENOMEM;
+				goto err;
+			}
+		}
+	}
+
+	for (i = 0; i < depth; i++) {
+		err = pthread_create(&q->workers[i], NULL, nvme_ioq_worker, q);
+		if (err) {
+			err = -err;
+			goto err;
+		}
+		q->nr_workers++;
+	}
+
+	*qp = q;
+	return 0;
+
+err:
+	nvme_ioq_close(q);
+	return err;
+}
+
+static void nvme_ioq_wait(struct nvme_ioq *q, struct nvme_ioq_req *req)
+{
+	while (req->state == NVME_IOQ_QUEUED)
+		pthread_cond_wait(&q->done, &q->lock);
+}
+
+/*
+ * Hand out the next slot. If the slot still holds an unconsumed request
+ * the call waits for it to complete and returns it with state
+ * NVME_IOQ_DONE; the caller has to consume the result before reusing it.
+ */
+struct nvme_ioq_req *nvme_ioq_next(struct nvme_ioq *q)
+{
+	struct nvme_ioq_req *req = &q->reqs[q->head];
+
+	pthread_mutex_lock(&q->lock);
+	if (q->pending == q->nr_reqs) {
+		nvme_ioq_wait(q, req);
+		q->tail = (q->tail + 1) % q->nr_reqs;
+		q->pending--;
+	} else {
+		req->state = NVME_IOQ_IDLE;
+	}
+	pthread_mutex_unlock(&q->lock);
+
+	q->head = (q->head + 1) % q->nr_reqs;
+
+	return req;
+}
+
+void nvme_ioq_submit(struct nvme_ioq *q, struct nvme_ioq_req *req)
+{
+	pthread_mutex_lock(&q->lock);
+	req->err = 0;
+	req->state = NVME_IOQ_QUEUED;
+	req->fifo_next = NULL;
+	if (q->fifo_tail)
+		q->fifo_tail->fifo_next = req;
+	else
+		q->fifo_head = req;
+	q->fifo_tail = req;
+	q->pending++;
+	pthread_cond_signal(&q->work);
+	pthread_mutex_unlock(&q->lock);
+}
+
+/*
+ * Wait for the oldest outstanding request. Returns NULL once everything
+ * submitted has been reaped.
+ */
+struct nvme_ioq_req *nvme_ioq_reap(struct nvme_ioq *q)
+{
+	struct nvme_ioq_req *req = NULL;
+
+	pthread_mutex_lock(&q->lock);
+	if (q->pending) {
+		req = &q->reqs[q->tail];
+		nvme_ioq_wait(q, req);
+		q->tail = (q->tail + 1) % q->nr_reqs;
+		q->pending--;
+	}
+	pthread_mutex_unlock(&q->lock);
+
+	return req;
+}
@@ -0,0 +1,61 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+#ifndef _NVME_IOQ_H
+#define _NVME_IOQ_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <libnvme.h>
+
+/*
+ * In-order passthru queue.
+ *
+ * The queue owns a ring of request slots, each with its own data and
+ * metadata buffer, and a pool of worker threads which issue the commands
+ * synchronously on a shared transport handle. Up to @depth commands are
+ * outstanding on the device, one extra slot is kept so the caller can
+ * fill (or drain) a buffer while the device is busy with the others.
+ *
+ * Slots are handed out and reaped strictly in submission order, which
+ * keeps file I/O sequential for the callers. A slot returned by
+ * nvme_ioq_next() has to be submitted before asking for the next one:
+ *
+ *	while (more) {
+ *		req = nvme_ioq_next(q);
+ *		if (req->state == NVME_IOQ_DONE)
+ *			consume(req);
+ *		prepare(req);
+ *		nvme_ioq_submit(q, req);
+ *	}
+ *	while ((req = nvme_ioq_reap(q)))
+ *		consume(req);
+ */
+
+enum nvme_ioq_state {
+	NVME_IOQ_IDLE,
+	NVME_IOQ_QUEUED,
+	NVME_IOQ_DONE,
+};
+
+struct nvme_ioq_req {
+	struct libnvme_passthru_cmd cmd;
+	void *buf;
+	void *mbuf;
+	__u64 tag;
+	bool admin;
+	int err;
+	enum nvme_ioq_state state;
+	struct nvme_ioq_req *fifo_next;
+};
+
+struct nvme_ioq;
+
+int nvme_ioq_open(struct libnvme_transport_handle *hdl, unsigned int depth,
+		  size_t size, size_t msize, struct nvme_ioq **q);
+void nvme_ioq_close(struct nvme_ioq *q);
+
+struct nvme_ioq_req *nvme_ioq_next(struct nvme_ioq *q);
+void nvme_ioq_submit(struct nvme_ioq *q, struct nvme_ioq_req *req);
+struct nvme_ioq_req *nvme_ioq_reap(struct nvme_ioq *q);
+
+#endif /* _NVME_IOQ_H */
@@ -0,0 +1,287 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * nvme-log-seg.c - read a large log page into a file in windows
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <ccan/minmax/minmax.h>
+
+#include <libnvme.h>
+
+#include "nvme-ioq.h"
+#include "nvme-log-seg.h"
+#include "nvme-print.h"
+#include "util/cleanup.h"
+#include "util/sighdl.h"
+
+/*
+ * The windows complete in any order, a window read with RAE cleared
+ * could let the log change under the ones still to be read.
+ */
+static void get_log_seg_init_cmd(struct nvme_log_seg *s,
+				 struct libnvme_passthru_cmd *cmd, void *buf,
+				 __u64 off, __u32 len)
+{
+	__u64 lpo = s->lpo + off;
+
+	nvme_init_get_log(cmd, s->nsid, s->lid, s->csi, buf, len);
+	cmd->cdw10 |= NVME_FIELD_ENCODE(s->lsp,
+			NVME_LOG_CDW10_LSP_SHIFT,
+			NVME_LOG_CDW10_LSP_MASK) |
+		      NVME_FIELD_ENCODE(1,
+			NVME_LOG_CDW10_RAE_SHIFT,
+			NVME_LOG_CDW10_RAE_MASK);
+	cmd->cdw11 |= NVME_FIELD_ENCODE(s->lsi,
+			NVME_LOG_CDW11_LSI_SHIFT,
+			NVME_LOG_CDW11_LSI_MASK);
+	cmd->cdw12 = lpo & 0xffffffff;
+	cmd->cdw13 = lpo >> 32;
+	cmd->cdw14 |= NVME_FIELD_ENCODE(s->uidx,
+			NVME_LOG_CDW14_UUID_SHIFT,
+			NVME_LOG_CDW14_UUID_MASK);
+}
+
+/* The first line of the map file identifies the log it belongs to */
+static void get_log_seg_hdr(struct nvme_log_seg *s, char *hdr, size_t size)
+{
+	snprintf(hdr, size, "%#x %#x %#x %#x %#x %#x %"PRIu64" %u %u\n",
+		 s->nsid, s->lid, s->lsp, s->lsi, s->csi, s->uidx,
+		 (uint64_t)s->lpo, s->len, s->xfer);
+}
+
+/* Returns 1 if a matching map was loaded, 0 if there is none */
+static int get_log_seg_load_map(struct nvme_log_seg *s)
+{
+	char hdr[128], line[128];
+	size_t size = (s->nr + 7) / 8;
+	FILE *fp;
+	int err;
+
+	fp = fopen(s->map_file, "r");
+	if (!fp) {
+		if (errno == ENOENT)
+			return 0;
+		err = -errno;
+		nvme_show_perror(s->map_file);
+		return err;
+	}
+
+	get_log_seg_hdr(s, hdr, sizeof(hdr));
+	if (!fgets(line, sizeof(line), fp) || strcmp(line, hdr) ||
+	    fread(s->map, 1, size, fp) != size) {
+		fclose(fp);
+		nvme_show_error("%s does not match this log, remove it to start over",
+				s->map_file);
+		return -EINVAL;
+	}
+	fclose(fp);
+
+	return 1;
+}
+
+static void get_log_seg_save_map(struct nvme_log_seg *s)
+{
+	__cleanup_free char *tmp = NULL;
+	char hdr[128];
+	FILE *fp;
+
+	/* a window is only marked once its data is on disk */
+	if (fdatasync(s->fd)) {
+		nvme_show_perror(s->file);
+		return;
+	}
+
+	if (asprintf(&tmp, "%s.tmp", s->map_file) < 0)
+		return;
+
+	fp = fopen(tmp, "w");
+	if (!fp) {
+		nvme_show_perror(tmp);
+		return;
+	}
+
+	get_log_seg_hdr(s, hdr, sizeof(hdr));
+	fputs(hdr, fp);
+	fwrite(s->map, 1, (s->nr + 7) / 8, fp);
+	if (fclose(fp) || rename(tmp, s->map_file))
+		nvme_show_perror(s->map_file);
+}
+
+static int get_log_seg_complete(struct nvme_log_seg *s,
+				struct nvme_ioq_req *req)
+{
+	__u32 win = req->tag;
+	ssize_t n;
+	int err;
+
+	if (req->err) {
+		nvme_show_error("log page offset %"PRIu64" failed",
+				(uint64_t)s->lpo + (__u64)win * s->xfer);
+		return req->err;
+	}
+
+	n = pwrite(s->fd, req->buf, req->cmd.data_len, (off_t)win * s->xfer);
+	if (n != (ssize_t)req->cmd.data_len) {
+		/* a short write leaves errno alone */
+		if (n >= 0)
+			errno = ENOSPC;
+		err = -errno;
+		nvme_show_perror(s->file);
+		return err;
+	}
+	s->map[win / 8] |= 1 << (win % 8);
+
+	return 0;
+}
+
+/* the log is complete, let the controller clear the event */
+static int get_log_seg_release(struct libnvme_transport_handle *hdl,
+			       struct nvme_log_seg *s)
+{
+	struct libnvme_passthru_cmd cmd;
+	__le32 dw;
+	int err;
+
+	get_log_seg_init_cmd(s, &cmd, &dw, 0, sizeof(dw));
+	cmd.cdw10 &= ~NVME_FIELD_ENCODE(1, NVME_LOG_CDW10_RAE_SHIFT,
+					NVME_LOG_CDW10_RAE_MASK);
+	err = libnvme_exec_admin_passthru(hdl, &cmd);
+	if (err)
+		nvme_show_err(err, "releasing the asynchronous event");
+
+	return err;
+}
+
+int nvme_get_log_segmented(struct libnvme_transport_handle *hdl,
+			   struct nvme_log_seg *s)
+{
+	__cleanup_free char *map_file = NULL;
+	__cleanup_free __u8 *map = NULL;
+	__cleanup_fd int fd = -1;
+	struct nvme_ioq_req *req;
+	__u32 win, left = 0;
+	time_t last, now;
+	struct nvme_ioq *q;
+	int err, ret;
+
+	s->nr = (s->len + s->xfer - 1) / s->xfer;
+	map = calloc((s->nr + 7) / 8, 1);
+	if (!map || asprintf(&map_file, "%s.map", s->file) < 0)
+		return -ENOMEM;
+	s->map = map;
+	s->map_file = map_file;
+
+	ret = get_log_seg_load_map(s);
+	if (ret < 0)
+		return ret;
+
+	/* without a map what is in the file is not known to be the log */
+	fd = open(s->file, ret ? O_WRONLY : O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		err = -errno;
+		nvme_show_perror(s->file);
+		return err;
+	}
+	s->fd = fd;
+
+	if (ftruncate(fd, s->len)) {
+		err = -errno;
+		nvme_show_perror(s->file);
+		return err;
+	}
+
+	for (win = 0; win < s->nr; win++)
+		if (!(s->map[win / 8] & (1 << (win % 8))))
+			left++;
+	if (ret)
+		printf("Resuming, %u of %u windows left\n", left, s->nr);
+
+	err = nvme_ioq_open(hdl, s->depth, s->xfer, 0, &q);
+	if (err) {
+		nvme_show_error("failed to set up admin queue: %s",
+				libnvme_strerror(-err));
+		return err;
+	}
+
+	last = time(NULL);
+	for (win = 0; win < s->nr; win++) {
+		if (s->map[win / 8] & (1 << (win % 8)))
+			continue;
+		if (nvme_sigint_received) {
+			err = -EINTR;
+			break;
+		}
+
+		req = nvme_ioq_next(q);
+		if (req->state == NVME_IOQ_DONE) {
+			err = get_log_seg_complete(s, req);
+			if (err)
+				break;
+		}
+
+		get_log_seg_init_cmd(s, &req->cmd, req->buf,
+				     (__u64)win * s->xfer,
+				     min(s->xfer, s->len - win * s->xfer));
+		req->admin = true;
+		req->tag = win;
+		nvme_ioq_submit(q, req);
+
+		now = time(NULL);
+		if (now != last) {
+			last = now;
+			get_log_seg_save_map(s);
+		}
+	}
+
+	/* drain in order, keep the first error and every window read */
+	while ((req = nvme_ioq_reap(q))) {
+		ret = get_log_seg_complete(s, req);
+		if (ret && !err)
+			err = ret;
+	}
+
+	nvme_ioq_close(q);
+
+	if (err) {
+		get_log_seg_save_map(s);
+		nvme_show_err(err, "log page");
+		nvme_show_error("resume with the same command, progress is kept in %s",
+				s->map_file);
+		return err;
+	}
+
+	if (!s->rae) {
+		err = get_log_seg_release(hdl, s);
+		if (err)
+			return err;
+	}
+
+	if (fsync(fd)) {
+		err = -errno;
+		nvme_show_perror(s->file);
+		return err;
+	}
+	unlink(s->map_file);
+
+	printf("%u bytes of log %#x written to %s\n", s->len, s->lid, s->file);
+
+	return 0;
+}
+
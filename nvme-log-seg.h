@@ -0,0 +1,44 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+#ifndef _NVME_LOG_SEG_H
+#define _NVME_LOG_SEG_H
+
+#include <stdbool.h>
+
+#include <libnvme.h>
+
+/*
+ * Reads a log page in windows of @xfer bytes at increasing offsets, with
+ * up to @depth commands in flight, and writes each window at its offset
+ * in @file. The windows written so far are kept in a bitmap in
+ * <file>.map, so an interrupted read is resumed by running the same
+ * command again.
+ *
+ * Every window is read with Retain Asynchronous Event set, so the log
+ * stays latched however the windows complete. Once all of them are on
+ * disk, one more dword is read with RAE cleared, unless @rae is set.
+ */
+struct nvme_log_seg {
+	__u32 nsid;
+	__u8 lid;
+	__u8 lsp;
+	__u16 lsi;
+	__u8 csi;
+	__u8 uidx;
+	bool rae;
+	__u64 lpo;
+	__u32 len;
+	__u32 xfer;
+	unsigned int depth;
+	const char *file;
+
+	/* state of the read */
+	__u32 nr;
+	__u8 *map;
+	char *map_file;
+	int fd;
+};
+
+int nvme_get_log_segmented(struct libnvme_transport_handle *hdl,
+			   struct nvme_log_seg *s);
+
+#endif /* _NVME_LOG_SEG_H */
@@ -0,0 +1,350 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * nvme-multi.c - run a command on several controllers in parallel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Workers pull the next controller from the list until it is exhausted,
+ * so a slow controller only holds up its own worker. The main thread
+ * waits for them and, if asked to, reports the progress once a second.
+ */
+#include <errno.h>
+#include <fnmatch.h>
+#include <pthread.h>
+#include <regex.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <libnvme.h>
+
+#include "common.h"
+#include "logging.h"
+#include "nvme-multi.h"
+#include "util/cleanup.h"
+#include "util/sighdl.h"
+
+#define NVME_MULTI_STATUS_INTERVAL	1
+
+struct nvme_multi_pool {
+	struct nvme_multi *m;
+	nvme_multi_fn fn;
+	void *arg;
+	pthread_mutex_t lock;
+	pthread_cond_t done;
+	unsigned int next;
+	unsigned int finished;
+};
+
+static const char *nvme_multi_basename(const char *name)
+{
+	const char *p = strrchr(name, '/');
+
+	return p ? p + 1 : name;
+}
+
+int nvme_multi_add(struct nvme_multi *m, const char *name)
+{
+	struct nvme_multi_dev *devs;
+	unsigned int i;
+
+	for (i = 0; i < m->nr; i++)
+		if (!strcmp(nvme_multi_basename(m->devs[i].name),
+			    nvme_multi_basename(name)))
+			return 0;
+
+	devs = realloc(m->devs, (m->nr + 1) * sizeof(*devs));
+	if (!devs)
+		return -ENOMEM;
+	m->devs = devs;
+
+	memset(&devs[m->nr], 0, sizeof(*devs));
+	devs[m->nr].name = strdup(name);
+	if (!devs[m->nr].name)
+		return -ENOMEM;
+	m->nr++;
+
+	return 0;
+}
+
+/* Adds the devices named in @argv, duplicates are dropped */
+int nvme_multi_add_devs(struct nvme_multi *m, int argc, char **argv)
+{
+	int i, err;
+
+	for (i = 0; i < argc; i++) {
+		err = nvme_multi_add(m, argv[i]);
+		if (err)
+			return err;
+	}
+
+	return 0;
+}
+
+/* model and serial numbers are padded with spaces */
+static const char *nvme_multi_trim(char *buf, size_t size, const char *str)
+{
+	size_t len;
+
+	snprintf(buf, size, "%s", str ? str : "");
+	len = strlen(buf);
+	while (len && buf[len - 1] == ' ')
+		buf[--len] = '\0';
+
+	return buf;
+}
+
+typedef bool (*nvme_multi_match_fn)(libnvme_subsystem_t s, libnvme_ctrl_t c,
+				    void *arg);
+
+/* adds the controllers @match accepts, returns how many it did */
+static int nvme_multi_scan(struct nvme_multi *m, nvme_multi_match_fn match,
+			   void *arg)
+{
+	__cleanup_nvme_global_ctx struct libnvme_global_ctx *ctx = NULL;
+	libnvme_subsystem_t s;
+	libnvme_host_t h;
+	libnvme_ctrl_t c;
+	int err, nr = 0;
+
+	ctx = libnvme_create_global_ctx(stderr, log_level);
+	if (!ctx)
+		return -ENOMEM;
+
+	err = libnvme_scan_topology(ctx, NULL, NULL);
+	if (err < 0)
+		return err;
+
+	libnvme_for_each_host(ctx, h) {
+		libnvme_for_each_subsystem(h, s) {
+			libnvme_subsystem_for_each_ctrl(s, c) {
+				if (!libnvme_ctrl_get_name(c) ||
+				    !match(s, c, arg))
+					continue;
+
+				err = nvme_multi_add(m, libnvme_ctrl_get_name(c));
+				if (err)
+					return err;
+				nr++;
+			}
+		}
+	}
+
+	return nr;
+}
+
+static bool nvme_multi_match_model(libnvme_subsystem_t s, libnvme_ctrl_t c,
+				   void *arg)
+{
+	char model[64];
+
+	nvme_multi_trim(model, sizeof(model), libnvme_ctrl_get_model(c));
+
+	return !fnmatch(arg, model, 0);
+}
+
+/*
+ * Adds every controller whose model number matches the shell wildcard
+ * pattern @model. Returns the number of matching controllers.
+ */
+int nvme_multi_add_model(struct nvme_multi *m, const char *model)
+{
+	return nvme_multi_scan(m, nvme_multi_match_model, (void *)model);
+}
+
+struct nvme_multi_filter {
+	regex_t *re;
+	const char *nqn;
+};
+
+static bool nvme_multi_match_filter(libnvme_subsystem_t s, libnvme_ctrl_t c,
+				    void *arg)
+{
+	struct nvme_multi_filter *f = arg;
+	const char *nqn = libnvme_subsystem_get_subsysnqn(s);
+	char model[64], serial[32];
+
+	if (f->nqn && (!nqn || strcmp(f->nqn, nqn)))
+		return false;
+	if (!f->re)
+		return true;
+
+	return !regexec(f->re, libnvme_ctrl_get_name(c), 0, NULL, 0) ||
+	       !regexec(f->re, nvme_multi_trim(model, sizeof(model),
+					       libnvme_ctrl_get_model(c)),
+			0, NULL, 0) ||
+	       !regexec(f->re, nvme_multi_trim(serial, sizeof(serial),
+					       libnvme_ctrl_get_serial(c)),
+			0, NULL, 0);
+}
+
+/*
+ * Adds every controller of the subsystem @nqn, if set, whose name, model
+ * or serial number matches the extended regular expression @regex, if
+ * set. Returns the number of matching controllers.
+ */
+int nvme_multi_add_match(struct nvme_multi *m, const char *regex,
+			 const char *nqn)
+{
+	struct nvme_multi_filter f = { .nqn = nqn };
+	regex_t re;
+	int err;
+
+	if (regex) {
+		if (regcomp(&re, regex, REG_EXTENDED | REG_NOSUB))
+			return -EINVAL;
+		f.re = &re;
+	}
+
+	err = nvme_multi_scan(m, nvme_multi_match_filter, &f);
+
+	if (regex)
+		regfree(&re);
+
+	return err;
+}
+
+void nvme_multi_free(struct nvme_multi *m)
+{
+	unsigned int i;
+
+	for (i = 0; i < m->nr; i++) {
+		free(m->devs[i].name);
+		free(m->devs[i].data);
+	}
+	free(m->devs);
+	m->devs = NULL;
+	m->nr = 0;
+}
+
+void nvme_multi_progress(struct nvme_multi_dev *dev, __u64 done)
+{
+	__atomic_store_n(&dev->done, done, __ATOMIC_RELAXED);
+}
+
+void nvme_multi_get_progress(struct nvme_multi *m, __u64 *done,
+			     __u64 *total, unsigned int *finished)
+{
+	unsigned int i;
+
+	*done = *total = 0;
+	*finished = 0;
+	for (i = 0; i < m->nr; i++) {
+		*done += __atomic_load_n(&m->devs[i].done, __ATOMIC_RELAXED);
+		*total += m->devs[i].total;
+		if (__atomic_load_n(&m->devs[i].finished, __ATOMIC_ACQUIRE))
+			(*finished)++;
+	}
+}
+
+static void *nvme_multi_worker(void *arg)
+{
+	struct nvme_multi_pool *pool = arg;
+	struct nvme_multi_dev *dev;
+	int err;
+
+	pthread_mutex_lock(&pool->lock);
+	while (pool->next < pool->m->nr) {
+		dev = &pool->m->devs[pool->next++];
+		pthread_mutex_unlock(&pool->lock);
+
+		/* controllers not started yet are skipped on SIGINT */
+		if (nvme_sigint_received)
+			err = -EINTR;
+		else
+			err = pool->fn(dev, pool->arg);
+
+		pthread_mutex_lock(&pool->lock);
+		dev->err = err;
+		__atomic_store_n(&dev->finished, true, __ATOMIC_RELEASE);
+		pool->finished++;
+		pthread_cond_broadcast(&pool->done);
+	}
+	pthread_mutex_unlock(&pool->lock);
+
+	return NULL;
+}
+
+/*
+ * Calls @fn for every controller with up to @jobs of them in parallel,
+ * and @status (if set) once a second and after the last one finished.
+ * Returns the error of the first controller which failed, in list order.
+ */
+int nvme_multi_run(struct nvme_multi *m, unsigned int jobs, nvme_multi_fn fn,
+		   void *arg, nvme_multi_status_fn status)
+{
+	struct nvme_multi_pool pool = {
+		.m = m,
+		.fn = fn,
+		.arg = arg,
+	};
+	__cleanup_free pthread_t *threads = NULL;
+	unsigned int i, nr_threads = 0;
+	struct timespec ts;
+	int err = 0;
+
+	if (!m->nr || !jobs)
+		return -EINVAL;
+
+	jobs = min(jobs, m->nr);
+	threads = calloc(jobs, sizeof(*threads));
+	if (!threads)
+		return -ENOMEM;
+
+	pthread_mutex_init(&pool.lock, NULL);
+	pthread_cond_init(&pool.done, NULL);
+
+	for (i = 0; i < jobs; i++) {
+		err = pthread_create(&threads[i], NULL, nvme_multi_worker, &pool);
+		if (err)
+			break;
+		nr_threads++;
+	}
+
+	if (!nr_threads) {
+		err = -err;
+		goto out;
+	}
+	err = 0;
+
+	pthread_mutex_lock(&pool.lock);
+	while (pool.finished < m->nr) {
+		if (!status) {
+			pthread_cond_wait(&pool.done, &pool.lock);
+			continue;
+		}
+
+		pthread_mutex_unlock(&pool.lock);
+		status(m, arg);
+		pthread_mutex_lock(&pool.lock);
+
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_sec += NVME_MULTI_STATUS_INTERVAL;
+		pthread_cond_timedwait(&pool.done, &pool.lock, &ts);
+	}
+	pthread_mutex_unlock(&pool.lock);
+
+	for (i = 0; i < nr_threads; i++)
+		pthread_join(threads[i], NULL);
+
+	if (status)
+		status(m, arg);
+
+	for (i = 0; i < m->nr && !err; i++)
+		err = m->devs[i].err;
+
+out:
+	pthread_cond_destroy(&pool.done);
+	pthread_mutex_destroy(&pool.lock);
+
+	return err;
+}
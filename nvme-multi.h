@@ -0,0 +1,61 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+#ifndef _NVME_MULTI_H
+#define _NVME_MULTI_H
+
+#include <stdbool.h>
+
+#include <libnvme.h>
+
+/*
+ * Runs a command on several controllers at once.
+ *
+ * The controllers are the devices named on the command line and, if
+ * asked for, all controllers whose model number matches a pattern or
+ * which pass a regular expression and subsystem NQN filter. Each
+ * controller is handled by a worker thread; at most @jobs of them run at
+ * the same time. Workers open their own global context and transport
+ * handle, so nothing is shared between them but the caller's argument.
+ * The result of every controller is kept for the caller to report once
+ * all of them are done:
+ *
+ *	nvme_multi_add_devs(&m, argc, argv);
+ *	nvme_multi_add_model(&m, model);
+ *	err = nvme_multi_run(&m, jobs, fn, arg, status);
+ *	for (i = 0; i < m.nr; i++)
+ *		report(&m.devs[i]);
+ *	nvme_multi_free(&m);
+ */
+
+struct nvme_multi_dev {
+	char *name;
+	int err;
+	__u32 result;	/* completion dword 0, if the command has one */
+	__u64 done;	/* progress, updated with nvme_multi_progress() */
+	__u64 total;
+	bool finished;
+	void *data;	/* result of the command, freed with the list */
+};
+
+struct nvme_multi {
+	struct nvme_multi_dev *devs;
+	unsigned int nr;
+};
+
+typedef int (*nvme_multi_fn)(struct nvme_multi_dev *dev, void *arg);
+typedef void (*nvme_multi_status_fn)(struct nvme_multi *m, void *arg);
+
+int nvme_multi_add(struct nvme_multi *m, const char *name);
+int nvme_multi_add_devs(struct nvme_multi *m, int argc, char **argv);
+int nvme_multi_add_model(struct nvme_multi *m, const char *model);
+int nvme_multi_add_match(struct nvme_multi *m, const char *regex,
+			 const char *nqn);
+void nvme_multi_free(struct nvme_multi *m);
+
+int nvme_multi_run(struct nvme_multi *m, unsigned int jobs, nvme_multi_fn fn,
+		   void *arg, nvme_multi_status_fn status);
+
+void nvme_multi_progress(struct nvme_multi_dev *dev, __u64 done);
+void nvme_multi_get_progress(struct nvme_multi *m, __u64 *done,
+			     __u64 *total, unsigned int *finished);
+
+#endif /* _NVME_MULTI_H */
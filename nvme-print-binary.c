@@ -26,6 +26,20 @@ static void binary_persistent_event_log(void *pevent_log_info,
 	d_raw((unsigned char *)pevent_log_info, size);
 }
 
+static void binary_persistent_event_log_start(
+	struct nvme_persistent_event_log *pevent_log_head, __u8 action,
+	const char *devname, struct json_object **events)
+{
+	d_raw((unsigned char *)pevent_log_head, sizeof(*pevent_log_head));
+}
+
+static void binary_persistent_event_entries(void *pevent_entries,
+	__u32 nr, __u32 size, __u32 first, const char *devname,
+	struct json_object *events)
+{
+	d_raw((unsigned char *)pevent_entries, size);
+}
+
 static void binary_endurance_group_event_agg_log(
 	struct nvme_aggregate_endurance_group_event *endurance_log,
 	__u64 log_entries, __u32 size, const char *devname)
@@ -399,6 +413,9 @@ static struct print_ops binary_print_ops = {
 	.ns_list_log			= binary_changed_ns_list_log,
 	.nvm_id_ns			= binary_nvm_id_ns,
 	.persistent_event_log		= binary_persistent_event_log,
+	.persistent_event_log_start	= binary_persistent_event_log_start,
+	.persistent_event_entries	= binary_persistent_event_entries,
+	.persistent_event_log_finish	= NULL,
 	.predictable_latency_event_agg_log = binary_predictable_latency_event_agg_log,
 	.predictable_latency_per_nvmset	= binary_predictable_latency_per_nvmset,
 	.primary_ctrl_cap		= binary_primary_ctrl_cap,
@@ -426,6 +443,8 @@ static struct print_ops binary_print_ops = {
 	.d				= NULL,
 	.show_init			= NULL,
 	.show_finish			= NULL,
+	.show_device			= NULL,
+	.show_devices_finish		= NULL,
 	.mgmt_addr_list_log		= binary_mgmt_addr_list_log,
 	.rotational_media_info_log	= binary_rotational_media_info_log,
 	.dispersed_ns_psub_log		= binary_dispersed_ns_psub_log,
@@ -0,0 +1,598 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <libnvme.h>
+
+#include "nvme-print.h"
+#include "util/cbor.h"
+#include "common.h"
+
+/*
+ * Self-describing CBOR (RFC 8949) output. Every printed structure is one
+ * tagged map, fields keep their integer types and 128-bit counters are
+ * encoded as integers or bignums instead of decimal strings. Repeated
+ * invocations produce a CBOR sequence (RFC 8742).
+ */
+
+static struct print_ops cbor_print_ops;
+
+static void cbor_begin(void)
+{
+	cbor_put_tag(stdout, CBOR_SELF_DESCRIBE);
+	cbor_open_map(stdout);
+}
+
+static void cbor_end(void)
+{
+	cbor_put_break(stdout);
+	fflush(stdout);
+}
+
+static void map_add_key(const char *k)
+{
+	cbor_put_text(stdout, k);
+}
+
+static void map_add_uint(const char *k, uint64_t v)
+{
+	map_add_key(k);
+	cbor_put_uint(stdout, v);
+}
+
+static void map_add_uint128(const char *k, __u8 *v)
+{
+	map_add_key(k);
+	cbor_put_uint128(stdout, v);
+}
+
+static void map_add_str(const char *k, const char *v)
+{
+	map_add_key(k);
+	cbor_put_text(stdout, v);
+}
+
+static void map_add_strn(const char *k, const char *v, size_t len)
+{
+	map_add_key(k);
+	cbor_put_textn(stdout, v, len);
+}
+
+static void map_add_bytes(const char *k, const void *v, size_t len)
+{
+	map_add_key(k);
+	cbor_put_bytes(stdout, v, len);
+}
+
+static void map_open_array(const char *k)
+{
+	map_add_key(k);
+	cbor_open_array(stdout);
+}
+
+static void cbor_smart_log(struct nvme_smart_log *smart, unsigned int nsid,
+			   const char *devname)
+{
+	int c;
+
+	cbor_begin();
+
+	map_add_str("device", devname);
+	map_add_uint("nsid", nsid);
+	map_add_uint("critical_warning", smart->critical_warning);
+	map_add_uint("temperature", smart->temperature[1] << 8 | smart->temperature[0]);
+	map_add_uint("avail_spare", smart->avail_spare);
+	map_add_uint("spare_thresh", smart->spare_thresh);
+	map_add_uint("percent_used", smart->percent_used);
+	map_add_uint("endurance_grp_critical_warning_summary",
+		     smart->endu_grp_crit_warn_sumry);
+	map_add_uint128("data_units_read", smart->data_units_read);
+	map_add_uint128("data_units_written", smart->data_units_written);
+	map_add_uint128("host_read_commands", smart->host_reads);
+	map_add_uint128("host_write_commands", smart->host_writes);
+	map_add_uint128("controller_busy_time", smart->ctrl_busy_time);
+	map_add_uint128("power_cycles", smart->power_cycles);
+	map_add_uint128("power_on_hours", smart->power_on_hours);
+	map_add_uint128("unsafe_shutdowns", smart->unsafe_shutdowns);
+	map_add_uint128("media_errors", smart->media_errors);
+	map_add_uint128("num_err_log_entries", smart->num_err_log_entries);
+	map_add_uint("warning_temp_time", le32_to_cpu(smart->warning_temp_time));
+	map_add_uint("critical_comp_time", le32_to_cpu(smart->critical_comp_time));
+
+	map_open_array("temperature_sensors");
+	for (c = 0; c < 8; c++)
+		cbor_put_uint(stdout, le16_to_cpu(smart->temp_sensor[c]));
+	cbor_put_break(stdout);
+
+	map_add_uint("thm_temp1_trans_count", le32_to_cpu(smart->thm_temp1_trans_count));
+	map_add_uint("thm_temp2_trans_count", le32_to_cpu(smart->thm_temp2_trans_count));
+	map_add_uint("thm_temp1_total_time", le32_to_cpu(smart->thm_temp1_total_time));
+	map_add_uint("thm_temp2_total_time", le32_to_cpu(smart->thm_temp2_total_time));
+	map_add_uint("op_lifetime_energy_consumed",
+		     le64_to_cpu(smart->op_lifetime_energy_consumed));
+	map_add_uint("interval_power_measurement",
+		     le32_to_cpu(smart->interval_power_measurement));
+
+	cbor_end();
+}
+
+static void cbor_error_log(struct nvme_error_log_page *err_log, int entries,
+			   const char *devname,
+			   struct nvme_error_log_filter *flt)
+{
+	struct nvme_error_log_page *e;
+	int i;
+
+	cbor_begin();
+
+	map_add_str("device", devname);
+	map_open_array("errors");
+
+	for (i = 0; i < entries; i++) {
+		e = &err_log[i];
+		if (nvme_is_error_log_filter(e, flt))
+			continue;
+
+		cbor_open_map(stdout);
+		map_add_uint("error_count", le64_to_cpu(e->error_count));
+		map_add_uint("sqid", le16_to_cpu(e->sqid));
+		map_add_uint("cmdid", le16_to_cpu(e->cmdid));
+		map_add_uint("status_field", le16_to_cpu(e->status_field));
+		map_add_uint("parm_error_location", le16_to_cpu(e->parm_error_location));
+		map_add_uint("lba", le64_to_cpu(e->lba));
+		map_add_uint("nsid", le32_to_cpu(e->nsid));
+		map_add_uint("vs", e->vs);
+		map_add_uint("trtype", e->trtype);
+		map_add_uint("csi", e->csi);
+		map_add_uint("opcode", e->opcode);
+		map_add_uint("cs", le64_to_cpu(e->cs));
+		map_add_uint("trtype_spec_info", le16_to_cpu(e->trtype_spec_info));
+		map_add_uint("log_page_version", e->log_page_version);
+		cbor_put_break(stdout);
+	}
+
+	cbor_put_break(stdout);
+	cbor_end();
+}
+
+static void cbor_fw_log(struct nvme_firmware_slot *fw_log, const char *devname)
+{
+	int i;
+
+	cbor_begin();
+
+	map_add_str("device", devname);
+	map_add_uint("afi", fw_log->afi);
+	map_open_array("frs");
+
+	for (i = 0; i < 7; i++) {
+		if (!fw_log->frs[i][0])
+			continue;
+
+		cbor_open_map(stdout);
+		map_add_uint("slot", i + 1);
+		map_add_strn("revision", fw_log->frs[i], sizeof(fw_log->frs[i]));
+		cbor_put_break(stdout);
+	}
+
+	cbor_put_break(stdout);
+	cbor_end();
+}
+
+static void cbor_self_test_log(struct nvme_self_test_log *self_test, __u8 dst_entries,
+			       __u32 size, const char *devname)
+{
+	__u32 num_entries = min(dst_entries, NVME_LOG_ST_MAX_RESULTS);
+	struct nvme_st_result *res;
+	int i;
+
+	cbor_begin();
+
+	map_add_str("device", devname);
+	map_add_uint("current_operation", self_test->current_operation);
+	map_add_uint("completion", self_test->completion);
+	map_open_array("results");
+
+	for (i = 0; i < num_entries; i++) {
+		res = &self_test->result[i];
+
+		cbor_open_map(stdout);
+		map_add_uint("result", res->dsts & 0xf);
+		if ((res->dsts & 0xf) != 0xf) {
+			map_add_uint("code", res->dsts >> 4);
+			map_add_uint("seg", res->seg);
+			map_add_uint("vdi", res->vdi);
+			map_add_uint("poh", le64_to_cpu(res->poh));
+			if (res->vdi & NVME_ST_VALID_DIAG_INFO_NSID)
+				map_add_uint("nsid", le32_to_cpu(res->nsid));
+			if (res->vdi & NVME_ST_VALID_DIAG_INFO_FLBA)
+				map_add_uint("flba", le64_to_cpu(res->flba));
+			if (res->vdi & NVME_ST_VALID_DIAG_INFO_SCT)
+				map_add_uint("sct", res->sct);
+			if (res->vdi & NVME_ST_VALID_DIAG_INFO_SC)
+				map_add_uint("sc", res->sc);
+			map_add_uint("vs", res->vs[1] << 8 | res->vs[0]);
+		}
+		cbor_put_break(stdout);
+	}
+
+	cbor_put_break(stdout);
+	cbor_end();
+}
+
+static void cbor_sanitize_log(struct nvme_sanitize_log_page *sanitize_log,
+			      const char *devname)
+{
+	cbor_begin();
+
+	map_add_str("device", devname);
+	map_add_uint("sprog", le16_to_cpu(sanitize_log->sprog));
+	map_add_uint("sstat", le16_to_cpu(sanitize_log->sstat));
+	map_add_uint("scdw10", le32_to_cpu(sanitize_log->scdw10));
+	map_add_uint("eto", le32_to_cpu(sanitize_log->eto));
+	map_add_uint("etbe", le32_to_cpu(sanitize_log->etbe));
+	map_add_uint("etce", le32_to_cpu(sanitize_log->etce));
+	map_add_uint("etond", le32_to_cpu(sanitize_log->etond));
+	map_add_uint("etbend", le32_to_cpu(sanitize_log->etbend));
+	map_add_uint("etcend", le32_to_cpu(sanitize_log->etcend));
+	map_add_uint("etpvds", le32_to_cpu(sanitize_log->etpvds));
+	map_add_uint("ssi", sanitize_log->ssi);
+
+	cbor_end();
+}
+
+static void cbor_ana_log(struct nvme_ana_log *ana_log, const char *devname,
+			 size_t len)
+{
+	size_t offset = sizeof(*ana_log);
+	struct nvme_ana_group_desc *desc;
+	void *base = ana_log;
+	__u32 nr_nsids, j;
+	int i;
+
+	cbor_begin();
+
+	map_add_str("device", devname);
+	map_add_uint("chgcnt", le64_to_cpu(ana_log->chgcnt));
+	map_add_uint("ngrps", le16_to_cpu(ana_log->ngrps));
+	map_open_array("groups");
+
+	for (i = 0; i < le16_to_cpu(ana_log->ngrps); i++) {
+		if (offset + sizeof(*desc) > len)
+			break;
+
+		desc = base + offset;
+		nr_nsids = le32_to_cpu(desc->nnsids);
+		offset += sizeof(*desc);
+
+		cbor_open_map(stdout);
+		map_add_uint("grpid", le32_to_cpu(desc->grpid));
+		map_add_uint("nnsids", nr_nsids);
+		map_add_uint("chgcnt", le64_to_cpu(desc->chgcnt));
+		map_add_uint("state", desc->state);
+		map_open_array("nsids");
+		for (j = 0; j < nr_nsids && offset + sizeof(__le32) <= len; j++) {
+			cbor_put_uint(stdout, le32_to_cpu(desc->nsids[j]));
+			offset += sizeof(__le32);
+		}
+		cbor_put_break(stdout);
+		cbor_put_break(stdout);
+	}
+
+	cbor_put_break(stdout);
+	cbor_end();
+}
+
+static void cbor_id_ctrl(struct nvme_id_ctrl *ctrl, const char *product_name,
+			 void (*vs)(__u8 *vs, struct json_object *root))
+{
+	__u32 ieee = ctrl->ieee[2] << 16 | ctrl->ieee[1] << 8 | ctrl->ieee[0];
+	struct nvme_id_psd *psd;
+	int i;
+
+	cbor_begin();
+
+	if (product_name)
+		map_add_str("product_name", product_name);
+
+	map_add_uint("vid", le16_to_cpu(ctrl->vid));
+	map_add_uint("ssvid", le16_to_cpu(ctrl->ssvid));
+	map_add_strn("sn", ctrl->sn, sizeof(ctrl->sn));
+	map_add_strn("mn", ctrl->mn, sizeof(ctrl->mn));
+	map_add_strn("fr", ctrl->fr, sizeof(ctrl->fr));
+	map_add_uint("rab", ctrl->rab);
+	map_add_uint("ieee", ieee);
+	map_add_uint("cmic", ctrl->cmic);
+	map_add_uint("mdts", ctrl->mdts);
+	map_add_uint("cntlid", le16_to_cpu(ctrl->cntlid));
+	map_add_uint("ver", le32_to_cpu(ctrl->ver));
+	map_add_uint("rtd3r", le32_to_cpu(ctrl->rtd3r));
+	map_add_uint("rtd3e", le32_to_cpu(ctrl->rtd3e));
+	map_add_uint("oaes", le32_to_cpu(ctrl->oaes));
+	map_add_uint("ctratt", le32_to_cpu(ctrl->ctratt));
+	map_add_uint("rrls", le16_to_cpu(ctrl->rrls));
+	map_add_uint("bpcap", ctrl->bpcap);
+	map_add_uint("nssl", le32_to_cpu(ctrl->nssl));
+	map_add_uint("plsi", ctrl->plsi);
+	map_add_uint("cntrltype", ctrl->cntrltype);
+	map_add_bytes("fguid", ctrl->fguid, sizeof(ctrl->fguid));
+	map_add_uint("crdt1", le16_to_cpu(ctrl->crdt1));
+	map_add_uint("crdt2", le16_to_cpu(ctrl->crdt2));
+	map_add_uint("crdt3", le16_to_cpu(ctrl->crdt3));
+	map_add_uint("crcap", ctrl->crcap);
+	map_add_uint("nvmsr", ctrl->nvmsr);
+	map_add_uint("vwci", ctrl->vwci);
+	map_add_uint("mec", ctrl->mec);
+	map_add_uint("oacs", le16_to_cpu(ctrl->oacs));
+	map_add_uint("acl", ctrl->acl);
+	map_add_uint("aerl", ctrl->aerl);
+	map_add_uint("frmw", ctrl->frmw);
+	map_add_uint("lpa", ctrl->lpa);
+	map_add_uint("elpe", ctrl->elpe);
+	map_add_uint("npss", ctrl->npss);
+	map_add_uint("avscc", ctrl->avscc);
+	map_add_uint("apsta", ctrl->apsta);
+	map_add_uint("wctemp", le16_to_cpu(ctrl->wctemp));
+	map_add_uint("cctemp", le16_to_cpu(ctrl->cctemp));
+	map_add_uint("mtfa", le16_to_cpu(ctrl->mtfa));
+	map_add_uint("hmpre", le32_to_cpu(ctrl->hmpre));
+	map_add_uint("hmmin", le32_to_cpu(ctrl->hmmin));
+	map_add_uint128("tnvmcap", ctrl->tnvmcap);
+	map_add_uint128("unvmcap", ctrl->unvmcap);
+	map_add_uint("rpmbs", le32_to_cpu(ctrl->rpmbs));
+	map_add_uint("edstt", le16_to_cpu(ctrl->edstt));
+	map_add_uint("dsto", ctrl->dsto);
+	map_add_uint("fwug", ctrl->fwug);
+	map_add_uint("kas", le16_to_cpu(ctrl->kas));
+	map_add_uint("hctma", le16_to_cpu(ctrl->hctma));
+	map_add_uint("mntmt", le16_to_cpu(ctrl->mntmt));
+	map_add_uint("mxtmt", le16_to_cpu(ctrl->mxtmt));
+	map_add_uint("sanicap", le32_to_cpu(ctrl->sanicap));
+	map_add_uint("hmminds", le32_to_cpu(ctrl->hmminds));
+	map_add_uint("hmmaxd", le16_to_cpu(ctrl->hmmaxd));
+	map_add_uint("nsetidmax", le16_to_cpu(ctrl->nsetidmax));
+	map_add_uint("endgidmax", le16_to_cpu(ctrl->endgidmax));
+	map_add_uint("anatt", ctrl->anatt);
+	map_add_uint("anacap", ctrl->anacap);
+	map_add_uint("anagrpmax", le32_to_cpu(ctrl->anagrpmax));
+	map_add_uint("nanagrpid", le32_to_cpu(ctrl->nanagrpid));
+	map_add_uint("pels", le32_to_cpu(ctrl->pels));
+	map_add_uint("domainid", le16_to_cpu(ctrl->domainid));
+	map_add_uint("kpioc", ctrl->kpioc);
+	map_add_uint("mptfawr", le16_to_cpu(ctrl->mptfawr));
+	map_add_uint128("megcap", ctrl->megcap);
+	map_add_uint("tmpthha", ctrl->tmpthha);
+	map_add_uint("cqt", le16_to_cpu(ctrl->cqt));
+	map_add_uint("cdpa", le16_to_cpu(ctrl->cdpa));
+	map_add_uint("mup", le16_to_cpu(ctrl->mup));
+	map_add_uint("ipmsr", le16_to_cpu(ctrl->ipmsr));
+	map_add_uint("msmt", le16_to_cpu(ctrl->msmt));
+	map_add_uint("sqes", ctrl->sqes);
+	map_add_uint("cqes", ctrl->cqes);
+	map_add_uint("maxcmd", le16_to_cpu(ctrl->maxcmd));
+	map_add_uint("nn", le32_to_cpu(ctrl->nn));
+	map_add_uint("oncs", le16_to_cpu(ctrl->oncs));
+	map_add_uint("fuses", le16_to_cpu(ctrl->fuses));
+	map_add_uint("fna", ctrl->fna);
+	map_add_uint("vwc", ctrl->vwc);
+	map_add_uint("awun", le16_to_cpu(ctrl->awun));
+	map_add_uint("awupf", le16_to_cpu(ctrl->awupf));
+	map_add_uint("icsvscc", ctrl->icsvscc);
+	map_add_uint("nwpc", ctrl->nwpc);
+	map_add_uint("acwu", le16_to_cpu(ctrl->acwu));
+	map_add_uint("ocfs", le16_to_cpu(ctrl->ocfs));
+	map_add_uint("sgls", le32_to_cpu(ctrl->sgls));
+	map_add_uint("mnan", le32_to_cpu(ctrl->mnan));
+	map_add_uint128("maxdna", ctrl->maxdna);
+	map_add_uint("maxcna", le32_to_cpu(ctrl->maxcna));
+	map_add_uint("oaqd", le32_to_cpu(ctrl->oaqd));
+	map_add_uint("rhiri", ctrl->rhiri);
+	map_add_uint("hirt", ctrl->hirt);
+	map_add_uint("cmmrtd", le16_to_cpu(ctrl->cmmrtd));
+	map_add_uint("nmmrtd", le16_to_cpu(ctrl->nmmrtd));
+	map_add_uint("minmrtg", ctrl->minmrtg);
+	map_add_uint("maxmrtg", ctrl->maxmrtg);
+	map_add_uint("trattr", ctrl->trattr);
+	map_add_uint("mcudmq", le16_to_cpu(ctrl->mcudmq));
+	map_add_uint("mnsudmq", le16_to_cpu(ctrl->mnsudmq));
+	map_add_uint("mcmr", le16_to_cpu(ctrl->mcmr));
+	map_add_uint("nmcmr", le16_to_cpu(ctrl->nmcmr));
+	map_add_uint("mcdqpc", le16_to_cpu(ctrl->mcdqpc));
+	map_add_strn("subnqn", ctrl->subnqn, sizeof(ctrl->subnqn));
+	map_add_uint("ioccsz", le32_to_cpu(ctrl->ioccsz));
+	map_add_uint("iorcsz", le32_to_cpu(ctrl->iorcsz));
+	map_add_uint("icdoff", le16_to_cpu(ctrl->icdoff));
+	map_add_uint("fcatt", ctrl->fcatt);
+	map_add_uint("msdbd", ctrl->msdbd);
+	map_add_uint("ofcs", le16_to_cpu(ctrl->ofcs));
+	map_add_uint("dctype", ctrl->dctype);
+	map_add_uint("ccrl", ctrl->ccrl);
+
+	map_open_array("psds");
+	for (i = 0; i <= ctrl->npss; i++) {
+		psd = &ctrl->psd[i];
+
+		cbor_open_map(stdout);
+		map_add_uint("max_power", le16_to_cpu(psd->mp));
+		map_add_uint("flags", psd->flags);
+		map_add_uint("entry_lat", le32_to_cpu(psd->enlat));
+		map_add_uint("exit_lat", le32_to_cpu(psd->exlat));
+		map_add_uint("read_tput", psd->rrt);
+		map_add_uint("read_lat", psd->rrl);
+		map_add_uint("write_tput", psd->rwt);
+		map_add_uint("write_lat", psd->rwl);
+		map_add_uint("idle_power", le16_to_cpu(psd->idlp));
+		map_add_uint("idle_scale", nvme_psd_power_scale(psd->ips));
+		map_add_uint("active_power", le16_to_cpu(psd->actp));
+		map_add_uint("active_power_work", psd->apws & 7);
+		map_add_uint("active_scale", nvme_psd_power_scale(psd->apws));
+		cbor_put_break(stdout);
+	}
+	cbor_put_break(stdout);
+
+	map_add_bytes("vs", ctrl->vs, sizeof(ctrl->vs));
+
+	cbor_end();
+}
+
+static void cbor_id_ns(struct nvme_id_ns *ns, unsigned int nsid,
+		       unsigned int lba_index, bool cap_only)
+{
+	__u8 flbas;
+	int i;
+
+	nvme_id_ns_flbas_to_lbaf_inuse(ns->flbas, &flbas);
+
+	cbor_begin();
+
+	map_add_uint("nsid", nsid);
+
+	if (!cap_only) {
+		map_add_uint("nsze", le64_to_cpu(ns->nsze));
+		map_add_uint("ncap", le64_to_cpu(ns->ncap));
+		map_add_uint("nuse", le64_to_cpu(ns->nuse));
+		map_add_uint("nsfeat", ns->nsfeat);
+		map_add_uint("flbas", ns->flbas);
+		map_add_uint("dps", ns->dps);
+		map_add_uint("nmic", ns->nmic);
+		map_add_uint("rescap", ns->rescap);
+		map_add_uint("fpi", ns->fpi);
+		map_add_uint("dlfeat", ns->dlfeat);
+		map_add_uint("nawun", le16_to_cpu(ns->nawun));
+		map_add_uint("nawupf", le16_to_cpu(ns->nawupf));
+		map_add_uint("nacwu", le16_to_cpu(ns->nacwu));
+		map_add_uint("nabsn", le16_to_cpu(ns->nabsn));
+		map_add_uint("nabo", le16_to_cpu(ns->nabo));
+		map_add_uint("nabspf", le16_to_cpu(ns->nabspf));
+		map_add_uint("noiob", le16_to_cpu(ns->noiob));
+		map_add_uint128("nvmcap", ns->nvmcap);
+		map_add_uint("npwg", le16_to_cpu(ns->npwg));
+		map_add_uint("npwa", le16_to_cpu(ns->npwa));
+		map_add_uint("npdg", le16_to_cpu(ns->npdg));
+		map_add_uint("npda", le16_to_cpu(ns->npda));
+		map_add_uint("nows", le16_to_cpu(ns->nows));
+		map_add_uint("mssrl", le16_to_cpu(ns->mssrl));
+		map_add_uint("mcl", le32_to_cpu(ns->mcl));
+		map_add_uint("msrc", ns->msrc);
+		map_add_uint("kpios", ns->kpios);
+		map_add_uint("kpiodaag", le32_to_cpu(ns->kpiodaag));
+		map_add_uint("anagrpid", le32_to_cpu(ns->anagrpid));
+		map_add_uint("nsattr", ns->nsattr);
+		map_add_uint("nvmsetid", le16_to_cpu(ns->nvmsetid));
+		map_add_uint("endgid", le16_to_cpu(ns->endgid));
+		map_add_bytes("nguid", ns->nguid, sizeof(ns->nguid));
+		map_add_bytes("eui64", ns->eui64, sizeof(ns->eui64));
+	}
+
+	map_add_uint("nlbaf", ns->nlbaf);
+	map_add_uint("mc", ns->mc);
+	map_add_uint("dpc", ns->dpc);
+	map_add_uint("nulbaf", ns->nulbaf);
+
+	map_open_array("lbafs");
+	for (i = 0; i <= ns->nlbaf; i++) {
+		cbor_open_map(stdout);
+		map_add_uint("ms", le16_to_cpu(ns->lbaf[i].ms));
+		map_add_uint("ds", ns->lbaf[i].ds);
+		map_add_uint("rp", ns->lbaf[i].rp);
+		map_add_key("in_use");
+		cbor_put_bool(stdout, i == flbas);
+		cbor_put_break(stdout);
+	}
+	cbor_put_break(stdout);
+
+	cbor_end();
+}
+
+static void cbor_zns_start_zone_list(__u64 nr_zones, struct json_object **zone_list)
+{
+	cbor_begin();
+
+	map_add_uint("nr_zones", nr_zones);
+	map_open_array("zone_list");
+}
+
+static void cbor_zns_report_zones(void *report, __u32 descs,
+				  __u8 ext_size, __u32 report_size,
+				  struct json_object *zone_list)
+{
+	struct nvme_zone_report *r = report;
+	struct nvme_zns_desc *desc;
+	int i;
+
+	for (i = 0; i < descs; i++) {
+		desc = (struct nvme_zns_desc *)
+			(report + sizeof(*r) + i * (sizeof(*desc) + ext_size));
+
+		cbor_open_map(stdout);
+		map_add_uint("slba", le64_to_cpu(desc->zslba));
+		map_add_uint("wp", le64_to_cpu(desc->wp));
+		map_add_uint("cap", le64_to_cpu(desc->zcap));
+		map_add_uint("state", desc->zs >> 4);
+		map_add_uint("type", desc->zt);
+		map_add_uint("attrs", desc->za);
+		map_add_uint("attrs_info", desc->zai);
+		if (ext_size && desc->za & NVME_ZNS_ZA_ZDEV)
+			map_add_bytes("ext_data", (__u8 *)desc + sizeof(*desc), ext_size);
+		cbor_put_break(stdout);
+	}
+}
+
+static void cbor_zns_finish_zone_list(__u64 nr_zones, struct json_object *zone_list)
+{
+	cbor_put_break(stdout);
+	cbor_end();
+}
+
+static void cbor_discovery_log(struct nvmf_discovery_log *log, int numrec)
+{
+	struct nvmf_disc_log_entry *e;
+	int i;
+
+	cbor_begin();
+
+	map_add_uint("genctr", le64_to_cpu(log->genctr));
+	map_open_array("records");
+
+	for (i = 0; i < numrec; i++) {
+		e = &log->entries[i];
+
+		cbor_open_map(stdout);
+		map_add_uint("trtype", e->trtype);
+		map_add_uint("adrfam", e->adrfam);
+		map_add_uint("subtype", e->subtype);
+		map_add_uint("treq", e->treq);
+		map_add_uint("portid", le16_to_cpu(e->portid));
+		map_add_uint("cntlid", le16_to_cpu(e->cntlid));
+		map_add_uint("asqsz", le16_to_cpu(e->asqsz));
+		map_add_uint("eflags", le16_to_cpu(e->eflags));
+		map_add_strn("trsvcid", e->trsvcid, sizeof(e->trsvcid));
+		map_add_strn("subnqn", e->subnqn, sizeof(e->subnqn));
+		map_add_strn("traddr", e->traddr, sizeof(e->traddr));
+		map_add_bytes("tsas", &e->tsas, sizeof(e->tsas));
+		cbor_put_break(stdout);
+	}
+
+	cbor_put_break(stdout);
+	cbor_end();
+}
+
+static struct print_ops cbor_print_ops = {
+	/* libnvme types.h print functions */
+	.ana_log			= cbor_ana_log,
+	.discovery_log			= cbor_discovery_log,
+	.error_log			= cbor_error_log,
+	.fw_log				= cbor_fw_log,
+	.id_ctrl			= cbor_id_ctrl,
+	.id_ns				= cbor_id_ns,
+	.sanitize_log_page		= cbor_sanitize_log,
+	.self_test_log			= cbor_self_test_log,
+	.smart_log			= cbor_smart_log,
+	.zns_start_zone_list		= cbor_zns_start_zone_list,
+	.zns_finish_zone_list		= cbor_zns_finish_zone_list,
+	.zns_report_zones		= cbor_zns_report_zones,
+};
+
+struct print_ops *nvme_get_cbor_print_ops(nvme_print_flags_t flags)
+{
+	cbor_print_ops.flags = flags;
+	return &cbor_print_ops;
+}
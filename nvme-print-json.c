@@ -51,7 +51,12 @@
 static const uint8_t zero_uuid[16] = { 0 };
 static struct print_ops json_print_ops;
 static struct json_object *json_r;
+static struct json_object *json_zone_r;
+static struct json_object *json_pevent_r;
 static int json_init;
+/* document of a command run on several devices, keyed by device */
+static struct json_object *json_devs;
+static const char *json_dev;
 
 static void json_feature_show_fields(enum nvme_features_id fid, unsigned int result,
 				     unsigned char *buf);
@@ -175,13 +180,84 @@ static struct json_object *obj_create(const char *k)
 	return obj;
 }
 
+static bool json_is_ndjson(void)
+{
+	return json_print_ops.flags & NDJSON;
+}
+
 void json_print(struct json_object *r)
 {
-	json_print_object(r, NULL);
+	struct json_object *o;
+
+	if (json_dev && json_is_ndjson()) {
+		/* one line per device */
+		o = json_create_object();
+		obj_add_obj(o, json_dev, r);
+		json_print_object_plain(o);
+		printf("\n");
+		json_free_object(o);
+		return;
+	}
+
+	if (json_dev) {
+		obj_add_obj(json_devs, json_dev, r);
+		return;
+	}
+
+	if (json_is_ndjson())
+		json_print_object_plain(r);
+	else
+		json_print_object(r, NULL);
 	printf("\n");
 	json_free_object(r);
 }
 
+/*
+ * Record lists are printed one record per line for ndjson, in which case the
+ * document around them is dropped. Otherwise the document is streamed, see
+ * json_create_stream_object(). Either way, records are written as soon as
+ * they are added with array_add_record(). Neither is done for a device of
+ * json_show_device(), whose document is printed with the other devices.
+ */
+static struct json_object *json_create_records_root(void)
+{
+	if (json_is_ndjson() || json_dev)
+		return json_create_object();
+
+	return json_create_stream_object(stdout);
+}
+
+static struct json_object *obj_create_records(struct json_object *o, const char *k)
+{
+	struct json_object *records;
+
+	if (json_is_ndjson() && !json_dev) {
+		records = json_create_ndjson_array(stdout);
+		obj_add_array(o, k, records);
+		return records;
+	}
+
+	return json_stream_add_array(o, k);
+}
+
+/* @o must not be changed anymore once added */
+static void array_add_record(struct json_object *records, struct json_object *o)
+{
+	array_add_obj(records, o);
+	json_stream_flush(records);
+}
+
+static void json_print_records(struct json_object *r, struct json_object *records)
+{
+	if (json_is_ndjson() && !json_dev) {
+		json_stream_flush(records);
+		json_free_object(r);
+		return;
+	}
+
+	json_print(r);
+}
+
 static void obj_print(struct json_object *o)
 {
 	if (!json_r)
@@ -527,14 +603,12 @@ static void json_error_log(struct nvme_error_log_page *err_log, int entries,
 			   const char *devname,
 			   struct nvme_error_log_filter *flt)
 {
-	struct json_object *r = json_create_object();
-	struct json_object *errors = json_create_array();
+	struct json_object *r = json_create_records_root();
+	struct json_object *errors = obj_create_records(r, "errors");
 	struct json_object *error;
 	__u16 sts;
 	int i;
 
-	obj_add_array(r, "errors", errors);
-
 	for (i = 0; i < entries; i++) {
 		if (nvme_is_error_log_filter(&err_log[i], flt))
 			continue;
@@ -563,10 +637,10 @@ static void json_error_log(struct nvme_error_log_page *err_log, int entries,
 		obj_add_int(error, "log_page_version",
 			    err_log[i].log_page_version);
 
-		array_add_obj(errors, error);
+		array_add_record(errors, error);
 	}
 
-	json_print(r);
+	json_print_records(r, errors);
 }
 
 void json_nvme_resv_report(struct nvme_resv_status *status,
@@ -1916,25 +1990,24 @@ void nvme_json_pel_vendor_specific_event(void *pevent_log_info, __u32 offset,
 	obj_add_array(valid_attrs, "vs_event_entry", vs_events);
 }
 
-static void json_pevent_entry(void *pevent_log_info, __u8 action, __u32 size, const char *devname,
-			      __u32 offset, struct json_object *valid)
+/* adds events @first to @first + @nr - 1, starting at @offset */
+static void json_pevent_entry(void *pevent_log_info, __u32 offset, __u32 size,
+			      __u32 first, __u32 nr, struct json_object *valid)
 {
-	int i;
+	__u32 i;
 	__u16 vsil, el;
-	struct nvme_persistent_event_log *pevent_log_head = pevent_log_info;
 	struct nvme_persistent_event_entry *pevent_entry_head;
 	struct json_object *valid_attrs;
 
-	for (i = 0; i < le32_to_cpu(pevent_log_head->tnev); i++) {
-		if (offset + sizeof(*pevent_entry_head) >= size)
+	for (i = first; i < first + nr; i++) {
+		if (offset + sizeof(*pevent_entry_head) > size)
 			break;
 
 		pevent_entry_head = pevent_log_info + offset;
 		vsil = le16_to_cpu(pevent_entry_head->vsil);
 		el = le16_to_cpu(pevent_entry_head->el);
 
-		if (offset + pevent_entry_head->ehl + 3 + el >=
-		    size)
+		if (offset + pevent_entry_head->ehl + 3 + el > size)
 			break;
 
 		valid_attrs = json_create_object();
@@ -2008,7 +2081,7 @@ static void json_pevent_entry(void *pevent_log_info, __u8 action, __u32 size, co
 			break;
 		}
 
-		array_add_obj(valid, valid_attrs);
+		array_add_record(valid, valid_attrs);
 		offset += le16_to_cpu(pevent_entry_head->el);
 	}
 }
@@ -2016,23 +2089,52 @@ static void json_pevent_entry(void *pevent_log_info, __u8 action, __u32 size, co
 static void json_persistent_event_log(void *pevent_log_info, __u8 action,
 				      __u32 size, const char *devname)
 {
+	struct nvme_persistent_event_log *pevent_log_head = pevent_log_info;
 	struct json_object *r = json_create_object();
-	struct json_object *valid = json_create_array();
-	__u32 offset = sizeof(struct nvme_persistent_event_log);
+	struct json_object *valid;
+	__u32 offset = sizeof(*pevent_log_head);
 
 	if (size >= offset) {
-		nvme_json_pevent_log_head(pevent_log_info, r);
-		json_pevent_entry(pevent_log_info, action, size, devname, offset, valid);
-		obj_add_array(r, "list_of_event_entries", valid);
-	} else {
-		obj_add_result(r, "No log data can be shown with this log len at least " \
-				"512 bytes is required or can be 0 to read the complete "\
-				"log page after context established");
+		nvme_json_pevent_log_head(pevent_log_head, r);
+		valid = obj_create_records(r, "list_of_event_entries");
+		json_pevent_entry(pevent_log_info, offset, size, 0,
+				  le32_to_cpu(pevent_log_head->tnev), valid);
+		json_print_records(r, valid);
+		return;
 	}
 
+	obj_add_result(r, "No log data can be shown with this log len at least " \
+			"512 bytes is required or can be 0 to read the complete "\
+			"log page after context established");
+
 	json_print(r);
 }
 
+static void json_persistent_event_log_start(struct nvme_persistent_event_log *pevent_log_head,
+					    __u8 action, const char *devname,
+					    struct json_object **events)
+{
+	/* a document that was never finished is dropped */
+	json_free_object(json_pevent_r);
+	json_pevent_r = json_create_records_root();
+
+	nvme_json_pevent_log_head(pevent_log_head, json_pevent_r);
+	*events = obj_create_records(json_pevent_r, "list_of_event_entries");
+}
+
+static void json_persistent_event_entries(void *pevent_entries, __u32 nr, __u32 size,
+					  __u32 first, const char *devname,
+					  struct json_object *events)
+{
+	json_pevent_entry(pevent_entries, 0, size, first, nr, events);
+}
+
+static void json_persistent_event_log_finish(struct json_object *events)
+{
+	json_print_records(json_pevent_r, events);
+	json_pevent_r = NULL;
+}
+
 static void json_endurance_group_event_agg_log(
 		struct nvme_aggregate_endurance_group_event *endurance_log,
 		__u64 log_entries, __u32 size, const char *devname)
@@ -2618,11 +2720,11 @@ static void json_nvme_fdp_events(struct nvme_fdp_events_log *log)
 	uint32_t n;
 
 	r = json_create_object();
-	obj_events = json_create_array();
 
 	n = le32_to_cpu(log->n);
 
 	obj_add_uint(r, "n", n);
+	obj_events = obj_create_records(r, "events");
 
 	for (unsigned int i = 0; i < n; i++) {
 		struct nvme_fdp_event *event = &log->events[i];
@@ -2646,12 +2748,10 @@ static void json_nvme_fdp_events(struct nvme_fdp_events_log *log)
 				obj_add_uint64(obj_event, "lba", le64_to_cpu(mr->lba));
 		}
 
-		array_add_obj(obj_events, obj_event);
+		array_add_record(obj_events, obj_event);
 	}
 
-	obj_add_array(r, "events", obj_events);
-
-	json_print(r);
+	json_print_records(r, obj_events);
 }
 
 static void json_nvme_fdp_ruh_status(struct nvme_fdp_ruh_status *status, size_t len)
@@ -3474,7 +3574,12 @@ static void json_nvme_list_ns(struct nvme_ns_list *ns_list)
 
 static void json_zns_start_zone_list(__u64 nr_zones, struct json_object **zone_list)
 {
-	*zone_list = json_create_array();
+	/* a document that was never finished is dropped */
+	json_free_object(json_zone_r);
+	json_zone_r = json_create_records_root();
+
+	obj_add_uint(json_zone_r, "nr_zones", nr_zones);
+	*zone_list = obj_create_records(json_zone_r, "zone_list");
 }
 
 static void json_zns_changed(struct nvme_zns_changed_zone_log *log)
@@ -3500,12 +3605,8 @@ static void json_zns_changed(struct nvme_zns_changed_zone_log *log)
 static void json_zns_finish_zone_list(__u64 nr_zones,
 				      struct json_object *zone_list)
 {
-	struct json_object *r = json_create_object();
-
-	obj_add_uint(r, "nr_zones", nr_zones);
-	obj_add_array(r, "zone_list", zone_list);
-
-	json_print(r);
+	json_print_records(json_zone_r, zone_list);
+	json_zone_r = NULL;
 }
 
 static void json_nvme_zns_report_zones(void *report, __u32 descs,
@@ -3542,7 +3643,7 @@ static void json_nvme_zns_report_zones(void *report, __u32 descs,
 			}
 		}
 
-		array_add_obj(zone_list, zone);
+		array_add_record(zone_list, zone);
 	}
 }
 
@@ -5219,12 +5320,12 @@ static void json_directive_show(__u8 type, __u8 oper, __u16 spec, __u32 nsid, __
 #ifdef CONFIG_FABRICS
 static void json_discovery_log(struct nvmf_discovery_log *log, int numrec)
 {
-	struct json_object *r = json_create_object();
-	struct json_object *entries = json_create_array();
+	struct json_object *r = json_create_records_root();
+	struct json_object *entries;
 	int i;
 
 	obj_add_uint64(r, "genctr", le64_to_cpu(log->genctr));
-	obj_add_array(r, "records", entries);
+	entries = obj_create_records(r, "records");
 
 	for (i = 0; i < numrec; i++) {
 		struct nvmf_disc_log_entry *e = &log->entries[i];
@@ -5253,10 +5354,10 @@ static void json_discovery_log(struct nvmf_discovery_log *log, int numrec)
 		default:
 			break;
 		}
-		array_add_obj(entries, entry);
+		array_add_record(entries, entry);
 	}
 
-	json_print(r);
+	json_print_records(r, entries);
 }
 #else
 static void json_discovery_log(struct nvmf_discovery_log *log, int numrec) {}
@@ -5468,6 +5569,23 @@ void json_show_finish(void)
 	json_r = NULL;
 }
 
+static void json_show_device(const char *devname)
+{
+	if (!json_devs && !json_is_ndjson())
+		json_devs = json_create_object();
+	json_dev = devname;
+}
+
+static void json_show_devices_finish(void)
+{
+	struct json_object *r = json_devs;
+
+	json_dev = NULL;
+	json_devs = NULL;
+	if (r)
+		json_print(r);
+}
+
 static void json_mgmt_addr_list_log(struct nvme_mgmt_addr_list_log *ma_list)
 {
 	int i;
@@ -5838,6 +5956,9 @@ static struct print_ops json_print_ops = {
 	.ns_list_log			= json_changed_ns_list_log,
 	.nvm_id_ns			= json_nvme_nvm_id_ns,
 	.persistent_event_log		= json_persistent_event_log,
+	.persistent_event_log_start	= json_persistent_event_log_start,
+	.persistent_event_entries	= json_persistent_event_entries,
+	.persistent_event_log_finish	= json_persistent_event_log_finish,
 	.predictable_latency_event_agg_log = json_predictable_latency_event_agg_log,
 	.predictable_latency_per_nvmset	= json_predictable_latency_per_nvmset,
 	.primary_ctrl_cap		= json_nvme_primary_ctrl_cap,
@@ -5865,6 +5986,8 @@ static struct print_ops json_print_ops = {
 	.d				= json_d,
 	.show_init			= json_show_init,
 	.show_finish			= json_show_finish,
+	.show_device			= json_show_device,
+	.show_devices_finish		= json_show_devices_finish,
 	.mgmt_addr_list_log		= json_mgmt_addr_list_log,
 	.rotational_media_info_log	= json_rotational_media_info_log,
 	.dispersed_ns_psub_log		= json_dispersed_ns_psub_log,
@@ -36,6 +36,33 @@
 #include "util/dashboard.h"
 #include "util/table.h"
 
+struct top_stat {
+	double r_iops, w_iops;
+	double r_lat, w_lat;
+	double r_bw, w_bw;
+	double util;
+	unsigned int inflights;
+};
+
+/*
+ * A table row which can be ranked before it's printed. Depending on the
+ * table only some of the object pointers are set.
+ */
+struct top_row {
+	double key;
+	libnvme_subsystem_t s;
+	libnvme_ctrl_t c;
+	libnvme_ns_t n;
+	libnvme_path_t p;
+	struct top_stat stat;
+};
+
+/* sort order and row limit requested on the command line */
+static struct {
+	enum nvme_cli_top_sort sort;
+	unsigned int limit;
+} top_cfg;
+
 static double nvme_calc_util_percent(unsigned int ticks, double interval_ms)
 {
 	if (!interval_ms)
@@ -367,6 +394,135 @@ static void nvme_path_calc_stat(libnvme_path_t p,
 	*util = nvme_path_calc_util_percent(p, interval_ms);
 }
 
+static void nvme_ns_calc_top_stat(libnvme_ns_t n, struct top_stat *st)
+{
+	nvme_ns_calc_stat(n, &st->r_iops, &st->w_iops,
+			&st->r_lat, &st->w_lat,
+			&st->r_bw, &st->w_bw,
+			&st->util, &st->inflights);
+}
+
+static void nvme_path_calc_top_stat(libnvme_path_t p, struct top_stat *st)
+{
+	nvme_path_calc_stat(p, &st->r_iops, &st->w_iops,
+			&st->r_lat, &st->w_lat,
+			&st->r_bw, &st->w_bw,
+			&st->util, &st->inflights);
+}
+
+/*
+ * Aggregates the stat of namespace @n into @st: IOPS, bandwidth and
+ * inflights are summed up whereas latency and util are the max seen.
+ */
+static void nvme_ns_calc_aggr_top_stat(libnvme_ns_t n, struct top_stat *st)
+{
+	nvme_ns_calc_aggr_stat(n, &st->r_iops, &st->w_iops,
+			&st->r_bw, &st->w_bw,
+			&st->r_lat, &st->w_lat,
+			&st->util);
+
+	st->inflights += libnvme_ns_get_inflights(n);
+}
+
+static void nvme_top_stat_aggr(struct top_stat *dst, struct top_stat *src)
+{
+	dst->r_iops += src->r_iops;
+	dst->w_iops += src->w_iops;
+	dst->r_bw += src->r_bw;
+	dst->w_bw += src->w_bw;
+	dst->inflights += src->inflights;
+
+	if (src->r_lat > dst->r_lat)
+		dst->r_lat = src->r_lat;
+	if (src->w_lat > dst->w_lat)
+		dst->w_lat = src->w_lat;
+	if (src->util > dst->util)
+		dst->util = src->util;
+}
+
+static double nvme_top_stat_key(struct top_stat *st)
+{
+	switch (top_cfg.sort) {
+	case NVME_CLI_TOP_SORT_IOPS:
+		return st->r_iops + st->w_iops;
+	case NVME_CLI_TOP_SORT_BW:
+		return st->r_bw + st->w_bw;
+	case NVME_CLI_TOP_SORT_LAT:
+		return st->r_lat > st->w_lat ? st->r_lat : st->w_lat;
+	case NVME_CLI_TOP_SORT_UTIL:
+		return st->util;
+	case NVME_CLI_TOP_SORT_INFLIGHTS:
+		return st->inflights;
+	default:
+		return 0;
+	}
+}
+
+static int nvme_top_row_cmp(const void *a, const void *b)
+{
+	const struct top_row *ra = a, *rb = b;
+
+	/* descending order, the busiest row comes first */
+	if (ra->key < rb->key)
+		return 1;
+	if (ra->key > rb->key)
+		return -1;
+	return 0;
+}
+
+static void nvme_top_heap_sift_down(struct top_row *heap, int nr, int i)
+{
+	struct top_row tmp;
+	int child;
+
+	while ((child = 2 * i + 1) < nr) {
+		if (child + 1 < nr && heap[child + 1].key < heap[child].key)
+			child++;
+		if (heap[i].key <= heap[child].key)
+			break;
+
+		tmp = heap[i];
+		heap[i] = heap[child];
+		heap[child] = tmp;
+		i = child;
+	}
+}
+
+/*
+ * Ranks @rows according to the requested sort order and returns the number
+ * of rows to print. When only the top @limit rows are wanted, they are
+ * collected in a min-heap of size @limit at the front of @rows, so the cost
+ * is O(n log k) instead of sorting all rows.
+ */
+static int nvme_top_select_rows(struct top_row *rows, int nr, bool limited)
+{
+	int i, k = nr;
+
+	if (limited && top_cfg.limit && top_cfg.limit < (unsigned int)nr)
+		k = top_cfg.limit;
+
+	if (top_cfg.sort == NVME_CLI_TOP_SORT_NONE)
+		return k;
+
+	for (i = 0; i < nr; i++)
+		rows[i].key = nvme_top_stat_key(&rows[i].stat);
+
+	if (k < nr) {
+		for (i = k / 2 - 1; i >= 0; i--)
+			nvme_top_heap_sift_down(rows, k, i);
+
+		for (i = k; i < nr; i++) {
+			if (rows[i].key <= rows[0].key)
+				continue;
+			rows[0] = rows[i];
+			nvme_top_heap_sift_down(rows, k, 0);
+		}
+	}
+
+	qsort(rows, k, sizeof(*rows), nvme_top_row_cmp);
+	return k;
+}
+
 static bool stdout_top_nvme_ctrl_is_fabric(libnvme_ctrl_t c)
 {
 	if (strcmp(libnvme_ctrl_get_transport(c), "pcie"))
@@ -605,12 +761,12 @@ static int stdout_top_print_ns_stat(FILE *stream, libnvme_subsystem_t s)
 	int ret = 0;
 	libnvme_ns_t n;
 	libnvme_ctrl_t c;
-	int col, row;
-	unsigned int inflights;
-	double r_iops, w_iops, r_lat, w_lat, r_bw, w_bw, util;
+	int i, col, row, nr_rows = 0;
+	struct top_stat *st;
 	char r_bw_str[16], w_bw_str[16];
 	char r_iops_str[16], w_iops_str[16];
 	char r_clat_str[16], w_clat_str[16];
+	__cleanup_free struct top_row *rows = NULL;
 	struct table *t;
 	struct table_column columns[] = {
 		{"Namespace", LEFT, AUTO_WIDTH},
@@ -628,6 +784,27 @@ static int stdout_top_print_ns_stat(FILE *stream, libnvme_subsystem_t s)
 		{"Util%",     LEFT, 6},
 	};
 
+	libnvme_subsystem_for_each_ctrl(s, c)
+		libnvme_ctrl_for_each_ns(c, n)
+			nr_rows++;
+
+	rows = calloc(nr_rows ? nr_rows : 1, sizeof(*rows));
+	if (!rows) {
+		nvme_show_error("Failed to allocate ns stat rows\n");
+		return 1;
+	}
+
+	i = 0;
+	libnvme_subsystem_for_each_ctrl(s, c) {
+		libnvme_ctrl_for_each_ns(c, n) {
+			rows[i].c = c;
+			rows[i].n = n;
+			nvme_ns_calc_top_stat(n, &rows[i].stat);
+			i++;
+		}
+	}
+	nr_rows = nvme_top_select_rows(rows, nr_rows, true);
+
 	t = table_create();
 	if (!t) {
 		nvme_show_error("Failed to init ns stat table\n");
@@ -641,60 +818,49 @@ static int stdout_top_print_ns_stat(FILE *stream, libnvme_subsystem_t s)
 	}
 
 	fprintf(stream, "----------- Namespace Stat -----------\n\n");
-	libnvme_subsystem_for_each_ctrl(s, c) {
-		libnvme_ctrl_for_each_ns(c, n) {
-			r_iops = r_lat = r_bw = 0;
-			w_iops = w_lat = w_bw = 0;
-			util = inflights = 0;
-
-			nvme_ns_calc_stat(n,
-					&r_iops, &w_iops,
-					&r_lat, &w_lat,
-					&r_bw, &w_bw,
-					&util, &inflights);
+	for (i = 0; i < nr_rows; i++) {
+		n = rows[i].n;
+		c = rows[i].c;
+		st = &rows[i].stat;
 
-			nvme_format_iops(r_iops, r_iops_str,
-					sizeof(r_iops_str));
-			nvme_format_iops(w_iops, w_iops_str,
-					sizeof(w_iops_str));
+		nvme_format_iops(st->r_iops, r_iops_str, sizeof(r_iops_str));
+		nvme_format_iops(st->w_iops, w_iops_str, sizeof(w_iops_str));
 
-			nvme_format_bw(r_bw, r_bw_str, sizeof(r_bw_str));
-			nvme_format_bw(w_bw, w_bw_str, sizeof(w_bw_str));
+		nvme_format_bw(st->r_bw, r_bw_str, sizeof(r_bw_str));
+		nvme_format_bw(st->w_bw, w_bw_str, sizeof(w_bw_str));
 
-			nvme_format_lat(r_lat, r_clat_str, sizeof(r_clat_str));
-			nvme_format_lat(w_lat, w_clat_str, sizeof(w_clat_str));
+		nvme_format_lat(st->r_lat, r_clat_str, sizeof(r_clat_str));
+		nvme_format_lat(st->w_lat, w_clat_str, sizeof(w_clat_str));
 
-			row = table_get_row_id(t);
-			if (row < 0) {
-				nvme_show_error("Failed to add row to ns stat table\n");
-				ret = 1;
-				goto free_tbl;
-			}
+		row = table_get_row_id(t);
+		if (row < 0) {
+			nvme_show_error("Failed to add row to ns stat table\n");
+			ret = 1;
+			goto free_tbl;
+		}
 
-			col = -1;
+		col = -1;
 
-			table_set_value_str(t, ++col, row,
-					libnvme_ns_get_name(n), LEFT);
-			table_set_value_int(t, ++col, row,
-					libnvme_ns_get_nsid(n), LEFT);
-			table_set_value_str(t, ++col, row,
-					libnvme_ctrl_get_name(c), LEFT);
-			table_set_value_long(t, ++col, row,
-				libnvme_ns_get_command_retry_count(n), LEFT);
-			table_set_value_long(t, ++col, row,
-				libnvme_ns_get_command_error_count(n), LEFT);
-			table_set_value_str(t, ++col, row, r_iops_str, LEFT);
-			table_set_value_str(t, ++col, row, w_iops_str, LEFT);
-			table_set_value_str(t, ++col, row, r_clat_str, LEFT);
-			table_set_value_str(t, ++col, row, w_clat_str, LEFT);
-			table_set_value_str(t, ++col, row, r_bw_str, LEFT);
-			table_set_value_str(t, ++col, row, w_bw_str, LEFT);
-			table_set_value_unsigned(t, ++col, row, inflights,
-					LEFT);
-			table_set_value_double(t, ++col, row, util, LEFT);
+		table_set_value_str(t, ++col, row,
+				libnvme_ns_get_name(n), LEFT);
+		table_set_value_int(t, ++col, row,
+				libnvme_ns_get_nsid(n), LEFT);
+		table_set_value_str(t, ++col, row,
+				libnvme_ctrl_get_name(c), LEFT);
+		table_set_value_long(t, ++col, row,
+			libnvme_ns_get_command_retry_count(n), LEFT);
+		table_set_value_long(t, ++col, row,
+			libnvme_ns_get_command_error_count(n), LEFT);
+		table_set_value_str(t, ++col, row, r_iops_str, LEFT);
+		table_set_value_str(t, ++col, row, w_iops_str, LEFT);
+		table_set_value_str(t, ++col, row, r_clat_str, LEFT);
+		table_set_value_str(t, ++col, row, w_clat_str, LEFT);
+		table_set_value_str(t, ++col, row, r_bw_str, LEFT);
+		table_set_value_str(t, ++col, row, w_bw_str, LEFT);
+		table_set_value_unsigned(t, ++col, row, st->inflights, LEFT);
+		table_set_value_double(t, ++col, row, st->util, LEFT);
 
-			table_add_row(t, row);
-		}
+		table_add_row(t, row);
 	}
 
 	table_print_stream(stream, t);
@@ -708,12 +874,12 @@ static int stdout_top_print_nshead_stat(FILE *stream, libnvme_subsystem_t s)
 	int ret = 0;
 	libnvme_ns_t n;
 	libnvme_path_t p;
-	double r_iops, w_iops, r_lat, w_lat, r_bw, w_bw, util;
-	unsigned int inflights;
-	int col, row, npaths;
+	struct top_stat *st;
+	int i, col, row, npaths, nr_rows = 0;
 	char r_iops_str[16], w_iops_str[16];
 	char r_clat_str[16], w_clat_str[16];
 	char r_bw_str[16], w_bw_str[16];
+	__cleanup_free struct top_row *rows = NULL;
 	struct table *t;
 	struct table_column columns[] = {
 			{"NSHead",     LEFT, AUTO_WIDTH},
@@ -731,6 +897,23 @@ static int stdout_top_print_nshead_stat(FILE *stream, libnvme_subsystem_t s)
 			{"Util%",      LEFT, 6},
 	};
 
+	libnvme_subsystem_for_each_ns(s, n)
+		nr_rows++;
+
+	rows = calloc(nr_rows ? nr_rows : 1, sizeof(*rows));
+	if (!rows) {
+		nvme_show_error("Failed to allocate nshead stat rows\n");
+		return 1;
+	}
+
+	i = 0;
+	libnvme_subsystem_for_each_ns(s, n) {
+		rows[i].n = n;
+		nvme_ns_calc_top_stat(n, &rows[i].stat);
+		i++;
+	}
+	nr_rows = nvme_top_select_rows(rows, nr_rows, true);
+
 	t = table_create();
 	if (!t) {
 		nvme_show_error("Failed to init nshead stat table\n");
@@ -744,26 +927,19 @@ static int stdout_top_print_nshead_stat(FILE *stream, libnvme_subsystem_t s)
 	}
 
 	fprintf(stream, "------------ NSHead Stat -------------\n\n");
-	libnvme_subsystem_for_each_ns(s, n) {
+	for (i = 0; i < nr_rows; i++) {
+		n = rows[i].n;
+		st = &rows[i].stat;
 		npaths = 0;
-		r_iops = r_lat = r_bw = 0;
-		w_iops = w_lat = w_bw = 0;
-		util = inflights = 0;
 
-		nvme_ns_calc_stat(n,
-				&r_iops, &w_iops,
-				&r_lat, &w_lat,
-				&r_bw, &w_bw,
-				&util, &inflights);
+		nvme_format_iops(st->r_iops, r_iops_str, sizeof(r_iops_str));
+		nvme_format_iops(st->w_iops, w_iops_str, sizeof(w_iops_str));
 
-		nvme_format_iops(r_iops, r_iops_str, sizeof(r_iops_str));
-		nvme_format_iops(w_iops, w_iops_str, sizeof(w_iops_str));
-
-		nvme_format_bw(r_bw, r_bw_str, sizeof(r_bw_str));
-		nvme_format_bw(w_bw, w_bw_str, sizeof(w_bw_str));
+		nvme_format_bw(st->r_bw, r_bw_str, sizeof(r_bw_str));
+		nvme_format_bw(st->w_bw, w_bw_str, sizeof(w_bw_str));
 
-		nvme_format_lat(r_lat, r_clat_str, sizeof(r_clat_str));
-		nvme_format_lat(w_lat, w_clat_str, sizeof(w_clat_str));
+		nvme_format_lat(st->r_lat, r_clat_str, sizeof(r_clat_str));
+		nvme_format_lat(st->w_lat, w_clat_str, sizeof(w_clat_str));
 
 		libnvme_namespace_for_each_path(n, p)
 			npaths++;
@@ -792,8 +968,8 @@ static int stdout_top_print_nshead_stat(FILE *stream, libnvme_subsystem_t s)
 		table_set_value_str(t, ++col, row, w_clat_str, LEFT);
 		table_set_value_str(t, ++col, row, r_bw_str, LEFT);
 		table_set_value_str(t, ++col, row, w_bw_str, LEFT);
-		table_set_value_unsigned(t, ++col, row, inflights, LEFT);
-		table_set_value_double(t, ++col, row, util, LEFT);
+		table_set_value_unsigned(t, ++col, row, st->inflights, LEFT);
+		table_set_value_double(t, ++col, row, st->util, LEFT);
 
 		table_add_row(t, row);
 	}
@@ -807,16 +983,15 @@ free_tbl:
 static int stdout_top_print_path_perf(FILE *stream, libnvme_subsystem_t s)
 {
 	int ret = 0;
-	libnvme_ns_t n;
+	libnvme_ns_t n, prev_n = NULL;
 	libnvme_path_t p;
 	libnvme_ctrl_t c;
-	unsigned int inflights;
-	int row, col;
-	double util, r_iops, w_iops, r_lat, w_lat, r_bw, w_bw;
+	struct top_stat *st;
+	int i, row, col, nr_rows = 0;
 	char r_iops_str[16], w_iops_str[16];
 	char r_clat_str[16], w_clat_str[16];
 	char r_bw_str[16], w_bw_str[16];
-	bool first;
+	__cleanup_free struct top_row *rows = NULL;
 	struct table *t;
 	const char *iopolicy = libnvme_subsystem_get_iopolicy(s);
 	struct table_column columns[] = {
@@ -836,6 +1011,27 @@ static int stdout_top_print_path_perf(FILE *stream, libnvme_subsystem_t s)
 		{"Util%",     LEFT, 6},
 	};
 
+	libnvme_subsystem_for_each_ns(s, n)
+		libnvme_namespace_for_each_path(n, p)
+			nr_rows++;
+
+	rows = calloc(nr_rows ? nr_rows : 1, sizeof(*rows));
+	if (!rows) {
+		nvme_show_error("Failed to allocate path perf rows");
+		return 1;
+	}
+
+	i = 0;
+	libnvme_subsystem_for_each_ns(s, n) {
+		libnvme_namespace_for_each_path(n, p) {
+			rows[i].n = n;
+			rows[i].p = p;
+			nvme_path_calc_top_stat(p, &rows[i].stat);
+			i++;
+		}
+	}
+	nr_rows = nvme_top_select_rows(rows, nr_rows, true);
+
 	t = table_create();
 	if (!t) {
 		nvme_show_error("Failed to init path perf table");
@@ -850,83 +1046,73 @@ static int stdout_top_print_path_perf(FILE *stream, libnvme_subsystem_t s)
 	}
 
 	fprintf(stream, "\n---------- Path Performance ----------\n\n");
-	libnvme_subsystem_for_each_ns(s, n) {
-		first = true;
-		libnvme_namespace_for_each_path(n, p) {
-			r_iops = r_lat = r_bw = 0;
-			w_iops = w_lat = w_bw = 0;
-			util = inflights = 0;
+	for (i = 0; i < nr_rows; i++) {
+		n = rows[i].n;
+		p = rows[i].p;
+		st = &rows[i].stat;
 
-			nvme_path_calc_stat(p,
-					&r_iops, &w_iops,
-					&r_lat, &w_lat,
-					&r_bw, &w_bw,
-					&util, &inflights);
+		nvme_format_iops(st->r_iops, r_iops_str, sizeof(r_iops_str));
+		nvme_format_iops(st->w_iops, w_iops_str, sizeof(w_iops_str));
 
-			nvme_format_iops(r_iops, r_iops_str,
-					sizeof(r_iops_str));
-			nvme_format_iops(w_iops, w_iops_str,
-					sizeof(w_iops_str));
+		nvme_format_bw(st->r_bw, r_bw_str, sizeof(r_bw_str));
+		nvme_format_bw(st->w_bw, w_bw_str, sizeof(w_bw_str));
 
-			nvme_format_bw(r_bw, r_bw_str, sizeof(r_bw_str));
-			nvme_format_bw(w_bw, w_bw_str, sizeof(w_bw_str));
+		nvme_format_lat(st->r_lat, r_clat_str, sizeof(r_clat_str));
+		nvme_format_lat(st->w_lat, w_clat_str, sizeof(w_clat_str));
 
-			nvme_format_lat(r_lat, r_clat_str, sizeof(r_clat_str));
-			nvme_format_lat(w_lat, w_clat_str, sizeof(w_clat_str));
-
-			/* get controller associated with the path */
-			c = libnvme_path_get_ctrl(p);
-
-			row = table_get_row_id(t);
-			if (row < 0) {
-				nvme_show_error("Failed to add row to path perf table");
-				ret = 1;
-				goto free_tbl;
-			}
+		/* get controller associated with the path */
+		c = libnvme_path_get_ctrl(p);
 
-			/*
-			 * For the first row we print actual NSHead name,
-			 * however, for the subsequent rows we print "arrow"
-			 * ("-->") symbol for NSHead. This "arrow" style makes
-			 * it visually obvious that subsequent entries (if
-			 * present) are a path under the first NSHead.
-			 */
-			col = -1;
+		row = table_get_row_id(t);
+		if (row < 0) {
+			nvme_show_error("Failed to add row to path perf table");
+			ret = 1;
+			goto free_tbl;
+		}
 
-			if (first) {
-				table_set_value_str(t, ++col, row,
-						libnvme_ns_get_name(n), LEFT);
-				first = false;
-			} else
-				table_set_value_str(t, ++col, row,
-						"-->", CENTERED);
+		/*
+		 * For the first row we print actual NSHead name,
+		 * however, for the subsequent rows we print "arrow"
+		 * ("-->") symbol for NSHead. This "arrow" style makes
+		 * it visually obvious that subsequent entries (if
+		 * present) are a path under the first NSHead. Once the
+		 * rows are sorted, paths of the same NSHead are no longer
+		 * adjacent, hence the arrow is only used while they are.
+		 */
+		col = -1;
 
-			table_set_value_int(t, ++col, row,
-					libnvme_ns_get_nsid(n), CENTERED);
+		if (n != prev_n) {
+			table_set_value_str(t, ++col, row,
+					libnvme_ns_get_name(n), LEFT);
+			prev_n = n;
+		} else
 			table_set_value_str(t, ++col, row,
-					libnvme_path_get_name(p), LEFT);
+					"-->", CENTERED);
 
-			if (!strcmp(iopolicy, "numa"))
-				table_set_value_str(t, ++col, row,
-				    libnvme_path_get_numa_nodes(p), CENTERED);
-			else if (!strcmp(iopolicy, "queue-depth"))
-				table_set_value_int(t, ++col, row,
-				    libnvme_path_get_queue_depth(p), CENTERED);
+		table_set_value_int(t, ++col, row,
+				libnvme_ns_get_nsid(n), CENTERED);
+		table_set_value_str(t, ++col, row,
+				libnvme_path_get_name(p), LEFT);
 
+		if (!strcmp(iopolicy, "numa"))
 			table_set_value_str(t, ++col, row,
-					libnvme_ctrl_get_name(c), LEFT);
-			table_set_value_str(t, ++col, row, r_iops_str, LEFT);
-			table_set_value_str(t, ++col, row, w_iops_str, LEFT);
-			table_set_value_str(t, ++col, row, r_clat_str, LEFT);
-			table_set_value_str(t, ++col, row, w_clat_str, LEFT);
-			table_set_value_str(t, ++col, row, r_bw_str, LEFT);
-			table_set_value_str(t, ++col, row, w_bw_str, LEFT);
-			table_set_value_unsigned(t, ++col, row,
-					inflights, LEFT);
-			table_set_value_double(t, ++col, row, util, LEFT);
+			    libnvme_path_get_numa_nodes(p), CENTERED);
+		else if (!strcmp(iopolicy, "queue-depth"))
+			table_set_value_int(t, ++col, row,
+			    libnvme_path_get_queue_depth(p), CENTERED);
 
-			table_add_row(t, row);
-		}
+		table_set_value_str(t, ++col, row,
+				libnvme_ctrl_get_name(c), LEFT);
+		table_set_value_str(t, ++col, row, r_iops_str, LEFT);
+		table_set_value_str(t, ++col, row, w_iops_str, LEFT);
+		table_set_value_str(t, ++col, row, r_clat_str, LEFT);
+		table_set_value_str(t, ++col, row, w_clat_str, LEFT);
+		table_set_value_str(t, ++col, row, r_bw_str, LEFT);
+		table_set_value_str(t, ++col, row, w_bw_str, LEFT);
+		table_set_value_unsigned(t, ++col, row, st->inflights, LEFT);
+		table_set_value_double(t, ++col, row, st->util, LEFT);
+
+		table_add_row(t, row);
 	}
 	table_print_stream(stream, t);
 free_tbl:
@@ -1261,22 +1447,156 @@ wait_for_event:
 	return ret;
 }
 
+static int stdout_top_calc_subsys_stat(libnvme_subsystem_t s,
+		struct top_stat *st)
+{
+	libnvme_ctrl_t c;
+	libnvme_ns_t n;
+	int ret;
+
+	ret = stdout_top_update_stat(s);
+	if (ret)
+		return ret;
+
+	if (nvme_is_multipath(s)) {
+		libnvme_subsystem_for_each_ns(s, n)
+			nvme_ns_calc_aggr_top_stat(n, st);
+	} else {
+		libnvme_subsystem_for_each_ctrl(s, c) {
+			libnvme_ctrl_for_each_ns(c, n)
+				nvme_ns_calc_aggr_top_stat(n, st);
+		}
+	}
+
+	return 0;
+}
+
+static int stdout_top_print_host_summary(FILE *stream,
+		struct top_row *rows, int nr_rows, int *nr_hosts)
+{
+	int ret = 0;
+	int i, j, row, col, nr = 0;
+	libnvme_host_t h;
+	char r_bw_str[16], w_bw_str[16];
+	char r_iops_str[16], w_iops_str[16];
+	char r_clat_str[16], w_clat_str[16];
+	__cleanup_free struct top_row *hosts = NULL;
+	__cleanup_free int *num_subsys = NULL;
+	struct top_stat *st;
+	struct table *t;
+	struct table_column columns[] = {
+		{"HostNQN",    LEFT, AUTO_WIDTH},
+		{"Subsystems", LEFT, AUTO_WIDTH},
+		{"r_IOPS",     LEFT, 9},
+		{"w_IOPS",     LEFT, 9},
+		{"r_clat",     LEFT, 8},
+		{"w_clat",     LEFT, 8},
+		{"r_bw",       LEFT, 13},
+		{"w_bw",       LEFT, 13},
+		{"Inflights",  LEFT, AUTO_WIDTH},
+		{"Util%",      LEFT, 6},
+	};
+
+	hosts = calloc(nr_rows, sizeof(*hosts));
+	num_subsys = calloc(nr_rows, sizeof(*num_subsys));
+	if (!hosts || !num_subsys) {
+		nvme_show_error("Failed to allocate host summary rows\n");
+		return -1;
+	}
+
+	/* the number of hosts is small, a linear lookup is good enough */
+	for (i = 0; i < nr_rows; i++) {
+		h = libnvme_subsystem_get_host(rows[i].s);
+		for (j = 0; j < nr; j++) {
+			if (libnvme_subsystem_get_host(hosts[j].s) == h)
+				break;
+		}
+		if (j == nr) {
+			hosts[j].s = rows[i].s;
+			nr++;
+		}
+		num_subsys[j]++;
+		nvme_top_stat_aggr(&hosts[j].stat, &rows[i].stat);
+	}
+
+	t = table_create();
+	if (!t) {
+		nvme_show_error("Failed to init host summary table\n");
+		return -1;
+	}
+
+	if (table_add_columns(t, columns, ARRAY_SIZE(columns)) < 0) {
+		nvme_show_error("Failed to add columns to host summary table\n");
+		ret = -1;
+		goto free_tbl;
+	}
+
+	for (i = 0; i < nr; i++) {
+		h = libnvme_subsystem_get_host(hosts[i].s);
+		st = &hosts[i].stat;
+
+		nvme_format_iops(st->r_iops, r_iops_str, sizeof(r_iops_str));
+		nvme_format_iops(st->w_iops, w_iops_str, sizeof(w_iops_str));
+
+		nvme_format_bw(st->r_bw, r_bw_str, sizeof(r_bw_str));
+		nvme_format_bw(st->w_bw, w_bw_str, sizeof(w_bw_str));
+
+		nvme_format_lat(st->r_lat, r_clat_str, sizeof(r_clat_str));
+		nvme_format_lat(st->w_lat, w_clat_str, sizeof(w_clat_str));
+
+		row = table_get_row_id(t);
+		if (row < 0) {
+			nvme_show_error("Failed to add row to host summary table\n");
+			ret = -1;
+			goto free_tbl;
+		}
+
+		col = -1;
+
+		table_set_value_str(t, ++col, row,
+				libnvme_host_get_hostnqn(h), LEFT);
+		table_set_value_int(t, ++col, row, num_subsys[i], LEFT);
+		table_set_value_str(t, ++col, row, r_iops_str, LEFT);
+		table_set_value_str(t, ++col, row, w_iops_str, LEFT);
+		table_set_value_str(t, ++col, row, r_clat_str, LEFT);
+		table_set_value_str(t, ++col, row, w_clat_str, LEFT);
+		table_set_value_str(t, ++col, row, r_bw_str, LEFT);
+		table_set_value_str(t, ++col, row, w_bw_str, LEFT);
+		table_set_value_unsigned(t, ++col, row, st->inflights, LEFT);
+		table_set_value_double(t, ++col, row, st->util, LEFT);
+
+		table_add_row(t, row);
+	}
+
+	fprintf(stream, "\n------------ Host Summary ------------\n\n");
+	table_print_stream(stream, t);
+	*nr_hosts = nr;
+free_tbl:
+	table_free(t);
+	return ret;
+}
+
+/*
+ * Draws the subsystem summary screen. If a sort order is requested then
+ * @subsys_arr is re-ordered accordingly and @subsys_idx is updated so that
+ * it keeps pointing to the selected subsystem.
+ */
 static int stdout_top_draw_subsys_screen(struct dashboard_ctx *db_ctx,
-		FILE *stream, libnvme_subsystem_t *subsys_arr, int num_subsys)
+		FILE *stream, libnvme_subsystem_t *subsys_arr, int num_subsys,
+		int *subsys_idx)
 {
 	int ret = 0;
-	libnvme_subsystem_t s;
+	libnvme_subsystem_t s, selected;
 	libnvme_ctrl_t c;
 	libnvme_ns_t n;
 	libnvme_path_t p;
-	int i, row, col, num_ns, num_path, num_ctrl;
-	double r_iops, w_iops;
-	double r_bw, w_bw;
-	double max_rlat, max_wlat, max_util;
+	int i, row, col, num_ns, num_path, num_ctrl, num_hosts = 0;
 	char r_bw_str[16], w_bw_str[16];
 	char r_iops_str[16], w_iops_str[16];
 	char r_clat_str[16], w_clat_str[16];
 	char *iopolicy;
+	__cleanup_free struct top_row *rows = NULL;
+	struct top_stat *st;
 	struct table *t;
 	struct table_column columns[] = {
 		{"Subsystem",  LEFT, AUTO_WIDTH},
@@ -1293,8 +1613,39 @@ static int stdout_top_draw_subsys_screen(struct dashboard_ctx *db_ctx,
 		{"Util%",      LEFT, 6},
 	};
 
+	rows = calloc(num_subsys, sizeof(*rows));
+	if (!rows) {
+		nvme_show_error("Failed to allocate subsys screen rows\n");
+		return -1;
+	}
+
+	for (i = 0; i < num_subsys; i++) {
+		rows[i].s = subsys_arr[i];
+		ret = stdout_top_calc_subsys_stat(rows[i].s, &rows[i].stat);
+		if (ret)
+			return ret;
+	}
+
+	/*
+	 * Every subsystem needs a row for the navigation to work, so the
+	 * subsystem rows are sorted but never truncated.
+	 */
+	selected = subsys_arr[*subsys_idx];
+	nvme_top_select_rows(rows, num_subsys, false);
+	for (i = 0; i < num_subsys; i++) {
+		subsys_arr[i] = rows[i].s;
+		if (subsys_arr[i] == selected)
+			*subsys_idx = i;
+	}
+
 	fprintf(stream, "---- nvme-top - Refresh: %d Second ----\n",
 			dashboard_get_interval(db_ctx));
+
+	ret = stdout_top_print_host_summary(stream, rows, num_subsys,
+			&num_hosts);
+	if (ret)
+		return ret;
+
 	fprintf(stream, "\n--------- Subsystem Summary ----------\n\n");
 
 	t = table_create();
@@ -1310,67 +1661,49 @@ static int stdout_top_draw_subsys_screen(struct dashboard_ctx *db_ctx,
 	}
 	/*
 	 * Header row count is calculated manually. The first row displays the
-	 * refresh interval, followed by an empty row. The third row displays
-	 * the heading followed by another empty row. The fifth row is for
-	 * displaying table columns and then another row for dashes underneath
-	 * the table columns.
+	 * refresh interval, followed by an empty row, the host summary heading
+	 * and another empty row. Then the host summary table follows which
+	 * has two rows for its columns and dashes plus one row per host. The
+	 * subsystem summary heading is surrounded by empty rows and is
+	 * followed by a row for the table columns and then another row for
+	 * dashes underneath the table columns.
 	 */
-	dashboard_set_header_rows(db_ctx, 6);
+	dashboard_set_header_rows(db_ctx, 11 + num_hosts);
 
 	/* highlight the first header row */
 	dashboard_set_header_row_reverse(db_ctx, 0);
 
 	for (i = 0; i < num_subsys; i++) {
-		s = subsys_arr[i];
+		s = rows[i].s;
+		st = &rows[i].stat;
 		num_ctrl = num_ns = num_path = 0;
-		r_iops = w_iops = 0;
-		r_bw = w_bw = 0;
-		max_rlat = max_wlat = 0;
-		max_util = 0;
 		iopolicy = libnvme_subsystem_get_iopolicy(s);
 
 		libnvme_subsystem_for_each_ctrl(s, c)
 			num_ctrl++;
 
-		ret = stdout_top_update_stat(s);
-		if (ret)
-			goto free_tbl;
-
 		if (nvme_is_multipath(s)) {
 			libnvme_subsystem_for_each_ns(s, n) {
 				num_ns++;
 
 				libnvme_namespace_for_each_path(n, p)
 					num_path++;
-
-				nvme_ns_calc_aggr_stat(n,
-						&r_iops, &w_iops,
-						&r_bw, &w_bw,
-						&max_rlat, &max_wlat,
-						&max_util);
 			}
 		} else {
 			libnvme_subsystem_for_each_ctrl(s, c) {
-				libnvme_ctrl_for_each_ns(c, n) {
+				libnvme_ctrl_for_each_ns(c, n)
 					num_ns++;
-
-					nvme_ns_calc_aggr_stat(n,
-							&r_iops, &w_iops,
-							&r_bw, &w_bw,
-							&max_rlat, &max_wlat,
-							&max_util);
-				}
 			}
 		}
 
-		nvme_format_iops(r_iops, r_iops_str, sizeof(r_iops_str));
-		nvme_format_iops(w_iops, w_iops_str, sizeof(w_iops_str));
+		nvme_format_iops(st->r_iops, r_iops_str, sizeof(r_iops_str));
+		nvme_format_iops(st->w_iops, w_iops_str, sizeof(w_iops_str));
 
-		nvme_format_bw(r_bw, r_bw_str, sizeof(r_bw_str));
-		nvme_format_bw(w_bw, w_bw_str, sizeof(w_bw_str));
+		nvme_format_bw(st->r_bw, r_bw_str, sizeof(r_bw_str));
+		nvme_format_bw(st->w_bw, w_bw_str, sizeof(w_bw_str));
 
-		nvme_format_lat(max_rlat, r_clat_str, sizeof(r_clat_str));
-		nvme_format_lat(max_wlat, w_clat_str, sizeof(w_clat_str));
+		nvme_format_lat(st->r_lat, r_clat_str, sizeof(r_clat_str));
+		nvme_format_lat(st->w_lat, w_clat_str, sizeof(w_clat_str));
 
 		row = table_get_row_id(t);
 		if (row < 0) {
@@ -1394,7 +1727,7 @@ static int stdout_top_draw_subsys_screen(struct dashboard_ctx *db_ctx,
 		table_set_value_str(t, ++col, row, w_clat_str, LEFT);
 		table_set_value_str(t, ++col, row, r_bw_str, LEFT);
 		table_set_value_str(t, ++col, row, w_bw_str, LEFT);
-		table_set_value_double(t, ++col, row, max_util, LEFT);
+		table_set_value_double(t, ++col, row, st->util, LEFT);
 
 		table_add_row(t, row);
 	}
@@ -1419,7 +1752,8 @@ free_tbl:
 	return ret;
 }
 
-void stdout_top(int refresh_interval)
+void stdout_top(int refresh_interval, enum nvme_cli_top_sort sort,
+		unsigned int limit)
 {
 	FILE *stream;
 	enum event_type event;
@@ -1431,6 +1765,9 @@ void stdout_top(int refresh_interval)
 	int data_start, frame_rows, quit = 0, scroll = 0;
 	int num_subsys = 0, subsys_idx = 0;
 
+	top_cfg.sort = sort;
+	top_cfg.limit = limit;
+
 	ctx = stdout_top_rescan_topology();
 	if (!ctx)
 		return;
@@ -1453,7 +1790,7 @@ void stdout_top(int refresh_interval)
 	subsys_idx = 0;
 	while (!quit) {
 		if (stdout_top_draw_subsys_screen(db_ctx, stream, subsys_arr,
-				num_subsys) < 0)
+				num_subsys, &subsys_idx) < 0)
 			break;
 draw:
 		/* highlight the selected @subsys_idx row */
@@ -556,40 +556,23 @@ void nvme_show_pel_vendor_specific_event(void *pevent_log_info, __u32 offset,
 	}
 }
 
-static void stdout_persistent_event_log(void *pevent_log_info, __u8 action, __u32 size,
-					const char *devname)
+/* shows events @first to @first + @nr - 1, starting at @offset */
+static void stdout_pel_events(void *pevent_log_info, __u32 offset, __u32 size,
+			      __u32 first, __u32 nr, const char *devname)
 {
-	struct nvme_persistent_event_log *pevent_log_head;
-	__u32 offset = sizeof(*pevent_log_head);
-	__u16 vsil, el;
 	struct nvme_persistent_event_entry *pevent_entry_head;
 	int human = stdout_print_ops.flags & VERBOSE;
+	__u16 vsil, el;
 
-	printf("Persistent Event Log for device: %s\n", devname);
-	printf("Action for Persistent Event Log: %u\n", action);
-
-	if (size < offset) {
-		printf("No log data can be shown with this log len at least " \
-		       "512 bytes is required or can be 0 to read the complete " \
-		       "log page after context established\n");
-		return;
-	}
-
-	pevent_log_head = pevent_log_info;
-
-	nvme_show_pel_header(pevent_log_head, human);
-
-	printf("\n");
-	printf("\nPersistent Event Entries:\n");
-	for (int i = 0; i < le32_to_cpu(pevent_log_head->tnev); i++) {
-		if (offset + sizeof(*pevent_entry_head) >= size)
+	for (__u32 i = first; i < first + nr; i++) {
+		if (offset + sizeof(*pevent_entry_head) > size)
 			break;
 
 		pevent_entry_head = pevent_log_info + offset;
 		vsil = le16_to_cpu(pevent_entry_head->vsil);
 		el = le16_to_cpu(pevent_entry_head->el);
 
-		if ((offset + pevent_entry_head->ehl + 3 + el) >= size)
+		if (offset + pevent_entry_head->ehl + 3 + el > size)
 			break;
 
 		nvme_show_pel_event_header(i, pevent_entry_head, human);
@@ -662,6 +645,47 @@ static void stdout_persistent_event_log(void *pevent_log_info, __u8 action, __u3
 	}
 }
 
+static void stdout_persistent_event_log_start(struct nvme_persistent_event_log *pevent_log_head,
+					      __u8 action, const char *devname,
+					      struct json_object **events)
+{
+	int human = stdout_print_ops.flags & VERBOSE;
+
+	printf("Persistent Event Log for device: %s\n", devname);
+	printf("Action for Persistent Event Log: %u\n", action);
+
+	nvme_show_pel_header(pevent_log_head, human);
+
+	printf("\n");
+	printf("\nPersistent Event Entries:\n");
+}
+
+static void stdout_persistent_event_entries(void *pevent_entries, __u32 nr, __u32 size,
+					    __u32 first, const char *devname,
+					    struct json_object *events)
+{
+	stdout_pel_events(pevent_entries, 0, size, first, nr, devname);
+}
+
+static void stdout_persistent_event_log(void *pevent_log_info, __u8 action, __u32 size,
+					const char *devname)
+{
+	struct nvme_persistent_event_log *pevent_log_head = pevent_log_info;
+
+	if (size < sizeof(*pevent_log_head)) {
+		printf("Persistent Event Log for device: %s\n", devname);
+		printf("Action for Persistent Event Log: %u\n", action);
+		printf("No log data can be shown with this log len at least " \
+		       "512 bytes is required or can be 0 to read the complete " \
+		       "log page after context established\n");
+		return;
+	}
+
+	stdout_persistent_event_log_start(pevent_log_head, action, devname, NULL);
+	stdout_pel_events(pevent_log_info, sizeof(*pevent_log_head), size, 0,
+			  le32_to_cpu(pevent_log_head->tnev), devname);
+}
+
 static void stdout_endurance_group_event_agg_log(
 		struct nvme_aggregate_endurance_group_event *endurance_log,
 		__u64 log_entries, __u32 size, const char *devname)
@@ -4275,7 +4299,7 @@ static void stdout_error_log(struct nvme_error_log_page *err_log, int entries,
 		printf(".................\n");
 	}
 
-	if (entries == filtered)
+	if (entries && entries == filtered)
 		printf("all entries filtered\n");
 }
 
@@ -7039,6 +7063,9 @@ static struct print_ops stdout_print_ops = {
 	.ns_list_log			= stdout_changed_ns_list_log,
 	.nvm_id_ns			= stdout_nvm_id_ns,
 	.persistent_event_log		= stdout_persistent_event_log,
+	.persistent_event_log_start	= stdout_persistent_event_log_start,
+	.persistent_event_entries	= stdout_persistent_event_entries,
+	.persistent_event_log_finish	= NULL,
 	.predictable_latency_event_agg_log = stdout_predictable_latency_event_agg_log,
 	.predictable_latency_per_nvmset	= stdout_predictable_latency_per_nvmset,
 	.primary_ctrl_cap		= stdout_primary_ctrl_cap,
@@ -7067,6 +7094,8 @@ static struct print_ops stdout_print_ops = {
 	.d				= stdout_d,
 	.show_init			= NULL,
 	.show_finish			= NULL,
+	.show_device			= NULL,
+	.show_devices_finish		= NULL,
 	.mgmt_addr_list_log		= stdout_mgmt_addr_list_log,
 	.rotational_media_info_log	= stdout_rotational_media_info_log,
 	.dispersed_ns_psub_log		= stdout_dispersed_ns_psub_log,
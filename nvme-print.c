@@ -39,6 +39,8 @@ static struct print_ops *nvme_print_ops(nvme_print_flags_t flags)
 		ops = nvme_get_json_print_ops(flags);
 	else if (flags & BINARY)
 		ops = nvme_get_binary_print_ops(flags);
+	else if (flags & CBOR)
+		ops = nvme_get_cbor_print_ops(flags);
 	else
 		ops = nvme_get_stdout_print_ops(flags);
 
@@ -264,6 +266,34 @@ void nvme_show_persistent_event_log(void *pevent_log_info,
 		   pevent_log_info, action, size, devname);
 }
 
+/*
+ * Shows a persistent event log as it is read: the header first, then the
+ * events in the order they arrive. @first is the number of the first of
+ * the @nr events in @pevent_entries.
+ */
+void nvme_show_persistent_event_log_start(
+	struct nvme_persistent_event_log *pevent_log_head, __u8 action,
+	const char *devname, struct json_object **events,
+	nvme_print_flags_t flags)
+{
+	nvme_print(persistent_event_log_start, flags,
+		   pevent_log_head, action, devname, events);
+}
+
+void nvme_show_persistent_event_entries(void *pevent_entries, __u32 nr,
+	__u32 size, __u32 first, const char *devname,
+	struct json_object *events, nvme_print_flags_t flags)
+{
+	nvme_print(persistent_event_entries, flags,
+		   pevent_entries, nr, size, first, devname, events);
+}
+
+void nvme_show_persistent_event_log_finish(struct json_object *events,
+	nvme_print_flags_t flags)
+{
+	nvme_print(persistent_event_log_finish, flags, events);
+}
+
 void nvme_show_endurance_group_event_agg_log(
 	struct nvme_aggregate_endurance_group_event *endurance_log,
 	__u64 log_entries, __u32 size, const char *devname,
@@ -1705,9 +1735,10 @@ void nvme_show_list_items(struct libnvme_global_ctx *ctx, nvme_print_flags_t fla
 	nvme_print(list_items, flags, ctx);
 }
 
-void nvme_show_top(nvme_print_flags_t flags, int refresh_interval)
+void nvme_show_top(nvme_print_flags_t flags, int refresh_interval,
+		   enum nvme_cli_top_sort sort, unsigned int limit)
 {
-	nvme_print(top, flags, refresh_interval);
+	nvme_print(top, flags, refresh_interval, sort, limit);
 }
 
 void nvme_show_topology(struct libnvme_global_ctx *ctx,
@@ -1796,6 +1827,21 @@ void nvme_show_finish(void)
 	nvme_print_output_format(show_finish);
 }
 
+/*
+ * Output of a command run on several devices: everything shown after
+ * nvme_show_device() belongs to that device, until the next call or
+ * nvme_show_devices_finish().
+ */
+void nvme_show_device(const char *devname, nvme_print_flags_t flags)
+{
+	nvme_print(show_device, flags, devname);
+}
+
+void nvme_show_devices_finish(nvme_print_flags_t flags)
+{
+	nvme_print(show_devices_finish, flags);
+}
+
 void nvme_show_mgmt_addr_list_log(struct nvme_mgmt_addr_list_log *ma_list, nvme_print_flags_t flags)
 {
 	nvme_print(mgmt_addr_list_log, flags, ma_list);
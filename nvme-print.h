@@ -78,6 +78,9 @@ struct print_ops {
 	void (*ns_list_log)(struct nvme_ns_list *log, const char *devname, bool alloc);
 	void (*nvm_id_ns)(struct nvme_nvm_id_ns *nvm_ns, unsigned int nsid, struct nvme_id_ns *ns, unsigned int lba_index, bool cap_only);
 	void (*persistent_event_log)(void *pevent_log_info, __u8 action, __u32 size, const char *devname);
+	void (*persistent_event_log_start)(struct nvme_persistent_event_log *pevent_log_head, __u8 action, const char *devname, struct json_object **events);
+	void (*persistent_event_entries)(void *pevent_entries, __u32 nr, __u32 size, __u32 first, const char *devname, struct json_object *events);
+	void (*persistent_event_log_finish)(struct json_object *events);
 	void (*power_meas_log)(struct nvme_power_meas_log *log, __u32 size);
 	void (*predictable_latency_event_agg_log)(struct nvme_aggregate_predictable_lat_event *pea_log, __u64 log_entries, __u32 size, const char *devname);
 	void (*predictable_latency_per_nvmset)(struct nvme_nvmset_predictable_lat_log *plpns_log, __u16 nvmset_id, const char *devname);
@@ -108,6 +111,8 @@ struct print_ops {
 	void (*d)(unsigned char *buf, int len, int width, int group);
 	void (*show_init)(void);
 	void (*show_finish)(void);
+	void (*show_device)(const char *devname);
+	void (*show_devices_finish)(void);
 	void (*mgmt_addr_list_log)(struct nvme_mgmt_addr_list_log *ma_log);
 	void (*rotational_media_info_log)(struct nvme_rotational_media_info_log *info);
 	void (*dispersed_ns_psub_log)(struct nvme_dispersed_ns_participating_nss_log *log);
@@ -129,7 +134,8 @@ struct print_ops {
 	void (*topology_tabular)(struct libnvme_global_ctx *ctx);
 
 	/* nvme top */
-	void (*top)(int refresh_interval);
+	void (*top)(int refresh_interval, enum nvme_cli_top_sort sort,
+		    unsigned int limit);
 
 	/* status and error messages */
 	void (*connect_msg)(libnvme_ctrl_t c);
@@ -177,8 +183,10 @@ static inline struct print_ops *nvme_get_json_print_ops(nvme_print_flags_t flags
 
 struct print_ops *nvme_get_stdout_print_ops(nvme_print_flags_t flags);
 struct print_ops *nvme_get_binary_print_ops(nvme_print_flags_t flags);
+struct print_ops *nvme_get_cbor_print_ops(nvme_print_flags_t flags);
 
-void stdout_top(int refresh_interval);
+void stdout_top(int refresh_interval, enum nvme_cli_top_sort sort,
+		unsigned int limit);
 
 void nvme_show_status(int status);
 void nvme_show_err(int err, const char *fmt, ...);
@@ -235,6 +243,15 @@ void nvme_show_predictable_latency_event_agg_log(
 void nvme_show_persistent_event_log(void *pevent_log_info,
 	__u8 action, __u32 size, const char *devname,
 	nvme_print_flags_t flags);
+void nvme_show_persistent_event_log_start(
+	struct nvme_persistent_event_log *pevent_log_head, __u8 action,
+	const char *devname, struct json_object **events,
+	nvme_print_flags_t flags);
+void nvme_show_persistent_event_entries(void *pevent_entries, __u32 nr,
+	__u32 size, __u32 first, const char *devname,
+	struct json_object *events, nvme_print_flags_t flags);
+void nvme_show_persistent_event_log_finish(struct json_object *events,
+	nvme_print_flags_t flags);
 void nvme_show_endurance_group_event_agg_log(
 	struct nvme_aggregate_endurance_group_event *endurance_log,
 	__u64 log_entries, __u32 size, const char *devname,
@@ -288,7 +305,8 @@ void nvme_show_topology(struct libnvme_global_ctx *ctx,
 void nvme_show_topology_tabular(struct libnvme_global_ctx *ctx, nvme_print_flags_t flags);
 void nvme_show_feature(enum nvme_features_id fid, int sel, unsigned int result,
 		       void *buf, __u32 data_len, nvme_print_flags_t flags);
-void nvme_show_top(nvme_print_flags_t flags, int refresh_interval);
+void nvme_show_top(nvme_print_flags_t flags, int refresh_interval,
+		   enum nvme_cli_top_sort sort, unsigned int limit);
 void nvme_feature_show_fields(enum nvme_features_id fid, unsigned int result, unsigned char *buf);
 void nvme_directive_show(__u8 type, __u8 oper, __u16 spec, __u32 nsid, __u64 result,
 	void *buf, __u32 len, nvme_print_flags_t flags);
@@ -378,6 +396,8 @@ void nvme_show_perror(const char *msg, ...);
 void nvme_show_error_status(int status, const char *msg, ...);
 void nvme_show_init(void);
 void nvme_show_finish(void);
+void nvme_show_device(const char *devname, nvme_print_flags_t flags);
+void nvme_show_devices_finish(nvme_print_flags_t flags);
 void nvme_show_key_value(const char *key, const char *value, ...);
 bool nvme_is_fabrics_reg(int offset);
 bool nvme_is_fabrics_optional_reg(int offset);
@@ -0,0 +1,1071 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * nvme-snapshot.c - collect the identify data and log pages of a controller
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * The collection runs in rounds, each one depending on the data of the
+ * previous: the identify controller data and the Supported Log Pages log
+ * first, then the Commands Supported and Effects log and the namespace
+ * list, then every log page the controller supports and the identify
+ * data of its namespaces, and last the bodies of the telemetry and
+ * persistent event logs, whose sizes are only known from their headers.
+ * The commands of a round are pipelined on an nvme_ioq, unless the
+ * effects log asks for Get Log Page or Identify to be serialized.
+ *
+ * Every log page is read with Retain Asynchronous Event set, and pages
+ * which are cleared by reading them are left alone. Taking a snapshot
+ * still creates a new host-initiated telemetry log, unless --no-telemetry
+ * is given, and establishes a persistent event log reporting context,
+ * which is released again before exiting. The pages are written
+ * as they were returned, next to their decoded form and an index, into
+ * one tar archive per controller.
+ */
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
+
+#include <libnvme.h>
+
+#include "common.h"
+#include "logging.h"
+#include "nvme-cmds.h"
+#include "nvme-ioq.h"
+#include "nvme-multi.h"
+#include "nvme-print.h"
+#include "nvme.h"
+#include "util/sighdl.h"
+
+#define SNAP_HDR_SIZE		512
+#define SNAP_ID_SIZE		4096
+#define SNAP_MAX_XFER		(1024 * 1024)
+#define SNAP_MAX_XFER_NUMDL	(256 * 1024)	/* without NUMDU */
+#define SNAP_MAX_LOG_SIZE	(256 * 1024 * 1024)
+#define SNAP_NS_LIST_MAX	1024
+
+/* bits of a Supported Log Pages entry */
+#define SNAP_LID_LSUPP		(1 << 0)
+
+#define TAR_BLOCK		512
+
+struct snap_cfg {
+	char *dir;
+	__u32 depth;
+	__u32 vendor_size;
+	bool no_telemetry;
+	struct argconfig_commandline_options *opts;
+};
+
+struct snap_dev;
+
+struct snap_page {
+	char name[32];
+	bool identify;
+	__u8 id;		/* LID or CNS */
+	__u8 lsp;
+	__u32 nsid;
+	__u32 size;
+	__u32 fetched;
+	void *buf;
+	int err;
+	bool truncated;
+	void (*show)(struct snap_dev *sd, struct snap_page *p,
+		     nvme_print_flags_t flags);
+};
+
+struct snap_dev {
+	struct libnvme_transport_handle *hdl;
+	const char *devname;
+	struct snap_cfg *cfg;
+	struct snap_page *pages;
+	unsigned int nr;
+	unsigned int depth;
+	__u32 xfer;
+	bool lpo;
+	bool pevent_ctx;
+};
+
+struct snap_result {
+	char path[PATH_MAX];
+	unsigned int pages;
+	unsigned int failed;
+};
+
+/* the printers write to stdout, which is redirected while decoding */
+static pthread_mutex_t snap_decode_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static struct snap_page *snap_find(struct snap_dev *sd, bool identify,
+				   __u8 id)
+{
+	unsigned int i;
+
+	for (i = 0; i < sd->nr; i++)
+		if (sd->pages[i].identify == identify && sd->pages[i].id == id)
+			return &sd->pages[i];
+
+	return NULL;
+}
+
+/* data of a page which was read completely, or NULL */
+static void *snap_data(struct snap_dev *sd, bool identify, __u8 id)
+{
+	struct snap_page *p = snap_find(sd, identify, id);
+
+	return p && !p->err ? p->buf : NULL;
+}
+
+static struct snap_page *snap_add(struct snap_dev *sd, const char *name,
+				  bool identify, __u8 id, __u32 nsid,
+				  __u32 size)
+{
+	struct snap_page *pages, *p;
+
+	pages = realloc(sd->pages, (sd->nr + 1) * sizeof(*pages));
+	if (!pages)
+		return NULL;
+	sd->pages = pages;
+
+	p = &pages[sd->nr];
+	memset(p, 0, sizeof(*p));
+	p->buf = libnvme_alloc(size);
+	if (!p->buf)
+		return NULL;
+
+	snprintf(p->name, sizeof(p->name), "%s", name);
+	p->identify = identify;
+	p->id = id;
+	p->nsid = nsid;
+	p->size = size;
+	sd->nr++;
+
+	return p;
+}
+
+/*
+ * Extends @p to @size bytes, the part already read is kept. Without
+ * offset support the page is read again from the start, in one command.
+ */
+static int snap_extend(struct snap_dev *sd, struct snap_page *p, __u32 size)
+{
+	void *buf;
+
+	if (size > SNAP_MAX_LOG_SIZE) {
+		size = SNAP_MAX_LOG_SIZE;
+		p->truncated = true;
+	}
+	if (size <= p->size)
+		return 0;
+	if (!sd->lpo) {
+		if (size > sd->xfer) {
+			size = sd->xfer;
+			p->truncated = true;
+		}
+		p->fetched = 0;
+	}
+
+	buf = libnvme_realloc(p->buf, size);
+	if (!buf)
+		return -ENOMEM;
+	p->buf = buf;
+	p->size = size;
+
+	return 0;
+}
+
+static void snap_init_cmd(struct snap_page *p, __u32 off, __u32 len,
+			  struct libnvme_passthru_cmd *cmd)
+{
+	void *data = (__u8 *)p->buf + off;
+
+	if (p->identify) {
+		nvme_init_identify(cmd, p->nsid, NVME_CSI_NVM, p->id, data, len);
+		return;
+	}
+
+	nvme_init_get_log(cmd, p->nsid, p->id, NVME_CSI_NVM, data, len);
+	cmd->cdw10 |= NVME_FIELD_ENCODE(p->lsp,
+					NVME_LOG_CDW10_LSP_SHIFT,
+					NVME_LOG_CDW10_LSP_MASK) |
+		      NVME_FIELD_ENCODE(1,
+					NVME_LOG_CDW10_RAE_SHIFT,
+					NVME_LOG_CDW10_RAE_MASK);
+	nvme_init_get_log_lpo(cmd, off);
+}
+
+static void snap_complete(struct snap_dev *sd, struct nvme_ioq_req *req)
+{
+	struct snap_page *p = &sd->pages[req->tag >> 32];
+
+	if (req->err && !p->err)
+		p->err = req->err;
+
+	/* released by snap_release_pevent() even if a later command fails */
+	if (!req->err && !p->identify &&
+	    p->id == NVME_LOG_LID_PERSISTENT_EVENT &&
+	    p->lsp == NVME_PEVENT_LOG_EST_CTX_AND_READ)
+		sd->pevent_ctx = true;
+}
+
+/* reads the part of every page which was not read yet */
+static int snap_fetch(struct snap_dev *sd)
+{
+	struct nvme_ioq_req *req;
+	struct snap_page *p;
+	struct nvme_ioq *q;
+	unsigned int i;
+	__u32 off, len;
+	int err;
+
+	err = nvme_ioq_open(sd->hdl, sd->depth, 0, 0, &q);
+	if (err)
+		return err;
+
+	for (i = 0; i < sd->nr && !nvme_sigint_received; i++) {
+		p = &sd->pages[i];
+		if (p->err)
+			continue;
+
+		for (off = p->fetched; off < p->size; off += len) {
+			len = min(p->size - off, sd->xfer);
+
+			req = nvme_ioq_next(q);
+			if (req->state == NVME_IOQ_DONE)
+				snap_complete(sd, req);
+
+			snap_init_cmd(p, off, len, &req->cmd);
+			req->admin = true;
+			req->tag = (__u64)i << 32 | off;
+			nvme_ioq_submit(q, req);
+		}
+		p->fetched = p->size;
+	}
+
+	while ((req = nvme_ioq_reap(q)))
+		snap_complete(sd, req);
+	nvme_ioq_close(q);
+
+	return nvme_sigint_received ? -EINTR : 0;
+}
+
+static void snap_show_id_ctrl(struct snap_dev *sd, struct snap_page *p,
+			      nvme_print_flags_t flags)
+{
+	nvme_show_id_ctrl(p->buf, sd->devname, flags, NULL);
+}
+
+static void snap_show_id_ns(struct snap_dev *sd, struct snap_page *p,
+			    nvme_print_flags_t flags)
+{
+	nvme_show_id_ns(p->buf, p->nsid, 0, false, flags);
+}
+
+static void snap_show_ns_list(struct snap_dev *sd, struct snap_page *p,
+			      nvme_print_flags_t flags)
+{
+	nvme_show_list_ns(p->buf, flags);
+}
+
+static void snap_show_supported(struct snap_dev *sd, struct snap_page *p,
+				nvme_print_flags_t flags)
+{
+	nvme_show_supported_log(p->buf, sd->devname, flags);
+}
+
+static void snap_show_effects(struct snap_dev *sd, struct snap_page *p,
+			      nvme_print_flags_t flags)
+{
+	__cleanup_free nvme_effects_log_node_t *node = NULL;
+	struct list_head list;
+
+	node = calloc(1, sizeof(*node));
+	if (!node)
+		return;
+
+	memcpy(&node->effects, p->buf, sizeof(node->effects));
+	node->csi = NVME_CSI_NVM;
+	list_head_init(&list);
+	list_add(&list, &node->node);
+
+	nvme_print_effects_log_pages(&list, flags);
+}
+
+static void snap_show_error(struct snap_dev *sd, struct snap_page *p,
+			    nvme_print_flags_t flags)
+{
+	struct nvme_error_log_filter flt = { 0 };
+
+	nvme_show_error_log(p->buf, p->size / sizeof(struct nvme_error_log_page),
+			    sd->devname, &flt, flags);
+}
+
+static void snap_show_smart(struct snap_dev *sd, struct snap_page *p,
+			    nvme_print_flags_t flags)
+{
+	nvme_show_smart_log(p->buf, p->nsid, sd->devname, flags);
+}
+
+static void snap_show_fw(struct snap_dev *sd, struct snap_page *p,
+			 nvme_print_flags_t flags)
+{
+	nvme_show_fw_log(p->buf, sd->devname, flags);
+}
+
+static void snap_show_self_test(struct snap_dev *sd, struct snap_page *p,
+				nvme_print_flags_t flags)
+{
+	nvme_show_self_test_log(p->buf, NVME_LOG_ST_MAX_RESULTS, 0,
+				sd->devname, flags);
+}
+
+static void snap_show_pevent(struct snap_dev *sd, struct snap_page *p,
+			     nvme_print_flags_t flags)
+{
+	if (p->size > SNAP_HDR_SIZE)
+		nvme_show_persistent_event_log(p->buf, NVME_PEVENT_LOG_READ,
+					       p->size, sd->devname, flags);
+}
+
+static void snap_show_sanitize(struct snap_dev *sd, struct snap_page *p,
+			       nvme_print_flags_t flags)
+{
+	nvme_show_sanitize_log(p->buf, sd->devname, flags);
+}
+
+static bool snap_supported(struct snap_dev *sd, struct nvme_id_ctrl *ctrl,
+			   __u8 lid)
+{
+	struct nvme_supported_log_pages *supported;
+
+	supported = snap_data(sd, false, NVME_LOG_LID_SUPPORTED_LOG_PAGES);
+	if (supported)
+		return le32_to_cpu(supported->lid_support[lid]) &
+		       SNAP_LID_LSUPP;
+
+	/* what the identify data tells for controllers without the log */
+	switch (lid) {
+	case NVME_LOG_LID_ERROR:
+	case NVME_LOG_LID_SMART:
+	case NVME_LOG_LID_FW_SLOT:
+		return true;
+	case NVME_LOG_LID_CMD_EFFECTS:
+		return ctrl->lpa & NVME_CTRL_LPA_CMD_EFFECTS;
+	case NVME_LOG_LID_DEVICE_SELF_TEST:
+		return le16_to_cpu(ctrl->oacs) & NVME_CTRL_OACS_SELF_TEST;
+	case NVME_LOG_LID_TELEMETRY_HOST:
+	case NVME_LOG_LID_TELEMETRY_CTRL:
+		return ctrl->lpa & NVME_CTRL_LPA_TELEMETRY;
+	case NVME_LOG_LID_PERSISTENT_EVENT:
+		return ctrl->lpa & NVME_CTRL_LPA_PERSETENT_EVENT;
+	case NVME_LOG_LID_SANITIZE:
+		return le32_to_cpu(ctrl->sanicap);
+	default:
+		return false;
+	}
+}
+
+/* the log pages with a fixed size, or one taken from the identify data */
+static int snap_plan_logs(struct snap_dev *sd, struct nvme_id_ctrl *ctrl)
+{
+	static const struct {
+		const char *name;
+		__u8 lid;
+		__u32 size;
+		void (*show)(struct snap_dev *sd, struct snap_page *p,
+			     nvme_print_flags_t flags);
+	} logs[] = {
+		{ "error", NVME_LOG_LID_ERROR, 0, snap_show_error },
+		{ "smart", NVME_LOG_LID_SMART,
+		  sizeof(struct nvme_smart_log), snap_show_smart },
+		{ "fw-slot", NVME_LOG_LID_FW_SLOT,
+		  sizeof(struct nvme_firmware_slot), snap_show_fw },
+		{ "self-test", NVME_LOG_LID_DEVICE_SELF_TEST,
+		  sizeof(struct nvme_self_test_log), snap_show_self_test },
+		{ "sanitize", NVME_LOG_LID_SANITIZE,
+		  sizeof(struct nvme_sanitize_log_page), snap_show_sanitize },
+	};
+	struct snap_page *p;
+	char name[32];
+	__u32 size;
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(logs); i++) {
+		if (!snap_supported(sd, ctrl, logs[i].lid))
+			continue;
+
+		size = logs[i].size;
+		if (logs[i].lid == NVME_LOG_LID_ERROR)
+			size = (ctrl->elpe + 1) *
+				sizeof(struct nvme_error_log_page);
+
+		p = snap_add(sd, logs[i].name, false, logs[i].lid,
+			     NVME_NSID_ALL, size);
+		if (!p)
+			return -ENOMEM;
+		p->show = logs[i].show;
+		if (size > sd->xfer && !sd->lpo) {
+			p->size = sd->xfer;
+			p->truncated = true;
+		}
+	}
+
+	if (!sd->cfg->vendor_size)
+		return 0;
+
+	for (i = 0xc0; i <= 0xff; i++) {
+		if (!snap_supported(sd, ctrl, i))
+			continue;
+
+		snprintf(name, sizeof(name), "vendor-%02x", i);
+		p = snap_add(sd, name, false, i, NVME_NSID_ALL,
+			     min(sd->cfg->vendor_size, sd->xfer));
+		if (!p)
+			return -ENOMEM;
+		p->truncated = sd->cfg->vendor_size > sd->xfer;
+	}
+
+	return 0;
+}
+
+/* the headers of the logs whose size is only known once they are read */
+static int snap_plan_headers(struct snap_dev *sd, struct nvme_id_ctrl *ctrl)
+{
+	struct snap_page *p;
+
+	if (!sd->cfg->no_telemetry &&
+	    snap_supported(sd, ctrl, NVME_LOG_LID_TELEMETRY_HOST)) {
+		p = snap_add(sd, "telemetry-host", false,
+			     NVME_LOG_LID_TELEMETRY_HOST, NVME_NSID_NONE,
+			     SNAP_HDR_SIZE);
+		if (!p)
+			return -ENOMEM;
+		p->lsp = NVME_LOG_TELEM_HOST_LSP_CREATE;
+	}
+
+	if (snap_supported(sd, ctrl, NVME_LOG_LID_TELEMETRY_CTRL)) {
+		p = snap_add(sd, "telemetry-ctrl", false,
+			     NVME_LOG_LID_TELEMETRY_CTRL, NVME_NSID_NONE,
+			     SNAP_HDR_SIZE);
+		if (!p)
+			return -ENOMEM;
+	}
+
+	if (snap_supported(sd, ctrl, NVME_LOG_LID_PERSISTENT_EVENT)) {
+		p = snap_add(sd, "persistent-event", false,
+			     NVME_LOG_LID_PERSISTENT_EVENT, NVME_NSID_ALL,
+			     SNAP_HDR_SIZE);
+		if (!p)
+			return -ENOMEM;
+		p->lsp = NVME_PEVENT_LOG_EST_CTX_AND_READ;
+		p->show = snap_show_pevent;
+	}
+
+	return 0;
+}
+
+static int snap_plan_bodies(struct snap_dev *sd)
+{
+	struct nvme_persistent_event_log *pevent;
+	struct nvme_telemetry_log *telem;
+	struct snap_page *p;
+	int err;
+
+	p = snap_find(sd, false, NVME_LOG_LID_TELEMETRY_HOST);
+	if (p && !p->err) {
+		telem = p->buf;
+		p->lsp = NVME_LOG_TELEM_HOST_LSP_RETAIN;
+		err = snap_extend(sd, p, (le16_to_cpu(telem->dalb3) + 1) *
+				  NVME_LOG_TELEM_BLOCK_SIZE);
+		if (err)
+			return err;
+	}
+
+	p = snap_find(sd, false, NVME_LOG_LID_TELEMETRY_CTRL);
+	if (p && !p->err) {
+		telem = p->buf;
+		err = snap_extend(sd, p, (le16_to_cpu(telem->dalb3) + 1) *
+				  NVME_LOG_TELEM_BLOCK_SIZE);
+		if (err)
+			return err;
+	}
+
+	p = snap_find(sd, false, NVME_LOG_LID_PERSISTENT_EVENT);
+	if (p && !p->err) {
+		pevent = p->buf;
+		p->lsp = NVME_PEVENT_LOG_READ;
+		err = snap_extend(sd, p, min(le64_to_cpu(pevent->tll),
+					     (__u64)SNAP_MAX_LOG_SIZE + 1));
+		if (err)
+			return err;
+	}
+
+	return 0;
+}
+
+static int snap_collect(struct snap_dev *sd)
+{
+	struct nvme_cmd_effects_log *effects;
+	struct nvme_id_ctrl *ctrl;
+	struct snap_page *p;
+	__le32 *nsids;
+	__u64 max;
+	unsigned int i;
+	char name[32];
+	int err;
+
+	/* the first rounds fit the smallest transfer size there is */
+	sd->xfer = SNAP_ID_SIZE;
+
+	p = snap_add(sd, "id-ctrl", true, NVME_IDENTIFY_CNS_CTRL, 0,
+		     sizeof(struct nvme_id_ctrl));
+	if (!p)
+		return -ENOMEM;
+	p->show = snap_show_id_ctrl;
+
+	p = snap_add(sd, "supported-log-pages", false,
+		     NVME_LOG_LID_SUPPORTED_LOG_PAGES, NVME_NSID_ALL,
+		     sizeof(struct nvme_supported_log_pages));
+	if (!p)
+		return -ENOMEM;
+	p->show = snap_show_supported;
+
+	err = snap_fetch(sd);
+	if (err)
+		return err;
+
+	ctrl = snap_data(sd, true, NVME_IDENTIFY_CNS_CTRL);
+	if (!ctrl)
+		return sd->pages[0].err;
+
+	max = SNAP_MAX_XFER;
+	if (ctrl->mdts && ctrl->mdts < 20)
+		max = min(max, (1ULL << ctrl->mdts) * 4096);
+	sd->lpo = ctrl->lpa & NVME_CTRL_LPA_EXTENDED;
+	if (!sd->lpo)
+		max = min(max, (__u64)SNAP_MAX_XFER_NUMDL);
+	sd->xfer = max;
+
+	if (snap_supported(sd, ctrl, NVME_LOG_LID_CMD_EFFECTS)) {
+		p = snap_add(sd, "effects", false, NVME_LOG_LID_CMD_EFFECTS,
+			     NVME_NSID_ALL, sizeof(struct nvme_cmd_effects_log));
+		if (!p)
+			return -ENOMEM;
+		p->show = snap_show_effects;
+	}
+
+	p = snap_add(sd, "id-ns-active-list", true,
+		     NVME_IDENTIFY_CNS_NS_ACTIVE_LIST, 0,
+		     sizeof(struct nvme_ns_list));
+	if (!p)
+		return -ENOMEM;
+	p->show = snap_show_ns_list;
+
+	err = snap_fetch(sd);
+	if (err)
+		return err;
+
+	effects = snap_data(sd, false, NVME_LOG_LID_CMD_EFFECTS);
+	if (effects &&
+	    (le32_to_cpu(effects->acs[nvme_admin_get_log_page]) |
+	     le32_to_cpu(effects->acs[nvme_admin_identify])) &
+	    NVME_CMD_EFFECTS_CSE_MASK)
+		sd->depth = 1;
+
+	nsids = snap_data(sd, true, NVME_IDENTIFY_CNS_NS_ACTIVE_LIST);
+	for (i = 0; nsids && i < SNAP_NS_LIST_MAX && nsids[i]; i++) {
+		snprintf(name, sizeof(name), "id-ns-%u", le32_to_cpu(nsids[i]));
+		p = snap_add(sd, name, true, NVME_IDENTIFY_CNS_NS,
+			     le32_to_cpu(nsids[i]), sizeof(struct nvme_id_ns));
+		if (!p)
+			return -ENOMEM;
+		p->show = snap_show_id_ns;
+	}
+
+	err = snap_plan_logs(sd, ctrl);
+	if (err)
+		return err;
+
+	err = snap_plan_headers(sd, ctrl);
+	if (err)
+		return err;
+
+	err = snap_fetch(sd);
+	if (err)
+		return err;
+
+	err = snap_plan_bodies(sd);
+	if (err)
+		return err;
+
+	return snap_fetch(sd);
+}
+
+static void snap_release_pevent(struct snap_dev *sd)
+{
+	struct snap_page *p;
+	int err;
+
+	if (!sd->pevent_ctx)
+		return;
+
+	p = snap_find(sd, false, NVME_LOG_LID_PERSISTENT_EVENT);
+
+	err = nvme_get_log_persistent_event(sd->hdl,
+					    NVME_PEVENT_LOG_RELEASE_CTX,
+					    p->buf, SNAP_HDR_SIZE);
+	if (err)
+		nvme_show_error("%s: failed to release the persistent event log context: %s",
+				sd->devname, libnvme_status_to_string(err, false));
+}
+
+static void snap_free(struct snap_dev *sd)
+{
+	unsigned int i;
+
+	for (i = 0; i < sd->nr; i++)
+		libnvme_free(sd->pages[i].buf);
+	free(sd->pages);
+}
+
+static int tar_write(FILE *f, const void *buf, size_t len)
+{
+	static const char zero[TAR_BLOCK];
+	size_t pad = (TAR_BLOCK - len % TAR_BLOCK) % TAR_BLOCK;
+
+	if (fwrite(buf, 1, len, f) != len || fwrite(zero, 1, pad, f) != pad)
+		return -errno;
+
+	return 0;
+}
+
+static int tar_add(FILE *f, const char *name, time_t mtime, const void *buf,
+		   size_t len)
+{
+	__u8 hdr[TAR_BLOCK] = { 0 };
+	unsigned int sum = 0;
+	size_t i;
+	int err;
+
+	if (strlen(name) >= 100)
+		return -ENAMETOOLONG;
+
+	/* ustar header: name, mode, uid, gid, size, mtime, checksum, type */
+	memcpy(hdr, name, strlen(name));
+	snprintf((char *)hdr + 100, 8, "%07o", 0644);
+	snprintf((char *)hdr + 108, 8, "%07o", 0);
+	snprintf((char *)hdr + 116, 8, "%07o", 0);
+	snprintf((char *)hdr + 124, 12, "%011llo", (unsigned long long)len);
+	snprintf((char *)hdr + 136, 12, "%011llo", (unsigned long long)mtime);
+	memset(hdr + 148, ' ', 8);
+	hdr[156] = '0';
+	memcpy(hdr + 257, "ustar", 6);
+	memcpy(hdr + 263, "00", 2);
+
+	for (i = 0; i < sizeof(hdr); i++)
+		sum += hdr[i];
+	snprintf((char *)hdr + 148, 8, "%06o", sum);
+
+	err = tar_write(f, hdr, sizeof(hdr));
+	if (err)
+		return err;
+
+	return tar_write(f, buf, len);
+}
+
+/* runs the printer of @p with stdout redirected to a buffer */
+static int snap_decode(struct snap_dev *sd, struct snap_page *p,
+		       nvme_print_flags_t flags, char **out, size_t *len)
+{
+	FILE *tmp;
+	long size;
+	int saved, err = 0;
+
+	*out = NULL;
+	*len = 0;
+
+	tmp = tmpfile();
+	if (!tmp)
+		return -errno;
+
+	pthread_mutex_lock(&snap_decode_lock);
+	fflush(stdout);
+	saved = dup(STDOUT_FILENO);
+	if (saved < 0 || dup2(fileno(tmp), STDOUT_FILENO) < 0) {
+		err = -errno;
+	} else {
+		p->show(sd, p, flags);
+		fflush(stdout);
+		dup2(saved, STDOUT_FILENO);
+	}
+	if (saved >= 0)
+		close(saved);
+	pthread_mutex_unlock(&snap_decode_lock);
+
+	if (err)
+		goto out;
+
+	size = lseek(fileno(tmp), 0, SEEK_END);
+	if (size <= 0)
+		goto out;
+
+	*out = malloc(size);
+	if (!*out) {
+		err = -ENOMEM;
+		goto out;
+	}
+	if (pread(fileno(tmp), *out, size, 0) != size) {
+		err = -EIO;
+		free(*out);
+		*out = NULL;
+		goto out;
+	}
+	*len = size;
+out:
+	fclose(tmp);
+	return err;
+}
+
+/* writes @str, of at most @len characters, as a JSON string */
+static int snap_json_str(FILE *f, const char *str, size_t len)
+{
+	size_t i;
+
+	/* identify strings are padded with spaces */
+	len = strnlen(str, len);
+	while (len && str[len - 1] == ' ')
+		len--;
+
+	fputc('"', f);
+	for (i = 0; i < len; i++) {
+		if (str[i] == '"' || str[i] == '\\')
+			fprintf(f, "\\%c", str[i]);
+		else if ((unsigned char)str[i] < 0x20)
+			fprintf(f, "\\u%04x", str[i]);
+		else
+			fputc(str[i], f);
+	}
+	return fputc('"', f) == EOF ? -EIO : 0;
+}
+
+static void snap_index_page(FILE *f, struct snap_page *p, const char *dsuffix,
+			    bool decoded, bool last)
+{
+	fprintf(f, "    {\n      \"name\": \"%s\",\n", p->name);
+	fprintf(f, "      \"%s\": %u,\n", p->identify ? "cns" : "lid", p->id);
+	fprintf(f, "      \"nsid\": %u,\n", p->nsid);
+	if (p->err) {
+		fprintf(f, "      \"error\": ");
+		snap_json_str(f, libnvme_status_to_string(p->err, false),
+			      SIZE_MAX);
+		fprintf(f, "\n    }%s\n", last ? "" : ",");
+		return;
+	}
+	fprintf(f, "      \"size\": %u,\n", p->size);
+	if (p->truncated)
+		fprintf(f, "      \"truncated\": true,\n");
+	if (decoded)
+		fprintf(f, "      \"decoded\": \"decoded/%s%s\",\n", p->name,
+			dsuffix);
+	fprintf(f, "      \"raw\": \"raw/%s.bin\"\n", p->name);
+	fprintf(f, "    }%s\n", last ? "" : ",");
+}
+
+/* replaces the characters which do not belong into a file name */
+static void snap_file_name(char *dst, size_t size, const char *src,
+			   size_t len)
+{
+	size_t i, n = 0;
+
+	for (i = 0; i < len && src[i] && n + 1 < size; i++) {
+		if (src[i] == ' ')
+			continue;
+		dst[n++] = isalnum((unsigned char)src[i]) || src[i] == '-' ||
+			   src[i] == '.' ? src[i] : '_';
+	}
+	dst[n] = '\0';
+}
+
+static int snap_write(struct snap_dev *sd, struct snap_result *res)
+{
+	struct nvme_id_ctrl *ctrl = snap_data(sd, true, NVME_IDENTIFY_CNS_CTRL);
+	nvme_print_flags_t flags = NORMAL;
+	const char *dsuffix = ".txt";
+	static const char zero[2 * TAR_BLOCK];
+	char base[96], serial[24], stamp[32], name[256], tmp[PATH_MAX + 8];
+	__cleanup_free char *index = NULL;
+	size_t index_len = 0, len;
+	FILE *f, *idx;
+	unsigned int i;
+	struct tm tm;
+	time_t now;
+	char *out;
+	int err = 0;
+
+#ifdef CONFIG_JSONC
+	flags = JSON;
+	dsuffix = ".json";
+#endif
+
+	now = time(NULL);
+	gmtime_r(&now, &tm);
+	strftime(stamp, sizeof(stamp), "%Y%m%dT%H%M%SZ", &tm);
+	snap_file_name(serial, sizeof(serial), ctrl->sn, sizeof(ctrl->sn));
+	snprintf(base, sizeof(base), "%s-%s-%s", sd->devname, serial, stamp);
+
+	if (snprintf(res->path, sizeof(res->path), "%s/%s.tar", sd->cfg->dir,
+		     base) >= sizeof(res->path))
+		return -ENAMETOOLONG;
+	snprintf(tmp, sizeof(tmp), "%s.tmp", res->path);
+
+	f = fopen(tmp, "w");
+	if (!f)
+		return -errno;
+
+	idx = open_memstream(&index, &index_len);
+	if (!idx) {
+		err = -errno;
+		goto out;
+	}
+
+	fprintf(idx, "{\n  \"device\": \"%s\",\n  \"model\": ", sd->devname);
+	snap_json_str(idx, ctrl->mn, sizeof(ctrl->mn));
+	fprintf(idx, ",\n  \"serial\": ");
+	snap_json_str(idx, ctrl->sn, sizeof(ctrl->sn));
+	fprintf(idx, ",\n  \"firmware\": ");
+	snap_json_str(idx, ctrl->fr, sizeof(ctrl->fr));
+	fprintf(idx, ",\n  \"time\": \"%s\",\n  \"pages\": [\n", stamp);
+
+	for (i = 0; i < sd->nr && !err; i++) {
+		struct snap_page *p = &sd->pages[i];
+		bool decoded = false;
+
+		res->pages++;
+		if (p->err) {
+			res->failed++;
+			snap_index_page(idx, p, dsuffix, false, i + 1 == sd->nr);
+			continue;
+		}
+
+		snprintf(name, sizeof(name), "%s/raw/%s.bin", base, p->name);
+		err = tar_add(f, name, now, p->buf, p->size);
+		if (err || !p->show)
+			goto index;
+
+		err = snap_decode(sd, p, flags, &out, &len);
+		if (err || !out)
+			goto index;
+
+		snprintf(name, sizeof(name), "%s/decoded/%s%s", base, p->name,
+			 dsuffix);
+		err = tar_add(f, name, now, out, len);
+		decoded = !err;
+		free(out);
+index:
+		snap_index_page(idx, p, dsuffix, decoded, i + 1 == sd->nr);
+	}
+
+	fprintf(idx, "  ]\n}\n");
+	if (fclose(idx) && !err)
+		err = -errno;
+	if (err)
+		goto out;
+
+	snprintf(name, sizeof(name), "%s/index.json", base);
+	err = tar_add(f, name, now, index, index_len);
+	if (err)
+		goto out;
+
+	/* the end of the archive is marked by two empty blocks */
+	if (fwrite(zero, 1, sizeof(zero), f) != sizeof(zero))
+		err = -errno;
+out:
+	if (fclose(f) && !err)
+		err = -errno;
+	if (!err && rename(tmp, res->path))
+		err = -errno;
+	if (err)
+		unlink(tmp);
+
+	return err;
+}
+
+static int snap_dev(struct nvme_multi_dev *dev, void *arg)
+{
+	__cleanup_nvme_transport_handle struct libnvme_transport_handle *hdl = NULL;
+	__cleanup_nvme_global_ctx struct libnvme_global_ctx *ctx = NULL;
+	struct snap_cfg *cfg = arg;
+	struct snap_result *res;
+	struct snap_dev sd = {
+		.cfg = cfg,
+		.depth = cfg->depth,
+	};
+	int err;
+
+	err = open_multi_dev(dev->name, cfg->opts, &ctx, &hdl);
+	if (err)
+		return err;
+
+	sd.hdl = hdl;
+	sd.devname = libnvme_transport_handle_get_name(hdl);
+
+	err = snap_collect(&sd);
+	snap_release_pevent(&sd);
+	if (err)
+		goto out;
+
+	res = calloc(1, sizeof(*res));
+	if (!res) {
+		err = -ENOMEM;
+		goto out;
+	}
+	dev->data = res;
+
+	err = snap_write(&sd, res);
+out:
+	snap_free(&sd);
+	return err;
+}
+
+int snapshot_cmd_option(int argc, char **argv, struct command *acmd,
+			struct plugin *plugin)
+{
+	const char *desc = "Collect the identify data and every supported log "
+		"page of the controllers into one archive per controller, "
+		"with the pages as they were returned, decoded and indexed.";
+	const char *output_dir = "directory to write the archives to";
+	const char *all_devices = "collect all controllers";
+	const char *device_regex = "collect the controllers whose name, model or serial number matches this regex";
+	const char *subsys_nqn = "collect the controllers of this subsystem";
+	const char *jobs = "controllers to collect in parallel";
+	const char *queue_depth = "commands outstanding on each controller";
+	const char *vendor_log_size = "bytes to read of each vendor specific log page, 0 to skip them";
+	const char *no_telemetry = "do not create and collect the host-initiated telemetry log";
+
+	__cleanup(nvme_multi_free) struct nvme_multi m = { 0 };
+	struct snap_result *res;
+	struct snap_cfg scfg;
+	struct nvme_multi_dev *dev;
+	unsigned int i, ok = 0;
+	struct stat st;
+	int err;
+
+	struct config {
+		char *dir;
+		bool all;
+		char *regex;
+		char *nqn;
+		__u32 jobs;
+		__u32 depth;
+		__u32 vendor_size;
+		bool no_telemetry;
+	};
+
+	struct config cfg = {
+		.dir		= ".",
+		.all		= false,
+		.regex		= NULL,
+		.nqn		= NULL,
+		.jobs		= 4,
+		.depth		= 8,
+		.vendor_size	= 4096,
+		.no_telemetry	= false,
+	};
+
+	NVME_ARGS(opts,
+		  OPT_STRING("output-dir",     'd', "DIR", &cfg.dir,     output_dir),
+		  OPT_FLAG("all-devices",       0,  &cfg.all,            all_devices),
+		  OPT_STR("device-regex",       0,  &cfg.regex,          device_regex),
+		  OPT_STR("subsys-nqn",         0,  &cfg.nqn,            subsys_nqn),
+		  OPT_UINT("jobs",              0,  &cfg.jobs,           jobs),
+		  OPT_UINT("queue-depth",      'q', &cfg.depth,          queue_depth),
+		  OPT_UINT("vendor-log-size",   0,  &cfg.vendor_size,    vendor_log_size),
+		  OPT_FLAG("no-telemetry",      0,  &cfg.no_telemetry,   no_telemetry));
+
+	err = argconfig_parse(argc, argv, desc, opts);
+	if (err)
+		return err;
+
+	log_level = map_log_level(nvme_args.verbose, false);
+
+	if (!cfg.jobs || !cfg.depth) {
+		nvme_show_error("jobs and queue depth must be at least 1");
+		return -EINVAL;
+	}
+
+	if (cfg.vendor_size % 4) {
+		nvme_show_error("vendor log size must be a multiple of 4");
+		return -EINVAL;
+	}
+
+	if (stat(cfg.dir, &st) || !S_ISDIR(st.st_mode)) {
+		nvme_show_error("%s is not a directory", cfg.dir);
+		return -ENOTDIR;
+	}
+
+	err = nvme_multi_add_devs(&m, argc - optind, argv + optind);
+	if (err) {
+		nvme_show_error("failed to add controllers: %s",
+				libnvme_strerror(-err));
+		return err;
+	}
+
+	if (cfg.all || cfg.regex || cfg.nqn) {
+		err = nvme_multi_add_match(&m, cfg.regex, cfg.nqn);
+		if (err == -EINVAL) {
+			nvme_show_error("invalid regex %s", cfg.regex);
+			return err;
+		} else if (err < 0) {
+			nvme_show_error("failed to scan topology: %s",
+					libnvme_strerror(-err));
+			return err;
+		}
+	}
+
+	if (!m.nr) {
+		nvme_show_error("no controller given");
+		return -ENODEV;
+	}
+
+	scfg = (struct snap_cfg) {
+		.dir		= cfg.dir,
+		.depth		= cfg.depth,
+		.vendor_size	= cfg.vendor_size,
+		.no_telemetry	= cfg.no_telemetry,
+		.opts		= opts,
+	};
+	err = nvme_multi_run(&m, cfg.jobs, snap_dev, &scfg, NULL);
+
+	for (i = 0; i < m.nr; i++) {
+		dev = &m.devs[i];
+		res = dev->data;
+		if (dev->err) {
+			nvme_show_error("%s: snapshot failed: %s", dev->name,
+					libnvme_status_to_string(dev->err, false));
+			continue;
+		}
+		printf("%s: %s, %u pages, %u failed\n", dev->name, res->path,
+		       res->pages, res->failed);
+		ok++;
+	}
+	if (m.nr > 1)
+		printf("Snapshot: %u of %u controllers collected\n", ok, m.nr);
+
+	return err;
+}
@@ -37,11 +37,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 #ifdef NVME_HAVE_MMAP
 #include <sys/mman.h>
 #endif
+#include <sys/file.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 
@@ -51,13 +53,19 @@
 #include "fabrics.h"
 #include "logging.h"
 #include "nvme-cmds.h"
+#include "nvme-ioq.h"
+#include "nvme-log-seg.h"
+#include "nvme-multi.h"
 #include "nvme-print.h"
 #include "nvme.h"
 #include "plugin.h"
 #include "util/argconfig.h"
 #include "util/base64.h"
 #include "util/cleanup.h"
+#include "util/compress.h"
 #include "util/crc32.h"
+#include "util/pattern.h"
+#include "util/pi.h"
 #include "util/sighdl.h"
 #include "util/suffix.h"
 
@@ -181,6 +189,10 @@ static struct program nvme = {
 
 const char *uuid_index = "UUID index";
 const char *namespace_id_desired = "identifier of desired namespace";
+const char *all_devices = "run on all controllers";
+const char *device_regex = "run on the controllers whose name, model or serial number matches this regex";
+const char *subsys_nqn_filter = "run on the controllers of this subsystem";
+const char *multi_jobs = "controllers to query in parallel";
 
 static const char *app_tag = "app tag for end-to-end PI";
 static const char *app_tag_mask = "app tag mask for end-to-end PI";
@@ -227,6 +239,10 @@ static const char *start_block = "64-bit LBA of first block to access";
 static const char *storage_tag = "storage tag for end-to-end PI";
 static const char *storage_tag_check = "This bit specifies if the Storage Tag field shall be checked as\n"
 	"part of end-to-end data protection processing";
+static const char *sweep_checkpoint = "file to record sweep progress in and resume from";
+static const char *sweep_queue_depth = "commands in flight while sweeping";
+static const char *sweep_range = "number of blocks to sweep from --start-block";
+static const char *sweep_to_end = "sweep from --start-block to the end of the namespace";
 static const char *uuid_index_specify = "specify uuid index";
 static const char dash[51] = {[0 ... 49] = '=', '\0'};
 static const char space[51] = {[0 ... 49] = ' ', '\0'};
@@ -364,18 +380,82 @@ static void setup_transport_handle(struct libnvme_global_ctx *ctx,
 		libnvme_transport_handle_set_timeout(hdl, nvme_args.timeout);
 }
 
+/* opens the device named by the first argument left after parse_args() */
+static int open_parsed(struct libnvme_global_ctx **ctx,
+		       struct libnvme_transport_handle **hdl, int argc,
+		       char **argv, const char *desc,
+		       struct argconfig_commandline_options *opts)
+{
+	struct libnvme_transport_handle *hdl_new;
+	struct libnvme_global_ctx *ctx_new;
+	int ret;
+
+	ctx_new = libnvme_create_global_ctx(stdout, log_level);
+	if (!ctx_new)
+		return -ENOMEM;
+
+	libnvme_set_ioctl_probing(ctx_new,
+		!argconfig_parse_seen(opts, "no-ioctl-probing"));
+
+	ret = get_transport_handle(ctx_new, argc, argv, O_RDONLY, &hdl_new);
+	if (ret) {
+		libnvme_free_global_ctx(ctx_new);
+		argconfig_print_help(desc, opts);
+		return -ENXIO;
+	}
+
+	setup_transport_handle(ctx_new, hdl_new, opts);
+
+	*ctx = ctx_new;
+	*hdl = hdl_new;
+
+	return 0;
+}
+
 int parse_and_open(struct libnvme_global_ctx **ctx,
 		   struct libnvme_transport_handle **hdl, int argc, char **argv,
 		   const char *desc, struct argconfig_commandline_options *opts)
 {
-	struct libnvme_transport_handle *hdl_new;
-	struct libnvme_global_ctx *ctx_new;
 	int ret;
 
 	ret = parse_args(argc, argv, desc, opts);
 	if (ret)
 		return ret;
 
+	return open_parsed(ctx, hdl, argc, argv, desc, opts);
+}
+
+int parse_and_open_devs(struct libnvme_global_ctx **ctx,
+			struct libnvme_transport_handle **hdl, int argc,
+			char **argv, const char *desc,
+			struct argconfig_commandline_options *opts,
+			struct multi_devs_cfg *devs)
+{
+	int ret;
+
+	ret = parse_args(argc, argv, desc, opts);
+	if (ret)
+		return ret;
+
+	if (multi_devs_requested(devs, argc))
+		return 0;
+
+	return open_parsed(ctx, hdl, argc, argv, desc, opts);
+}
+
+/*
+ * Opens @devname from a worker of nvme_multi_run(), with a global context
+ * of its own. Errors are left to the caller to report.
+ */
+int open_multi_dev(const char *devname,
+		   struct argconfig_commandline_options *opts,
+		   struct libnvme_global_ctx **ctx,
+		   struct libnvme_transport_handle **hdl)
+{
+	struct libnvme_transport_handle *hdl_new;
+	struct libnvme_global_ctx *ctx_new;
+	int ret;
+
 	ctx_new = libnvme_create_global_ctx(stdout, log_level);
 	if (!ctx_new)
 		return -ENOMEM;
@@ -383,11 +463,10 @@ int parse_and_open(struct libnvme_global_ctx **ctx,
 	libnvme_set_ioctl_probing(ctx_new,
 		!argconfig_parse_seen(opts, "no-ioctl-probing"));
 
-	ret = get_transport_handle(ctx_new, argc, argv, O_RDONLY, &hdl_new);
+	ret = libnvme_open(ctx_new, devname, &hdl_new);
 	if (ret) {
 		libnvme_free_global_ctx(ctx_new);
-		argconfig_print_help(desc, opts);
-		return -ENXIO;
+		return ret;
 	}
 
 	setup_transport_handle(ctx_new, hdl_new, opts);
@@ -480,9 +559,13 @@ int validate_output_format(const char *format, nvme_print_flags_t *flags)
 #ifdef CONFIG_JSONC
 	else if (!strcmp(format, "json"))
 		f = JSON;
+	else if (!strcmp(format, "ndjson"))
+		f = JSON | NDJSON;
 #endif /* CONFIG_JSONC */
 	else if (!strcmp(format, "binary"))
 		f = BINARY;
+	else if (!strcmp(format, "cbor"))
+		f = CBOR;
 	else if (!strcmp(format, "tabular"))
 		f = TABULAR;
 	else
@@ -500,7 +583,108 @@ bool nvme_is_output_format_json(void)
 	if (validate_output_format(nvme_args.output_format, &flags))
 		return false;
 
-	return flags == JSON;
+	return flags & JSON;
+}
+
+bool multi_devs_requested(struct multi_devs_cfg *cfg, int argc)
+{
+	return cfg->all || cfg->regex || cfg->nqn || argc - optind > 1;
+}
+
+static int multi_log_dev(struct nvme_multi_dev *dev, void *arg)
+{
+	__cleanup_nvme_global_ctx struct libnvme_global_ctx *ctx = NULL;
+	__cleanup_nvme_transport_handle struct libnvme_transport_handle *hdl = NULL;
+	struct multi_log_job *job = arg;
+	int err;
+
+	err = open_multi_dev(dev->name, job->opts, &ctx, &hdl);
+	if (err)
+		return err;
+
+	return job->fetch(hdl, dev, job->arg);
+}
+
+/*
+ * Fetches a log from several controllers, up to cfg->jobs at a time, and
+ * shows them in the order given as one document keyed by device.
+ */
+int multi_log(struct multi_log_job *job, struct multi_devs_cfg *cfg,
+	      int argc, char **argv, nvme_print_flags_t flags)
+{
+	__cleanup(nvme_multi_free) struct nvme_multi m = { 0 };
+	struct nvme_multi_dev *dev;
+	unsigned int i;
+	int err;
+
+	if (flags & BINARY) {
+		nvme_show_error("binary output is not supported for several devices");
+		return -EINVAL;
+	}
+
+	if (!cfg->jobs) {
+		nvme_show_error("Invalid number of jobs");
+		return -EINVAL;
+	}
+
+	err = nvme_multi_add_devs(&m, argc - optind, argv + optind);
+	if (err) {
+		nvme_show_error("failed to add controllers: %s",
+				libnvme_strerror(-err));
+		return err;
+	}
+
+	if (cfg->all || cfg->regex || cfg->nqn) {
+		err = nvme_multi_add_match(&m, cfg->regex, cfg->nqn);
+		if (err == -EINVAL) {
+			nvme_show_error("invalid regex %s", cfg->regex);
+			return err;
+		} else if (err < 0) {
+			nvme_show_error("failed to scan topology: %s",
+					libnvme_strerror(-err));
+			return err;
+		}
+	}
+
+	if (!m.nr) {
+		nvme_show_error("no controller matches");
+		return -ENODEV;
+	}
+
+	err = nvme_multi_run(&m, cfg->jobs, multi_log_dev, job, NULL);
+
+	for (i = 0; i < m.nr; i++) {
+		dev = &m.devs[i];
+		nvme_show_device(dev->name, flags);
+		if (dev->err)
+			nvme_show_error("%s: %s", dev->name,
+					libnvme_status_to_string(dev->err, false));
+		else
+			job->show(dev, job->arg, flags);
+	}
+	nvme_show_devices_finish(flags);
+
+	return err;
+}
+
+static int smart_log_fetch(struct libnvme_transport_handle *hdl,
+			   struct nvme_multi_dev *dev, void *arg)
+{
+	__u32 *nsid = arg;
+
+	dev->data = calloc(1, sizeof(struct nvme_smart_log));
+	if (!dev->data)
+		return -ENOMEM;
+
+	return nvme_get_log_smart(hdl, *nsid, dev->data);
+}
+
+static void smart_log_show(struct nvme_multi_dev *dev, void *arg,
+			   nvme_print_flags_t flags)
+{
+	__u32 *nsid = arg;
+
+	nvme_show_smart_log(dev->data, *nsid, dev->name, flags);
 }
 
 static int get_smart_log(int argc, char **argv, struct command *acmd, struct plugin *plugin)
@@ -520,20 +704,24 @@ static int get_smart_log(int argc, char **argv, struct command *acmd, struct plu
 		__u32	namespace_id;
 		bool	raw_binary;
 		bool	human_readable;
+		struct multi_devs_cfg devs;
 	};
 
 	struct config cfg = {
 		.namespace_id	= NVME_NSID_ALL,
 		.raw_binary	= false,
 		.human_readable	= false,
+		.devs		= { .jobs = 8 },
 	};
 
 	NVME_ARGS(opts,
 		  OPT_UINT("namespace-id",   'n', &cfg.namespace_id,   namespace),
 		  OPT_FLAG("raw-binary",     'b', &cfg.raw_binary,     raw_output),
-		  OPT_FLAG("human-readable", 'H', &cfg.human_readable, human_readable_info));
+		  OPT_FLAG("human-readable", 'H', &cfg.human_readable, human_readable_info),
+		  OPT_MULTI_DEVS(cfg.devs));
 
-	err = parse_and_open(&ctx, &hdl, argc, argv, desc, opts);
+	err = parse_and_open_devs(&ctx, &hdl, argc, argv, desc, opts,
+				  &cfg.devs);
 	if (err)
 		return err;
 
@@ -549,6 +737,17 @@ static int get_smart_log(int argc, char **argv, struct command *acmd, struct plu
 	if (cfg.human_readable || argconfig_parse_seen(opts, "verbose"))
 		flags |= VERBOSE;
 
+	if (multi_devs_requested(&cfg.devs, argc)) {
+		struct multi_log_job job = {
+			.opts = opts,
+			.fetch = smart_log_fetch,
+			.show = smart_log_show,
+			.arg = &cfg.namespace_id,
+		};
+
+		return multi_log(&job, &cfg.devs, argc, argv, flags);
+	}
+
 	smart_log = libnvme_alloc(sizeof(*smart_log));
 	if (!smart_log)
 		return -ENOMEM;
@@ -823,6 +1022,79 @@ static int __get_telemetry_log_host(struct libnvme_transport_handle *hdl,
 	return get_log_telemetry_host(hdl, *size, buf);
 }
 
+/*
+ * Updates @buf, a log of an earlier call or NULL, reading only what
+ * changed since.
+ */
+static int __update_telemetry_log(struct libnvme_transport_handle *hdl,
+				  bool ctrl, bool rae,
+				  enum nvme_telemetry_da da,
+				  size_t *size,
+				  struct nvme_telemetry_log **buf)
+{
+	size_t offset, max_data_tx;
+	int err;
+
+	err = libnvme_get_telemetry_max(hdl, NULL, &max_data_tx);
+	if (err)
+		return err;
+	if (!max_data_tx)
+		max_data_tx = NVME_LOG_PAGE_PDU_SIZE;
+
+	err = libnvme_update_telemetry_log(hdl, ctrl, rae, max_data_tx, da,
+					   buf, size, &offset);
+	if (err)
+		return err;
+
+	if (ctrl && !(*buf)->ctrlavail)
+		printf("Warning: Telemetry Controller-Initiated Data Not Available.\n");
+	else if (log_level >= LIBNVME_LOG_INFO)
+		printf("Read %zu of %zu bytes from the controller\n",
+		       NVME_LOG_TELEM_BLOCK_SIZE + *size - offset, *size);
+
+	return 0;
+}
+
+/* reads a log saved by an earlier telemetry-log, if there is one */
+static int read_telemetry_file(const char *file,
+			       struct nvme_telemetry_log **log, size_t *size)
+{
+	__cleanup_fd int fd = -1;
+	struct stat st;
+	size_t len = 0;
+	void *buf;
+	ssize_t n;
+
+	fd = open(file, O_RDONLY);
+	if (fd < 0)
+		return errno == ENOENT ? 0 : -errno;
+
+	if (fstat(fd, &st))
+		return -errno;
+
+	/* no header, the log is read anew */
+	if (st.st_size < NVME_LOG_TELEM_BLOCK_SIZE)
+		return 0;
+
+	buf = libnvme_alloc(st.st_size);
+	if (!buf)
+		return -ENOMEM;
+
+	while (len < st.st_size) {
+		n = read(fd, buf + len, st.st_size - len);
+		if (n <= 0) {
+			libnvme_free(buf);
+			return n ? -errno : -EIO;
+		}
+		len += n;
+	}
+
+	*log = buf;
+	*size = len;
+
+	return 0;
+}
+
 static int get_telemetry_log(int argc, char **argv, struct command *acmd,
 			     struct plugin *plugin)
 {
@@ -833,16 +1105,18 @@ static int get_telemetry_log(int argc, char **argv, struct command *acmd,
 	const char *dgen = "Pick which telemetry data area to report. Default is 3 to fetch areas 1-3. Valid options are 1, 2, 3, 4.";
 	const char *mcda = "Host-init Maximum Created Data Area. Valid options are 0 ~ 4 "
 		"If given, This option will override dgen. 0 : controller determines data area";
+	const char *previous = "earlier capture of the log, only data it lacks is read if the "
+		"data generation number did not change since. May be the output file";
+	const char *compress = "compress the output file: none, rle, gzip or zstd";
 
 	__cleanup_libnvme_free struct nvme_telemetry_log *log = NULL;
 	__cleanup_libnvme_free struct nvme_id_ctrl *id_ctrl = NULL;
 	__cleanup_nvme_global_ctx struct libnvme_global_ctx *ctx = NULL;
 	__cleanup_nvme_transport_handle struct libnvme_transport_handle *hdl = NULL;
 	__cleanup_fd int output = -1;
+	struct compress_stream *cs;
 	int err = 0;
 	size_t total_size = 0;
-	__u8 *data_ptr = NULL;
-	int data_written = 0, data_remaining = 0;
 	nvme_print_flags_t flags;
 	bool da4_support = false,
 	host_behavior_changed = false;
@@ -854,6 +1128,8 @@ static int get_telemetry_log(int argc, char **argv, struct command *acmd,
 		int	data_area;
 		bool	rae;
 		__u8	mcda;
+		char	*previous;
+		__u8	compress;
 	};
 	struct config cfg = {
 		.file_name	= NULL,
@@ -862,6 +1138,8 @@ static int get_telemetry_log(int argc, char **argv, struct command *acmd,
 		.data_area	= 3,
 		.rae		= false,
 		.mcda		= 0xff,
+		.previous	= NULL,
+		.compress	= COMPRESS_NONE,
 	};
 
 	NVME_ARGS(opts,
@@ -870,7 +1148,9 @@ static int get_telemetry_log(int argc, char **argv, struct command *acmd,
 		  OPT_FLAG("controller-init", 'c', &cfg.ctrl_init, cgen),
 		  OPT_UINT("data-area",       'd', &cfg.data_area, dgen),
 		  OPT_FLAG("rae",             'r', &cfg.rae,       rae),
-		  OPT_BYTE("mcda",            'm', &cfg.mcda,      mcda));
+		  OPT_BYTE("mcda",            'm', &cfg.mcda,      mcda),
+		  OPT_FILE("previous",        'p', &cfg.previous,  previous),
+		  OPT_BYTE("compress",        0,   &cfg.compress,  compress, compress_vals));
 
 
 	err = parse_and_open(&ctx, &hdl, argc, argv, desc, opts);
@@ -898,6 +1178,17 @@ static int get_telemetry_log(int argc, char **argv, struct command *acmd,
 		cfg.data_area = cfg.mcda;
 	}
 
+	/* a newly created log always has a new data generation number */
+	if (cfg.previous && !cfg.ctrl_init && cfg.host_gen) {
+		nvme_show_error("--previous needs --controller-init or --host-generate=0");
+		return -EINVAL;
+	}
+
+	if (cfg.previous && cfg.compress != COMPRESS_NONE) {
+		nvme_show_error("--previous needs an uncompressed log");
+		return -EINVAL;
+	}
+
 	if (cfg.data_area == 4) {
 		id_ctrl = libnvme_alloc(sizeof(*id_ctrl));
 		if (!id_ctrl)
@@ -924,18 +1215,31 @@ static int get_telemetry_log(int argc, char **argv, struct command *acmd,
 		}
 	}
 
-	output = open(cfg.file_name, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (cfg.previous) {
+		err = read_telemetry_file(cfg.previous, &log, &total_size);
+		if (err) {
+			nvme_show_error("Failed to read %s: %s", cfg.previous,
+					libnvme_strerror(-err));
+			return err;
+		}
+	}
+
+	/*
+	 * The previous log may be the output file, which is only cut to
+	 * size once the new log has been written.
+	 */
+	output = open(cfg.file_name,
+		      O_WRONLY | O_CREAT | (cfg.previous ? 0 : O_TRUNC), 0666);
 	if (output < 0) {
 		nvme_show_error("Failed to open output file %s: %s!",
 				cfg.file_name, libnvme_strerror(errno));
 		return output;
 	}
 
-	log = libnvme_alloc(sizeof(*log));
-	if (!log)
-		return -ENOMEM;
-
-	if (cfg.ctrl_init)
+	if (cfg.previous)
+		err = __update_telemetry_log(hdl, cfg.ctrl_init, cfg.rae,
+					     cfg.data_area, &total_size, &log);
+	else if (cfg.ctrl_init)
 		err = __get_telemetry_log_ctrl(hdl, cfg.rae, cfg.data_area,
 					       &total_size, &log, da4_support);
 	else if (cfg.host_gen)
@@ -953,27 +1257,24 @@ static int get_telemetry_log(int argc, char **argv, struct command *acmd,
 		return err;
 	}
 
-	data_written = 0;
-	data_remaining = total_size;
-	data_ptr = (__u8 *)log;
+	cs = compress_open(output, cfg.compress);
+	if (!cs) {
+		err = -errno;
+		nvme_show_perror("compress_open");
+		return err;
+	}
+
+	/* a write error is kept by the stream and returned on close */
+	compress_write(cs, log, total_size);
+	err = compress_close(cs);
+	if (err)
+		nvme_show_error("ERROR: %s: : write failed with error : %s",
+				__func__, libnvme_strerror(-err));
 
-	while (data_remaining) {
-		data_written = write(output, data_ptr, data_remaining);
-		if (data_written < 0) {
-			err = -errno;
-			nvme_show_error("ERROR: %s: : write failed with error : %s",
-					__func__, libnvme_strerror(errno));
-			break;
-		} else if (data_written <= data_remaining) {
-			data_remaining -= data_written;
-			data_ptr += data_written;
-		} else {
-			/* Unexpected overwrite */
-			fprintf(stderr, "Failure: Unexpected telemetry log overwrite - data_remaining = 0x%x, data_written = 0x%x\n",
-					data_remaining, data_written);
-			err = -1;
-			break;
-		}
+	if (cfg.previous && !err && ftruncate(output, total_size) < 0) {
+		err = -errno;
+		nvme_show_perror(cfg.file_name);
+		return err;
 	}
 
 	if (fsync(output) < 0) {
@@ -993,6 +1294,26 @@ static int get_telemetry_log(int argc, char **argv, struct command *acmd,
 	return err;
 }
 
+static int endurance_log_fetch(struct libnvme_transport_handle *hdl,
+			       struct nvme_multi_dev *dev, void *arg)
+{
+	__u16 *group_id = arg;
+
+	dev->data = calloc(1, sizeof(struct nvme_endurance_group_log));
+	if (!dev->data)
+		return -ENOMEM;
+
+	return nvme_get_log_endurance_group(hdl, *group_id, dev->data);
+}
+
+static void endurance_log_show(struct nvme_multi_dev *dev, void *arg,
+			       nvme_print_flags_t flags)
+{
+	__u16 *group_id = arg;
+
+	nvme_show_endurance_log(dev->data, *group_id, dev->name, flags);
+}
+
 static int get_endurance_log(int argc, char **argv, struct command *acmd, struct plugin *plugin)
 {
 	const char *desc = "Retrieves endurance groups log page and prints the log.";
@@ -1006,17 +1327,21 @@ static int get_endurance_log(int argc, char **argv, struct command *acmd, struct
 
 	struct config {
 		__u16	group_id;
+		struct multi_devs_cfg devs;
 	};
 
 	struct config cfg = {
 		.group_id	= 0,
+		.devs		= { .jobs = 8 },
 	};
 
 	NVME_ARGS(opts,
-		  OPT_SHRT("group-id",     'g', &cfg.group_id,      group_id));
+		  OPT_SHRT("group-id",     'g', &cfg.group_id,      group_id),
+		  OPT_MULTI_DEVS(cfg.devs));
 
 
-	err = parse_and_open(&ctx, &hdl, argc, argv, desc, opts);
+	err = parse_and_open_devs(&ctx, &hdl, argc, argv, desc, opts,
+				  &cfg.devs);
 	if (err)
 		return err;
 
@@ -1026,6 +1351,17 @@ static int get_endurance_log(int argc, char **argv, struct command *acmd, struct
 		return err;
 	}
 
+	if (multi_devs_requested(&cfg.devs, argc)) {
+		struct multi_log_job job = {
+			.opts = opts,
+			.fetch = endurance_log_fetch,
+			.show = endurance_log_show,
+			.arg = &cfg.group_id,
+		};
+
+		return multi_log(&job, &cfg.devs, argc, argv, flags);
+	}
+
 	endurance_log = libnvme_alloc(sizeof(*endurance_log));
 	if (!endurance_log)
 		return -ENOMEM;
@@ -1200,73 +1536,374 @@ static int get_supported_log_pages(int argc, char **argv, struct command *acmd,
 	return err;
 }
 
-static int get_error_log(int argc, char **argv, struct command *acmd, struct plugin *plugin)
-{
-	const char *desc = "Retrieve specified number of "
-		"error log entries from a given device "
-		"in either decoded format (default) or binary.";
-	const char *log_entries = "number of entries to retrieve";
-	const char *status = "output specified STATUS entry only";
-	const char *nsid = "output specified NSID entry only";
-	const char *trtype = "output specified TRTYPE entry only";
-	const char *opcode = "output specified OPC entry only";
-	const char *sqid = "output specified SQID entry only";
-	const char *valid_entry = "output valid entry only";
-	const char *lba = "output specified LBA entry only";
-	const char *csi = "output specified CSI entry only";
-	const char *raw = "dump in binary format";
-
-	__cleanup_libnvme_free struct nvme_error_log_page *err_log = NULL;
-	__cleanup_nvme_global_ctx struct libnvme_global_ctx *ctx = NULL;
-	__cleanup_nvme_transport_handle struct libnvme_transport_handle *hdl = NULL;
-	struct nvme_id_ctrl ctrl = { 0 };
-	nvme_print_flags_t flags;
-	int err = -1;
-
-	struct config {
-		__u32	log_entries;
-		bool	raw_binary;
-		struct nvme_error_log_filter flt;
-	};
+struct error_log_args {
+	__u32 entries;
+	struct nvme_error_log_filter *flt;
+};
 
-	struct config cfg = {
-		.log_entries	= 64,
-		.raw_binary	= false,
-	};
+struct multi_error_log {
+	__u32 entries;
+	struct nvme_error_log_page log[];
+};
 
-	NVME_ARGS(opts,
-		  OPT_UINT("log-entries",  'e', &cfg.log_entries, log_entries),
-		  OPT_FLAG("raw-binary",   'b', &cfg.raw_binary,  raw),
-		  OPT_FLAG("valid-entry",  'V', &cfg.flt.valid,   valid_entry),
-		  OPT_SHRT("sqid",         'S', &cfg.flt.sqid,    sqid),
-		  OPT_SHRT("status",       's', &cfg.flt.status,  status),
-		  OPT_SUFFIX("lba",        'l', &cfg.flt.lba,     lba),
-		  OPT_UINT("namespace-id", 'n', &cfg.flt.nsid,    nsid),
-		  OPT_BYTE("trtype",       't', &cfg.flt.trtype,  trtype),
-		  OPT_BYTE("csi",          'c', &cfg.flt.csi,     csi),
-		  OPT_BYTE("opcode",       'O', &cfg.flt.opcode,  opcode));
+static int error_log_fetch(struct libnvme_transport_handle *hdl,
+			   struct nvme_multi_dev *dev, void *arg)
+{
+	struct error_log_args *args = arg;
+	struct multi_error_log *el;
+	struct nvme_id_ctrl ctrl;
+	__u32 entries;
+	int err;
 
-	err = parse_and_open(&ctx, &hdl, argc, argv, desc, opts);
+	err = nvme_identify_ctrl(hdl, &ctrl);
 	if (err)
 		return err;
 
-	err = validate_output_format(nvme_args.output_format, &flags);
-	if (err < 0) {
-		nvme_show_error("Invalid output format");
-		return err;
-	}
+	entries = min(args->entries, ctrl.elpe + 1);
+	el = calloc(1, sizeof(*el) + entries * sizeof(el->log[0]));
+	if (!el)
+		return -ENOMEM;
+	el->entries = entries;
+	dev->data = el;
 
-	if (cfg.raw_binary)
-		flags = BINARY;
+	return nvme_get_log_error(hdl, NVME_NSID_ALL, entries, el->log);
+}
 
-	if (!cfg.log_entries) {
-		nvme_show_error("non-zero log-entries is required param");
-		return -1;
-	}
+static void error_log_show(struct nvme_multi_dev *dev, void *arg,
+			   nvme_print_flags_t flags)
+{
+	struct error_log_args *args = arg;
+	struct multi_error_log *el = dev->data;
 
-	err = nvme_identify_ctrl(hdl, &ctrl);
-	if (err < 0) {
-		nvme_show_perror("identify controller");
+	nvme_show_error_log(el->log, el->entries, dev->name, args->flt, flags);
+}
+
+/* reads the whole of a state file into a string */
+static int state_file_read(int fd, char **buf)
+{
+	size_t len = 0;
+	ssize_t n;
+
+	do {
+		char *tmp = realloc(*buf, len + 4096 + 1);
+
+		if (!tmp)
+			return -ENOMEM;
+		*buf = tmp;
+		n = read(fd, *buf + len, 4096);
+		if (n < 0)
+			return -errno;
+		len += n;
+	} while (n);
+	(*buf)[len] = '\0';
+
+	return 0;
+}
+
+/* serial numbers are padded with spaces, and may contain some */
+static void state_file_serial(char *dst, size_t size, const char *src,
+			      size_t len)
+{
+	size_t i;
+
+	len = strnlen(src, len);
+	while (len && src[len - 1] == ' ')
+		len--;
+	len = min(len, size - 1);
+
+	for (i = 0; i < len; i++)
+		dst[i] = src[i] == ' ' ? '_' : src[i];
+	dst[len] = '\0';
+}
+
+/*
+ * The state files of --state-file have a line per controller with its
+ * serial number and two counters, which are up to the command:
+ *
+ * error-log: the error count of the newest entry seen and the number of
+ *	entries the log holds
+ * persistent-event-log: the time stamp of the newest event seen and how
+ *	many of the events seen carry that time stamp
+ */
+struct state_file_rec {
+	char serial[32];
+	__u64 val;
+	__u32 nr;
+};
+
+static int state_file_load(int fd, struct state_file_rec **recs,
+			   unsigned int *nr)
+{
+	__cleanup_free char *buf = NULL;
+	struct state_file_rec *rec, rec_new;
+	unsigned long long val;
+	char *line, *save;
+	int err;
+
+	err = state_file_read(fd, &buf);
+	if (err)
+		return err;
+
+	for (line = strtok_r(buf, "\n", &save); line;
+	     line = strtok_r(NULL, "\n", &save)) {
+		if (sscanf(line, "%31s %llu %u", rec_new.serial, &val,
+			   &rec_new.nr) != 3)
+			continue;
+		rec_new.val = val;
+
+		rec = realloc(*recs, (*nr + 1) * sizeof(*rec));
+		if (!rec)
+			return -ENOMEM;
+		*recs = rec;
+		rec[(*nr)++] = rec_new;
+	}
+
+	return 0;
+}
+
+static int state_file_save(int fd, struct state_file_rec *recs,
+			   unsigned int nr)
+{
+	unsigned int i;
+
+	if (lseek(fd, 0, SEEK_SET) < 0 || ftruncate(fd, 0))
+		return -errno;
+
+	for (i = 0; i < nr; i++)
+		if (dprintf(fd, "%s %llu %u\n", recs[i].serial,
+			    (unsigned long long)recs[i].val, recs[i].nr) < 0)
+			return -errno;
+
+	return 0;
+}
+
+/* the record of the controller with @serial, added if missing and @add */
+static struct state_file_rec *state_file_get(struct state_file_rec **recs,
+					     unsigned int *nr,
+					     const char *serial, bool add)
+{
+	struct state_file_rec *rec;
+	unsigned int i;
+
+	for (i = 0; i < *nr; i++)
+		if (!strcmp((*recs)[i].serial, serial))
+			return &(*recs)[i];
+
+	if (!add)
+		return NULL;
+
+	rec = realloc(*recs, (*nr + 1) * sizeof(*rec));
+	if (!rec)
+		return NULL;
+	*recs = rec;
+	rec = &rec[(*nr)++];
+	memset(rec, 0, sizeof(*rec));
+	strcpy(rec->serial, serial);
+
+	return rec;
+}
+
+/*
+ * Prints the entries added to the error log since the last call with the
+ * same @file. The error count of the newest entry tells how many there
+ * are, so once the controller is known only the new entries are read.
+ * The serial number is taken from sysfs when @hdl is a controller, which
+ * saves the Identify Controller command.
+ */
+static int error_log_incremental(struct libnvme_transport_handle *hdl,
+				 const char *file,
+				 struct nvme_error_log_filter *flt,
+				 nvme_print_flags_t flags)
+{
+	__cleanup_libnvme_free struct nvme_error_log_page *err_log = NULL;
+	__cleanup_free struct state_file_rec *states = NULL;
+	__cleanup_free char *path = NULL, *attr = NULL;
+	const char *name = libnvme_transport_handle_get_name(hdl);
+	struct state_file_rec *st = NULL;
+	__cleanup_fd int fd = -1;
+	struct nvme_id_ctrl ctrl;
+	unsigned int i, nr = 0;
+	char serial[32];
+	__u64 count, seen, entries;
+	int err;
+
+	fd = open(file, O_RDWR | O_CREAT, 0644);
+	if (fd < 0 || flock(fd, LOCK_EX)) {
+		err = -errno;
+		nvme_show_perror(file);
+		return err;
+	}
+
+	err = state_file_load(fd, &states, &nr);
+	if (err) {
+		nvme_show_error("failed to read %s: %s", file,
+				libnvme_strerror(-err));
+		return err;
+	}
+
+	if (asprintf(&path, "/sys/class/nvme/%s",
+		     strrchr(name, '/') ? strrchr(name, '/') + 1 : name) < 0)
+		return -ENOMEM;
+	attr = libnvme_get_attr(path, "serial");
+	if (attr) {
+		state_file_serial(serial, sizeof(serial), attr, strlen(attr));
+		st = state_file_get(&states, &nr, serial, false);
+	}
+
+	/* the number of entries is only known from the identify */
+	if (!st || !st->nr) {
+		err = nvme_identify_ctrl(hdl, &ctrl);
+		if (err) {
+			nvme_show_err(err, "identify controller");
+			return err;
+		}
+
+		state_file_serial(serial, sizeof(serial), ctrl.sn,
+				  sizeof(ctrl.sn));
+		st = state_file_get(&states, &nr, serial, true);
+		if (!st)
+			return -ENOMEM;
+		st->nr = ctrl.elpe + 1;
+	}
+
+	err_log = libnvme_alloc(st->nr * sizeof(*err_log));
+	if (!err_log)
+		return -ENOMEM;
+
+	err = nvme_get_log_error(hdl, NVME_NSID_ALL, 1, err_log);
+	if (err) {
+		nvme_show_err(err, "error log");
+		return err;
+	}
+
+	/* a lower count means the controller started counting anew */
+	count = le64_to_cpu(err_log[0].error_count);
+	seen = count < st->val ? 0 : st->val;
+	entries = min(count - seen, (__u64)st->nr);
+
+	if (entries > 1) {
+		err = nvme_get_log_error(hdl, NVME_NSID_ALL, entries, err_log);
+		if (err) {
+			nvme_show_err(err, "error log");
+			return err;
+		}
+	}
+
+	/* the newest entry comes first */
+	for (i = 0; i < entries; i++)
+		if (le64_to_cpu(err_log[i].error_count) <= seen)
+			break;
+
+	nvme_show_error_log(err_log, i, name, flt, flags);
+
+	st->val = count;
+	err = state_file_save(fd, states, nr);
+	if (err)
+		nvme_show_error("failed to update %s: %s", file,
+				libnvme_strerror(-err));
+
+	return err;
+}
+
+static int get_error_log(int argc, char **argv, struct command *acmd, struct plugin *plugin)
+{
+	const char *desc = "Retrieve specified number of "
+		"error log entries from a given device "
+		"in either decoded format (default) or binary.";
+	const char *log_entries = "number of entries to retrieve";
+	const char *status = "output specified STATUS entry only";
+	const char *nsid = "output specified NSID entry only";
+	const char *trtype = "output specified TRTYPE entry only";
+	const char *opcode = "output specified OPC entry only";
+	const char *sqid = "output specified SQID entry only";
+	const char *valid_entry = "output valid entry only";
+	const char *lba = "output specified LBA entry only";
+	const char *csi = "output specified CSI entry only";
+	const char *raw = "dump in binary format";
+	const char *state_file = "only print the entries added since the last call with this state file";
+
+	__cleanup_libnvme_free struct nvme_error_log_page *err_log = NULL;
+	__cleanup_nvme_global_ctx struct libnvme_global_ctx *ctx = NULL;
+	__cleanup_nvme_transport_handle struct libnvme_transport_handle *hdl = NULL;
+	struct nvme_id_ctrl ctrl = { 0 };
+	nvme_print_flags_t flags;
+	int err = -1;
+
+	struct config {
+		__u32	log_entries;
+		bool	raw_binary;
+		char	*state_file;
+		struct nvme_error_log_filter flt;
+		struct multi_devs_cfg devs;
+	};
+
+	struct config cfg = {
+		.log_entries	= 64,
+		.raw_binary	= false,
+		.state_file	= NULL,
+		.devs		= { .jobs = 8 },
+	};
+
+	NVME_ARGS(opts,
+		  OPT_UINT("log-entries",  'e', &cfg.log_entries, log_entries),
+		  OPT_FLAG("raw-binary",   'b', &cfg.raw_binary,  raw),
+		  OPT_FLAG("valid-entry",  'V', &cfg.flt.valid,   valid_entry),
+		  OPT_SHRT("sqid",         'S', &cfg.flt.sqid,    sqid),
+		  OPT_SHRT("status",       's', &cfg.flt.status,  status),
+		  OPT_SUFFIX("lba",        'l', &cfg.flt.lba,     lba),
+		  OPT_UINT("namespace-id", 'n', &cfg.flt.nsid,    nsid),
+		  OPT_BYTE("trtype",       't', &cfg.flt.trtype,  trtype),
+		  OPT_BYTE("csi",          'c', &cfg.flt.csi,     csi),
+		  OPT_BYTE("opcode",       'O', &cfg.flt.opcode,  opcode),
+		  OPT_FILE("state-file",    0,  &cfg.state_file,  state_file),
+		  OPT_MULTI_DEVS(cfg.devs));
+
+	err = parse_and_open_devs(&ctx, &hdl, argc, argv, desc, opts,
+				  &cfg.devs);
+	if (err)
+		return err;
+
+	if (multi_devs_requested(&cfg.devs, argc) && cfg.state_file) {
+		nvme_show_error("a state file is only supported for one device");
+		return -EINVAL;
+	}
+
+	err = validate_output_format(nvme_args.output_format, &flags);
+	if (err < 0) {
+		nvme_show_error("Invalid output format");
+		return err;
+	}
+
+	if (cfg.raw_binary)
+		flags = BINARY;
+
+	if (cfg.state_file)
+		return error_log_incremental(hdl, cfg.state_file, &cfg.flt,
+					     flags);
+
+	if (!cfg.log_entries) {
+		nvme_show_error("non-zero log-entries is required param");
+		return -1;
+	}
+
+	if (multi_devs_requested(&cfg.devs, argc)) {
+		struct error_log_args args = {
+			.entries = cfg.log_entries,
+			.flt = &cfg.flt,
+		};
+		struct multi_log_job job = {
+			.opts = opts,
+			.fetch = error_log_fetch,
+			.show = error_log_show,
+			.arg = &args,
+		};
+
+		return multi_log(&job, &cfg.devs, argc, argv, flags);
+	}
+
+	err = nvme_identify_ctrl(hdl, &ctrl);
+	if (err < 0) {
+		nvme_show_perror("identify controller");
 		return err;
 	} else if (err) {
 		nvme_show_error("could not identify controller");
@@ -1291,6 +1928,22 @@ static int get_error_log(int argc, char **argv, struct command *acmd, struct plu
 	return err;
 }
 
+static int fw_log_fetch(struct libnvme_transport_handle *hdl,
+			struct nvme_multi_dev *dev, void *arg)
+{
+	dev->data = calloc(1, sizeof(struct nvme_firmware_slot));
+	if (!dev->data)
+		return -ENOMEM;
+
+	return nvme_get_log_fw_slot(hdl, false, dev->data);
+}
+
+static void fw_log_show(struct nvme_multi_dev *dev, void *arg,
+			nvme_print_flags_t flags)
+{
+	nvme_show_fw_log(dev->data, dev->name, flags);
+}
+
 static int get_fw_log(int argc, char **argv, struct command *acmd, struct plugin *plugin)
 {
 	const char *desc = "Retrieve the firmware log for the "
@@ -1304,16 +1957,20 @@ static int get_fw_log(int argc, char **argv, struct command *acmd, struct plugin
 
 	struct config {
 		bool	raw_binary;
+		struct multi_devs_cfg devs;
 	};
 
 	struct config cfg = {
 		.raw_binary	= false,
+		.devs		= { .jobs = 8 },
 	};
 
 	NVME_ARGS(opts,
-		  OPT_FLAG("raw-binary",   'b', &cfg.raw_binary,    raw_use));
+		  OPT_FLAG("raw-binary",   'b', &cfg.raw_binary,    raw_use),
+		  OPT_MULTI_DEVS(cfg.devs));
 
-	err = parse_and_open(&ctx, &hdl, argc, argv, desc, opts);
+	err = parse_and_open_devs(&ctx, &hdl, argc, argv, desc, opts,
+				  &cfg.devs);
 	if (err)
 		return err;
 
@@ -1326,6 +1983,16 @@ static int get_fw_log(int argc, char **argv, struct command *acmd, struct plugin
 	if (cfg.raw_binary)
 		flags = BINARY;
 
+	if (multi_devs_requested(&cfg.devs, argc)) {
+		struct multi_log_job job = {
+			.opts = opts,
+			.fetch = fw_log_fetch,
+			.show = fw_log_show,
+		};
+
+		return multi_log(&job, &cfg.devs, argc, argv, flags);
+	}
+
 	fw_log = libnvme_alloc(sizeof(*fw_log));
 	if (!fw_log)
 		return -ENOMEM;
@@ -1554,62 +2221,318 @@ static int get_pred_lat_event_agg_log(int argc, char **argv,
 	return err;
 }
 
-static int get_persistent_event_log(int argc, char **argv,
-		struct command *command, struct plugin *plugin)
+#define PEVENT_CHUNK_SIZE	(64 * 1024)
+/* an event is at most a 255 byte header and 64 KiB of data */
+#define PEVENT_MAX_EVENT_SIZE	(3 + 255 + 0xffff)
+/* bits 47:0 of the event time stamp count milliseconds */
+#define PEVENT_TS_MASK		0xffffffffffffULL
+
+struct pevent_walk {
+	struct state_file_rec *st;	/* NULL without a state file */
+	bool all_new;
+	__u64 ts;			/* time stamp of the last event */
+	__u32 nr_ts;			/* events with that time stamp */
+	__u32 nr_ts_seen;		/* events with the time stamp st->val */
+};
+
+/*
+ * Events come oldest first, so the first one newer than the state is
+ * followed by new ones only. Several events may share a time stamp, the
+ * ones with the time stamp of the state are counted to tell them apart.
+ */
+static bool pevent_is_new(struct pevent_walk *w,
+			  struct nvme_persistent_event_entry *entry)
 {
-	const char *desc = "Retrieve Persistent Event log info for "
-		"the given device in either decoded format(default), json or binary.";
-	const char *action = "action the controller shall take during "
-		"processing this persistent log page command.";
-	const char *log_len = "number of bytes to retrieve";
+	__u64 ts = le64_to_cpu(entry->ets) & PEVENT_TS_MASK;
 
-	__cleanup_libnvme_free struct nvme_persistent_event_log *pevent = NULL;
-	struct nvme_persistent_event_log *pevent_collected = NULL;
-	__cleanup_huge struct libnvme_mem_huge mh = { 0, };
-	__cleanup_nvme_global_ctx struct libnvme_global_ctx *ctx = NULL;
-	__cleanup_nvme_transport_handle struct libnvme_transport_handle *hdl = NULL;
-	nvme_print_flags_t flags;
-	void *pevent_log_info;
-	int err;
+	if (ts == w->ts) {
+		w->nr_ts++;
+	} else {
+		w->ts = ts;
+		w->nr_ts = 1;
+	}
 
-	struct config {
-		__u8	action;
-		__u32	log_len;
-		bool	raw_binary;
-	};
+	if (!w->all_new && w->st) {
+		if (ts == w->st->val)
+			w->all_new = ++w->nr_ts_seen > w->st->nr;
+		else
+			w->all_new = ts > w->st->val;
+	} else {
+		w->all_new = true;
+	}
 
-	struct config cfg = {
-		.action		= 0xff,
-		.log_len	= 0,
-		.raw_binary	= false,
-	};
+	return w->all_new;
+}
 
-	NVME_ARGS(opts,
-		  OPT_BYTE("action",       'a', &cfg.action,        action),
-		  OPT_UINT("log_len",	 'l', &cfg.log_len,	  log_len),
-		  OPT_FLAG("raw-binary",   'b', &cfg.raw_binary,    raw_use));
+static int pevent_log_establish(struct libnvme_transport_handle *hdl,
+				struct nvme_persistent_event_log *pevent)
+{
+	int err;
 
-	err = parse_and_open(&ctx, &hdl, argc, argv, desc, opts);
-	if (err)
+	err = nvme_get_log_persistent_event(hdl,
+		NVME_PEVENT_LOG_EST_CTX_AND_READ, pevent, sizeof(*pevent));
+	if (!nvme_status_equals(err, NVME_STATUS_TYPE_NVME,
+				NVME_SC_CMD_SEQ_ERROR))
 		return err;
 
-	err = validate_output_format(nvme_args.output_format, &flags);
-	if (err < 0) {
-		nvme_show_error("Invalid output format");
+	/* a context left behind by an earlier reader */
+	err = nvme_get_log_persistent_event(hdl, NVME_PEVENT_LOG_RELEASE_CTX,
+					    pevent, sizeof(*pevent));
+	if (err)
 		return err;
-	}
 
-	if (cfg.raw_binary)
-		flags = BINARY;
+	return nvme_get_log_persistent_event(hdl,
+		NVME_PEVENT_LOG_EST_CTX_AND_READ, pevent, sizeof(*pevent));
+}
 
+/*
+ * Reads the log in chunks of @chunk_size bytes within one reporting
+ * context and shows every complete event of a chunk before reading the
+ * next one, so only a chunk and a partial event are held in memory.
+ * Controllers without log page offsets return the log in one go. With
+ * @file only the events newer than the ones of the last call with the
+ * same file are shown.
+ */
+static int pevent_log_stream(struct libnvme_transport_handle *hdl,
+			     __u64 chunk_size, const char *file,
+			     nvme_print_flags_t flags)
+{
+	__cleanup_libnvme_free struct nvme_persistent_event_log *pevent = NULL;
+	__cleanup_libnvme_free struct nvme_id_ctrl *ctrl = NULL;
+	__cleanup_free struct state_file_rec *states = NULL;
+	__cleanup_libnvme_free void *buf = NULL;
+	const char *name = libnvme_transport_handle_get_name(hdl);
+	struct nvme_persistent_event_entry *entry;
+	struct json_object *events = NULL;
+	struct pevent_walk w = { 0 };
+	struct libnvme_passthru_cmd cmd;
+	__u64 tll, off, len, dlen, xfer, max_xfer = PEVENT_CHUNK_SIZE;
+	__u32 tnev, i = 0, first, nr, have, pos, start, size;
+	__cleanup_fd int fd = -1;
+	unsigned int nr_states = 0;
+	char serial[32];
+	bool lpo;
+	int err, rel;
+
+	ctrl = libnvme_alloc(sizeof(*ctrl));
 	pevent = libnvme_alloc(sizeof(*pevent));
-	if (!pevent)
+	if (!ctrl || !pevent)
 		return -ENOMEM;
 
-	err = nvme_get_log_persistent_event(hdl, cfg.action, pevent,
-					    sizeof(*pevent));
+	err = nvme_identify_ctrl(hdl, ctrl);
 	if (err) {
-		nvme_show_err(err, "persistent event log");
+		nvme_show_err(err, "identify controller");
+		return err;
+	}
+
+	if (file) {
+		fd = open(file, O_RDWR | O_CREAT, 0644);
+		if (fd < 0 || flock(fd, LOCK_EX)) {
+			err = -errno;
+			nvme_show_perror(file);
+			return err;
+		}
+
+		err = state_file_load(fd, &states, &nr_states);
+		if (err) {
+			nvme_show_error("failed to read %s: %s", file,
+					libnvme_strerror(-err));
+			return err;
+		}
+
+		state_file_serial(serial, sizeof(serial), ctrl->sn,
+				  sizeof(ctrl->sn));
+		w.st = state_file_get(&states, &nr_states, serial, true);
+		if (!w.st)
+			return -ENOMEM;
+	}
+
+	/* assuming CAP.MPSMIN is zero, as get_max_xfer_size() does */
+	if (ctrl->mdts && ctrl->mdts < 32)
+		max_xfer = (1ULL << ctrl->mdts) * 4096;
+
+	err = pevent_log_establish(hdl, pevent);
+	if (err) {
+		nvme_show_err(err, "persistent event log");
+		return err;
+	}
+
+	tll = le64_to_cpu(pevent->tll);
+	tnev = le32_to_cpu(pevent->tnev);
+	lpo = ctrl->lpa & NVME_CTRL_LPA_EXTENDED;
+	if (!lpo) {
+		if (tll > UINT32_MAX - 3) {
+			nvme_show_error("persistent event log too large to read without log page offsets");
+			err = -EINVAL;
+			goto release;
+		}
+		chunk_size = tll;
+	}
+
+	/* room for a chunk behind the partial event of the previous one */
+	size = lpo ? chunk_size + PEVENT_MAX_EVENT_SIZE + 3 : tll + 3;
+	buf = libnvme_alloc(size);
+	if (!buf) {
+		err = -ENOMEM;
+		goto release;
+	}
+
+	nvme_show_persistent_event_log_start(pevent,
+		NVME_PEVENT_LOG_EST_CTX_AND_READ, name, &events, flags);
+
+	off = lpo ? sizeof(*pevent) : 0;
+	have = 0;
+	while (off < tll && i < tnev) {
+		len = min(chunk_size, tll - off);
+		dlen = (len + 3) & ~3ULL;
+		xfer = lpo ? min(dlen, max_xfer) : dlen;
+
+		nvme_init_get_log_persistent_event(&cmd, NVME_PEVENT_LOG_READ,
+						   buf + have, dlen);
+		cmd.cdw12 = off & 0xffffffff;
+		cmd.cdw13 = off >> 32;
+		err = libnvme_get_log(hdl, &cmd, false, xfer);
+		if (err) {
+			nvme_show_err(err, "persistent event log");
+			break;
+		}
+
+		pos = lpo || off ? 0 : sizeof(*pevent);
+		off += len;
+		have += len;
+
+		start = pos;
+		first = i;
+		nr = 0;
+		while (i < tnev && pos + sizeof(*entry) <= have) {
+			entry = buf + pos;
+			if (pos + entry->ehl + 3 + le16_to_cpu(entry->el) > have)
+				break;
+
+			if (pevent_is_new(&w, entry)) {
+				nr++;
+			} else {
+				start = pos + entry->ehl + 3 +
+					le16_to_cpu(entry->el);
+				first = i + 1;
+			}
+			pos += entry->ehl + 3 + le16_to_cpu(entry->el);
+			i++;
+		}
+
+		if (nr)
+			nvme_show_persistent_event_entries(buf + start, nr,
+				pos - start, first, name, events, flags);
+
+		have -= pos;
+		memmove(buf, buf + pos, have);
+	}
+
+	nvme_show_persistent_event_log_finish(events, flags);
+
+release:
+	rel = nvme_get_log_persistent_event(hdl, NVME_PEVENT_LOG_RELEASE_CTX,
+					    pevent, sizeof(*pevent));
+	if (rel) {
+		nvme_show_err(rel, "release persistent event log context");
+		if (!err)
+			err = rel;
+	}
+
+	if (err || !w.st || !w.nr_ts)
+		return err;
+
+	w.st->val = w.ts;
+	w.st->nr = w.nr_ts;
+	err = state_file_save(fd, states, nr_states);
+	if (err)
+		nvme_show_error("failed to update %s: %s", file,
+				libnvme_strerror(-err));
+
+	return err;
+}
+
+static int get_persistent_event_log(int argc, char **argv,
+		struct command *command, struct plugin *plugin)
+{
+	const char *desc = "Retrieve Persistent Event log info for "
+		"the given device in either decoded format(default), json or binary.";
+	const char *action = "action the controller shall take during "
+		"processing this persistent log page command.";
+	const char *log_len = "number of bytes to retrieve";
+	const char *chunk_size = "read and show the log in chunks of this many bytes";
+	const char *state_file = "only show the events added since the last call with this state file";
+
+	__cleanup_libnvme_free struct nvme_persistent_event_log *pevent = NULL;
+	struct nvme_persistent_event_log *pevent_collected = NULL;
+	__cleanup_huge struct libnvme_mem_huge mh = { 0, };
+	__cleanup_nvme_global_ctx struct libnvme_global_ctx *ctx = NULL;
+	__cleanup_nvme_transport_handle struct libnvme_transport_handle *hdl = NULL;
+	nvme_print_flags_t flags;
+	void *pevent_log_info;
+	int err;
+
+	struct config {
+		__u8	action;
+		__u32	log_len;
+		bool	raw_binary;
+		__u64	chunk_size;
+		char	*state_file;
+	};
+
+	struct config cfg = {
+		.action		= 0xff,
+		.log_len	= 0,
+		.raw_binary	= false,
+		.chunk_size	= 0,
+		.state_file	= NULL,
+	};
+
+	NVME_ARGS(opts,
+		  OPT_BYTE("action",       'a', &cfg.action,        action),
+		  OPT_UINT("log_len",	 'l', &cfg.log_len,	  log_len),
+		  OPT_FLAG("raw-binary",   'b', &cfg.raw_binary,    raw_use),
+		  OPT_SUFFIX("chunk-size", 'c', &cfg.chunk_size,    chunk_size),
+		  OPT_FILE("state-file",     0, &cfg.state_file,    state_file));
+
+	err = parse_and_open(&ctx, &hdl, argc, argv, desc, opts);
+	if (err)
+		return err;
+
+	err = validate_output_format(nvme_args.output_format, &flags);
+	if (err < 0) {
+		nvme_show_error("Invalid output format");
+		return err;
+	}
+
+	if (cfg.raw_binary)
+		flags = BINARY;
+
+	if (cfg.chunk_size || cfg.state_file) {
+		if (cfg.action != 0xff || cfg.log_len) {
+			nvme_show_error("--chunk-size and --state-file cannot be used with --action or --log_len");
+			return -EINVAL;
+		}
+		if (cfg.chunk_size % 4 || cfg.chunk_size > UINT32_MAX / 2) {
+			nvme_show_error("Invalid chunk size");
+			return -EINVAL;
+		}
+
+		if (!cfg.chunk_size)
+			cfg.chunk_size = PEVENT_CHUNK_SIZE;
+
+		return pevent_log_stream(hdl, cfg.chunk_size, cfg.state_file,
+					 flags);
+	}
+
+	pevent = libnvme_alloc(sizeof(*pevent));
+	if (!pevent)
+		return -ENOMEM;
+
+	err = nvme_get_log_persistent_event(hdl, cfg.action, pevent,
+					    sizeof(*pevent));
+	if (err) {
+		nvme_show_err(err, "persistent event log");
 		return err;
 	}
 
@@ -2292,6 +3215,29 @@ static int io_mgmt_recv(int argc, char **argv, struct command *acmd, struct plug
 	return err;
 }
 
+static int get_log_seg_check_lpo(struct libnvme_transport_handle *hdl)
+{
+	__cleanup_libnvme_free struct nvme_id_ctrl *ctrl = NULL;
+	int err;
+
+	ctrl = libnvme_alloc(sizeof(*ctrl));
+	if (!ctrl)
+		return -ENOMEM;
+
+	err = nvme_identify_ctrl(hdl, ctrl);
+	if (err) {
+		nvme_show_err(err, "identify controller");
+		return err;
+	}
+
+	if (!(ctrl->lpa & NVME_CTRL_LPA_EXTENDED)) {
+		nvme_show_error("controller does not support log page offsets, use a --xfer-len of at least --log-len");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
 static int get_log(int argc, char **argv, struct command *acmd, struct plugin *plugin)
 {
 	const char *desc = "Retrieve desired number of bytes "
@@ -2305,6 +3251,8 @@ static int get_log(int argc, char **argv, struct command *acmd, struct plugin *p
 	const char *raw = "output in raw format";
 	const char *offset_type = "offset type";
 	const char *xfer_len = "read chunk size (default 4k)";
+	const char *output_file = "write the log to this file in windows of --xfer-len, resuming an interrupted read";
+	const char *queue_depth = "windows read at the same time with --output-file";
 
 	__cleanup_nvme_global_ctx struct libnvme_global_ctx *ctx = NULL;
 	__cleanup_nvme_transport_handle struct libnvme_transport_handle *hdl = NULL;
@@ -2328,6 +3276,8 @@ static int get_log(int argc, char **argv, struct command *acmd, struct plugin *p
 		__u8	csi;
 		bool	ot;
 		__u32	xfer_len;
+		char	*output_file;
+		__u32	queue_depth;
 	};
 
 	struct config cfg = {
@@ -2345,6 +3295,8 @@ static int get_log(int argc, char **argv, struct command *acmd, struct plugin *p
 		.csi		= NVME_CSI_NVM,
 		.ot		= false,
 		.xfer_len	= 4096,
+		.output_file	= NULL,
+		.queue_depth	= 4,
 	};
 
 	OPT_VALS(log_name) = {
@@ -2407,7 +3359,9 @@ static int get_log(int argc, char **argv, struct command *acmd, struct plugin *p
 		  OPT_FLAG("raw-binary",   'b', &cfg.raw_binary,   raw),
 		  OPT_BYTE("csi",          'y', &cfg.csi,          csi),
 		  OPT_FLAG("ot",           'O', &cfg.ot,           offset_type),
-		  OPT_UINT("xfer-len",     'x', &cfg.xfer_len,     xfer_len));
+		  OPT_UINT("xfer-len",     'x', &cfg.xfer_len,     xfer_len),
+		  OPT_FILE("output-file",  'f', &cfg.output_file,  output_file),
+		  OPT_UINT("queue-depth",  'q', &cfg.queue_depth,  queue_depth));
 
 	err = parse_and_open(&ctx, &hdl, argc, argv, desc, opts);
 	if (err)
@@ -2444,6 +3398,42 @@ static int get_log(int argc, char **argv, struct command *acmd, struct plugin *p
 		return -EINVAL;
 	}
 
+	if (cfg.output_file) {
+		struct nvme_log_seg s = {
+			.nsid	= cfg.namespace_id,
+			.lid	= cfg.log_id,
+			.lsp	= cfg.lsp,
+			.lsi	= cfg.lsi,
+			.csi	= cfg.csi,
+			.uidx	= cfg.uuid_index,
+			.rae	= cfg.rae,
+			.lpo	= cfg.lpo,
+			.len	= cfg.log_len,
+			.xfer	= cfg.xfer_len,
+			.depth	= cfg.queue_depth,
+			.file	= cfg.output_file,
+		};
+
+		if (cfg.ot || cfg.ish) {
+			nvme_show_error("--output-file cannot be used with --ot or --ish");
+			return -EINVAL;
+		}
+		if (!cfg.queue_depth) {
+			nvme_show_error("Invalid queue depth");
+			return -EINVAL;
+		}
+		if (libnvme_transport_handle_is_mi(hdl))
+			s.depth = 1;
+
+		if (cfg.log_len > cfg.xfer_len) {
+			err = get_log_seg_check_lpo(hdl);
+			if (err)
+				return err;
+		}
+
+		return nvme_get_log_segmented(hdl, &s);
+	}
+
 	log = libnvme_alloc(cfg.log_len);
 	if (!log)
 		return -ENOMEM;
@@ -2700,7 +3690,7 @@ static int list_ctrl(int argc, char **argv, struct command *acmd, struct plugin
 		return err;
 
 	err = validate_output_format(nvme_args.output_format, &flags);
-	if (err < 0 || (flags != JSON && flags != NORMAL)) {
+	if (err < 0 || (!(flags & JSON) && flags != NORMAL)) {
 		nvme_show_error("Invalid output format");
 		return err;
 	}
@@ -2763,7 +3753,7 @@ static int list_ns(int argc, char **argv, struct command *acmd, struct plugin *p
 		return err;
 
 	err = validate_output_format(nvme_args.output_format, &flags);
-	if (err < 0 || (flags != JSON && flags != NORMAL)) {
+	if (err < 0 || (!(flags & JSON) && flags != NORMAL)) {
 		nvme_show_error("Invalid output format");
 		return -EINVAL;
 	}
@@ -2887,7 +3877,7 @@ static int id_endurance_grp_list(int argc, char **argv, struct command *acmd,
 		return err;
 
 	err = validate_output_format(nvme_args.output_format, &flags);
-	if (err < 0 || (flags != JSON && flags != NORMAL)) {
+	if (err < 0 || (!(flags & JSON) && flags != NORMAL)) {
 		nvme_show_error("invalid output format");
 		return -EINVAL;
 	}
@@ -3542,7 +4532,7 @@ static int list_subsys(int argc, char **argv, struct command *acmd,
 		devname = basename(argv[optind++]);
 
 	err = validate_output_format(nvme_args.output_format, &flags);
-	if (err < 0 || (flags != JSON && flags != NORMAL)) {
+	if (err < 0 || (!(flags & JSON) && flags != NORMAL)) {
 		nvme_show_error("Invalid output format");
 		return -EINVAL;
 	}
@@ -3584,19 +4574,28 @@ static int top(int argc, char **argv, struct command *acmd,
 {
 	int err;
 	nvme_print_flags_t flags = 0;
+	enum nvme_cli_top_sort sort;
 	const char *desc = "show nvme top output";
 	const char *delay = "refresh interval in seconds";
+	const char *sort_by = "Sort rows by: none|iops|bw|lat|util|inflights";
+	const char *limit = "show at most this many rows per table (0 = all)";
 
 	struct config {
-		int delay;
+		int		delay;
+		char		*sort;
+		unsigned int	limit;
 	};
 
 	struct config cfg = {
-		.delay = 1,
+		.delay	= 1,
+		.sort	= "none",
+		.limit	= 0,
 	};
 
 	NVME_ARGS(opts,
-		  OPT_INT("delay", 'd', &cfg.delay, delay));
+		  OPT_INT("delay", 'd', &cfg.delay, delay),
+		  OPT_FMT("sort",  's', &cfg.sort,  sort_by),
+		  OPT_UINT("limit", 'n', &cfg.limit, limit));
 
 	err = parse_args(argc, argv, desc, opts);
 	if (err)
@@ -3613,13 +4612,30 @@ static int top(int argc, char **argv, struct command *acmd,
 		return -EINVAL;
 	}
 
+	if (!strcmp(cfg.sort, "none")) {
+		sort = NVME_CLI_TOP_SORT_NONE;
+	} else if (!strcmp(cfg.sort, "iops")) {
+		sort = NVME_CLI_TOP_SORT_IOPS;
+	} else if (!strcmp(cfg.sort, "bw")) {
+		sort = NVME_CLI_TOP_SORT_BW;
+	} else if (!strcmp(cfg.sort, "lat")) {
+		sort = NVME_CLI_TOP_SORT_LAT;
+	} else if (!strcmp(cfg.sort, "util")) {
+		sort = NVME_CLI_TOP_SORT_UTIL;
+	} else if (!strcmp(cfg.sort, "inflights")) {
+		sort = NVME_CLI_TOP_SORT_INFLIGHTS;
+	} else {
+		nvme_show_error("Invalid sort argument: %s", cfg.sort);
+		return -EINVAL;
+	}
+
 	err = nvme_install_sigwinch_handler();
 	if (err) {
 		nvme_show_error("failed to install sig handler for SIGWINCH");
 		return err;
 	}
 
-	nvme_show_top(flags, cfg.delay);
+	nvme_show_top(flags, cfg.delay, sort, cfg.limit);
 
 	return err;
 }
@@ -3638,7 +4654,7 @@ static int list(int argc, char **argv, struct command *acmd, struct plugin *plug
 		return err;
 
 	err = validate_output_format(nvme_args.output_format, &flags);
-	if (err < 0 || (flags != JSON && flags != NORMAL)) {
+	if (err < 0 || (!(flags & JSON) && flags != NORMAL)) {
 		nvme_show_error("Invalid output format");
 		return -EINVAL;
 	}
@@ -5092,8 +6108,8 @@ static int get_feature(int argc, char **argv, struct command *acmd,
 
 /*
  * Transfers one chunk of firmware to the device, and decodes & reports any
- * errors. Returns -1 on (fatal) error; signifying that the transfer should
- * be aborted.
+ * errors. Returns the error of the last try on (fatal) error; signifying
+ * that the transfer should be aborted.
  */
 static int fw_download_single(struct libnvme_transport_handle *hdl, void *fw_buf,
 			      bool ish, unsigned int fw_len, uint32_t offset,
@@ -5179,133 +6195,448 @@ static int fw_download_single(struct libnvme_transport_handle *hdl, void *fw_buf
 			break;
 	}
 
-	return -1;
+	return err;
 }
 
-static int fw_download(int argc, char **argv, struct command *acmd, struct plugin *plugin)
-{
-	const char *desc = "Copy all or part of a firmware image to "
-		"a controller for future update. Optionally, specify how "
-		"many KiB of the firmware to transfer at once. The offset will "
-		"start at 0 and automatically adjust based on xfer size "
-		"unless fw is split across multiple files. May be submitted "
-		"while outstanding commands exist on the Admin and IO "
-		"Submission Queues. Activate downloaded firmware with "
-		"fw-activate, and then reset the device to apply the downloaded firmware.";
-	const char *fw = "firmware file (required)";
-	const char *xfer = "transfer chunksize limit";
-	const char *offset = "starting dword offset, default 0";
-	const char *progress = "display firmware transfer progress";
-	const char *ignore_ovr = "ignore overwrite errors";
-
-	__cleanup_nvme_global_ctx struct libnvme_global_ctx *ctx = NULL;
-	__cleanup_nvme_transport_handle struct libnvme_transport_handle *hdl = NULL;
-	__cleanup_huge struct libnvme_mem_huge mh = { 0, };
-	__cleanup_fd int fw_fd = -1;
-	unsigned int fw_size, pos;
-	int err;
-	struct stat sb;
-	void *fw_buf;
-	struct nvme_id_ctrl ctrl = { 0 };
-	nvme_print_flags_t flags;
+/* transfer size used when the controller does not limit it (MDTS 0) */
+#define FW_DOWNLOAD_MAX_XFER	(1024 * 1024)
 
-	struct config {
-		char	*fw;
-		bool	ish;
-		__u32	xfer;
-		__u32	offset;
-		bool	progress;
-		bool	ignore_ovr;
-	};
+/*
+ * The largest transfer which is a multiple of the firmware update
+ * granularity (FWUG) and does not exceed MDTS.
+ */
+static __u32 fw_download_xfer(struct nvme_id_ctrl *ctrl)
+{
+	__u64 gran = 4096, max = FW_DOWNLOAD_MAX_XFER;
 
-	struct config cfg = {
-		.fw         = "",
-		.ish        = false,
-		.xfer       = 0,
-		.offset     = 0,
-		.progress   = false,
-		.ignore_ovr = false,
-	};
+	if (ctrl->fwug && ctrl->fwug != 0xff)
+		gran = ctrl->fwug * 4096;
 
-	NVME_ARGS(opts,
-		  OPT_FILE("fw",         'f', &cfg.fw,         fw),
-		  OPT_FLAG("ish",        'I', &cfg.ish,        ish),
-		  OPT_UINT("xfer",       'x', &cfg.xfer,       xfer),
-		  OPT_UINT("offset",     'O', &cfg.offset,     offset),
-		  OPT_FLAG("progress",   'p', &cfg.progress,   progress),
-		  OPT_FLAG("ignore-ovr", 'i', &cfg.ignore_ovr, ignore_ovr));
+	/* assuming CAP.MPSMIN is zero, as get_max_xfer_size() does */
+	if (ctrl->mdts && ctrl->mdts < 20)
+		max = (1ULL << ctrl->mdts) * 4096;
 
-	err = parse_and_open(&ctx, &hdl, argc, argv, desc, opts);
-	if (err)
-		return err;
+	return max > gran ? max / gran * gran : gran;
+}
 
-	err = validate_output_format(nvme_args.output_format, &flags);
-	if (err < 0) {
-		nvme_show_error("Invalid output format");
-		return err;
-	}
+static int fw_download_complete(struct libnvme_transport_handle *hdl,
+				struct nvme_ioq_req *req, void *fw_buf,
+				unsigned int fw_size, uint32_t offset,
+				bool progress, bool ignore_ovr)
+{
+	if (!req->err)
+		return 0;
 
-	fw_fd = open(cfg.fw, O_RDONLY);
-	cfg.offset <<= 2;
-	if (fw_fd < 0) {
-		nvme_show_error("Failed to open firmware file %s: %s", cfg.fw, libnvme_strerror(errno));
-		return -EINVAL;
-	}
+	/* retry the chunk on its own, which also reports the error */
+	return fw_download_single(hdl, fw_buf + req->tag, false, fw_size,
+				  offset + req->tag, req->cmd.data_len,
+				  progress, ignore_ovr);
+}
 
-	err = fstat(fw_fd, &sb);
-	if (err < 0) {
-		nvme_show_perror("fstat");
+/*
+ * Keeps up to @depth Firmware Image Download commands in flight. The
+ * image is still handed out in order, the commands may complete in any.
+ * With @dev set the completed bytes are reported to nvme_multi_run().
+ */
+static int fw_download_queued(struct libnvme_transport_handle *hdl,
+			      void *fw_buf, unsigned int fw_size,
+			      uint32_t offset, uint32_t xfer,
+			      unsigned int depth, bool progress,
+			      bool ignore_ovr, struct nvme_multi_dev *dev)
+{
+	struct nvme_ioq_req *req;
+	struct nvme_ioq *q;
+	unsigned int pos, done = 0;
+	int err, ret;
+
+	err = nvme_ioq_open(hdl, depth, 0, 0, &q);
+	if (err) {
+		nvme_show_error("failed to set up admin queue: %s",
+				libnvme_strerror(-err));
 		return err;
 	}
 
-	fw_size = sb.st_size;
-	if ((fw_size & 0x3) || (fw_size == 0)) {
-		nvme_show_error("Invalid size:%d for f/w image", fw_size);
-		return -EINVAL;
-	}
+	for (pos = 0; pos < fw_size; pos += xfer) {
+		if (nvme_sigint_received) {
+			err = -EINTR;
+			break;
+		}
 
-	if (cfg.xfer == 0) {
-		err = nvme_identify_ctrl(hdl, &ctrl);
-		if (err) {
-			nvme_show_error("identify-ctrl: %s", libnvme_strerror(err));
-			return err;
+		req = nvme_ioq_next(q);
+		if (req->state == NVME_IOQ_DONE) {
+			err = fw_download_complete(hdl, req, fw_buf, fw_size,
+						   offset, progress, ignore_ovr);
+			if (err)
+				break;
+			done += req->cmd.data_len;
+			if (dev)
+				nvme_multi_progress(dev, done);
 		}
-		if (ctrl.fwug == 0 || ctrl.fwug == 0xff)
-			cfg.xfer = 4096;
-		else
-			cfg.xfer = ctrl.fwug * 4096;
-	} else if (cfg.xfer % 4096)
-		cfg.xfer = 4096;
 
-	if (ctrl.fwug && ctrl.fwug != 0xff && fw_size % cfg.xfer)
-		nvme_show_error("WARNING: firmware file size %u not conform to FWUG alignment %lu",
-				fw_size, cfg.xfer);
+		if (progress)
+			printf("Firmware download: transferring 0x%08x/0x%08x bytes: %03d%%\r",
+			       offset + pos, fw_size, (int)(100ULL * pos / fw_size));
 
-	fw_buf = libnvme_alloc_huge(fw_size, &mh);
-	if (!fw_buf) {
-		nvme_show_error("failed to allocate huge memory");
-		return -ENOMEM;
-	}
+		err = nvme_init_fw_download(&req->cmd, fw_buf + pos,
+					    min(xfer, fw_size - pos), offset + pos);
+		if (err)
+			break;
+		req->admin = true;
+		req->tag = pos;
 
-	if (read(fw_fd, fw_buf, fw_size) != ((ssize_t)(fw_size))) {
-		err = -errno;
-		nvme_show_error("read :%s :%s", cfg.fw, libnvme_strerror(errno));
-		return err;
+		nvme_ioq_submit(q, req);
 	}
 
-	if (cfg.ish && !libnvme_transport_handle_is_mi(hdl)) {
-		printf("ISH is supported only for NVMe-MI\n");
+	/* drain in order, keep the first error */
+	while ((req = nvme_ioq_reap(q))) {
+		if (err)
+			continue;
+		ret = fw_download_complete(hdl, req, fw_buf, fw_size, offset,
+					   progress, ignore_ovr);
+		if (ret)
+			err = ret;
+		done += req->cmd.data_len;
+		if (dev)
+			nvme_multi_progress(dev, done);
 	}
 
-	for (pos = 0; pos < fw_size; pos += cfg.xfer) {
-		cfg.xfer = min(cfg.xfer, fw_size - pos);
+	nvme_ioq_close(q);
 
-		err = fw_download_single(hdl, fw_buf + pos, cfg.ish, fw_size,
-					 cfg.offset + pos, cfg.xfer,
-					 cfg.progress, cfg.ignore_ovr);
-		if (err)
-			break;
-	}
+	return err;
+}
+
+struct fw_image {
+	void *buf;
+	size_t size;
+};
+
+static void cleanup_fw_image(struct fw_image *img)
+{
+	if (img->buf)
+		munmap(img->buf, img->size);
+}
+
+/*
+ * Collects the controllers named on the command line and those whose
+ * model matches @model for fw-download and fw-commit.
+ */
+static int fw_multi_devs(struct nvme_multi *m, int argc, char **argv,
+			 const char *model, unsigned int jobs)
+{
+	int err;
+
+	if (!jobs) {
+		nvme_show_error("Invalid number of jobs");
+		return -EINVAL;
+	}
+
+	err = nvme_multi_add_devs(m, argc - optind, argv + optind);
+	if (err) {
+		nvme_show_error("failed to add controllers: %s",
+				libnvme_strerror(-err));
+		return err;
+	}
+
+	if (model) {
+		err = nvme_multi_add_model(m, model);
+		if (err < 0) {
+			nvme_show_error("failed to scan topology: %s",
+					libnvme_strerror(-err));
+			return err;
+		}
+		if (!err) {
+			nvme_show_error("no controller matches model %s", model);
+			return -ENODEV;
+		}
+	}
+
+	return 0;
+}
+
+struct fw_download_job {
+	struct argconfig_commandline_options *opts;
+	void *fw_buf;
+	unsigned int fw_size;
+	uint32_t offset;
+	uint32_t xfer;		/* 0: derived from each controller */
+	unsigned int depth;
+	bool ish;
+	bool ignore_ovr;
+	bool progress;
+};
+
+static int fw_download_dev(struct nvme_multi_dev *dev, void *arg)
+{
+	__cleanup_nvme_global_ctx struct libnvme_global_ctx *ctx = NULL;
+	__cleanup_nvme_transport_handle struct libnvme_transport_handle *hdl = NULL;
+	struct fw_download_job *job = arg;
+	struct nvme_id_ctrl ctrl;
+	uint32_t xfer = job->xfer, len;
+	unsigned int pos;
+	int err;
+
+	err = open_multi_dev(dev->name, job->opts, &ctx, &hdl);
+	if (err)
+		return err;
+
+	if (!xfer) {
+		err = nvme_identify_ctrl(hdl, &ctrl);
+		if (err)
+			return err;
+		xfer = fw_download_xfer(&ctrl);
+	}
+
+	if (job->depth > 1 && !libnvme_transport_handle_is_mi(hdl))
+		return fw_download_queued(hdl, job->fw_buf, job->fw_size,
+					  job->offset, xfer, job->depth, false,
+					  job->ignore_ovr, dev);
+
+	for (pos = 0; pos < job->fw_size; pos += len) {
+		if (nvme_sigint_received)
+			return -EINTR;
+
+		len = min(xfer, job->fw_size - pos);
+		err = fw_download_single(hdl, job->fw_buf + pos, job->ish,
+					 job->fw_size, job->offset + pos, len,
+					 false, job->ignore_ovr);
+		if (err)
+			return err;
+		nvme_multi_progress(dev, pos + len);
+	}
+
+	return 0;
+}
+
+static void fw_download_status(struct nvme_multi *m, void *arg)
+{
+	struct fw_download_job *job = arg;
+	unsigned int finished;
+	__u64 done, total;
+
+	if (!job->progress)
+		return;
+
+	nvme_multi_get_progress(m, &done, &total, &finished);
+	printf("Firmware download: %u/%u controllers done, %03d%%\r",
+	       finished, m->nr, (int)(100 * done / total));
+	fflush(stdout);
+}
+
+/*
+ * Downloads the image to all controllers in @m, up to @jobs at a time,
+ * and reports the result of each once all are done.
+ */
+static int fw_download_multi(struct nvme_multi *m, unsigned int jobs,
+			     struct fw_download_job *job)
+{
+	unsigned int i, ok = 0;
+	int err;
+
+	for (i = 0; i < m->nr; i++)
+		m->devs[i].total = job->fw_size;
+
+	err = nvme_multi_run(m, jobs, fw_download_dev, job, fw_download_status);
+
+	/* end the progress output */
+	if (job->progress)
+		printf("\n");
+
+	for (i = 0; i < m->nr; i++) {
+		if (m->devs[i].err) {
+			printf("%s: Firmware download failed: %s\n",
+			       m->devs[i].name,
+			       libnvme_status_to_string(m->devs[i].err, false));
+			continue;
+		}
+		printf("%s: Firmware download success\n", m->devs[i].name);
+		ok++;
+	}
+	printf("Firmware download: %u of %u controllers succeeded\n", ok, m->nr);
+
+	return err;
+}
+
+static int fw_download(int argc, char **argv, struct command *acmd, struct plugin *plugin)
+{
+	const char *desc = "Copy all or part of a firmware image to "
+		"a controller for future update. Optionally, specify how "
+		"many KiB of the firmware to transfer at once. The offset will "
+		"start at 0 and automatically adjust based on xfer size "
+		"unless fw is split across multiple files. May be submitted "
+		"while outstanding commands exist on the Admin and IO "
+		"Submission Queues. Activate downloaded firmware with "
+		"fw-activate, and then reset the device to apply the downloaded firmware.";
+	const char *fw = "firmware file (required)";
+	const char *xfer = "transfer chunksize limit";
+	const char *offset = "starting dword offset, default 0";
+	const char *progress = "display firmware transfer progress";
+	const char *ignore_ovr = "ignore overwrite errors";
+	const char *queue_depth = "commands kept in flight, if the controller accepts them out of order";
+	const char *model = "also download to all controllers whose model matches this pattern";
+	const char *jobs = "controllers to download to in parallel";
+
+	__cleanup(nvme_multi_free) struct nvme_multi m = { 0 };
+	__cleanup_nvme_global_ctx struct libnvme_global_ctx *ctx = NULL;
+	__cleanup_nvme_transport_handle struct libnvme_transport_handle *hdl = NULL;
+	__cleanup_huge struct libnvme_mem_huge mh = { 0, };
+	__cleanup(cleanup_fw_image) struct fw_image img = { 0 };
+	__cleanup_fd int fw_fd = -1;
+	unsigned int fw_size, pos;
+	int err;
+	struct stat sb;
+	void *fw_buf;
+	struct nvme_id_ctrl ctrl = { 0 };
+	nvme_print_flags_t flags;
+	bool multi;
+
+	struct config {
+		char	*fw;
+		bool	ish;
+		__u32	xfer;
+		__u32	offset;
+		bool	progress;
+		bool	ignore_ovr;
+		__u32	queue_depth;
+		char	*model;
+		__u32	jobs;
+	};
+
+	struct config cfg = {
+		.fw          = "",
+		.ish         = false,
+		.xfer        = 0,
+		.offset      = 0,
+		.progress    = false,
+		.ignore_ovr  = false,
+		.queue_depth = 1,
+		.model       = NULL,
+		.jobs        = 8,
+	};
+
+	NVME_ARGS(opts,
+		  OPT_FILE("fw",         'f', &cfg.fw,         fw),
+		  OPT_FLAG("ish",        'I', &cfg.ish,        ish),
+		  OPT_UINT("xfer",       'x', &cfg.xfer,       xfer),
+		  OPT_UINT("offset",     'O', &cfg.offset,     offset),
+		  OPT_FLAG("progress",   'p', &cfg.progress,   progress),
+		  OPT_FLAG("ignore-ovr", 'i', &cfg.ignore_ovr, ignore_ovr),
+		  OPT_UINT("queue-depth", 'q', &cfg.queue_depth, queue_depth),
+		  OPT_STR("model",       'M', &cfg.model,       model),
+		  OPT_UINT("jobs",       'j', &cfg.jobs,        jobs));
+
+	err = parse_args(argc, argv, desc, opts);
+	if (err)
+		return err;
+
+	multi = argc - optind > 1 || cfg.model;
+	if (multi)
+		err = fw_multi_devs(&m, argc, argv, cfg.model, cfg.jobs);
+	else
+		err = open_parsed(&ctx, &hdl, argc, argv, desc, opts);
+	if (err)
+		return err;
+
+	err = validate_output_format(nvme_args.output_format, &flags);
+	if (err < 0) {
+		nvme_show_error("Invalid output format");
+		return err;
+	}
+
+	fw_fd = open(cfg.fw, O_RDONLY);
+	cfg.offset <<= 2;
+	if (fw_fd < 0) {
+		nvme_show_error("Failed to open firmware file %s: %s", cfg.fw, libnvme_strerror(errno));
+		return -EINVAL;
+	}
+
+	err = fstat(fw_fd, &sb);
+	if (err < 0) {
+		nvme_show_perror("fstat");
+		return err;
+	}
+
+	fw_size = sb.st_size;
+	if ((fw_size & 0x3) || (fw_size == 0)) {
+		nvme_show_error("Invalid size:%d for f/w image", fw_size);
+		return -EINVAL;
+	}
+
+	if (!cfg.queue_depth) {
+		nvme_show_error("Invalid queue depth");
+		return -EINVAL;
+	}
+
+	if (cfg.xfer == 0 && !multi) {
+		err = nvme_identify_ctrl(hdl, &ctrl);
+		if (err) {
+			nvme_show_error("identify-ctrl: %s", libnvme_strerror(err));
+			return err;
+		}
+		cfg.xfer = fw_download_xfer(&ctrl);
+	} else if (cfg.xfer % 4096)
+		cfg.xfer = 4096;
+
+	if (ctrl.fwug && ctrl.fwug != 0xff && fw_size % (ctrl.fwug * 4096))
+		nvme_show_error("WARNING: firmware file size %u not conform to FWUG alignment %u",
+				fw_size, ctrl.fwug * 4096);
+
+	/* transfer straight from the page cache, copy if it can't be mapped */
+	fw_buf = mmap(NULL, fw_size, PROT_READ, MAP_PRIVATE, fw_fd, 0);
+	if (fw_buf != MAP_FAILED) {
+		img.buf = fw_buf;
+		img.size = fw_size;
+		madvise(fw_buf, fw_size, MADV_SEQUENTIAL);
+		madvise(fw_buf, fw_size, MADV_WILLNEED);
+	} else {
+		fw_buf = libnvme_alloc_huge(fw_size, &mh);
+		if (!fw_buf) {
+			nvme_show_error("failed to allocate huge memory");
+			return -ENOMEM;
+		}
+
+		if (read(fw_fd, fw_buf, fw_size) != ((ssize_t)(fw_size))) {
+			err = -errno;
+			nvme_show_error("read :%s :%s", cfg.fw, libnvme_strerror(errno));
+			return err;
+		}
+	}
+
+	if (multi) {
+		struct fw_download_job job = {
+			.opts = opts,
+			.fw_buf = fw_buf,
+			.fw_size = fw_size,
+			.offset = cfg.offset,
+			.xfer = cfg.xfer,
+			.depth = cfg.queue_depth,
+			.ish = cfg.ish,
+			.ignore_ovr = cfg.ignore_ovr,
+			.progress = cfg.progress,
+		};
+
+		return fw_download_multi(&m, cfg.jobs, &job);
+	}
+
+	if (cfg.ish && !libnvme_transport_handle_is_mi(hdl)) {
+		printf("ISH is supported only for NVMe-MI\n");
+	}
+
+	if (cfg.queue_depth > 1 && !libnvme_transport_handle_is_mi(hdl)) {
+		err = fw_download_queued(hdl, fw_buf, fw_size, cfg.offset,
+					 cfg.xfer, cfg.queue_depth,
+					 cfg.progress, cfg.ignore_ovr, NULL);
+	} else {
+		for (pos = 0; pos < fw_size; pos += cfg.xfer) {
+			cfg.xfer = min(cfg.xfer, fw_size - pos);
+
+			err = fw_download_single(hdl, fw_buf + pos, cfg.ish,
+						 fw_size, cfg.offset + pos,
+						 cfg.xfer, cfg.progress,
+						 cfg.ignore_ovr);
+			if (err)
+				break;
+		}
+	}
 
 	if (!err) {
 		/* end the progress output */
@@ -5367,31 +6698,113 @@ static void fw_commit_print_mud(struct libnvme_transport_handle *hdl, __u64 resu
 		       "sequence due to processing a command from a Management Endpoint\n");
 }
 
-static void fw_commit_err(int err, __u8 action, __u8 slot, __u8 bpid)
+/* the reset the activated firmware waits for, NULL if @err is a failure */
+static const char *fw_commit_reset_needed(int err)
 {
 	__u32 val;
 
-	if (err > 0 && nvme_status_get_type(err) == NVME_STATUS_TYPE_NVME) {
-		val = nvme_status_get_value(err);
-		switch (val & 0x7ff) {
-		case NVME_SC_FW_NEEDS_CONV_RESET:
-		case NVME_SC_FW_NEEDS_SUBSYS_RESET:
-		case NVME_SC_FW_NEEDS_RESET:
-			printf("Success activating firmware action:%d slot:%d",
-			       action, slot);
-			if (action == 6 || action == 7)
-				printf(" bpid:%d", bpid);
-			printf(", but firmware requires %s reset\n",
-			       nvme_fw_status_reset_type(val));
-			return;
-		default:
-			break;
-		}
+	if (err <= 0 || nvme_status_get_type(err) != NVME_STATUS_TYPE_NVME)
+		return NULL;
+
+	val = nvme_status_get_value(err);
+	switch (val & 0x7ff) {
+	case NVME_SC_FW_NEEDS_CONV_RESET:
+	case NVME_SC_FW_NEEDS_SUBSYS_RESET:
+	case NVME_SC_FW_NEEDS_RESET:
+		return nvme_fw_status_reset_type(val);
+	default:
+		return NULL;
+	}
+}
+
+static void fw_commit_err(int err, __u8 action, __u8 slot, __u8 bpid)
+{
+	const char *reset = fw_commit_reset_needed(err);
+
+	if (reset) {
+		printf("Success activating firmware action:%d slot:%d",
+		       action, slot);
+		if (action == 6 || action == 7)
+			printf(" bpid:%d", bpid);
+		printf(", but firmware requires %s reset\n", reset);
+		return;
 	}
 
 	nvme_show_err(err, "fw-commit");
 }
 
+struct fw_commit_job {
+	struct argconfig_commandline_options *opts;
+	bool ish;
+	__u8 slot;
+	__u8 action;
+	__u8 bpid;
+};
+
+static int fw_commit_dev(struct nvme_multi_dev *dev, void *arg)
+{
+	__cleanup_nvme_global_ctx struct libnvme_global_ctx *ctx = NULL;
+	__cleanup_nvme_transport_handle struct libnvme_transport_handle *hdl = NULL;
+	struct fw_commit_job *job = arg;
+	struct libnvme_passthru_cmd cmd;
+	int err;
+
+	err = open_multi_dev(dev->name, job->opts, &ctx, &hdl);
+	if (err)
+		return err;
+
+	nvme_init_fw_commit(&cmd, job->slot, job->action, job->bpid);
+	if (job->ish && libnvme_transport_handle_is_mi(hdl))
+		nvme_init_mi_cmd_flags(&cmd, job->ish);
+
+	err = libnvme_exec_admin_passthru(hdl, &cmd);
+	if (!err && fw_commit_support_mud(hdl))
+		dev->result = cmd.result;
+
+	return err;
+}
+
+/*
+ * Commits on all controllers in @m, up to @jobs at a time, and reports
+ * the result of each once all are done.
+ */
+static int fw_commit_multi(struct nvme_multi *m, unsigned int jobs,
+			   struct fw_commit_job *job)
+{
+	struct nvme_multi_dev *dev;
+	unsigned int i, ok = 0;
+	const char *reset;
+	int err;
+
+	err = nvme_multi_run(m, jobs, fw_commit_dev, job, NULL);
+
+	for (i = 0; i < m->nr; i++) {
+		dev = &m->devs[i];
+		reset = fw_commit_reset_needed(dev->err);
+		if (dev->err && !reset) {
+			printf("%s: fw-commit failed: %s\n", dev->name,
+			       libnvme_status_to_string(dev->err, false));
+			continue;
+		}
+
+		printf("%s: Success %s firmware action:%d slot:%d", dev->name,
+		       reset ? "activating" : "committing", job->action,
+		       job->slot);
+		if (job->action == 6 || job->action == 7)
+			printf(" bpid:%d", job->bpid);
+		if (reset)
+			printf(", but firmware requires %s reset", reset);
+		if (dev->result)
+			printf(", Multiple Update Detected (MUD) Value: %#x",
+			       dev->result);
+		printf("\n");
+		ok++;
+	}
+	printf("Firmware commit: %u of %u controllers succeeded\n", ok, m->nr);
+
+	return err;
+}
+
 static int fw_commit(int argc, char **argv, struct command *acmd, struct plugin *plugin)
 {
 	const char *desc = "Verify downloaded firmware image and "
@@ -5406,18 +6819,24 @@ static int fw_commit(int argc, char **argv, struct command *acmd, struct plugin
 				"6 = replace boot partition, "
 				"7 = activate boot partition";
 	const char *bpid = "[0,1]: boot partition identifier, if applicable (default: 0)";
+	const char *model = "also commit on all controllers whose model matches this pattern";
+	const char *jobs = "controllers to commit on in parallel";
 
+	__cleanup(nvme_multi_free) struct nvme_multi m = { 0 };
 	__cleanup_nvme_global_ctx struct libnvme_global_ctx *ctx = NULL;
 	__cleanup_nvme_transport_handle struct libnvme_transport_handle *hdl = NULL;
 	struct libnvme_passthru_cmd cmd;
 	int err;
 	nvme_print_flags_t flags;
+	bool multi;
 
 	struct config {
 		bool	ish;
 		__u8	slot;
 		__u8	action;
 		__u8	bpid;
+		char	*model;
+		__u32	jobs;
 	};
 
 	struct config cfg = {
@@ -5425,6 +6844,8 @@ static int fw_commit(int argc, char **argv, struct command *acmd, struct plugin
 		.slot	= 0,
 		.action	= 0,
 		.bpid	= 0,
+		.model	= NULL,
+		.jobs	= 8,
 	};
 
 	OPT_VALS(ca) = {
@@ -5445,9 +6866,19 @@ static int fw_commit(int argc, char **argv, struct command *acmd, struct plugin
 		  OPT_FLAG("ish",    'I', &cfg.ish,    ish),
 		  OPT_BYTE("slot",   's', &cfg.slot,   slot),
 		  OPT_BYTE("action", 'a', &cfg.action, action, ca),
-		  OPT_BYTE("bpid",   'b', &cfg.bpid,   bpid));
+		  OPT_BYTE("bpid",   'b', &cfg.bpid,   bpid),
+		  OPT_STR("model",   'M', &cfg.model,  model),
+		  OPT_UINT("jobs",   'j', &cfg.jobs,   jobs));
 
-	err = parse_and_open(&ctx, &hdl, argc, argv, desc, opts);
+	err = parse_args(argc, argv, desc, opts);
+	if (err)
+		return err;
+
+	multi = argc - optind > 1 || cfg.model;
+	if (multi)
+		err = fw_multi_devs(&m, argc, argv, cfg.model, cfg.jobs);
+	else
+		err = open_parsed(&ctx, &hdl, argc, argv, desc, opts);
 	if (err)
 		return err;
 
@@ -5480,6 +6911,18 @@ static int fw_commit(int argc, char **argv, struct command *acmd, struct plugin
 		return -EINVAL;
 	}
 
+	if (multi) {
+		struct fw_commit_job job = {
+			.opts = opts,
+			.ish = cfg.ish,
+			.slot = cfg.slot,
+			.action = cfg.action,
+			.bpid = cfg.bpid,
+		};
+
+		return fw_commit_multi(&m, cfg.jobs, &job);
+	}
+
 	nvme_init_fw_commit(&cmd, cfg.slot, cfg.action, cfg.bpid);
 	if (cfg.ish) {
 		if (libnvme_transport_handle_is_mi(hdl))
@@ -7323,22 +8766,356 @@ static int dir_send(int argc, char **argv, struct command *acmd, struct plugin *
 	return err;
 }
 
-static int write_uncor(int argc, char **argv, struct command *acmd, struct plugin *plugin)
+static int identify_ctrl_nvm(struct libnvme_transport_handle *hdl,
+			     struct nvme_id_ctrl_nvm *ctrl_nvm)
 {
-	const char *desc =
-	    "The Write Uncorrectable command is used to set a range of logical blocks to invalid.";
-
-	__cleanup_nvme_global_ctx struct libnvme_global_ctx *ctx = NULL;
-	__cleanup_nvme_transport_handle struct libnvme_transport_handle *hdl = NULL;
 	struct libnvme_passthru_cmd cmd;
-	int err;
 
-	struct config {
-		__u32	namespace_id;
-		__u64	start_block;
-		__u16	block_count;
+	nvme_init_identify_csi_ctrl(&cmd, NVME_CSI_NVM, ctrl_nvm);
+	return libnvme_exec_admin_passthru(hdl, &cmd);
+}
+
+#define LBA_SWEEP_MAX_NLB	0x10000
+
+/*
+ * Walks an LBA range with Verify, Write Zeroes or Write Uncorrectable
+ * commands of the largest size the controller accepts, keeping up to
+ * @depth of them in flight. The range completed so far (in order) can be
+ * kept in a checkpoint file so an interrupted sweep can be resumed.
+ */
+struct lba_sweep {
+	const char *name;
+	__u8 opcode;
+	__u32 nsid;
+	__u16 control;
+	__u16 dspec;
+
+	bool pi;
+	__u8 pif;
+	__u8 sts;
+	__u64 ilbrt;
+	__u64 lbst;
+	__u16 lbat;
+	__u16 lbatm;
+
+	__u64 slba;
+	__u64 elba;
+	__u32 max_nlb;
+	__u32 lba_size;
+	unsigned int depth;
+	const char *checkpoint;
+};
+
+/* Returns 1 if a sweep was requested, 0 if not or -EINVAL */
+static int lba_sweep_requested(struct argconfig_commandline_options *opts,
+			       __u64 range, bool to_end, __u32 depth,
+			       const char *checkpoint)
+{
+	if (!range && !to_end) {
+		if (checkpoint) {
+			nvme_show_error("--checkpoint needs --range or --to-end");
+			return -EINVAL;
+		}
+		return 0;
+	}
+
+	if (range && to_end) {
+		nvme_show_error("Use either --range or --to-end");
+		return -EINVAL;
+	}
+	if (argconfig_parse_seen(opts, "block-count")) {
+		nvme_show_error("--block-count cannot be used with --range or --to-end");
+		return -EINVAL;
+	}
+	if (!depth) {
+		nvme_show_error("Invalid queue depth");
+		return -EINVAL;
+	}
+
+	return 1;
+}
+
+/*
+ * Set up the range and the per command limit. @nlb is the number of
+ * blocks to sweep, zero means up to the end of the namespace.
+ */
+static int lba_sweep_setup(struct libnvme_transport_handle *hdl,
+			   struct lba_sweep *s, __u64 nlb)
+{
+	__cleanup_libnvme_free struct nvme_id_ctrl_nvm *ctrl_nvm = NULL;
+	__cleanup_libnvme_free struct nvme_id_ns *ns = NULL;
+	__u64 nsze, max_bytes;
+	__u8 lbaf, limit = 0;
+	int err;
+
+	ns = libnvme_alloc(sizeof(*ns));
+	if (!ns)
+		return -ENOMEM;
+
+	err = nvme_identify_ns(hdl, s->nsid, ns);
+	if (err) {
+		nvme_show_err(err, "identify namespace");
+		return err;
+	}
+
+	nvme_id_ns_flbas_to_lbaf_inuse(ns->flbas, &lbaf);
+	s->lba_size = 1 << ns->lbaf[lbaf].ds;
+	nsze = le64_to_cpu(ns->nsze);
+
+	if (s->slba >= nsze || (nlb && nlb > nsze - s->slba)) {
+		nvme_show_error("range exceeds the namespace size of %"PRIu64" blocks",
+				(uint64_t)nsze);
+		return -EINVAL;
+	}
+	s->elba = nlb ? s->slba + nlb : nsze;
+
+	ctrl_nvm = libnvme_alloc(sizeof(*ctrl_nvm));
+	if (!ctrl_nvm)
+		return -ENOMEM;
+
+	/* the limits are optional, zero means no limit */
+	if (!identify_ctrl_nvm(hdl, ctrl_nvm)) {
+		switch (s->opcode) {
+		case nvme_cmd_verify:
+			limit = ctrl_nvm->vsl;
+			break;
+		case nvme_cmd_write_zeroes:
+			limit = ctrl_nvm->wzsl;
+			if ((s->control & NVME_IO_DEAC) && ctrl_nvm->wzdsl)
+				limit = ctrl_nvm->wzdsl;
+			break;
+		case nvme_cmd_write_uncor:
+			limit = ctrl_nvm->wusl;
+			break;
+		}
+	}
+
+	s->max_nlb = LBA_SWEEP_MAX_NLB;
+	/* in units of CAP.MPSMIN, assumed to be 4k as for MDTS */
+	if (limit && limit < 32) {
+		max_bytes = (1ULL << limit) * 4096;
+		s->max_nlb = max(min(max_bytes / s->lba_size, s->max_nlb), 1);
+	}
+
+	return 0;
+}
+
+/* Returns the LBA to resume at, the start of the range without a checkpoint */
+static int lba_sweep_load_checkpoint(struct lba_sweep *s, __u64 *next)
+{
+	unsigned long long slba, elba, lba;
+	unsigned int nsid;
+	FILE *fp;
+	int n;
+
+	*next = s->slba;
+	if (!s->checkpoint)
+		return 0;
+
+	fp = fopen(s->checkpoint, "r");
+	if (!fp) {
+		if (errno == ENOENT)
+			return 0;
+		n = -errno;
+		nvme_show_perror(s->checkpoint);
+		return n;
+	}
+
+	n = fscanf(fp, "%u %llu %llu %llu", &nsid, &slba, &elba, &lba);
+	fclose(fp);
+
+	if (n != 4 || nsid != s->nsid || slba != s->slba || elba != s->elba ||
+	    lba < slba || lba > elba) {
+		nvme_show_error("%s does not match this sweep", s->checkpoint);
+		return -EINVAL;
+	}
+
+	*next = lba;
+	return 0;
+}
+
+static void lba_sweep_save_checkpoint(struct lba_sweep *s, __u64 lba)
+{
+	__cleanup_free char *tmp = NULL;
+	FILE *fp;
+
+	if (!s->checkpoint)
+		return;
+
+	if (asprintf(&tmp, "%s.tmp", s->checkpoint) < 0)
+		return;
+
+	fp = fopen(tmp, "w");
+	if (!fp) {
+		nvme_show_perror(tmp);
+		return;
+	}
+
+	fprintf(fp, "%u %"PRIu64" %"PRIu64" %"PRIu64"\n", s->nsid,
+		(uint64_t)s->slba, (uint64_t)s->elba, (uint64_t)lba);
+	if (fclose(fp) || rename(tmp, s->checkpoint))
+		nvme_show_perror(s->checkpoint);
+}
+
+static void lba_sweep_init_cmd(struct lba_sweep *s,
+			       struct libnvme_passthru_cmd *cmd, __u64 slba,
+			       __u32 nlb)
+{
+	switch (s->opcode) {
+	case nvme_cmd_verify:
+		nvme_init_verify(cmd, s->nsid, slba, nlb - 1, s->control, 0,
+				 NULL, 0, NULL, 0);
+		break;
+	case nvme_cmd_write_zeroes:
+		nvme_init_write_zeros(cmd, s->nsid, slba, nlb - 1, s->control,
+				      s->dspec, 0, 0);
+		break;
+	default:
+		nvme_init_write_uncorrectable(cmd, s->nsid, slba, nlb - 1,
+					      s->control, s->dspec);
+		return;
+	}
+
+	/* the reference tag given applies to the first block of the range */
+	if (s->pi) {
+		nvme_init_var_size_tags(cmd, s->pif, s->sts,
+					s->ilbrt + (slba - s->slba), s->lbst);
+		nvme_init_app_tag(cmd, s->lbat, s->lbatm);
+	}
+}
+
+static double lba_sweep_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void lba_sweep_show_progress(struct lba_sweep *s, __u64 lba,
+				    __u64 first, double elapsed)
+{
+	__u64 total = s->elba - s->slba;
+	double mib = (double)(lba - first) * s->lba_size / (1 << 20);
+
+	fprintf(stderr, "%s: %"PRIu64"/%"PRIu64" blocks (%.1f%%), %.1f MiB/s\r",
+		s->name, (uint64_t)(lba - s->slba), (uint64_t)total,
+		100.0 * (lba - s->slba) / total, elapsed > 0 ? mib / elapsed : 0);
+}
+
+static int lba_sweep_run(struct libnvme_transport_handle *hdl,
+			 struct lba_sweep *s)
+{
+	__u64 next, done, first, cmds = 0;
+	double start, last, now, elapsed;
+	bool progress = isatty(STDERR_FILENO);
+	struct nvme_ioq_req *req;
+	__u64 failed = 0;
+	struct nvme_ioq *q;
+	__u32 nlb;
+	int err;
+
+	err = lba_sweep_load_checkpoint(s, &next);
+	if (err)
+		return err;
+	done = first = next;
+
+	err = nvme_ioq_open(hdl, s->depth, 0, 0, &q);
+	if (err) {
+		nvme_show_error("failed to set up I/O queue: %s",
+				libnvme_strerror(-err));
+		return err;
+	}
+
+	start = last = lba_sweep_now();
+	while (next < s->elba && !nvme_sigint_received) {
+		req = nvme_ioq_next(q);
+		if (req->state == NVME_IOQ_DONE) {
+			if (req->err) {
+				err = req->err;
+				failed = req->cmd.cdw10 | (__u64)req->cmd.cdw11 << 32;
+				break;
+			}
+			done = req->tag;
+		}
+
+		nlb = min(s->elba - next, s->max_nlb);
+		lba_sweep_init_cmd(s, &req->cmd, next, nlb);
+		req->tag = next + nlb;
+		nvme_ioq_submit(q, req);
+		next += nlb;
+		cmds++;
+
+		now = lba_sweep_now();
+		if (now - last >= 1) {
+			last = now;
+			lba_sweep_save_checkpoint(s, done);
+			if (progress)
+				lba_sweep_show_progress(s, done, first, now - start);
+		}
+	}
+	if (!err && nvme_sigint_received)
+		err = -EINTR;
+
+	while ((req = nvme_ioq_reap(q))) {
+		if (err)
+			continue;
+		if (req->err) {
+			err = req->err;
+			failed = req->cmd.cdw10 | (__u64)req->cmd.cdw11 << 32;
+			continue;
+		}
+		done = req->tag;
+	}
+
+	nvme_ioq_close(q);
+	elapsed = lba_sweep_now() - start;
+
+	if (progress)
+		fprintf(stderr, "\n");
+
+	if (err) {
+		lba_sweep_save_checkpoint(s, done);
+		if (err != -EINTR)
+			nvme_show_error("%s: command at LBA %"PRIu64" failed",
+					s->name, (uint64_t)failed);
+		nvme_show_err(err, s->name);
+		if (s->checkpoint)
+			nvme_show_error("%"PRIu64" blocks done, resume with the same --checkpoint",
+					(uint64_t)(done - s->slba));
+		return err;
+	}
+
+	if (s->checkpoint)
+		unlink(s->checkpoint);
+
+	printf("%s: success, %"PRIu64" blocks in %"PRIu64" commands, %.1f MiB/s\n",
+	       s->name, (uint64_t)(done - first), (uint64_t)cmds,
+	       elapsed > 0 ? (double)(done - first) * s->lba_size / (1 << 20) / elapsed : 0);
+
+	return 0;
+}
+
+static int write_uncor(int argc, char **argv, struct command *acmd, struct plugin *plugin)
+{
+	const char *desc =
+	    "The Write Uncorrectable command is used to set a range of logical blocks to invalid.";
+
+	__cleanup_nvme_global_ctx struct libnvme_global_ctx *ctx = NULL;
+	__cleanup_nvme_transport_handle struct libnvme_transport_handle *hdl = NULL;
+	struct libnvme_passthru_cmd cmd;
+	int err, sweep;
+
+	struct config {
+		__u32	namespace_id;
+		__u64	start_block;
+		__u16	block_count;
 		__u8	dtype;
 		__u16	dspec;
+		__u64	range;
+		bool	to_end;
+		__u32	queue_depth;
+		char	*checkpoint;
 	};
 
 	struct config cfg = {
@@ -7347,6 +9124,10 @@ static int write_uncor(int argc, char **argv, struct command *acmd, struct plugi
 		.block_count	= 0,
 		.dtype			= 0,
 		.dspec			= 0,
+		.range			= 0,
+		.to_end			= false,
+		.queue_depth	= 4,
+		.checkpoint		= NULL,
 	};
 
 	NVME_ARGS(opts,
@@ -7354,12 +9135,21 @@ static int write_uncor(int argc, char **argv, struct command *acmd, struct plugi
 		  OPT_SUFFIX("start-block", 's', &cfg.start_block,  start_block),
 		  OPT_SHRT("block-count",   'c', &cfg.block_count,  block_count),
 		  OPT_BYTE("dir-type",      'T', &cfg.dtype,        dtype),
-		  OPT_SHRT("dir-spec",      'S', &cfg.dspec,        dspec_w_dtype));
+		  OPT_SHRT("dir-spec",      'S', &cfg.dspec,        dspec_w_dtype),
+		  OPT_SUFFIX("range",       'R', &cfg.range,        sweep_range),
+		  OPT_FLAG("to-end",        'e', &cfg.to_end,       sweep_to_end),
+		  OPT_UINT("queue-depth",   'q', &cfg.queue_depth,  sweep_queue_depth),
+		  OPT_FILE("checkpoint",    'k', &cfg.checkpoint,   sweep_checkpoint));
 
 	err = parse_and_open(&ctx, &hdl, argc, argv, desc, opts);
 	if (err)
 		return err;
 
+	sweep = lba_sweep_requested(opts, cfg.range, cfg.to_end,
+				    cfg.queue_depth, cfg.checkpoint);
+	if (sweep < 0)
+		return sweep;
+
 	if (!cfg.namespace_id) {
 		err = libnvme_get_nsid(hdl, &cfg.namespace_id);
 		if (err < 0) {
@@ -7373,6 +9163,25 @@ static int write_uncor(int argc, char **argv, struct command *acmd, struct plugi
 		return -EINVAL;
 	}
 
+	if (sweep) {
+		struct lba_sweep s = {
+			.name		= "NVMe Write Uncorrectable",
+			.opcode		= nvme_cmd_write_uncor,
+			.nsid		= cfg.namespace_id,
+			.control	= cfg.dtype << 4,
+			.dspec		= cfg.dspec,
+			.slba		= cfg.start_block,
+			.depth		= cfg.queue_depth,
+			.checkpoint	= cfg.checkpoint,
+		};
+
+		err = lba_sweep_setup(hdl, &s, cfg.range);
+		if (err)
+			return err;
+
+		return lba_sweep_run(hdl, &s);
+	}
+
 	nvme_init_write_uncorrectable(&cmd, cfg.namespace_id, cfg.start_block,
 		cfg.block_count, cfg.dtype << 4, cfg.dspec);
 	err = libnvme_exec_io_passthru(hdl, &cmd);
@@ -7436,12 +9245,14 @@ static void get_pif_sts(struct nvme_id_ns *ns, struct nvme_nvm_id_ns *nvm_ns,
 
 static int get_pi_info(struct libnvme_transport_handle *hdl,
 		__u32 nsid, __u8 prinfo, __u64 ilbrt, __u64 lbst,
-		unsigned int *logical_block_size, __u16 *metadata_size)
+		unsigned int *logical_block_size, __u16 *metadata_size,
+		bool *ext)
 {
 	__cleanup_libnvme_free struct nvme_nvm_id_ns *nvm_ns = NULL;
 	__cleanup_libnvme_free struct nvme_id_ns *ns = NULL;
 	__u8 sts = 0, pif = 0;
 	unsigned int lbs = 0;
+	bool in_block = false;
 	__u8 lba_index;
 	int pi_size;
 	__u16 ms;
@@ -7484,8 +9295,10 @@ static int get_pi_info(struct libnvme_transport_handle *hdl,
 		 *   5.2.2.1 Protection Information and Write Commands
 		 *   5.2.2.2 Protection Information and Read Commands
 		 */
-		if (!((prinfo & 0x8) != 0 && ms == pi_size))
+		if (!((prinfo & 0x8) != 0 && ms == pi_size)) {
 			lbs += ms;
+			in_block = true;
+		}
 	}
 
 	if (invalid_tags(lbst, ilbrt, sts, pif))
@@ -7493,17 +9306,16 @@ static int get_pi_info(struct libnvme_transport_handle *hdl,
 
 	*logical_block_size = lbs;
 	*metadata_size = ms;
+	*ext = in_block;
 
 	return 0;
 }
 
-static int init_pi_tags(struct libnvme_transport_handle *hdl,
-	struct libnvme_passthru_cmd *cmd, __u32 nsid, __u64 ilbrt, __u64 lbst,
-	__u16 lbat, __u16 lbatm)
+static int get_pi_format(struct libnvme_transport_handle *hdl, __u32 nsid,
+	__u8 *pif, __u8 *sts)
 {
 	__cleanup_libnvme_free struct nvme_nvm_id_ns *nvm_ns = NULL;
 	__cleanup_libnvme_free struct nvme_id_ns *ns = NULL;
-	__u8 sts = 0, pif = 0;
 	int err = 0;
 
 	ns = libnvme_alloc(sizeof(*ns));
@@ -7522,7 +9334,7 @@ static int init_pi_tags(struct libnvme_transport_handle *hdl,
 
 	err = nvme_identify_csi_ns(hdl, nsid, NVME_CSI_NVM, 0, nvm_ns);
 	if (!err)
-		get_pif_sts(ns, nvm_ns, &pif, &sts);
+		get_pif_sts(ns, nvm_ns, pif, sts);
 	else if (!nvme_status_equals(err, NVME_STATUS_TYPE_NVME,
 				     NVME_SC_INVALID_FIELD))
 		/*
@@ -7532,6 +9344,72 @@ static int init_pi_tags(struct libnvme_transport_handle *hdl,
 		 */
 		return NVME_SC_INVALID_FIELD;
 
+	return 0;
+}
+
+static int get_host_pi(struct libnvme_transport_handle *hdl, __u32 nsid,
+	struct pi *pi)
+{
+	__cleanup_libnvme_free struct nvme_nvm_id_ns *nvm_ns = NULL;
+	__cleanup_libnvme_free struct nvme_id_ns *ns = NULL;
+	__u8 sts = 0, pif = 0, type;
+	__u8 lba_index;
+	int err;
+
+	ns = libnvme_alloc(sizeof(*ns));
+	if (!ns)
+		return -ENOMEM;
+
+	err = nvme_identify_ns(hdl, nsid, ns);
+	if (err) {
+		nvme_show_err(err, "identify namespace");
+		return err;
+	}
+
+	type = ns->dps & NVME_NS_DPS_PI_MASK;
+	if (type == NVME_NS_DPS_PI_NONE) {
+		nvme_show_error("namespace %u is not formatted with protection information",
+				nsid);
+		return -EINVAL;
+	}
+
+	nvm_ns = libnvme_alloc(sizeof(*nvm_ns));
+	if (!nvm_ns)
+		return -ENOMEM;
+
+	/* without the NVM command set identify only the 16b guard exists */
+	err = nvme_identify_csi_ns(hdl, nsid, NVME_CSI_NVM, 0, nvm_ns);
+	if (!err)
+		get_pif_sts(ns, nvm_ns, &pif, &sts);
+	else if (!nvme_status_equals(err, NVME_STATUS_TYPE_NVME,
+				     NVME_SC_INVALID_FIELD)) {
+		nvme_show_err(err, "identify namespace (NVM)");
+		return err;
+	}
+
+	nvme_id_ns_flbas_to_lbaf_inuse(ns->flbas, &lba_index);
+	err = pi_init(pi, pif, type, sts, ns->dps & NVME_NS_DPS_PI_FIRST,
+		      1 << ns->lbaf[lba_index].ds,
+		      le16_to_cpu(ns->lbaf[lba_index].ms),
+		      NVME_FLBAS_META_EXT(ns->flbas));
+	if (err)
+		nvme_show_error("unsupported protection information format (pif %u, sts %u)",
+				pif, sts);
+
+	return err;
+}
+
+static int init_pi_tags(struct libnvme_transport_handle *hdl,
+	struct libnvme_passthru_cmd *cmd, __u32 nsid, __u64 ilbrt, __u64 lbst,
+	__u16 lbat, __u16 lbatm)
+{
+	__u8 sts = 0, pif = 0;
+	int err;
+
+	err = get_pi_format(hdl, nsid, &pif, &sts);
+	if (err)
+		return err;
+
 	if (invalid_tags(lbst, ilbrt, sts, pif))
 		return -EINVAL;
 
@@ -7541,6 +9419,29 @@ static int init_pi_tags(struct libnvme_transport_handle *hdl,
 	return 0;
 }
 
+static int init_sweep_pi(struct libnvme_transport_handle *hdl,
+	struct lba_sweep *s, __u64 ilbrt, __u64 lbst, __u16 lbat, __u16 lbatm)
+{
+	int err;
+
+	err = get_pi_format(hdl, s->nsid, &s->pif, &s->sts);
+	if (err == NVME_SC_INVALID_FIELD)
+		return 0;
+	if (err)
+		return err;
+
+	if (invalid_tags(lbst, ilbrt, s->sts, s->pif))
+		return -EINVAL;
+
+	s->pi = true;
+	s->ilbrt = ilbrt;
+	s->lbst = lbst;
+	s->lbat = lbat;
+	s->lbatm = lbatm;
+
+	return 0;
+}
+
 static int write_zeroes(int argc, char **argv,
 	struct command *acmd, struct plugin *plugin)
 {
@@ -7548,7 +9449,7 @@ static int write_zeroes(int argc, char **argv,
 	__cleanup_nvme_global_ctx struct libnvme_global_ctx *ctx = NULL;
 	struct libnvme_passthru_cmd cmd;
 	__u16 control = 0;
-	int err;
+	int err, sweep;
 
 	const char *desc =
 	    "The Write Zeroes command is used to set a range of logical blocks to zero.";
@@ -7572,6 +9473,10 @@ static int write_zeroes(int argc, char **argv,
 		bool	stc;
 		__u16	dspec;
 		bool	nsz;
+		__u64	range;
+		bool	to_end;
+		__u32	queue_depth;
+		char	*checkpoint;
 	};
 
 	struct config cfg = {
@@ -7590,6 +9495,10 @@ static int write_zeroes(int argc, char **argv,
 		.stc				= false,
 		.dspec				= 0,
 		.nsz				= false,
+		.range				= 0,
+		.to_end				= false,
+		.queue_depth		= 4,
+		.checkpoint			= NULL,
 	};
 
 	NVME_ARGS(opts,
@@ -7607,12 +9516,25 @@ static int write_zeroes(int argc, char **argv,
 		  OPT_SUFFIX("storage-tag",     'S', &cfg.lbst,				 storage_tag),
 		  OPT_FLAG("storage-tag-check", 'C', &cfg.stc,				 storage_tag_check),
 		  OPT_SHRT("dir-spec",          'D', &cfg.dspec,             dspec_w_dtype),
-		  OPT_FLAG("namespace-zeroes",  'Z', &cfg.nsz,               nsz));
+		  OPT_FLAG("namespace-zeroes",  'Z', &cfg.nsz,               nsz),
+		  OPT_SUFFIX("range",           'R', &cfg.range,             sweep_range),
+		  OPT_FLAG("to-end",            'e', &cfg.to_end,            sweep_to_end),
+		  OPT_UINT("queue-depth",       'q', &cfg.queue_depth,       sweep_queue_depth),
+		  OPT_FILE("checkpoint",        'k', &cfg.checkpoint,        sweep_checkpoint));
 
 	err = parse_and_open(&ctx, &hdl, argc, argv, desc, opts);
 	if (err)
 		return err;
 
+	sweep = lba_sweep_requested(opts, cfg.range, cfg.to_end,
+				    cfg.queue_depth, cfg.checkpoint);
+	if (sweep < 0)
+		return sweep;
+	if (sweep && cfg.nsz) {
+		nvme_show_error("--namespace-zeroes cannot be used with --range or --to-end");
+		return -EINVAL;
+	}
+
 	if (cfg.prinfo > 0xf)
 		return -EINVAL;
 
@@ -7641,6 +9563,30 @@ static int write_zeroes(int argc, char **argv,
 		}
 	}
 
+	if (sweep) {
+		struct lba_sweep s = {
+			.name		= "NVMe Write Zeroes",
+			.opcode		= nvme_cmd_write_zeroes,
+			.nsid		= cfg.nsid,
+			.control	= control,
+			.dspec		= cfg.dspec,
+			.slba		= cfg.start_block,
+			.depth		= cfg.queue_depth,
+			.checkpoint	= cfg.checkpoint,
+		};
+
+		err = init_sweep_pi(hdl, &s, cfg.ilbrt, cfg.lbst, cfg.lbat,
+				    cfg.lbatm);
+		if (err)
+			return err;
+
+		err = lba_sweep_setup(hdl, &s, cfg.range);
+		if (err)
+			return err;
+
+		return lba_sweep_run(hdl, &s);
+	}
+
 	nvme_init_write_zeros(&cmd, cfg.nsid, cfg.start_block, cfg.block_count,
 			      control, cfg.dspec, 0, 0);
 
@@ -7669,6 +9615,297 @@ static int write_zeroes(int argc, char **argv,
 	return err;
 }
 
+#define DSM_MAX_RANGES		256
+
+enum dsm_range_format {
+	DSM_RANGE_TEXT,
+	DSM_RANGE_BINARY,
+};
+
+static OPT_VALS(dsm_range_formats) = {
+	VAL_BYTE("text", DSM_RANGE_TEXT),
+	VAL_BYTE("binary", DSM_RANGE_BINARY),
+	VAL_END()
+};
+
+#define RANGE_FILE_UNSET	(~0ULL)
+
+struct range_file {
+	FILE *fp;
+	char *line;
+	size_t line_len;
+	unsigned long lineno;
+};
+
+static int range_file_open(struct range_file *rf, const char *path)
+{
+	int err;
+
+	memset(rf, 0, sizeof(*rf));
+	if (!strcmp(path, "-")) {
+		rf->fp = stdin;
+		return 0;
+	}
+
+	rf->fp = fopen(path, "r");
+	if (!rf->fp) {
+		err = -errno;
+		nvme_show_perror(path);
+		return err;
+	}
+
+	return 0;
+}
+
+static void range_file_close(struct range_file *rf)
+{
+	if (rf->fp && rf->fp != stdin)
+		fclose(rf->fp);
+	free(rf->line);
+}
+
+/*
+ * Read the next line of a text range file and parse up to @max numbers,
+ * separated by white space or commas, into @vals. A '-' leaves the value
+ * at RANGE_FILE_UNSET. Empty lines and lines starting with '#' are
+ * skipped. Returns the number of fields, 0 at the end of the file.
+ */
+static int range_file_read_line(struct range_file *rf, __u64 *vals, int max)
+{
+	char *p, *end;
+	int i;
+
+	while (getline(&rf->line, &rf->line_len, rf->fp) >= 0) {
+		rf->lineno++;
+		p = rf->line + strspn(rf->line, " \t");
+		if (*p == '#' || *p == '\n' || !*p)
+			continue;
+
+		for (i = 0; i < max; i++) {
+			vals[i] = RANGE_FILE_UNSET;
+			p += strspn(p, " \t,");
+			if (!*p || *p == '\n' || *p == '#')
+				break;
+			if (*p == '-') {
+				p++;
+				continue;
+			}
+			errno = 0;
+			vals[i] = strtoull(p, &end, 0);
+			if (errno || end == p)
+				break;
+			p = end;
+		}
+		p += strspn(p, " \t,");
+		if (*p && *p != '\n' && *p != '#') {
+			nvme_show_error("invalid range on line %lu", rf->lineno);
+			return -EINVAL;
+		}
+
+		return i;
+	}
+
+	return ferror(rf->fp) ? -EIO : 0;
+}
+
+struct dsm_extent {
+	__u64 slba;
+	__u64 nlb;
+	__u32 cattr;
+};
+
+/*
+ * Streams extents from a range file, merges extents which directly
+ * follow each other and cuts the result into commands which honour the
+ * DMRL, DMRSL and DMSL limits of the controller.
+ */
+struct dsm_reader {
+	struct range_file rf;
+	enum dsm_range_format format;
+
+	struct dsm_extent next;
+	bool have_next;
+	struct dsm_extent cur;
+	bool have_cur;
+
+	__u16 max_ranges;
+	__u32 max_range_nlb;
+	__u64 max_nlb;
+};
+
+/* Returns 1 if an extent was read, 0 at the end of the file */
+static int dsm_read_extent(struct dsm_reader *r, struct dsm_extent *ext)
+{
+	struct nvme_dsm_range range;
+	__u64 vals[3];
+	int n;
+
+	if (r->format == DSM_RANGE_BINARY) {
+		if (fread(&range, sizeof(range), 1, r->rf.fp) != 1)
+			return ferror(r->rf.fp) ? -EIO : 0;
+
+		ext->cattr = le32_to_cpu(range.cattr);
+		ext->nlb = le32_to_cpu(range.nlb);
+		ext->slba = le64_to_cpu(range.slba);
+		return 1;
+	}
+
+	/* text: "<slba> <nlb> [<cattr>]" per line */
+	n = range_file_read_line(&r->rf, vals, ARRAY_SIZE(vals));
+	if (n <= 0)
+		return n;
+
+	if (n < 2 || vals[0] == RANGE_FILE_UNSET || vals[1] > UINT32_MAX ||
+	    (n > 2 && vals[2] > UINT32_MAX)) {
+		nvme_show_error("invalid range on line %lu", r->rf.lineno);
+		return -EINVAL;
+	}
+
+	ext->slba = vals[0];
+	ext->nlb = vals[1];
+	ext->cattr = n > 2 ? vals[2] : 0;
+	return 1;
+}
+
+/* Returns 1 if an extent is available in r->cur, 0 at the end */
+static int dsm_next_coalesced(struct dsm_reader *r)
+{
+	struct dsm_extent ext;
+	int err;
+
+	if (r->have_cur)
+		return 1;
+
+	for (;;) {
+		if (r->have_next) {
+			ext = r->next;
+			r->have_next = false;
+		} else {
+			err = dsm_read_extent(r, &ext);
+			if (err < 0)
+				return err;
+			if (!err)
+				return r->have_cur;
+		}
+
+		if (!ext.nlb)
+			continue;
+
+		if (!r->have_cur) {
+			r->cur = ext;
+			r->have_cur = true;
+			continue;
+		}
+
+		if (ext.slba == r->cur.slba + r->cur.nlb &&
+		    ext.cattr == r->cur.cattr &&
+		    r->cur.nlb + ext.nlb > r->cur.nlb) {
+			r->cur.nlb += ext.nlb;
+			continue;
+		}
+
+		r->next = ext;
+		r->have_next = true;
+		return 1;
+	}
+}
+
+/* Fill @ranges for one command, returns the number of ranges or -errno */
+static int dsm_fill_ranges(struct dsm_reader *r, struct nvme_dsm_range *ranges,
+			   __u64 *nlb)
+{
+	__u64 total = 0, len;
+	int nr = 0, err;
+
+	while (nr < r->max_ranges) {
+		err = dsm_next_coalesced(r);
+		if (err < 0)
+			return err;
+		if (!err)
+			break;
+
+		len = min(r->cur.nlb, r->max_range_nlb);
+		if (r->max_nlb) {
+			if (total >= r->max_nlb)
+				break;
+			len = min(len, r->max_nlb - total);
+		}
+
+		ranges[nr].cattr = cpu_to_le32(r->cur.cattr);
+		ranges[nr].nlb = cpu_to_le32(len);
+		ranges[nr].slba = cpu_to_le64(r->cur.slba);
+		nr++;
+
+		total += len;
+		r->cur.slba += len;
+		r->cur.nlb -= len;
+		if (!r->cur.nlb)
+			r->have_cur = false;
+	}
+
+	*nlb = total;
+	return nr;
+}
+
+static int dsm_range_file(struct libnvme_transport_handle *hdl, __u32 nsid,
+			  struct dsm_reader *r, unsigned int depth, bool idr,
+			  bool idw, bool ad)
+{
+	__u64 nlb, blocks = 0, ranges = 0, cmds = 0;
+	struct nvme_ioq_req *req;
+	struct nvme_ioq *q;
+	int nr, err = 0;
+
+	err = nvme_ioq_open(hdl, depth, DSM_MAX_RANGES * sizeof(struct nvme_dsm_range),
+			    0, &q);
+	if (err) {
+		nvme_show_error("failed to set up I/O queue: %s",
+				libnvme_strerror(-err));
+		return err;
+	}
+
+	while (!nvme_sigint_received) {
+		req = nvme_ioq_next(q);
+		if (req->state == NVME_IOQ_DONE && req->err) {
+			err = req->err;
+			break;
+		}
+
+		nr = dsm_fill_ranges(r, req->buf, &nlb);
+		if (nr <= 0) {
+			err = nr;
+			break;
+		}
+
+		nvme_init_dsm(&req->cmd, nsid, nr, idr, idw, ad, req->buf,
+			      sizeof(struct nvme_dsm_range) * nr);
+		nvme_ioq_submit(q, req);
+
+		blocks += nlb;
+		ranges += nr;
+		cmds++;
+	}
+	if (!err && nvme_sigint_received)
+		err = -EINTR;
+
+	while ((req = nvme_ioq_reap(q))) {
+		if (req->err && !err)
+			err = req->err;
+	}
+
+	nvme_ioq_close(q);
+
+	if (err) {
+		nvme_show_err(err, "data-set management");
+		return err;
+	}
+
+	printf("NVMe DSM: success, %"PRIu64" blocks in %"PRIu64" ranges, %"PRIu64" commands\n",
+	       (uint64_t)blocks, (uint64_t)ranges, (uint64_t)cmds);
+
+	return 0;
+}
+
 static int dsm(int argc, char **argv, struct command *acmd, struct plugin *plugin)
 {
 	const char *desc = "The Dataset Management command is used by the host to\n"
@@ -7682,16 +9919,21 @@ static int dsm(int argc, char **argv, struct command *acmd, struct plugin *plugi
 	const char *idw = "Attribute Integral Dataset for Write";
 	const char *idr = "Attribute Integral Dataset for Read";
 	const char *cdw11 = "All the command DWORD 11 attributes. Use instead of specifying individual attributes";
+	const char *range_file = "file with the ranges, '-' for stdin";
+	const char *range_format = "range file format: text|binary";
+	const char *queue_depth = "commands kept in flight for a range file";
 
 	__cleanup_nvme_global_ctx struct libnvme_global_ctx *ctx = NULL;
 	__cleanup_nvme_transport_handle struct libnvme_transport_handle *hdl = NULL;
+	__cleanup_libnvme_free struct nvme_id_ctrl_nvm *ctrl_nvm = NULL;
 	__cleanup_libnvme_free struct nvme_dsm_range *dsm = NULL;
+	struct dsm_reader reader = { 0 };
 	struct libnvme_passthru_cmd cmd;
 	__u32 ctx_attrs[256] = {0,};
 	__u32 nlbs[256] = {0,};
 	__u64 slbas[256] = {0,};
 	nvme_print_flags_t flags;
-	uint16_t nc, nb, ns;
+	uint16_t nc, nb = 0, ns;
 	int err;
 
 	struct config {
@@ -7703,6 +9945,9 @@ static int dsm(int argc, char **argv, struct command *acmd, struct plugin *plugi
 		bool	idw;
 		bool	idr;
 		__u32	cdw11;
+		char	*range_file;
+		__u8	range_format;
+		__u32	queue_depth;
 	};
 
 	struct config cfg = {
@@ -7714,6 +9959,9 @@ static int dsm(int argc, char **argv, struct command *acmd, struct plugin *plugi
 		.idw		= false,
 		.idr		= false,
 		.cdw11		= 0,
+		.range_file	= NULL,
+		.range_format	= DSM_RANGE_TEXT,
+		.queue_depth	= 4,
 	};
 
 	NVME_ARGS(opts,
@@ -7724,7 +9972,10 @@ static int dsm(int argc, char **argv, struct command *acmd, struct plugin *plugi
 		  OPT_FLAG("ad",           'd', &cfg.ad,           ad),
 		  OPT_FLAG("idw",          'w', &cfg.idw,          idw),
 		  OPT_FLAG("idr",          'r', &cfg.idr,          idr),
-		  OPT_UINT("cdw11",        'c', &cfg.cdw11,        cdw11));
+		  OPT_UINT("cdw11",        'c', &cfg.cdw11,        cdw11),
+		  OPT_FILE("range-file",   'f', &cfg.range_file,   range_file),
+		  OPT_BYTE("range-format", 'F', &cfg.range_format, range_format, dsm_range_formats),
+		  OPT_UINT("queue-depth",  'q', &cfg.queue_depth,  queue_depth));
 
 	err = parse_and_open(&ctx, &hdl, argc, argv, desc, opts);
 	if (err)
@@ -7740,17 +9991,28 @@ static int dsm(int argc, char **argv, struct command *acmd, struct plugin *plugi
 		return err;
 	}
 
-	nc = argconfig_parse_comma_sep_array_u32(cfg.ctx_attrs, ctx_attrs, ARRAY_SIZE(ctx_attrs));
-	nb = argconfig_parse_comma_sep_array_u32(cfg.blocks, nlbs, ARRAY_SIZE(nlbs));
-	ns = argconfig_parse_comma_sep_array_u64(cfg.slbas, slbas, ARRAY_SIZE(slbas));
-	if ((nb != ns) ||
-	    (argconfig_parse_seen(opts, "ctx-attrs") && nb != nc)) {
-		nvme_show_error("No valid range definition provided");
-		return -EINVAL;
-	}
-	if (!nb || nb > 256) {
-		nvme_show_error("No range definition provided");
-		return -EINVAL;
+	if (cfg.range_file) {
+		if (strlen(cfg.blocks) || strlen(cfg.slbas)) {
+			nvme_show_error("Use either a range file or range lists");
+			return -EINVAL;
+		}
+		if (!cfg.queue_depth) {
+			nvme_show_error("Invalid queue depth");
+			return -EINVAL;
+		}
+	} else {
+		nc = argconfig_parse_comma_sep_array_u32(cfg.ctx_attrs, ctx_attrs, ARRAY_SIZE(ctx_attrs));
+		nb = argconfig_parse_comma_sep_array_u32(cfg.blocks, nlbs, ARRAY_SIZE(nlbs));
+		ns = argconfig_parse_comma_sep_array_u64(cfg.slbas, slbas, ARRAY_SIZE(slbas));
+		if ((nb != ns) ||
+		    (argconfig_parse_seen(opts, "ctx-attrs") && nb != nc)) {
+			nvme_show_error("No valid range definition provided");
+			return -EINVAL;
+		}
+		if (!nb || nb > 256) {
+			nvme_show_error("No range definition provided");
+			return -EINVAL;
+		}
 	}
 
 	if (!cfg.namespace_id) {
@@ -7766,6 +10028,36 @@ static int dsm(int argc, char **argv, struct command *acmd, struct plugin *plugi
 		cfg.idr = NVME_GET(cfg.cdw11, DSM_CDW11_IDR);
 	}
 
+	if (cfg.range_file) {
+		reader.max_ranges = DSM_MAX_RANGES;
+		reader.max_range_nlb = UINT32_MAX;
+
+		ctrl_nvm = libnvme_alloc(sizeof(*ctrl_nvm));
+		if (!ctrl_nvm)
+			return -ENOMEM;
+
+		/* zero means no limit for all of them */
+		if (!identify_ctrl_nvm(hdl, ctrl_nvm)) {
+			if (ctrl_nvm->dmrl)
+				reader.max_ranges = ctrl_nvm->dmrl;
+			if (ctrl_nvm->dmrsl)
+				reader.max_range_nlb = le32_to_cpu(ctrl_nvm->dmrsl);
+			reader.max_nlb = le64_to_cpu(ctrl_nvm->dmsl);
+		}
+
+		err = range_file_open(&reader.rf, cfg.range_file);
+		if (err)
+			return err;
+		reader.format = cfg.range_format;
+
+		err = dsm_range_file(hdl, cfg.namespace_id, &reader,
+				     cfg.queue_depth, cfg.idr, cfg.idw, cfg.ad);
+
+		range_file_close(&reader.rf);
+
+		return err;
+	}
+
 	dsm = libnvme_alloc(sizeof(*dsm) * nb);
 	if (!dsm)
 		return -ENOMEM;
@@ -7784,6 +10076,280 @@ static int dsm(int argc, char **argv, struct command *acmd, struct plugin *plugi
 	return err;
 }
 
+#define COPY_MAX_RANGES		256
+
+union copy_range {
+	struct nvme_copy_range_f0 f0;
+	struct nvme_copy_range_f1 f1;
+	struct nvme_copy_range_f2 f2;
+	struct nvme_copy_range_f3 f3;
+};
+
+struct copy_extent {
+	__u64 slba;
+	__u64 nlb;
+	__u64 dlba;
+	__u32 snsid;
+};
+
+/*
+ * Streams source extents from a range file, merges extents which are
+ * contiguous on both the source and the destination side and packs them
+ * into Copy commands which honour the MSRC, MSSRL and MCL limits of the
+ * namespace. A command ends where the destination is not contiguous.
+ */
+struct copy_reader {
+	struct range_file rf;
+	__u32 nsid;
+	__u8 format;
+	__u64 next_dlba;
+
+	struct copy_extent next;
+	bool have_next;
+	struct copy_extent cur;
+	bool have_cur;
+
+	__u16 max_ranges;
+	__u32 max_range_nlb;
+	__u64 max_nlb;
+};
+
+struct copy_params {
+	__u8 format;
+	__u8 prinfor;
+	__u8 prinfow;
+	__u8 dtype;
+	__u16 dspec;
+	bool stc;
+	bool fua;
+	bool lr;
+	bool pi;
+	__u8 pif;
+	__u8 sts;
+	__u64 ilbrt;
+	__u64 lbst;
+	__u16 lbat;
+	__u16 lbatm;
+};
+
+/* Returns 1 if an extent was read, 0 at the end of the file */
+static int copy_read_extent(struct copy_reader *r, struct copy_extent *ext)
+{
+	__u64 vals[4];
+	int n;
+
+	/* "<slba> <nlb> [<dlba>|-] [<snsid>]" per line */
+	n = range_file_read_line(&r->rf, vals, ARRAY_SIZE(vals));
+	if (n <= 0)
+		return n;
+
+	if (n < 2 || vals[0] == RANGE_FILE_UNSET ||
+	    vals[1] == RANGE_FILE_UNSET ||
+	    (n > 3 && vals[3] != RANGE_FILE_UNSET && vals[3] > UINT32_MAX)) {
+		nvme_show_error("invalid range on line %lu", r->rf.lineno);
+		return -EINVAL;
+	}
+
+	ext->slba = vals[0];
+	ext->nlb = vals[1];
+	ext->dlba = n > 2 && vals[2] != RANGE_FILE_UNSET ? vals[2] : r->next_dlba;
+	ext->snsid = n > 3 && vals[3] != RANGE_FILE_UNSET ? vals[3] : r->nsid;
+
+	if (ext->snsid != r->nsid && r->format != 2 && r->format != 3) {
+		nvme_show_error("formats 0 and 1 do not support cross-namespace copy (line %lu)",
+				r->rf.lineno);
+		return -EINVAL;
+	}
+
+	r->next_dlba = ext->dlba + ext->nlb;
+	return 1;
+}
+
+/* Returns 1 if an extent is available in r->cur, 0 at the end */
+static int copy_next_coalesced(struct copy_reader *r)
+{
+	struct copy_extent ext;
+	int err;
+
+	if (r->have_cur)
+		return 1;
+
+	for (;;) {
+		if (r->have_next) {
+			ext = r->next;
+			r->have_next = false;
+		} else {
+			err = copy_read_extent(r, &ext);
+			if (err < 0)
+				return err;
+			if (!err)
+				return r->have_cur;
+		}
+
+		if (!ext.nlb)
+			continue;
+
+		if (!r->have_cur) {
+			r->cur = ext;
+			r->have_cur = true;
+			continue;
+		}
+
+		if (ext.slba == r->cur.slba + r->cur.nlb &&
+		    ext.dlba == r->cur.dlba + r->cur.nlb &&
+		    ext.snsid == r->cur.snsid &&
+		    r->cur.nlb + ext.nlb > r->cur.nlb) {
+			r->cur.nlb += ext.nlb;
+			continue;
+		}
+
+		r->next = ext;
+		r->have_next = true;
+		return 1;
+	}
+}
+
+static void copy_set_range(void *buf, __u8 format, int i, __u32 snsid,
+			   __u64 slba, __u64 nlb)
+{
+	union copy_range *ranges = buf;
+	__u16 nlb0 = nlb - 1, zero16 = 0;
+	__u32 zero32 = 0;
+	__u64 zero64 = 0;
+
+	switch (format) {
+	case 1:
+		nvme_init_copy_range_f1(&ranges->f1 + i, &nlb0, &slba, &zero64,
+					&zero16, &zero16, 1);
+		break;
+	case 2:
+		nvme_init_copy_range_f2(&ranges->f2 + i, &snsid, &nlb0, &slba,
+					&zero16, &zero32, &zero16, &zero16, 1);
+		break;
+	case 3:
+		nvme_init_copy_range_f3(&ranges->f3 + i, &snsid, &nlb0, &slba,
+					&zero16, &zero64, &zero16, &zero16, 1);
+		break;
+	default:
+		nvme_init_copy_range_f0(&ranges->f0 + i, &nlb0, &slba, &zero32,
+					&zero16, &zero16, 1);
+		break;
+	}
+}
+
+/*
+ * Fill the source range descriptors for one command. Returns the number
+ * of ranges or -errno, @sdlba and @nlb describe the destination.
+ */
+static int copy_fill_ranges(struct copy_reader *r, void *buf, __u64 *sdlba,
+			    __u64 *nlb)
+{
+	__u64 total = 0, len;
+	int nr = 0, err;
+
+	while (nr < r->max_ranges) {
+		err = copy_next_coalesced(r);
+		if (err < 0)
+			return err;
+		if (!err)
+			break;
+
+		if (!nr)
+			*sdlba = r->cur.dlba;
+		else if (r->cur.dlba != *sdlba + total)
+			break;
+
+		len = min(r->cur.nlb, r->max_range_nlb);
+		if (r->max_nlb) {
+			if (total >= r->max_nlb)
+				break;
+			len = min(len, r->max_nlb - total);
+		}
+
+		copy_set_range(buf, r->format, nr, r->cur.snsid, r->cur.slba, len);
+		nr++;
+
+		total += len;
+		r->cur.slba += len;
+		r->cur.dlba += len;
+		r->cur.nlb -= len;
+		if (!r->cur.nlb)
+			r->have_cur = false;
+	}
+
+	*nlb = total;
+	return nr;
+}
+
+static int copy_range_file(struct libnvme_transport_handle *hdl, __u32 nsid,
+			   struct copy_reader *r, unsigned int depth,
+			   struct copy_params *p)
+{
+	__u64 sdlba = 0, first_sdlba = 0, nlb, blocks = 0, ranges = 0, cmds = 0;
+	struct nvme_ioq_req *req;
+	struct nvme_ioq *q;
+	int nr, err = 0;
+
+	err = nvme_ioq_open(hdl, depth, COPY_MAX_RANGES * sizeof(union copy_range),
+			    0, &q);
+	if (err) {
+		nvme_show_error("failed to set up I/O queue: %s",
+				libnvme_strerror(-err));
+		return err;
+	}
+
+	while (!nvme_sigint_received) {
+		req = nvme_ioq_next(q);
+		if (req->state == NVME_IOQ_DONE && req->err) {
+			err = req->err;
+			break;
+		}
+
+		nr = copy_fill_ranges(r, req->buf, &sdlba, &nlb);
+		if (nr <= 0) {
+			err = nr;
+			break;
+		}
+		if (!cmds)
+			first_sdlba = sdlba;
+
+		nvme_init_copy(&req->cmd, nsid, sdlba, nr, p->format,
+			       p->prinfor, p->prinfow, 0, p->dtype, p->stc,
+			       p->stc, p->fua, p->lr, 0, p->dspec, req->buf);
+		/* the reference tag given applies to the first destination block */
+		if (p->pi) {
+			nvme_init_var_size_tags(&req->cmd, p->pif, p->sts,
+						p->ilbrt + (sdlba - first_sdlba),
+						p->lbst);
+			nvme_init_app_tag(&req->cmd, p->lbat, p->lbatm);
+		}
+		nvme_ioq_submit(q, req);
+
+		blocks += nlb;
+		ranges += nr;
+		cmds++;
+	}
+	if (!err && nvme_sigint_received)
+		err = -EINTR;
+
+	while ((req = nvme_ioq_reap(q))) {
+		if (req->err && !err)
+			err = req->err;
+	}
+
+	nvme_ioq_close(q);
+
+	if (err) {
+		nvme_show_err(err, "NVMe Copy");
+		return err;
+	}
+
+	printf("NVMe Copy: success, %"PRIu64" blocks in %"PRIu64" ranges, %"PRIu64" commands\n",
+	       (uint64_t)blocks, (uint64_t)ranges, (uint64_t)cmds);
+
+	return 0;
+}
+
 static int copy_cmd(int argc, char **argv, struct command *acmd, struct plugin *plugin)
 {
 	const char *desc = "The Copy command is used by the host to copy data\n"
@@ -7807,6 +10373,8 @@ static int copy_cmd(int argc, char **argv, struct command *acmd, struct plugin *
 	const char *d_dtype = "directive type (write part)";
 	const char *d_dspec = "directive specific (write part)";
 	const char *d_format = "source range entry format";
+	const char *d_range_file = "file with one source range per line, '-' for stdin";
+	const char *d_queue_depth = "Copy commands in flight (range file only)";
 
 	__cleanup_nvme_global_ctx struct libnvme_global_ctx *ctx = NULL;
 	__cleanup_nvme_transport_handle struct libnvme_transport_handle *hdl = NULL;
@@ -7832,6 +10400,7 @@ static int copy_cmd(int argc, char **argv, struct command *acmd, struct plugin *
 		struct nvme_copy_range_f2 f2[256];
 		struct nvme_copy_range_f3 f3[256];
 	} *copy = NULL;
+	__cleanup_libnvme_free struct nvme_id_ns *ns_id = NULL;
 
 	struct config {
 		__u32	nsid;
@@ -7855,6 +10424,8 @@ static int copy_cmd(int argc, char **argv, struct command *acmd, struct plugin *
 		__u8	format;
 		__u64	lbst;
 		bool	stc;
+		char	*range_file;
+		__u32	queue_depth;
 	};
 
 	struct config cfg = {
@@ -7879,6 +10450,8 @@ static int copy_cmd(int argc, char **argv, struct command *acmd, struct plugin *
 		.format		= 0,
 		.lbst		= 0,
 		.stc		= false,
+		.range_file	= NULL,
+		.queue_depth	= 4,
 	};
 
 	NVME_ARGS(opts,
@@ -7902,7 +10475,9 @@ static int copy_cmd(int argc, char **argv, struct command *acmd, struct plugin *
 		  OPT_SHRT("dir-spec",               'S', &cfg.dspec,		d_dspec),
 		  OPT_BYTE("format",                 'F', &cfg.format,		d_format),
 		  OPT_SUFFIX("storage-tag",			 't', &cfg.lbst,		storage_tag),
-		  OPT_FLAG("storage-tag-check",		 'c', &cfg.stc,			storage_tag_check));
+		  OPT_FLAG("storage-tag-check",		 'c', &cfg.stc,			storage_tag_check),
+		  OPT_FILE("range-file",             'i', &cfg.range_file,	d_range_file),
+		  OPT_UINT("queue-depth",            'q', &cfg.queue_depth,	d_queue_depth));
 
 	err = parse_and_open(&ctx, &hdl, argc, argv, desc, opts);
 	if (err)
@@ -7939,7 +10514,16 @@ static int copy_cmd(int argc, char **argv, struct command *acmd, struct plugin *
 						   ARRAY_SIZE(elbats));
 
 	nr = max(nb, max(ns, max(nrts, max(natms, nats))));
-	if (cfg.format == 2 || cfg.format == 3) {
+	if (cfg.range_file) {
+		if (nr || nids || strlen(cfg.sopts)) {
+			nvme_show_error("Use either a range file or range lists");
+			return -EINVAL;
+		}
+		if (!cfg.queue_depth) {
+			nvme_show_error("Invalid queue depth");
+			return -EINVAL;
+		}
+	} else if (cfg.format == 2 || cfg.format == 3) {
 		if (nr != nids) {
 			nvme_show_error("formats 2 and 3 require source namespace ids for each source range");
 			return -EINVAL;
@@ -7948,7 +10532,7 @@ static int copy_cmd(int argc, char **argv, struct command *acmd, struct plugin *
 		nvme_show_error("formats 0 and 1 do not support cross-namespace copy");
 		return -EINVAL;
 	}
-	if (!nr || nr > 256) {
+	if (!cfg.range_file && (!nr || nr > 256)) {
 		nvme_show_error("invalid range");
 		return -EINVAL;
 	}
@@ -7961,6 +10545,66 @@ static int copy_cmd(int argc, char **argv, struct command *acmd, struct plugin *
 		}
 	}
 
+	if (cfg.range_file) {
+		struct copy_params params = {
+			.format		= cfg.format,
+			.prinfor	= cfg.prinfor,
+			.prinfow	= cfg.prinfow,
+			.dtype		= cfg.dtype,
+			.dspec		= cfg.dspec,
+			.stc		= cfg.stc,
+			.fua		= cfg.fua,
+			.lr		= cfg.lr,
+			.ilbrt		= cfg.ilbrt,
+			.lbst		= cfg.lbst,
+			.lbat		= cfg.lbat,
+			.lbatm		= cfg.lbatm,
+		};
+		struct copy_reader reader = {
+			.nsid		= cfg.nsid,
+			.format		= cfg.format,
+			.next_dlba	= cfg.sdlba,
+			.max_ranges	= COPY_MAX_RANGES,
+			.max_range_nlb	= 0x10000,
+		};
+
+		ns_id = libnvme_alloc(sizeof(*ns_id));
+		if (!ns_id)
+			return -ENOMEM;
+
+		err = nvme_identify_ns(hdl, cfg.nsid, ns_id);
+		if (err) {
+			nvme_show_err(err, "identify namespace");
+			return err;
+		}
+
+		/* MSRC is 0's based, an MSSRL or MCL of zero means no limit */
+		reader.max_ranges = min(ns_id->msrc + 1, COPY_MAX_RANGES);
+		if (ns_id->mssrl)
+			reader.max_range_nlb = min(le16_to_cpu(ns_id->mssrl),
+						   reader.max_range_nlb);
+		reader.max_nlb = le32_to_cpu(ns_id->mcl);
+
+		err = get_pi_format(hdl, cfg.nsid, &params.pif, &params.sts);
+		if (err && err != NVME_SC_INVALID_FIELD)
+			return err;
+		params.pi = !err;
+		if (params.pi && invalid_tags(cfg.lbst, cfg.ilbrt, params.sts,
+					      params.pif))
+			return -EINVAL;
+
+		err = range_file_open(&reader.rf, cfg.range_file);
+		if (err)
+			return err;
+
+		err = copy_range_file(hdl, cfg.nsid, &reader, cfg.queue_depth,
+				      &params);
+
+		range_file_close(&reader.rf);
+
+		return err;
+	}
+
 	copy = libnvme_alloc(sizeof(*copy));
 	if (!copy)
 		return -ENOMEM;
@@ -8391,6 +11035,344 @@ unsigned long long elapsed_utime(struct timeval start_time,
 	return err;
 }
 
+/*
+ * Large transfers are split into commands of at most @chunk logical
+ * blocks which are kept in flight on an nvme_ioq, so reading the input
+ * (or writing the output) overlaps with the device working on the
+ * previous commands.
+ */
+#define SUBMIT_IO_DEFAULT_XFER	(1024 * 1024)
+/* smallest MDTS a controller can report, MPSMIN is at least 4k */
+#define SUBMIT_IO_MIN_XFER	(2 * 4096)
+
+static OPT_VALS(patterns) = {
+	VAL_BYTE("zero", PATTERN_ZERO),
+	VAL_BYTE("random", PATTERN_RANDOM),
+	VAL_BYTE("lba", PATTERN_LBA),
+	VAL_BYTE("user", PATTERN_USER),
+	VAL_END()
+};
+
+struct submit_io_xfer {
+	struct libnvme_transport_handle *hdl;
+	__u8 opcode;
+	__u32 nsid;
+	__u64 slba;
+	__u64 nlb;
+	__u32 chunk;
+	unsigned int lbs;
+	__u16 ms;
+	__u16 control;
+	__u16 dspec;
+	__u8 dsmgmt;
+	bool pi;
+	__u8 pif;
+	__u8 sts;
+	__u64 ilbrt;
+	__u64 lbst;
+	__u16 lbat;
+	__u16 lbatm;
+	const struct pattern *pat;
+	const struct pi *host_pi;
+	int dfd;
+	int mfd;
+};
+
+/*
+ * Only transfers which might not fit into a single command need the MDTS of
+ * the controller. If it can't be read, @len is sent as one command.
+ */
+static __u64 get_max_xfer_size(struct libnvme_transport_handle *hdl,
+			       __u64 xfer_size, __u64 len)
+{
+	__cleanup_libnvme_free struct nvme_id_ctrl *ctrl = NULL;
+
+	if (xfer_size)
+		return xfer_size;
+
+	if (len <= SUBMIT_IO_MIN_XFER)
+		return len;
+
+	ctrl = libnvme_alloc(sizeof(*ctrl));
+	if (!ctrl || nvme_identify_ctrl(hdl, ctrl))
+		return len;
+
+	/* assuming CAP.MPSMIN is zero, as libnvme_get_telemetry_max() does */
+	if (ctrl->mdts && ctrl->mdts < 32)
+		return (1ULL << ctrl->mdts) * 4096;
+
+	return SUBMIT_IO_DEFAULT_XFER;
+}
+
+/*
+ * The streamed data and metadata files bypass the page cache where the
+ * file system allows it. Transfers which do not meet the O_DIRECT
+ * alignment rules (usually the tail of the file or the metadata) make
+ * the fd fall back to buffered I/O.
+ */
+static void set_direct_io(int fd)
+{
+#ifdef O_DIRECT
+	int flags = fcntl(fd, F_GETFL);
+
+	if (flags >= 0)
+		fcntl(fd, F_SETFL, flags | O_DIRECT);
+#endif
+}
+
+static bool clear_direct_io(int fd)
+{
+#ifdef O_DIRECT
+	int flags = fcntl(fd, F_GETFL);
+
+	if (flags >= 0 && (flags & O_DIRECT))
+		return !fcntl(fd, F_SETFL, flags & ~O_DIRECT);
+#endif
+	return false;
+}
+
+static ssize_t read_full(int fd, void *buf, size_t len)
+{
+	size_t done = 0;
+	ssize_t n;
+
+	while (done < len) {
+		n = read(fd, buf + done, len - done);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EINVAL && clear_direct_io(fd))
+				continue;
+			return -errno;
+		}
+		if (!n)
+			break;
+		done += n;
+	}
+
+	return done;
+}
+
+static int write_full(int fd, const void *buf, size_t len)
+{
+	ssize_t n;
+
+	while (len) {
+		n = write(fd, buf, len);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EINVAL && clear_direct_io(fd))
+				continue;
+			return -errno;
+		}
+		buf += n;
+		len -= n;
+	}
+
+	return 0;
+}
+
+static void cleanup_pattern(struct pattern *p)
+{
+	pattern_free(p);
+}
+
+/* Check @nlb blocks read at @slba, offsets are reported from @first */
+static int check_pattern(const struct pattern *p, const void *buf,
+			 __u64 slba, __u64 nlb, __u64 first)
+{
+	struct pattern_miscompare m;
+	__u64 lba;
+
+	if (pattern_check(p, buf, slba, nlb, &m))
+		return 0;
+
+	lba = slba + m.offset / p->stride;
+	nvme_show_error("pattern miscompare at LBA %"PRIu64" (byte %"PRIu64" of the transfer): expected %016"PRIx64", read %016"PRIx64,
+			(uint64_t)lba, (uint64_t)((slba - first) * p->stride + m.offset),
+			(uint64_t)m.expected, (uint64_t)m.actual);
+
+	return -EILSEQ;
+}
+
+/* Check the PI of @nlb blocks read at @slba with reference tag @ref_tag */
+static int check_pi(const struct pi *pi, const void *buf, const void *mbuf,
+		    __u64 slba, __u64 ref_tag, __u64 nlb)
+{
+	struct pi_error e;
+
+	if (pi_verify(pi, buf, mbuf, ref_tag, nlb, &e))
+		return 0;
+
+	nvme_show_error("PI %s check failed at LBA %"PRIu64": expected %"PRIx64", read %"PRIx64,
+			pi_field_name(e.field), (uint64_t)(slba + e.block),
+			(uint64_t)e.expected, (uint64_t)e.actual);
+
+	return -EILSEQ;
+}
+
+static int submit_io_fill(struct submit_io_xfer *x, struct nvme_ioq_req *req,
+			  __u64 off)
+{
+	__u32 nlb = min(x->chunk, x->nlb - off);
+	size_t len = (size_t)nlb * x->lbs;
+	size_t mlen = (size_t)nlb * x->ms;
+	ssize_t n;
+
+	if (x->opcode & 1) {
+		if (x->pat) {
+			pattern_fill(x->pat, req->buf, x->slba + off, nlb);
+		} else {
+			n = read_full(x->dfd, req->buf, len);
+			if (n < 0) {
+				nvme_show_error("failed to read data buffer from input file %s",
+						libnvme_strerror(-n));
+				return n;
+			}
+			memset(req->buf + n, 0, len - n);
+		}
+
+		if (mlen && x->mfd >= 0) {
+			n = read_full(x->mfd, req->mbuf, mlen);
+			if (n < 0) {
+				nvme_show_error("failed to read meta-data buffer from input file %s",
+						libnvme_strerror(-n));
+				return n;
+			}
+			memset(req->mbuf + n, 0, mlen - n);
+		} else if (mlen) {
+			memset(req->mbuf, 0, mlen);
+		}
+
+		if (x->host_pi)
+			pi_generate(x->host_pi, req->buf, req->mbuf,
+				    x->ilbrt + off, nlb);
+	}
+
+	nvme_init_io(&req->cmd, x->opcode, x->nsid, x->slba + off, req->buf,
+		     len, mlen ? req->mbuf : NULL, mlen);
+	req->cmd.cdw12 = NVME_FIELD_ENCODE(nlb - 1,
+			NVME_IOCS_COMMON_CDW12_NLB_SHIFT,
+			NVME_IOCS_COMMON_CDW12_NLB_MASK) |
+		    NVME_FIELD_ENCODE(x->control,
+			NVME_IOCS_COMMON_CDW12_CONTROL_SHIFT,
+			NVME_IOCS_COMMON_CDW12_CONTROL_MASK);
+	req->cmd.cdw13 = NVME_FIELD_ENCODE(x->dspec,
+			NVME_IOCS_COMMON_CDW13_DSPEC_SHIFT,
+			NVME_IOCS_COMMON_CDW13_DSPEC_MASK) |
+		    NVME_FIELD_ENCODE(x->dsmgmt,
+			NVME_IOCS_COMMON_CDW13_DSM_SHIFT,
+			NVME_IOCS_COMMON_CDW13_DSM_MASK);
+	if (x->pi) {
+		/* the reference tag follows the LBA for Type 1 and 2 */
+		nvme_init_var_size_tags(&req->cmd, x->pif, x->sts,
+					x->ilbrt + off, x->lbst);
+		nvme_init_app_tag(&req->cmd, x->lbat, x->lbatm);
+	}
+	req->tag = off;
+
+	return 0;
+}
+
+static int submit_io_complete(struct submit_io_xfer *x,
+			      struct nvme_ioq_req *req)
+{
+	int err;
+
+	if (req->err) {
+		nvme_show_err(req->err, "submit-io");
+		return req->err;
+	}
+
+	if (x->opcode & 1)
+		return 0;
+
+	if (x->host_pi) {
+		err = check_pi(x->host_pi, req->buf, req->mbuf,
+			       x->slba + req->tag, x->ilbrt + req->tag,
+			       req->cmd.data_len / x->lbs);
+		if (err)
+			return err;
+	}
+
+	if (x->pat) {
+		err = check_pattern(x->pat, req->buf, x->slba + req->tag,
+				    req->cmd.data_len / x->lbs, x->slba);
+		if (err)
+			return err;
+	}
+
+	if (x->dfd >= 0) {
+		err = write_full(x->dfd, req->buf, req->cmd.data_len);
+		if (err) {
+			nvme_show_error("write: %s: failed to write buffer to output file",
+					libnvme_strerror(-err));
+			return -EINVAL;
+		}
+	}
+
+	if (req->cmd.metadata_len && x->mfd >= 0) {
+		err = write_full(x->mfd, req->mbuf, req->cmd.metadata_len);
+		if (err) {
+			nvme_show_error("write: %s: failed to write meta-data buffer to output file",
+					libnvme_strerror(-err));
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
+static int submit_io_queued(struct submit_io_xfer *x, unsigned int depth)
+{
+	struct nvme_ioq_req *req;
+	struct nvme_ioq *q;
+	__u64 off;
+	int err, ret;
+
+	err = nvme_ioq_open(x->hdl, depth, (size_t)x->chunk * x->lbs,
+			    (size_t)x->chunk * x->ms, &q);
+	if (err) {
+		nvme_show_error("failed to set up I/O queue: %s",
+				libnvme_strerror(-err));
+		return err;
+	}
+
+	for (off = 0; off < x->nlb; off += x->chunk) {
+		if (nvme_sigint_received) {
+			err = -EINTR;
+			break;
+		}
+
+		req = nvme_ioq_next(q);
+		if (req->state == NVME_IOQ_DONE) {
+			err = submit_io_complete(x, req);
+			if (err)
+				break;
+		}
+
+		err = submit_io_fill(x, req, off);
+		if (err)
+			break;
+
+		nvme_ioq_submit(q, req);
+	}
+
+	/* drain in order, keep the first error */
+	while ((req = nvme_ioq_reap(q))) {
+		if (err)
+			continue;
+		ret = submit_io_complete(x, req);
+		if (ret)
+			err = ret;
+	}
+
+	nvme_ioq_close(q);
+
+	return err;
+}
+
 static int submit_io(int opcode, char *command, const char *desc, int argc, char **argv)
 {
 	__cleanup_nvme_transport_handle struct libnvme_transport_handle *hdl = NULL;
@@ -8403,13 +11385,21 @@ static int submit_io(int opcode, char *command, const char *desc, int argc, char
 	struct timeval start_time, end_time;
 	__cleanup_free void *mbuffer = NULL;
 	__cleanup_fd int dfd = -1, mfd = -1;
+	__cleanup(cleanup_pattern) struct pattern pat = { 0 };
+	struct pi host_pi = { 0 };
 	__u16 control = 0, nblocks = 0;
 	struct libnvme_passthru_cmd cmd;
+	struct submit_io_xfer xfer;
 	__u8 sts = 0, pif = 0;
+	unsigned long long nlb = 0;
+	__u64 max_xfer;
+	__u32 chunk = 0;
 	bool pi_available;
+	bool ext = false;
+	bool queued = false;
 	__u32 dsmgmt = 0;
 	int mode = 0644;
-	void *buffer;
+	void *buffer = NULL;
 	__u16 ms = 0;
 	int err = 0;
 	int flags;
@@ -8427,6 +11417,12 @@ static int submit_io(int opcode, char *command, const char *desc, int argc, char
 	const char *dspec = "directive specific (for write-only)";
 	const char *dsm = "dataset management attributes (lower 8 bits)";
 	const char *force = "The \"I know what I'm doing\" flag, do not enforce exclusive access for write";
+	const char *queue_depth = "commands kept in flight when the transfer is split";
+	const char *xfer_size = "max bytes per command, MDTS of the controller otherwise";
+	const char *pattern_desc = "generate (write) or check (read) a data pattern: zero|random|lba|user";
+	const char *pattern_seed = "random seed, or the tag of the lba pattern";
+	const char *pattern_data = "hex bytes of the user pattern";
+	const char *host_pi_desc = "generate (write) or check (read) protection information on the host";
 
 	struct config {
 		__u32	nsid;
@@ -8451,6 +11447,12 @@ static int submit_io(int opcode, char *command, const char *desc, int argc, char
 		bool	show;
 		bool	latency;
 		bool	force;
+		__u32	queue_depth;
+		__u64	xfer_size;
+		__u8	pattern;
+		__u64	pattern_seed;
+		char	*pattern_data;
+		bool	host_pi;
 	};
 
 	struct config cfg = {
@@ -8476,6 +11478,12 @@ static int submit_io(int opcode, char *command, const char *desc, int argc, char
 		.show				= false,
 		.latency			= false,
 		.force				= false,
+		.queue_depth		= 4,
+		.xfer_size			= 0,
+		.pattern			= PATTERN_NONE,
+		.pattern_seed		= 0,
+		.pattern_data		= NULL,
+		.host_pi		= false,
 	};
 
 	NVME_ARGS(opts,
@@ -8500,7 +11508,13 @@ static int submit_io(int opcode, char *command, const char *desc, int argc, char
 		  OPT_BYTE("dsm",               'D', &cfg.dsmgmt,            dsm),
 		  OPT_FLAG("show-command",      'V', &cfg.show,              show),
 		  OPT_FLAG("latency",           't', &cfg.latency,           latency),
-		  OPT_FLAG("force",               0, &cfg.force,             force));
+		  OPT_FLAG("force",               0, &cfg.force,             force),
+		  OPT_UINT("queue-depth",       'q', &cfg.queue_depth,       queue_depth),
+		  OPT_SUFFIX("xfer-size",       'x', &cfg.xfer_size,         xfer_size),
+		  OPT_BYTE("pattern",           'P', &cfg.pattern,           pattern_desc, patterns),
+		  OPT_SUFFIX("pattern-seed",    'e', &cfg.pattern_seed,      pattern_seed),
+		  OPT_STR("pattern-data",       'u', &cfg.pattern_data,      pattern_data),
+		  OPT_FLAG("host-pi",           'H', &cfg.host_pi,           host_pi_desc));
 
 	if (opcode != nvme_cmd_write) {
 		err = parse_and_open(&ctx, &hdl, argc, argv, desc, opts);
@@ -8588,10 +11602,85 @@ static int submit_io(int opcode, char *command, const char *desc, int argc, char
 		pi_available = true;
 	} else {
 		err = get_pi_info(hdl, cfg.nsid, cfg.prinfo,
-			cfg.ilbrt, cfg.lbst, &logical_block_size, &ms);
+			cfg.ilbrt, cfg.lbst, &logical_block_size, &ms, &ext);
 		pi_available = err == 0;
 	}
 
+	if (cfg.pattern) {
+		__u8 user[PATTERN_MAX_USER];
+		size_t user_len = 0;
+		__u64 seed = cfg.pattern_seed;
+		bool seeded = argconfig_parse_seen(opts, "pattern-seed");
+
+		if ((opcode & 1) && strlen(cfg.data)) {
+			nvme_show_error("Use either --data or --pattern");
+			return -EINVAL;
+		}
+		if (cfg.pattern == PATTERN_USER &&
+		    (!cfg.pattern_data ||
+		     pattern_parse_hex(cfg.pattern_data, user, &user_len))) {
+			nvme_show_error("user pattern needs --pattern-data of up to %d hex bytes",
+					PATTERN_MAX_USER);
+			return -EINVAL;
+		}
+		if (cfg.pattern == PATTERN_LBA && (opcode & 1) && !seeded) {
+			seed = time(NULL);
+			fprintf(stderr, "pattern tag: %"PRIu64"\n", (uint64_t)seed);
+		}
+
+		/* the metadata of extended LBAs is left alone */
+		err = pattern_init(&pat, cfg.pattern, seed, user, user_len,
+				   logical_block_size - (ext ? ms : 0));
+		if (err) {
+			nvme_show_error("pattern: %s", libnvme_strerror(-err));
+			return err;
+		}
+		pat.stride = logical_block_size;
+		/* without a tag the lba pattern only has to be consistent */
+		pat.any_tag = !seeded;
+
+		/* the pattern replaces stdin and stdout */
+		if (!strlen(cfg.data))
+			dfd = -1;
+		if (!strlen(cfg.metadata))
+			mfd = -1;
+	}
+
+	if (cfg.host_pi) {
+		if (cfg.prinfo & 0x8) {
+			nvme_show_error("--host-pi needs PRACT cleared in --prinfo");
+			return -EINVAL;
+		}
+
+		err = get_host_pi(hdl, cfg.nsid, &host_pi);
+		if (err)
+			return err;
+
+		if (logical_block_size !=
+		    host_pi.lbs + (host_pi.ext ? host_pi.ms : 0)) {
+			nvme_show_error("block size does not match the namespace format");
+			return -EINVAL;
+		}
+		ms = host_pi.ms;
+
+		host_pi.app_tag = cfg.lbat;
+		host_pi.app_mask = cfg.lbatm;
+		host_pi.storage_tag = cfg.lbst;
+		host_pi.check_storage = cfg.stc;
+
+		/* Type 1 reference tags are the lower bits of the LBA */
+		if (host_pi.type == NVME_NS_DPS_PI_TYPE1 &&
+		    !argconfig_parse_seen(opts, "ref-tag")) {
+			cfg.ilbrt = cfg.start_block;
+			if (host_pi.ref_bits < 64)
+				cfg.ilbrt &= (1ULL << host_pi.ref_bits) - 1;
+		}
+
+		/* the PI is generated, not read from stdin or written to stdout */
+		if (!host_pi.ext && !strlen(cfg.metadata))
+			mfd = -1;
+	}
+
 	buffer_size = ((long long)cfg.block_count + 1) * logical_block_size;
 	if (cfg.data_size < buffer_size)
 		nvme_show_error("Rounding data size to fit block count (%lld bytes)", buffer_size);
@@ -8602,6 +11691,33 @@ static int submit_io(int opcode, char *command, const char *desc, int argc, char
 		/* Use the value provided */
 		nblocks = cfg.block_count;
 	} else {
+		nlb = (buffer_size + (logical_block_size - 1)) / logical_block_size;
+		max_xfer = get_max_xfer_size(hdl, cfg.xfer_size,
+					     nlb * logical_block_size);
+		chunk = min(max_xfer / logical_block_size, 0x10000);
+		if (!chunk)
+			chunk = 1;
+		queued = nlb > chunk;
+	}
+
+	if (queued) {
+		if (!cfg.queue_depth) {
+			nvme_show_error("Invalid queue depth");
+			return -EINVAL;
+		}
+		if (cfg.metadata_size && !ms) {
+			nvme_show_error("metadata size per block unknown, use --block-count");
+			return -EINVAL;
+		}
+		if (pi_available) {
+			err = get_pi_format(hdl, cfg.nsid, &pif, &sts);
+			if (err)
+				return err;
+			if (invalid_tags(cfg.lbst, cfg.ilbrt, sts, pif))
+				return -EINVAL;
+		}
+		nblocks = chunk - 1;
+	} else if (!argconfig_parse_seen(opts, "block-count")) {
 		/* Get the required block count. Note this is a zeroes based value. */
 		nblocks = ((buffer_size + (logical_block_size - 1)) / logical_block_size) - 1;
 
@@ -8609,42 +11725,57 @@ static int submit_io(int opcode, char *command, const char *desc, int argc, char
 		buffer_size = ((unsigned long long)nblocks + 1) * logical_block_size;
 	}
 
-	buffer = libnvme_alloc_huge(buffer_size, &mh);
-	if (!buffer) {
-		nvme_show_error("failed to allocate huge memory");
-		return -ENOMEM;
-	}
+	if (cfg.host_pi && !host_pi.ext) {
+		unsigned long long msize = (queued ? nlb : nblocks + 1ULL) * ms;
 
-	if (cfg.metadata_size) {
-		mbuffer_size = ((unsigned long long)cfg.block_count + 1) * ms;
-		if (ms && cfg.metadata_size < mbuffer_size)
-			nvme_show_error("Rounding metadata size to fit block count (%lld bytes)",
-					mbuffer_size);
-		else
-			mbuffer_size = cfg.metadata_size;
+		if (cfg.metadata_size < msize)
+			cfg.metadata_size = msize;
+	}
 
-		mbuffer = malloc(mbuffer_size);
-		if (!mbuffer)
+	if (!queued) {
+		buffer = libnvme_alloc_huge(buffer_size, &mh);
+		if (!buffer) {
+			nvme_show_error("failed to allocate huge memory");
 			return -ENOMEM;
-		memset(mbuffer, 0, mbuffer_size);
-	}
+		}
 
-	if (opcode & 1) {
-		err = read(dfd, (void *)buffer, cfg.data_size);
-		if (err < 0) {
-			err = -errno;
-			nvme_show_error("failed to read data buffer from input file %s", libnvme_strerror(errno));
-			return err;
+		if (cfg.metadata_size) {
+			mbuffer_size = ((unsigned long long)cfg.block_count + 1) * ms;
+			if (ms && cfg.metadata_size < mbuffer_size)
+				nvme_show_error("Rounding metadata size to fit block count (%lld bytes)",
+						mbuffer_size);
+			else
+				mbuffer_size = cfg.metadata_size;
+
+			mbuffer = malloc(mbuffer_size);
+			if (!mbuffer)
+				return -ENOMEM;
+			memset(mbuffer, 0, mbuffer_size);
 		}
-	}
 
-	if ((opcode & 1) && cfg.metadata_size) {
-		err = read(mfd, (void *)mbuffer, mbuffer_size);
-		if (err < 0) {
-			err = -errno;
-			nvme_show_error("failed to read meta-data buffer from input file %s", libnvme_strerror(errno));
-			return err;
+		if ((opcode & 1) && cfg.pattern) {
+			pattern_fill(&pat, buffer, cfg.start_block, nblocks + 1);
+		} else if (opcode & 1) {
+			err = read(dfd, (void *)buffer, cfg.data_size);
+			if (err < 0) {
+				err = -errno;
+				nvme_show_error("failed to read data buffer from input file %s", libnvme_strerror(errno));
+				return err;
+			}
+		}
+
+		if ((opcode & 1) && cfg.metadata_size && mfd >= 0) {
+			err = read(mfd, (void *)mbuffer, mbuffer_size);
+			if (err < 0) {
+				err = -errno;
+				nvme_show_error("failed to read meta-data buffer from input file %s", libnvme_strerror(errno));
+				return err;
+			}
 		}
+
+		if ((opcode & 1) && cfg.host_pi)
+			pi_generate(&host_pi, buffer, mbuffer, cfg.ilbrt,
+				    nblocks + 1);
 	}
 
 	if (cfg.show || nvme_args.dry_run) {
@@ -8664,10 +11795,56 @@ static int submit_io(int opcode, char *command, const char *desc, int argc, char
 		printf("storagetag      : %"PRIx64"\n", (uint64_t)cfg.lbst);
 		printf("pif             : %02x\n", pif);
 		printf("sts             : %02x\n", sts);
+		if (queued) {
+			printf("commands        : %llu\n",
+			       (nlb + chunk - 1) / chunk);
+			printf("queue depth     : %u\n", cfg.queue_depth);
+		}
 	}
 	if (nvme_args.dry_run)
 		return 0;
 
+	if (queued) {
+		if (strlen(cfg.data))
+			set_direct_io(dfd);
+		if (strlen(cfg.metadata))
+			set_direct_io(mfd);
+
+		xfer = (struct submit_io_xfer) {
+			.hdl = hdl,
+			.opcode = opcode,
+			.nsid = cfg.nsid,
+			.slba = cfg.start_block,
+			.nlb = nlb,
+			.chunk = chunk,
+			.lbs = logical_block_size,
+			.ms = cfg.metadata_size ? ms : 0,
+			.control = control,
+			.dspec = cfg.dspec,
+			.dsmgmt = cfg.dsmgmt,
+			.pi = pi_available,
+			.pif = pif,
+			.sts = sts,
+			.ilbrt = cfg.ilbrt,
+			.lbst = cfg.lbst,
+			.lbat = cfg.lbat,
+			.lbatm = cfg.lbatm,
+			.pat = cfg.pattern ? &pat : NULL,
+			.host_pi = cfg.host_pi ? &host_pi : NULL,
+			.dfd = dfd,
+			.mfd = mfd,
+		};
+
+		gettimeofday(&start_time, NULL);
+		err = submit_io_queued(&xfer, cfg.queue_depth);
+		gettimeofday(&end_time, NULL);
+		if (cfg.latency)
+			printf(" latency: %s: %llu us\n", command, elapsed_utime(start_time, end_time));
+		if (!err)
+			fprintf(stderr, "%s: Success\n", command);
+		return err;
+	}
+
 	nvme_init_io(&cmd, opcode, cfg.nsid, cfg.start_block, buffer,
 		     buffer_size, mbuffer, mbuffer_size);
 	cmd.cdw12 = NVME_FIELD_ENCODE(nblocks,
@@ -8698,12 +11875,27 @@ static int submit_io(int opcode, char *command, const char *desc, int argc, char
 		return err;
 	}
 
-	if (!(opcode & 1) && write(dfd, (void *)buffer, buffer_size) < 0) {
+	if (!(opcode & 1) && cfg.host_pi) {
+		err = check_pi(&host_pi, buffer, mbuffer, cfg.start_block,
+			       cfg.ilbrt, nblocks + 1);
+		if (err)
+			return err;
+	}
+
+	if (!(opcode & 1) && cfg.pattern) {
+		err = check_pattern(&pat, buffer, cfg.start_block, nblocks + 1,
+				    cfg.start_block);
+		if (err)
+			return err;
+	}
+
+	if (!(opcode & 1) && dfd >= 0 &&
+	    write(dfd, (void *)buffer, buffer_size) < 0) {
 		nvme_show_error(
 		    "write: %s: failed to write buffer to output file",
 		    libnvme_strerror(errno));
 		err = -EINVAL;
-	} else if (!(opcode & 1) && cfg.metadata_size &&
+	} else if (!(opcode & 1) && cfg.metadata_size && mfd >= 0 &&
 		   write(mfd, (void *)mbuffer, mbuffer_size) < 0) {
 		nvme_show_error(
 		    "write: %s: failed to write meta-data buffer to output file",
@@ -8747,7 +11939,7 @@ static int verify_cmd(int argc, char **argv, struct command *acmd, struct plugin
 	__cleanup_nvme_global_ctx struct libnvme_global_ctx *ctx = NULL;
 	struct libnvme_passthru_cmd cmd;
 	__u16 control = 0;
-	int err;
+	int err, sweep;
 
 	const char *desc = "Verify specified logical blocks on the given device.";
 	const char *force_unit_access_verify =
@@ -8767,6 +11959,10 @@ static int verify_cmd(int argc, char **argv, struct command *acmd, struct plugin
 		__u16	lbatm;
 		__u64	lbst;
 		bool	stc;
+		__u64	range;
+		bool	to_end;
+		__u32	queue_depth;
+		char	*checkpoint;
 	};
 
 	struct config cfg = {
@@ -8781,6 +11977,10 @@ static int verify_cmd(int argc, char **argv, struct command *acmd, struct plugin
 		.lbatm				= 0,
 		.lbst				= 0,
 		.stc				= false,
+		.range				= 0,
+		.to_end				= false,
+		.queue_depth		= 4,
+		.checkpoint			= NULL,
 	};
 
 	NVME_ARGS(opts,
@@ -8794,13 +11994,22 @@ static int verify_cmd(int argc, char **argv, struct command *acmd, struct plugin
 		  OPT_SHRT("app-tag",           'a', &cfg.lbat,				 app_tag),
 		  OPT_SHRT("app-tag-mask",      'm', &cfg.lbatm,			 app_tag_mask),
 		  OPT_SUFFIX("storage-tag",     'S', &cfg.lbst,				 storage_tag),
-		  OPT_FLAG("storage-tag-check", 'C', &cfg.stc,				 storage_tag_check));
+		  OPT_FLAG("storage-tag-check", 'C', &cfg.stc,				 storage_tag_check),
+		  OPT_SUFFIX("range",           'R', &cfg.range,             sweep_range),
+		  OPT_FLAG("to-end",            'e', &cfg.to_end,            sweep_to_end),
+		  OPT_UINT("queue-depth",       'q', &cfg.queue_depth,       sweep_queue_depth),
+		  OPT_FILE("checkpoint",        'k', &cfg.checkpoint,        sweep_checkpoint));
 
 
 	err = parse_and_open(&ctx, &hdl, argc, argv, desc, opts);
 	if (err)
 		return err;
 
+	sweep = lba_sweep_requested(opts, cfg.range, cfg.to_end,
+				    cfg.queue_depth, cfg.checkpoint);
+	if (sweep < 0)
+		return sweep;
+
 	err = open_fallback_chardev(ctx, cfg.nsid, &hdl);
 	if (err)
 		return err;
@@ -8824,6 +12033,29 @@ static int verify_cmd(int argc, char **argv, struct command *acmd, struct plugin
 		}
 	}
 
+	if (sweep) {
+		struct lba_sweep s = {
+			.name		= "NVMe Verify",
+			.opcode		= nvme_cmd_verify,
+			.nsid		= cfg.nsid,
+			.control	= control,
+			.slba		= cfg.start_block,
+			.depth		= cfg.queue_depth,
+			.checkpoint	= cfg.checkpoint,
+		};
+
+		err = init_sweep_pi(hdl, &s, cfg.ilbrt, cfg.lbst, cfg.lbat,
+				    cfg.lbatm);
+		if (err)
+			return err;
+
+		err = lba_sweep_setup(hdl, &s, cfg.range);
+		if (err)
+			return err;
+
+		return lba_sweep_run(hdl, &s);
+	}
+
 	nvme_init_verify(&cmd, cfg.nsid, cfg.start_block,
 		cfg.block_count, control, 0, NULL, 0, NULL, 0);
 	err = init_pi_tags(hdl, &cmd, cfg.nsid, cfg.ilbrt, cfg.lbst,
@@ -9219,6 +12451,27 @@ static int rpmb_cmd(int argc, char **argv, struct command *acmd, struct plugin *
 	return rpmb_cmd_option(argc, argv, acmd, plugin);
 }
 
+/* export_cmd_option is defined in nvme-export.c */
+extern int export_cmd_option(int, char **, struct command *, struct plugin *);
+static int export_cmd(int argc, char **argv, struct command *acmd, struct plugin *plugin)
+{
+	return export_cmd_option(argc, argv, acmd, plugin);
+}
+
+/* bench_cmd_option is defined in nvme-bench.c */
+extern int bench_cmd_option(int, char **, struct command *, struct plugin *);
+static int bench_cmd(int argc, char **argv, struct command *acmd, struct plugin *plugin)
+{
+	return bench_cmd_option(argc, argv, acmd, plugin);
+}
+
+/* snapshot_cmd_option is defined in nvme-snapshot.c */
+extern int snapshot_cmd_option(int, char **, struct command *, struct plugin *);
+static int snapshot_cmd(int argc, char **argv, struct command *acmd, struct plugin *plugin)
+{
+	return snapshot_cmd_option(argc, argv, acmd, plugin);
+}
+
 static int lockdown_cmd(int argc, char **argv, struct command *acmd, struct plugin *plugin)
 {
 	const char *desc = "The Lockdown command is used to control the\n"
@@ -40,16 +40,33 @@ enum nvme_print_flags {
 	VS		= 1 << 2,	/* hex dump vendor specific data areas */
 	BINARY		= 1 << 3,	/* binary dump raw bytes */
 	TABULAR		= 1 << 4,	/* prints aligned columns for easy reading */
+	NDJSON		= 1 << 5,	/* json, one line per object or record */
+	CBOR		= 1 << 6,	/* self-describing CBOR encoding */
 };
 
 typedef uint32_t nvme_print_flags_t;
 
+/* the output format of @flags, ndjson is json printed line by line */
+static inline nvme_print_flags_t nvme_output_format(nvme_print_flags_t flags)
+{
+	return flags & ~NDJSON;
+}
+
 enum nvme_cli_topo_ranking {
 	NVME_CLI_TOPO_NAMESPACE,
 	NVME_CLI_TOPO_CTRL,
 	NVME_CLI_TOPO_MULTIPATH,
 };
 
+enum nvme_cli_top_sort {
+	NVME_CLI_TOP_SORT_NONE,
+	NVME_CLI_TOP_SORT_IOPS,
+	NVME_CLI_TOP_SORT_BW,
+	NVME_CLI_TOP_SORT_LAT,
+	NVME_CLI_TOP_SORT_UTIL,
+	NVME_CLI_TOP_SORT_INFLIGHTS,
+};
+
 #define SYS_NVME "/sys/class/nvme"
 
 struct nvme_args {
@@ -63,9 +80,9 @@ struct nvme_args {
 };
 
 #ifdef CONFIG_JSONC
-#define DESC_OUTPUT_FORMAT "Output format: normal|json|binary|tabular"
+#define DESC_OUTPUT_FORMAT "Output format: normal|json|ndjson|binary|cbor|tabular"
 #else /* CONFIG_JSONC */
-#define DESC_OUTPUT_FORMAT "Output format: normal|binary|tabular"
+#define DESC_OUTPUT_FORMAT "Output format: normal|binary|cbor|tabular"
 #endif /* CONFIG_JSONC */
 
 /*
@@ -135,6 +152,59 @@ int parse_and_open(struct libnvme_global_ctx **ctx,
 		struct libnvme_transport_handle **hdl, int argc, char **argv,
 		const char *desc, struct argconfig_commandline_options *clo);
 
+/* selects the controllers a log is fetched from, besides those named */
+struct multi_devs_cfg {
+	bool	all;
+	char	*regex;
+	char	*nqn;
+	__u32	jobs;
+};
+
+#define OPT_MULTI_DEVS(devs)							\
+	OPT_FLAG("all-devices",   0, &(devs).all,   all_devices),		\
+	OPT_STR("device-regex",   0, &(devs).regex, device_regex),		\
+	OPT_STR("subsys-nqn",     0, &(devs).nqn,   subsys_nqn_filter),	\
+	OPT_UINT("jobs",          0, &(devs).jobs,  multi_jobs)
+
+struct nvme_multi_dev;
+
+struct multi_log_job {
+	struct argconfig_commandline_options *opts;
+	/* fetches the log into dev->data, allocated with malloc() */
+	int (*fetch)(struct libnvme_transport_handle *hdl,
+		     struct nvme_multi_dev *dev, void *arg);
+	void (*show)(struct nvme_multi_dev *dev, void *arg,
+		     nvme_print_flags_t flags);
+	void *arg;
+};
+
+/*
+ * parse_and_open_devs - like parse_and_open(), but leaves the device
+ * closed when @devs selects several controllers, for multi_log()
+ */
+int parse_and_open_devs(struct libnvme_global_ctx **ctx,
+		struct libnvme_transport_handle **hdl, int argc, char **argv,
+		const char *desc, struct argconfig_commandline_options *clo,
+		struct multi_devs_cfg *devs);
+
+bool multi_devs_requested(struct multi_devs_cfg *cfg, int argc);
+
+/*
+ * multi_log - fetches a log from the controllers selected by @cfg and
+ * the devices named, and shows them as one document keyed by device
+ */
+int multi_log(struct multi_log_job *job, struct multi_devs_cfg *cfg,
+	      int argc, char **argv, nvme_print_flags_t flags);
+
+/*
+ * open_multi_dev - opens @devname with a global context of its own, for
+ * the workers of nvme_multi_run()
+ */
+int open_multi_dev(const char *devname,
+		struct argconfig_commandline_options *opts,
+		struct libnvme_global_ctx **ctx,
+		struct libnvme_transport_handle **hdl);
+
 // TODO: unsure if we need a double ptr here
 static inline DEFINE_CLEANUP_FUNC(
 	cleanup_nvme_transport_handle, struct libnvme_transport_handle *, libnvme_close)
@@ -142,6 +212,10 @@ static inline DEFINE_CLEANUP_FUNC(
 
 extern const char *uuid_index;
 extern const char *namespace_id_desired;
+extern const char *all_devices;
+extern const char *device_regex;
+extern const char *subsys_nqn_filter;
+extern const char *multi_jobs;
 extern struct nvme_args nvme_args;
 
 int validate_output_format(const char *format, nvme_print_flags_t *flags);
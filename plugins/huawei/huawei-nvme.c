@@ -316,7 +316,7 @@ static int huawei_list(int argc, char **argv, struct command *acmd,
 		return ret;
 
 	ret = validate_output_format(nvme_args.output_format, &fmt);
-	if (ret < 0 || (fmt != JSON && fmt != NORMAL))
+	if (ret < 0 || (!(fmt & JSON) && fmt != NORMAL))
 		return ret;
 
 	n = scandir("/dev", &devices, libnvme_filter_namespace, alphasort);
@@ -350,7 +350,7 @@ static int huawei_list(int argc, char **argv, struct command *acmd,
 
 	if (huawei_num > 0) {
 #ifdef CONFIG_JSONC
-		if (fmt == JSON)
+		if (fmt & JSON)
 			huawei_json_print_list_items(list_items, huawei_num);
 		else
 #endif /* CONFIG_JSONC */
@@ -574,7 +574,7 @@ int show_nbft(int argc, char **argv, struct command *acmd, struct plugin *plugin
 		if (flags == NORMAL)
 			normal_show_nbfts(head, show_subsys,
 				show_hfi, show_discovery);
-		else if (flags == JSON)
+		else if (flags & JSON)
 			ret = json_show_nbfts(head, show_subsys,
 				show_hfi, show_discovery);
 		libnvmf_nbft_free(ctx, head);
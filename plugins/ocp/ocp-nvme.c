@@ -24,6 +24,7 @@
 #include "nvme-print.h"
 #include "nvme.h"
 #include "plugin.h"
+#include "util/compress.h"
 #include "util/types.h"
 
 #include "ocp-smart-extended-log.h"
@@ -792,13 +793,14 @@ static void print_telemetry_da_fifo(struct telemetry_event_desc *da_fifo,
 }
 static int extract_dump_get_log(struct libnvme_transport_handle *hdl, char *featurename, char *filename, char *sn,
 				int dumpsize, int transfersize, __u32 nsid, __u8 log_id,
-				__u8 lsp, __u64 offset, bool rae)
+				__u8 lsp, __u64 offset, bool rae, enum compress_type compress)
 {
 	int i = 0, err = 0;
 
 	char *data = calloc(transfersize, sizeof(char));
 	char filepath[FILE_NAME_SIZE] = {0,};
 	int output = 0;
+	struct compress_stream *cs = NULL;
 	int total_loop_cnt = dumpsize / transfersize;
 	int last_xfer_size = dumpsize % transfersize;
 	struct libnvme_passthru_cmd cmd;
@@ -809,9 +811,11 @@ static int extract_dump_get_log(struct libnvme_transport_handle *hdl, char *feat
 		last_xfer_size = transfersize;
 
 	if (filename == 0)
-		snprintf(filepath, FILE_NAME_SIZE, "%s_%s.bin", featurename, sn);
+		snprintf(filepath, FILE_NAME_SIZE, "%s_%s.bin%s", featurename, sn,
+			 compress_suffix(compress));
 	else
-		snprintf(filepath, FILE_NAME_SIZE, "%s%s_%s.bin", filename, featurename, sn);
+		snprintf(filepath, FILE_NAME_SIZE, "%s%s_%s.bin%s", filename, featurename, sn,
+			 compress_suffix(compress));
 
 	for (i = 0; i < total_loop_cnt; i++) {
 		memset(data, 0, transfersize);
@@ -827,31 +831,35 @@ static int extract_dump_get_log(struct libnvme_transport_handle *hdl, char *feat
 				goto end;
 		}
 
-		if (i != total_loop_cnt - 1) {
-			if (!i) {
-				output = open(filepath, O_WRONLY | O_CREAT | O_TRUNC, 0666);
-				if (output < 0) {
-					err = -13;
-					goto end;
-				}
+		if (!i) {
+			output = open(filepath, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+			if (output < 0) {
+				err = -13;
+				goto end;
 			}
-			if (write(output, data, transfersize) < 0) {
-				err = -10;
-				goto close_output;
-			}
-		} else {
-			if (write(output, data, last_xfer_size) < 0) {
-				err = -10;
+			/* the transfers are compressed as they arrive */
+			cs = compress_open(output, compress);
+			if (!cs) {
+				err = -errno;
 				goto close_output;
 			}
 		}
+
+		if (compress_write(cs, data, i != total_loop_cnt - 1 ?
+				   transfersize : last_xfer_size) < 0) {
+			err = -10;
+			goto close_output;
+		}
 		offset += transfersize;
 		printf("%d%%\r", (i + 1) * 100 / total_loop_cnt);
 	}
-	printf("100%%\nThe log file was saved at \"%s\"\n", filepath);
 
 close_output:
+	if (cs && compress_close(cs) < 0 && !err)
+		err = -10;
 	close(output);
+	if (!err)
+		printf("100%%\nThe log file was saved at \"%s\"\n", filepath);
 
 end:
 	free(data);
@@ -859,7 +867,8 @@ end:
 }
 
 static int get_telemetry_dump(struct libnvme_transport_handle *hdl, char *filename, char *sn,
-			      enum TELEMETRY_TYPE tele_type, int data_area, bool header_print)
+			      enum TELEMETRY_TYPE tele_type, int data_area, bool header_print,
+			      enum compress_type compress)
 {
 	__u32 err = 0, nsid = 0;
 	__u64 da1_sz = 512, m_512_sz = 0, da1_off = 0, m_512_off = 0, diff = 0, temp_sz = 0,
@@ -1154,7 +1163,8 @@ static int get_telemetry_dump(struct libnvme_transport_handle *hdl, char *filena
 
 	snprintf(dumpname, FILE_NAME_SIZE, "Telemetry_%s_Area_%d", featurename, data_area);
 	err = extract_dump_get_log(hdl, dumpname, filename, sn, size * TELEMETRY_BYTE_PER_BLOCK,
-				   TELEMETRY_TRANSFER_SIZE, nsid, tele_type, 0, offset, rae);
+				   TELEMETRY_TRANSFER_SIZE, nsid, tele_type, 0, offset, rae,
+				   compress);
 
 	return err;
 }
@@ -1425,6 +1435,8 @@ static int ocp_telemetry_log(int argc, char **argv, struct command *acmd, struct
 			"e.g. '-a 4 for Data Areas 1, 2, 3, and 4.';\n";
 
 	const char *telemetry_type = "Telemetry Type; 'host', 'host0', 'host1' or 'controller'";
+	const char *compress_dump = "Compress the host0 and host1 dumps as they are read;\n"
+			"none, rle, gzip or zstd";
 
 	__cleanup_nvme_global_ctx struct libnvme_global_ctx *ctx = NULL;
 	__cleanup_nvme_transport_handle struct libnvme_transport_handle *hdl = NULL;
@@ -1440,13 +1452,15 @@ static int ocp_telemetry_log(int argc, char **argv, struct command *acmd, struct
 	const char *string_suffix = "string.bin";
 	const char *tele_log_suffix = "telemetry.bin";
 	bool host_behavior_changed = false;
+	__u8 compress = COMPRESS_NONE;
 
 	NVME_ARGS(opts,
 		OPT_STR("telemetry-log", 'l', &opt.telemetry_log, telemetry_log),
 		OPT_STR("string-log", 's', &opt.string_log, string_log),
 		OPT_FILE("output-file", 'f', &opt.output_file, output_file),
 		OPT_INT("data-area", 'a', &opt.data_area, data_area),
-		OPT_STR("telemetry-type", 't', &opt.telemetry_type, telemetry_type));
+		OPT_STR("telemetry-type", 't', &opt.telemetry_type, telemetry_type),
+		OPT_BYTE("compress", 0, &compress, compress_dump, compress_vals));
 
 	err = parse_and_open(&ctx, &hdl, argc, argv, desc, opts);
 	if (err)
@@ -1586,7 +1600,8 @@ static int ocp_telemetry_log(int argc, char **argv, struct command *acmd, struct
 		printf("Extracting Telemetry Host(%d) Dump (Data Area %d)...\n",
 				(tele_type == TELEMETRY_TYPE_HOST_0) ? 0 : 1, tele_area);
 
-		err = get_telemetry_dump(hdl, opt.output_file, sn, tele_type, tele_area, true);
+		err = get_telemetry_dump(hdl, opt.output_file, sn, tele_type, tele_area, true,
+					 compress);
 		if (err)
 			fprintf(stderr, "NVMe Status: %s(%x)\n", libnvme_status_to_string(err, false),
 				err);
@@ -371,9 +371,7 @@ static void json_smart_extended_log_v1(struct ocp_smart_extended_log *log)
 		json_object_add_value_uint(root, "Power State Change Count",
 						le64_to_cpu(log->power_state_change_count));
 	}
-	json_print_object(root, NULL);
-	printf("\n");
-	json_free_object(root);
+	json_print(root);
 }
 
 static void json_smart_extended_log_v2(struct ocp_smart_extended_log *log)
@@ -535,9 +533,7 @@ static void json_smart_extended_log_v2(struct ocp_smart_extended_log *log)
 		json_object_add_value_uint(root, "power_state_change_count",
 						le64_to_cpu(log->power_state_change_count));
 	}
-	json_print_object(root, NULL);
-	printf("\n");
-	json_free_object(root);
+	json_print(root);
 }
 
 static void json_smart_extended_log(struct ocp_smart_extended_log *log, unsigned int version)
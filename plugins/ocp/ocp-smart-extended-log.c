@@ -10,6 +10,7 @@
 #include <stdio.h>
 
 #include "common.h"
+#include "nvme-multi.h"
 #include "nvme-print.h"
 #include "ocp-nvme.h"
 #include "ocp-print.h"
@@ -26,15 +27,53 @@ static __u8 scao_guid[GUID_LEN] = {
 	0xC9, 0x14, 0xD5, 0xAF
 };
 
+/* reads the C0 log page into @data, which is C0_SMART_CLOUD_ATTR_LEN long */
+static int read_c0_log_page(struct libnvme_transport_handle *hdl,
+			    struct ocp_smart_extended_log *data)
+{
+	struct libnvme_passthru_cmd cmd;
+	__u8 uidx;
+	int ret;
+	int i, j;
+
+	ocp_get_uuid_index(hdl, &uidx);
+	nvme_init_get_log(&cmd, NVME_NSID_ALL,
+			  (enum nvme_cmd_get_log_lid)OCP_LID_SMART,
+			  NVME_CSI_NVM, data, C0_SMART_CLOUD_ATTR_LEN);
+	cmd.cdw14 |= NVME_FIELD_ENCODE(uidx,
+				       NVME_LOG_CDW14_UUID_SHIFT,
+				       NVME_LOG_CDW14_UUID_MASK);
+	ret = libnvme_get_log(hdl, &cmd, false, NVME_LOG_PAGE_PDU_SIZE);
+	if (ret)
+		return ret;
+
+	/* check log page guid */
+	/* Verify GUID matches */
+	for (i = 0; i < 16; i++) {
+		if (scao_guid[i] != data->log_page_guid[i]) {
+			fprintf(stderr, "ERROR : OCP : Unknown GUID in C0 Log Page data\n");
+			fprintf(stderr, "ERROR : OCP : Expected GUID:  0x");
+			for (j = 0; j < 16; j++)
+				fprintf(stderr, "%x", scao_guid[j]);
+
+			fprintf(stderr, "\nERROR : OCP : Actual GUID:    0x");
+			for (j = 0; j < 16; j++)
+				fprintf(stderr, "%x", data->log_page_guid[j]);
+			fprintf(stderr, "\n");
+
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
 static int get_c0_log_page(struct libnvme_transport_handle *hdl, char *format,
 			   unsigned int format_version)
 {
 	struct ocp_smart_extended_log *data;
-	struct libnvme_passthru_cmd cmd;
 	nvme_print_flags_t fmt;
-	__u8 uidx;
 	int ret;
-	int i;
 
 	ret = validate_output_format(format, &fmt);
 	if (ret < 0) {
@@ -49,66 +88,71 @@ static int get_c0_log_page(struct libnvme_transport_handle *hdl, char *format,
 	}
 	memset(data, 0, sizeof(__u8) * C0_SMART_CLOUD_ATTR_LEN);
 
-	ocp_get_uuid_index(hdl, &uidx);
-	nvme_init_get_log(&cmd, NVME_NSID_ALL,
-			  (enum nvme_cmd_get_log_lid)OCP_LID_SMART,
-			  NVME_CSI_NVM, data, C0_SMART_CLOUD_ATTR_LEN);
-	cmd.cdw14 |= NVME_FIELD_ENCODE(uidx,
-				       NVME_LOG_CDW14_UUID_SHIFT,
-				       NVME_LOG_CDW14_UUID_MASK);
-	ret = libnvme_get_log(hdl, &cmd, false, NVME_LOG_PAGE_PDU_SIZE);
+	ret = read_c0_log_page(hdl, data);
 
 	if (strcmp(format, "json"))
 		fprintf(stderr, "NVMe Status:%s(%x)\n",
 			libnvme_status_to_string(ret, false), ret);
 
-	if (ret == 0) {
-		/* check log page guid */
-		/* Verify GUID matches */
-		for (i = 0; i < 16; i++) {
-			if (scao_guid[i] != data->log_page_guid[i]) {
-				int j;
-
-				fprintf(stderr, "ERROR : OCP : Unknown GUID in C0 Log Page data\n");
-				fprintf(stderr, "ERROR : OCP : Expected GUID:  0x");
-				for (j = 0; j < 16; j++)
-					fprintf(stderr, "%x", scao_guid[j]);
-
-				fprintf(stderr, "\nERROR : OCP : Actual GUID:    0x");
-				for (j = 0; j < 16; j++)
-					fprintf(stderr, "%x", data->log_page_guid[j]);
-				fprintf(stderr, "\n");
-
-				ret = -1;
-				goto out;
-			}
-		}
-
+	if (ret == 0)
 		/* print the data */
 		ocp_smart_extended_log(data, format_version, fmt);
-	} else {
+	else
 		fprintf(stderr, "ERROR : OCP : Unable to read C0 data from buffer\n");
-	}
 
-out:
 	free(data);
 	return ret;
 }
 
+static int c0_log_fetch(struct libnvme_transport_handle *hdl,
+			struct nvme_multi_dev *dev, void *arg)
+{
+	dev->data = calloc(1, C0_SMART_CLOUD_ATTR_LEN);
+	if (!dev->data)
+		return -ENOMEM;
+
+	return read_c0_log_page(hdl, dev->data);
+}
+
+static void c0_log_show(struct nvme_multi_dev *dev, void *arg,
+			nvme_print_flags_t flags)
+{
+	ocp_smart_extended_log(dev->data, nvme_args.output_format_ver, flags);
+}
+
 int ocp_smart_add_log(int argc, char **argv, struct command *acmd,
 		      struct plugin *plugin)
 {
 	const char *desc = "Retrieve the extended SMART health data.";
 	__cleanup_nvme_global_ctx struct libnvme_global_ctx *ctx = NULL;
 	__cleanup_nvme_transport_handle struct libnvme_transport_handle *hdl = NULL;
+	struct multi_devs_cfg devs = { .jobs = 8 };
+	nvme_print_flags_t flags;
 	int ret = 0;
 
-	NVME_ARGS(opts);
+	NVME_ARGS(opts,
+		  OPT_MULTI_DEVS(devs));
 
-	ret = parse_and_open(&ctx, &hdl, argc, argv, desc, opts);
+	ret = parse_and_open_devs(&ctx, &hdl, argc, argv, desc, opts, &devs);
 	if (ret)
 		return ret;
 
+	if (multi_devs_requested(&devs, argc)) {
+		struct multi_log_job job = {
+			.opts = opts,
+			.fetch = c0_log_fetch,
+			.show = c0_log_show,
+		};
+
+		ret = validate_output_format(nvme_args.output_format, &flags);
+		if (ret < 0) {
+			fprintf(stderr, "ERROR : OCP : invalid output format\n");
+			return ret;
+		}
+
+		return multi_log(&job, &devs, argc, argv, flags);
+	}
+
 	ret = get_c0_log_page(hdl, nvme_args.output_format,
 			      nvme_args.output_format_ver);
 	if (ret)
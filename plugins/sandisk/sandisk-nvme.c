@@ -909,7 +909,7 @@ static int sndk_print_fw_act_history_log(__u8 *data, int num_entries, int fmt)
 		return -1;
 	}
 
-	switch (fmt) {
+	switch (nvme_output_format(fmt)) {
 	case NORMAL:
 		sndk_print_fw_act_history_log_normal(data, num_entries);
 		break;
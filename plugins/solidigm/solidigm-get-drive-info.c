@@ -31,7 +31,7 @@ int sldgm_get_drive_info(int argc, char **argv, struct command *acmd, struct plu
 		return err;
 
 	err = validate_output_format(nvme_args.output_format, &flags);
-	if ((err < 0) || !(flags == NORMAL || flags == JSON)) {
+	if ((err < 0) || !(flags == NORMAL || flags & JSON)) {
 		nvme_show_error("Invalid output format");
 		return err;
 	}
@@ -67,7 +67,7 @@ int sldgm_get_drive_info(int argc, char **argv, struct command *acmd, struct plu
 	lba_size = 1 << ns.lbaf[flbaf_inUse].ds;
 	ftl_unit_size = (le16_to_cpu(ns.npwg) + 1) * lba_size / 1024;
 
-	if (flags == JSON) {
+	if (flags & JSON) {
 		struct json_object *root = json_create_object();
 
 		json_object_add_value_int(root, FTL_unit_size_str, ftl_unit_size);
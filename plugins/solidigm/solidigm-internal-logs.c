@@ -24,6 +24,7 @@
 #include "plugin.h"
 
 #include "solidigm-util.h"
+#include "util/compress.h"
 
 #define DWORD_SIZE 4
 #define LOG_FILE_PERMISSION 0644
@@ -134,6 +135,7 @@ struct config {
 	char *out_dir;
 	char *type;
 	bool verbose;
+	__u8 compress;
 };
 
 struct ilog {
@@ -176,7 +178,8 @@ static void print_nlog_header(__u8 *buffer)
 #define INTERNAL_LOG_MAX_DWORD_TRANSFER (INTERNAL_LOG_MAX_BYTE_TRANSFER / 4)
 
 static int cmd_dump_repeat(struct libnvme_passthru_cmd *cmd, __u32 total_dw_size,
-			   int out_fd, struct libnvme_transport_handle *hdl, bool force_max_transfer)
+			   struct compress_stream *out, struct libnvme_transport_handle *hdl,
+			   bool force_max_transfer)
 {
 	int err = 0;
 
@@ -189,13 +192,13 @@ static int cmd_dump_repeat(struct libnvme_passthru_cmd *cmd, __u32 total_dw_size
 		if (err)
 			return err;
 
-		if (out_fd > 0) {
-			err = write(out_fd, (const void *)(uintptr_t)cmd->addr, cmd->data_len);
+		if (out) {
+			err = compress_write(out, (const void *)(uintptr_t)cmd->addr,
+					     cmd->data_len);
 			if (err < 0) {
-				perror("write failure");
+				fprintf(stderr, "write failure: %s\n", strerror(-err));
 				return err;
 			}
-			err = 0;
 		}
 		total_dw_size -= dword_tfer;
 		cmd->cdw13 += dword_tfer;
@@ -203,17 +206,43 @@ static int cmd_dump_repeat(struct libnvme_passthru_cmd *cmd, __u32 total_dw_size
 	return err;
 }
 
-static int write_header(__u8 *buf, int fd, size_t amnt)
+static int write_header(__u8 *buf, struct compress_stream *out, size_t amnt)
 {
-	if (write(fd, buf, amnt) < 0)
+	if (compress_write(out, buf, amnt) < 0)
 		return 1;
 	return 0;
 }
 
+/* dumps are compressed as they are read if asked to */
+static int ilog_open(struct ilog *ilog, const char *file_path, struct compress_stream **out)
+{
+	int fd;
+
+	fd = open(file_path, O_WRONLY | O_CREAT | O_TRUNC, LOG_FILE_PERMISSION);
+	if (fd < 0)
+		return -errno;
+
+	*out = compress_open(fd, ilog->cfg->compress);
+	if (!*out) {
+		close(fd);
+		return -errno;
+	}
+
+	return fd;
+}
+
+static int ilog_close(struct compress_stream *out, int fd)
+{
+	int err = compress_close(out);
+
+	close(fd);
+	return err;
+}
+
 static int read_header(struct libnvme_passthru_cmd *cmd, struct libnvme_transport_handle *hdl)
 {
 	memset((void *)(uintptr_t)cmd->addr, 0, INTERNAL_LOG_MAX_BYTE_TRANSFER);
-	return cmd_dump_repeat(cmd, INTERNAL_LOG_MAX_DWORD_TRANSFER, -1, hdl, false);
+	return cmd_dump_repeat(cmd, INTERNAL_LOG_MAX_DWORD_TRANSFER, NULL, hdl, false);
 }
 
 static int get_serial_number(char *str, struct libnvme_transport_handle *hdl)
@@ -246,23 +275,25 @@ static int ilog_dump_assert_logs(struct libnvme_transport_handle *hdl, struct il
 		.cdw12 = ASSERTLOG,
 		.cdw13 = 0,
 	};
+	struct compress_stream *out;
 	int output, err;
 
 	err = read_header(&cmd, hdl);
 	if (err)
 		return err;
 
-	if (asprintf(&file_path, "%.*s/%s",
+	if (asprintf(&file_path, "%.*s/%s%s",
 		 (int) (sizeof(file_path) - sizeof(file_name) - 1),
-		 ilog->cfg->out_dir, file_name) < 0)
+		 ilog->cfg->out_dir, file_name,
+		 compress_suffix(ilog->cfg->compress)) < 0)
 		return -errno;
-	output = open(file_path, O_WRONLY | O_CREAT | O_TRUNC, LOG_FILE_PERMISSION);
+	output = ilog_open(ilog, file_path, &out);
 	if (output < 0)
-		return -errno;
-	err = write_header((__u8 *)ad, output, ad->header.header_size * DWORD_SIZE);
+		return output;
+	err = write_header((__u8 *)ad, out, ad->header.header_size * DWORD_SIZE);
 	if (err) {
 		perror("write failure");
-		close(output);
+		ilog_close(out, output);
 		return err;
 	}
 	cmd.addr = (__u64)(void *)buf;
@@ -278,14 +309,16 @@ static int ilog_dump_assert_logs(struct libnvme_transport_handle *hdl, struct il
 		if (!ad->core[i].assertvalid)
 			continue;
 		cmd.cdw13 = ad->core[i].coreoffset;
-		err = cmd_dump_repeat(&cmd, ad->core[i].assertsize, output,
+		err = cmd_dump_repeat(&cmd, ad->core[i].assertsize, out,
 				      hdl, false);
 		if (err) {
-			close(output);
+			ilog_close(out, output);
 			return err;
 		}
 	}
-	close(output);
+	err = ilog_close(out, output);
+	if (err)
+		return err;
 	printf("Successfully wrote Assert to %s\n", file_path);
 	return err;
 }
@@ -303,23 +336,25 @@ static int ilog_dump_event_logs(struct libnvme_transport_handle *hdl, struct ilo
 		.cdw12 = EVENTLOG,
 		.cdw13 = 0,
 	};
+	struct compress_stream *out;
 	int output;
 	int core_num, err;
 
 	err = read_header(&cmd, hdl);
 	if (err)
 		return err;
-	if (asprintf(&file_path, "%s/EventLog.bin", ilog->cfg->out_dir))
+	if (asprintf(&file_path, "%s/EventLog.bin%s", ilog->cfg->out_dir,
+		     compress_suffix(ilog->cfg->compress)) < 0)
 		return -errno;
-	output = open(file_path, O_WRONLY | O_CREAT | O_TRUNC, LOG_FILE_PERMISSION);
+	output = ilog_open(ilog, file_path, &out);
 	if (output < 0)
-		return -errno;
-	err = write_header(head_buf, output, INTERNAL_LOG_MAX_BYTE_TRANSFER);
+		return output;
+	err = write_header(head_buf, out, INTERNAL_LOG_MAX_BYTE_TRANSFER);
 
 	core_num = ehdr->header.numcores;
 
 	if (err) {
-		close(output);
+		ilog_close(out, output);
 		return err;
 	}
 	cmd.addr = (__u64)(void *)buf;
@@ -337,13 +372,15 @@ static int ilog_dump_event_logs(struct libnvme_transport_handle *hdl, struct ilo
 		}
 		cmd.cdw13 = ehdr->edumps[j].coreoffset;
 		err = cmd_dump_repeat(&cmd, ehdr->edumps[j].coresize,
-				output, hdl, false);
+				out, hdl, false);
 		if (err) {
-			close(output);
+			ilog_close(out, output);
 			return err;
 		}
 	}
-	close(output);
+	err = ilog_close(out, output);
+	if (err)
+		return err;
 	printf("Successfully wrote Events to %s\n", file_path);
 	return err;
 }
@@ -387,6 +424,7 @@ static int ilog_dump_nlogs(struct libnvme_transport_handle *hdl, struct ilog *il
 			__u32 raw;
 		};
 	} log_select;
+	struct compress_stream *out;
 	int output;
 	bool is_open = false;
 	size_t header_size = 0;
@@ -400,30 +438,30 @@ static int ilog_dump_nlogs(struct libnvme_transport_handle *hdl, struct ilog *il
 			err = read_header(&cmd, hdl);
 			if (err) {
 				if (is_open)
-					close(output);
+					ilog_close(out, output);
 				return err;
 			}
 			count = nlog_header->totalnlogs;
 			core_num = core < 0 ? nlog_header->corecount : 0;
 			if (!header_size) {
-				if (asprintf(&file_path, "%s/NLog.bin", ilog->cfg->out_dir) >= 0) {
-					output = open(file_path, O_WRONLY | O_CREAT | O_TRUNC,
-							LOG_FILE_PERMISSION);
+				if (asprintf(&file_path, "%s/NLog.bin%s", ilog->cfg->out_dir,
+					     compress_suffix(ilog->cfg->compress)) >= 0) {
+					output = ilog_open(ilog, file_path, &out);
 					if (output < 0)
-						return -errno;
+						return output;
 				} else
 					return -errno;
 				header_size = get_nlog_header_size(nlog_header);
 				is_open = true;
 			}
-			err = write_header(buf, output, header_size);
+			err = write_header(buf, out, header_size);
 			if (err)
 				break;
 			if (ilog->cfg->verbose)
 				print_nlog_header(buf);
 			cmd.cdw13 = 0x400;
 			err = cmd_dump_repeat(&cmd, nlog_header->nlogbytesize / 4,
-				output, hdl, true);
+				out, hdl, true);
 			if (err)
 				break;
 		} while (++log_select.selectNlog < count);
@@ -431,8 +469,12 @@ static int ilog_dump_nlogs(struct libnvme_transport_handle *hdl, struct ilog *il
 			break;
 	} while (++log_select.selectCore < core_num);
 	if (is_open) {
-		close(output);
-		printf("Successfully wrote Nlog to %s\n", file_path);
+		int ret = ilog_close(out, output);
+
+		if (!err)
+			err = ret;
+		if (!err)
+			printf("Successfully wrote Nlog to %s\n", file_path);
 	}
 	return err;
 }
@@ -462,33 +504,28 @@ struct log {
 	__u8 *buffer;
 };
 
-static int log_save(struct log *log, const char *parent_dir_name, const char *subdir_name,
+static int log_save(struct ilog *ilog, struct log *log, const char *subdir_name,
 		    const char *file_name, __u8 *buffer, size_t buf_size)
 {
-	__cleanup_fd int output = -1;
 	__cleanup_free char *file_path = NULL;
-	size_t bytes_remaining = 0;
+	struct compress_stream *out;
+	int output, err;
 
-	ensure_dir(parent_dir_name, subdir_name);
+	ensure_dir(ilog->cfg->out_dir, subdir_name);
 
-	if (asprintf(&file_path, "%s/%s/%s", parent_dir_name, subdir_name, file_name) < 0)
+	if (asprintf(&file_path, "%s/%s/%s%s", ilog->cfg->out_dir, subdir_name, file_name,
+		     compress_suffix(ilog->cfg->compress)) < 0)
 		return -errno;
 
-	output = open(file_path, O_WRONLY | O_CREAT | O_TRUNC, LOG_FILE_PERMISSION);
+	output = ilog_open(ilog, file_path, &out);
 	if (output < 0)
-		return -errno;
-
-	bytes_remaining = buf_size;
+		return output;
 
-	while (bytes_remaining) {
-		ssize_t bytes_written = write(output, buffer, bytes_remaining);
-
-		if (bytes_written < 0)
-			return -errno;
+	compress_write(out, buffer, buf_size);
+	err = ilog_close(out, output);
+	if (err)
+		return err;
 
-		bytes_remaining -= bytes_written;
-		buffer += bytes_written;
-	}
 	printf("Successfully wrote %s to %s\n", log->desc, file_path);
 	return 0;
 }
@@ -510,7 +547,7 @@ static int ilog_dump_identify_page(struct libnvme_transport_handle *hdl,
 		     cns->id, nsid) < 0)
 		return -errno;
 
-	return log_save(cns, ilog->cfg->out_dir, "identify", filename, buff,
+	return log_save(ilog, cns, "identify", filename, buff,
 			sizeof(data));
 }
 
@@ -618,7 +655,7 @@ static int ilog_dump_telemetry(struct libnvme_transport_handle *hdl, struct ilog
 	if (err)
 		return err;
 
-	err = log_save(&log, ilog->cfg->out_dir, "log_pages", file_name, log.buffer,
+	err = log_save(ilog, &log, "log_pages", file_name, log.buffer,
 		       log.buffer_size);
 	return err;
 }
@@ -702,7 +739,7 @@ static int ilog_dump_log_page(struct libnvme_transport_handle *hdl, struct ilog
 	if (asprintf(&filename, "lid_0x%02x_lsp_0x00_lsi_0x0000.bin", lp->id) < 0)
 		return -errno;
 
-	return log_save(lp, ilog->cfg->out_dir, "log_pages", filename, buff, lp->buffer_size);
+	return log_save(ilog, lp, "log_pages", filename, buff, lp->buffer_size);
 }
 
 static int ilog_dump_no_lsp_log_pages(struct libnvme_transport_handle *hdl, struct ilog *ilog)
@@ -821,7 +858,7 @@ static int ilog_dump_pel(struct libnvme_transport_handle *hdl, struct ilog *ilog
 
 	ilog->count++;
 
-	err = log_save(&lp, ilog->cfg->out_dir, "log_pages", "lid_0x0d_lsp_0x00_lsi_0x0000.bin",
+	err = log_save(ilog, &lp, "log_pages", "lid_0x0d_lsp_0x00_lsi_0x0000.bin",
 		       pevent_log_full, lp.buffer_size);
 
 	nvme_get_log_persistent_event(hdl, NVME_PEVENT_LOG_RELEASE_CTX,
@@ -852,15 +889,18 @@ int solidigm_get_internal_log(int argc, char **argv, struct command *acmd,
 	const char *desc = "Get Debug Firmware Logs and save them.";
 	const char *type = "Log type; Defaults to ALL.";
 	const char *out_dir = "Output directory; defaults to current working directory.";
+	const char *compress = "Compress each log as it is read; none, rle, gzip or zstd.";
 
 	struct config cfg = {
 		.out_dir = ".",
 		.type = type_ALL,
+		.compress = COMPRESS_NONE,
 	};
 
 	NVME_ARGS(opts,
 		OPT_STRING("type", 't', "ALL|CIT|HIT|NLOG|ASSERT|EVENT|EXTENDED", &cfg.type, type),
-		OPT_STRING("dir-name", 'd', "DIRECTORY", &cfg.out_dir, out_dir));
+		OPT_STRING("dir-name", 'd', "DIRECTORY", &cfg.out_dir, out_dir),
+		OPT_BYTE("compress", 0, &cfg.compress, compress, compress_vals));
 
 	err = parse_and_open(&ctx, &hdl, argc, argv, desc, opts);
 	if (err)
@@ -106,7 +106,7 @@ static void latency_tracker_bucket_parse(const struct latency_tracker *lt, int i
 		printf("%-*d\n", COL_WIDTH, bucket_data);
 	}
 
-	if (lt->print_flags == JSON) {
+	if (lt->print_flags & JSON) {
 		/*
 		 * Creates a bucket under the "values" json_object. Format is:
 		 * "values" : {
@@ -222,13 +222,13 @@ static void latency_tracker_pre_parse(struct latency_tracker *lt)
 		printf("%-12s%-12s%-12s%-20s\n", "Bucket", "Start", "End", "Value");
 		print_dash_separator();
 	}
-	if (lt->print_flags == JSON)
+	if (lt->print_flags & JSON)
 		lt->bucket_list = json_object_new_array();
 }
 
 static void latency_tracker_post_parse(struct latency_tracker *lt)
 {
-	if (lt->print_flags == JSON) {
+	if (lt->print_flags & JSON) {
 		struct json_object *root = json_create_object();
 
 		latency_tracker_populate_json_root(lt, root);
@@ -406,7 +406,7 @@ int solidigm_get_latency_tracking_log(int argc, char **argv, struct command *acm
 
 	err = latency_tracking_is_enable(&lt, &enabled);
 	if (!err) {
-		if (lt.print_flags == JSON) {
+		if (lt.print_flags & JSON) {
 			struct json_object *root = json_create_object();
 
 			json_object_add_value_int(root, "enabled", enabled);
@@ -246,7 +246,7 @@ int solidigm_get_log_page_directory_log(int argc, char **argv, struct command *a
 
 		if (print_flag == NORMAL) {
 			supported_log_pages_normal(lid_dirs);
-		} else if (print_flag == JSON) {
+		} else if (print_flag & JSON) {
 			supported_log_pages_json(lid_dirs);
 		}
 	}
@@ -5105,7 +5105,7 @@ static int wdc_print_log(struct wdc_ssd_perf_stats *perf, int fmt)
 		fprintf(stderr, "ERROR: WDC: Invalid buffer to read perf stats\n");
 		return -1;
 	}
-	switch (fmt) {
+	switch (nvme_output_format(fmt)) {
 	case NORMAL:
 		wdc_print_log_normal(perf);
 		break;
@@ -6344,7 +6344,7 @@ static int nvme_get_print_ocp_cloud_smart_log(struct libnvme_transport_handle *h
 				       NVME_LOG_CDW14_UUID_SHIFT,
 				       NVME_LOG_CDW14_UUID_MASK);
 	ret = libnvme_get_log(hdl, &cmd, false, NVME_LOG_PAGE_PDU_SIZE);
-	if (fmt == JSON)
+	if (fmt & JSON)
 		nvme_show_status(ret);
 
 	if (!ret) {
@@ -6409,7 +6409,7 @@ static int nvme_get_print_c0_eol_log(struct libnvme_transport_handle *hdl,
 				       NVME_LOG_CDW14_UUID_SHIFT,
 				       NVME_LOG_CDW14_UUID_MASK);
 	ret = libnvme_get_log(hdl, &cmd, false, NVME_LOG_PAGE_PDU_SIZE);
-	if (fmt == JSON)
+	if (fmt & JSON)
 		nvme_show_status(ret);
 
 	if (!ret) {
@@ -7140,7 +7140,7 @@ static int wdc_print_ext_smart_cloud_log(void *data, int fmt)
 		fprintf(stderr, "ERROR: WDC: Invalid buffer to read 0xC0 V1 log\n");
 		return -1;
 	}
-	switch (fmt) {
+	switch (nvme_output_format(fmt)) {
 	case NORMAL:
 		wdc_print_ext_smart_cloud_log_normal(data, WDC_SCA_V1_ALL);
 		break;
@@ -7162,7 +7162,7 @@ static int wdc_print_c0_cloud_attr_log(void *data,
 		return -1;
 	}
 
-	switch (fmt) {
+	switch (nvme_output_format(fmt)) {
 	case BINARY:
 		d_raw((unsigned char *)log, sizeof(struct ocp_cloud_smart_log));
 		break;
@@ -7182,7 +7182,7 @@ static int wdc_print_c0_eol_log(void *data, int fmt)
 		fprintf(stderr, "ERROR: WDC: Invalid buffer to read 0xC0 log\n");
 		return -1;
 	}
-	switch (fmt) {
+	switch (nvme_output_format(fmt)) {
 	case BINARY:
 		d_raw((unsigned char *)data, WDC_NVME_EOL_STATUS_LOG_LEN);
 		break;
@@ -7347,7 +7347,7 @@ static int wdc_print_latency_monitor_log(struct libnvme_transport_handle *hdl,
 		fprintf(stderr, "ERROR: WDC: Invalid C3 log data buffer\n");
 		return -1;
 	}
-	switch (fmt) {
+	switch (nvme_output_format(fmt)) {
 	case NORMAL:
 		wdc_print_latency_monitor_log_normal(hdl, log_data);
 		break;
@@ -7364,7 +7364,7 @@ static int wdc_print_error_rec_log(struct wdc_ocp_c1_error_recovery_log *log_dat
 		fprintf(stderr, "ERROR: WDC: Invalid C1 log data buffer\n");
 		return -1;
 	}
-	switch (fmt) {
+	switch (nvme_output_format(fmt)) {
 	case NORMAL:
 		wdc_print_error_rec_log_normal(log_data);
 		break;
@@ -7381,7 +7381,7 @@ static int wdc_print_dev_cap_log(struct wdc_ocp_C4_dev_cap_log *log_data, int fm
 		fprintf(stderr, "ERROR: WDC: Invalid C4 log data buffer\n");
 		return -1;
 	}
-	switch (fmt) {
+	switch (nvme_output_format(fmt)) {
 	case NORMAL:
 		wdc_print_dev_cap_log_normal(log_data);
 		break;
@@ -7398,7 +7398,7 @@ static int wdc_print_unsupported_reqs_log(struct wdc_ocp_C5_unsupported_reqs *lo
 		fprintf(stderr, "ERROR: WDC: Invalid C5 log data buffer\n");
 		return -1;
 	}
-	switch (fmt) {
+	switch (nvme_output_format(fmt)) {
 	case NORMAL:
 		wdc_print_unsupported_reqs_log_normal(log_data);
 		break;
@@ -7415,7 +7415,7 @@ static int wdc_print_fb_ca_log(struct wdc_ssd_ca_perf_stats *perf, int fmt)
 		fprintf(stderr, "ERROR: WDC: Invalid buffer to read perf stats\n");
 		return -1;
 	}
-	switch (fmt) {
+	switch (nvme_output_format(fmt)) {
 	case NORMAL:
 		wdc_print_fb_ca_log_normal(perf);
 		break;
@@ -7432,7 +7432,7 @@ static int wdc_print_bd_ca_log(struct libnvme_transport_handle *hdl, void *bd_da
 		fprintf(stderr, "ERROR: WDC: Invalid buffer to read data\n");
 		return -1;
 	}
-	switch (fmt) {
+	switch (nvme_output_format(fmt)) {
 	case NORMAL:
 		wdc_print_bd_ca_log_normal(hdl, bd_data);
 		break;
@@ -7452,7 +7452,7 @@ static int wdc_print_d0_log(struct wdc_ssd_d0_smart_log *perf, int fmt)
 		fprintf(stderr, "ERROR: WDC: Invalid buffer to read perf stats\n");
 		return -1;
 	}
-	switch (fmt) {
+	switch (nvme_output_format(fmt)) {
 	case NORMAL:
 		wdc_print_d0_log_normal(perf);
 		break;
@@ -7472,7 +7472,7 @@ static int wdc_print_fw_act_history_log(__u8 *data, int num_entries, int fmt,
 		return -1;
 	}
 
-	switch (fmt) {
+	switch (nvme_output_format(fmt)) {
 	case NORMAL:
 		wdc_print_fw_act_history_log_normal(data, num_entries, cust_id,
 						    vendor_id, device_id);
@@ -8665,7 +8665,7 @@ static int wdc_vs_hw_rev_log(int argc, char **argv, struct command *acmd,
 			ret = -1;
 			goto out;
 		}
-		switch (fmt) {
+		switch (nvme_output_format(fmt)) {
 		case NORMAL:
 			wdc_print_hw_rev_log_normal(data);
 			break;
@@ -8787,7 +8787,7 @@ static int wdc_vs_device_waf(int argc, char **argv, struct command *acmd,
 				(phys_media_units_written_tlc/data_units_written));
 		printf("Device Write Amplification Factor SLC : %4.2Lf\n",
 				(phys_media_units_written_slc/data_units_written));
-	} else if (fmt == JSON) {
+	} else if (fmt & JSON) {
 		root = json_create_object();
 		sprintf(tlc_waf_str, "%4.2Lf", (phys_media_units_written_tlc/data_units_written));
 		sprintf(slc_waf_str, "%4.2Lf", (phys_media_units_written_slc/data_units_written));
@@ -10956,7 +10956,7 @@ static int wdc_log_page_directory(int argc, char **argv, struct command *acmd,
 
 			ret = libnvme_exec_admin_passthru(hdl, &cmd);
 			if (!ret) {
-				switch (fmt) {
+				switch (nvme_output_format(fmt)) {
 				case BINARY:
 					d_raw((unsigned char *)data, 32);
 					break;
@@ -11500,7 +11500,7 @@ static int wdc_do_vs_nand_stats_sn810_2(struct libnvme_transport_handle *hdl, ch
 		}
 
 		/* parse the data */
-		switch (fmt) {
+		switch (nvme_output_format(fmt)) {
 		case NORMAL:
 			wdc_print_ext_smart_cloud_log_normal(data, WDC_SCA_V1_NAND_STATS);
 			break;
@@ -11546,7 +11546,7 @@ static int wdc_do_vs_nand_stats(struct libnvme_transport_handle *hdl, char *form
 		version = output[WDC_NVME_NAND_STATS_SIZE - 2];
 
 		/* parse the data */
-		switch (fmt) {
+		switch (nvme_output_format(fmt)) {
 		case NORMAL:
 			wdc_print_nand_stats_normal(version, output);
 			break;
@@ -11694,7 +11694,7 @@ static int wdc_vs_pcie_stats(int argc, char **argv, struct command *acmd,
 			fprintf(stderr, "ERROR: WDC: Failure reading PCIE statistics, ret = 0x%x\n", ret);
 		} else {
 			/* parse the data */
-			switch (fmt) {
+			switch (nvme_output_format(fmt)) {
 			case NORMAL:
 				wdc_print_pcie_stats_normal(pcieStatsPtr);
 				break;
@@ -11805,7 +11805,7 @@ static int wdc_vs_drive_info(int argc, char **argv,
 					printf("Drive HW Revision: %4.1f\n", (.1 * rev));
 					printf("FTL Unit Size:     0x%x KB\n", size);
 					printf("Customer SN:        %-.*s\n", (int)sizeof(ctrl.sn), &ctrl.sn[0]);
-				} else if (fmt == JSON) {
+				} else if (fmt & JSON) {
 					root = json_create_object();
 					sprintf(rev_str, "%4.1f", (.1 * rev));
 					json_object_add_value_string(root, "Drive HW Revision", rev_str);
@@ -11830,7 +11830,7 @@ static int wdc_vs_drive_info(int argc, char **argv,
 			if (fmt == NORMAL) {
 				printf("Drive HW Revision:   %c.%c\n", major_rev, minor_rev);
 				printf("Customer SN:         %-.*s\n", 14, &ctrl.sn[0]);
-			} else if (fmt == JSON) {
+			} else if (fmt & JSON) {
 				root = json_create_object();
 				sprintf(rev_str, "%c.%c", major_rev, minor_rev);
 				json_object_add_value_string(root, "Drive HW Revison", rev_str);
@@ -11895,7 +11895,7 @@ static int wdc_vs_drive_info(int argc, char **argv,
 				printf("HyperScale Boot Version Spec:        %d.%d\n", boot_spec_major, boot_spec_minor);
 				printf("TCG Device Ownership Status:          %2d\n", tcg_dev_ownership);
 
-			} else if (fmt == JSON) {
+			} else if (fmt & JSON) {
 				root = json_create_object();
 
 				json_object_add_value_int(root, "Drive HW Revison", major_rev);
@@ -11937,7 +11937,7 @@ static int wdc_vs_drive_info(int argc, char **argv,
 					       hw_rev_major, hw_rev_minor);
 					printf("FTL Unit Size : %" PRIu32 "\n",
 					       le32_to_cpu(info.ftl_unit_size));
-				} else if (fmt == JSON) {
+				} else if (fmt & JSON) {
 					char buf[20];
 
 					root = json_create_object();
@@ -12056,7 +12056,7 @@ static int wdc_vs_temperature_stats(int argc, char **argv,
 		printf("TMT2 Transition Counter                 : %"PRIu32"\n", smart_log.thm_temp2_trans_count);
 		printf("TMT2 Total Time                         : %"PRIu32"\n", smart_log.thm_temp2_total_time);
 		printf("Thermal Shutdown Threshold              : 95 °C\n");
-	} else if (fmt == JSON) {
+	} else if (fmt & JSON) {
 		struct json_object *root;
 
 		root = json_create_object();
@@ -0,0 +1,59 @@
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# This file is part of nvme-cli
+#
+"""
+NVMe ndjson Output Testcase:-
+
+    1. Execute list-ctrl and list-ns with --output-format=ndjson.
+    2. Check every line is a JSON document with the content of the json
+       output.
+"""
+
+import json
+
+from nvme_test import TestNVMe
+
+
+class TestNVMeNdjson(TestNVMe):
+
+    """
+    Represents ndjson output testcase
+    """
+
+    def setUp(self):
+        """ Pre Section for TestNVMeNdjson. """
+        super().setUp()
+        self.setup_log_dir(self.__class__.__name__)
+
+    def tearDown(self):
+        """ Post Section for TestNVMeNdjson
+
+            Call super class's destructor.
+        """
+        super().tearDown()
+
+    def check_ndjson(self, cmd):
+        """ Run @cmd with json and ndjson output and compare them.
+            - Args:
+                - cmd : nvme command, without the output format.
+            - Returns:
+                - None
+        """
+        result = self.run_cmd(f"{cmd} --output-format=json")
+        self.assertEqual(result.returncode, 0, f"ERROR : {cmd} failed")
+        expected = json.loads(result.stdout)
+
+        result = self.run_cmd(f"{cmd} --output-format=ndjson")
+        self.assertEqual(result.returncode, 0,
+                         f"ERROR : {cmd} rejected ndjson")
+        lines = [line for line in result.stdout.splitlines() if line]
+        self.assertEqual(len(lines), 1,
+                         f"ERROR : {cmd} printed {len(lines)} lines")
+        self.assertEqual(json.loads(lines[0]), expected,
+                         f"ERROR : {cmd} ndjson differs from json")
+
+    def test_ndjson(self):
+        """ Testcase main """
+        self.check_ndjson(f"{self.nvme_bin} list-ctrl {self.ctrl}")
+        self.check_ndjson(f"{self.nvme_bin} list-ns {self.ctrl}")
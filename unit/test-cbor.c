@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../util/cbor.h"
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof(a[0]))
+
+static int test_rc;
+
+static void check_enc(const char *name, const char *exp, size_t exp_len,
+		      const char *res, size_t len)
+{
+	size_t i;
+
+	if (len == exp_len && !memcmp(res, exp, len))
+		return;
+
+	printf("ERROR: encoding %s, got '", name);
+	for (i = 0; i < len; i++)
+		printf("%02x", (unsigned char)res[i]);
+	printf("', expected '");
+	for (i = 0; i < exp_len; i++)
+		printf("%02x", (unsigned char)exp[i]);
+	printf("'\n");
+
+	test_rc = 1;
+}
+
+#define CHECK(name, exp, expr)					\
+	do {							\
+		char *buf = NULL;				\
+		size_t len = 0;					\
+		FILE *fp = open_memstream(&buf, &len);		\
+								\
+		expr;						\
+		fclose(fp);					\
+		check_enc(name, exp, sizeof(exp) - 1, buf, len);	\
+		free(buf);					\
+	} while (0)
+
+struct uint_test {
+	uint64_t val;
+	const char *exp;
+	size_t len;
+};
+
+/* RFC 8949, Appendix A */
+static struct uint_test uint_tests[] = {
+	{ 0, "\x00", 1 },
+	{ 1, "\x01", 1 },
+	{ 23, "\x17", 1 },
+	{ 24, "\x18\x18", 2 },
+	{ 100, "\x18\x64", 2 },
+	{ 1000, "\x19\x03\xe8", 3 },
+	{ 1000000, "\x1a\x00\x0f\x42\x40", 5 },
+	{ 1000000000000ULL, "\x1b\x00\x00\x00\xe8\xd4\xa5\x10\x00", 9 },
+	{ 18446744073709551615ULL, "\x1b\xff\xff\xff\xff\xff\xff\xff\xff", 9 },
+};
+
+int main(void)
+{
+	uint8_t u128[16] = { 0 };
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(uint_tests); i++) {
+		char *buf = NULL;
+		size_t len = 0;
+		FILE *fp = open_memstream(&buf, &len);
+
+		cbor_put_uint(fp, uint_tests[i].val);
+		fclose(fp);
+		check_enc("uint", uint_tests[i].exp, uint_tests[i].len, buf, len);
+		free(buf);
+	}
+
+	CHECK("-1", "\x20", cbor_put_int(fp, -1));
+	CHECK("-10", "\x29", cbor_put_int(fp, -10));
+	CHECK("-100", "\x38\x63", cbor_put_int(fp, -100));
+	CHECK("-1000", "\x39\x03\xe7", cbor_put_int(fp, -1000));
+	CHECK("\"\"", "\x60", cbor_put_text(fp, ""));
+	CHECK("\"IETF\"", "\x64IETF", cbor_put_text(fp, "IETF"));
+	CHECK("h'01020304'", "\x44\x01\x02\x03\x04", cbor_put_bytes(fp, "\x01\x02\x03\x04", 4));
+	CHECK("false", "\xf4", cbor_put_bool(fp, false));
+	CHECK("true", "\xf5", cbor_put_bool(fp, true));
+	CHECK("null", "\xf6", cbor_put_null(fp));
+	CHECK("padded text", "\x63" "abc", cbor_put_textn(fp, "abc     ", 8));
+	CHECK("[_ 1, [2, 3]]", "\x9f\x01\x9f\x02\x03\xff\xff",
+	      cbor_open_array(fp); cbor_put_uint(fp, 1); cbor_open_array(fp);
+	      cbor_put_uint(fp, 2); cbor_put_uint(fp, 3); cbor_put_break(fp);
+	      cbor_put_break(fp));
+	CHECK("{_ \"a\": 1}", "\xbf\x61" "a" "\x01\xff",
+	      cbor_open_map(fp); cbor_put_text(fp, "a"); cbor_put_uint(fp, 1);
+	      cbor_put_break(fp));
+
+	/* 128 bit values are little endian, as found in log pages */
+	u128[0] = 0xe8;
+	u128[1] = 0x03;
+	CHECK("u128 1000", "\x19\x03\xe8", cbor_put_uint128(fp, u128));
+
+	/* 18446744073709551616 = 2^64 */
+	memset(u128, 0, sizeof(u128));
+	u128[8] = 1;
+	CHECK("u128 2^64", "\xc2\x49\x01\x00\x00\x00\x00\x00\x00\x00\x00",
+	      cbor_put_uint128(fp, u128));
+
+	return test_rc ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,163 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef CONFIG_ZLIB
+#include <zlib.h>
+#endif
+#ifdef CONFIG_ZSTD
+#include <zstd.h>
+#endif
+
+#include "../util/compress.h"
+
+#define DATA_SIZE	(300 * 1024)
+
+static int test_rc;
+
+/* reference decoder of the format described in compress.h */
+static size_t rle_decode(const uint8_t *in, size_t in_len, uint8_t *out,
+			 size_t out_size)
+{
+	size_t i = strlen(COMPRESS_RLE_MAGIC), len = 0;
+	uint64_t n;
+	int shift;
+
+	if (in_len < i || memcmp(in, COMPRESS_RLE_MAGIC, i))
+		return 0;
+
+	while (i < in_len) {
+		n = 0;
+		shift = 0;
+		do {
+			n |= (uint64_t)(in[i] & 0x7f) << shift;
+			shift += 7;
+		} while (in[i++] & 0x80);
+
+		if (len + (n >> 1) > out_size)
+			return 0;
+		if (n & 1) {
+			memset(out + len, in[i++], n >> 1);
+		} else {
+			memcpy(out + len, in + i, n >> 1);
+			i += n >> 1;
+		}
+		len += n >> 1;
+	}
+
+	return len;
+}
+
+static size_t decode(enum compress_type type, const uint8_t *in, size_t in_len,
+		     uint8_t *out, size_t out_size)
+{
+	switch (type) {
+	case COMPRESS_RLE:
+		return rle_decode(in, in_len, out, out_size);
+#ifdef CONFIG_ZLIB
+	case COMPRESS_GZIP: {
+		z_stream z = {
+			.next_in = (uint8_t *)in,
+			.avail_in = in_len,
+			.next_out = out,
+			.avail_out = out_size,
+		};
+		int ret;
+
+		if (inflateInit2(&z, 15 + 16) != Z_OK)
+			return 0;
+		ret = inflate(&z, Z_FINISH);
+		inflateEnd(&z);
+		return ret == Z_STREAM_END ? z.total_out : 0;
+	}
+#endif
+#ifdef CONFIG_ZSTD
+	case COMPRESS_ZSTD: {
+		size_t ret = ZSTD_decompress(out, out_size, in, in_len);
+
+		return ZSTD_isError(ret) ? 0 : ret;
+	}
+#endif
+	default:
+		memcpy(out, in, in_len);
+		return in_len;
+	}
+}
+
+static void check_roundtrip(enum compress_type type, const uint8_t *data,
+			    size_t chunk)
+{
+	static uint8_t in[2 * DATA_SIZE], out[DATA_SIZE];
+	struct compress_stream *cs;
+	size_t off, n, len;
+	FILE *f;
+
+	f = tmpfile();
+	if (!f) {
+		perror("tmpfile");
+		test_rc = 1;
+		return;
+	}
+
+	cs = compress_open(fileno(f), type);
+	if (!cs) {
+		printf("ERROR: type %d: open failed\n", type);
+		test_rc = 1;
+		goto close;
+	}
+
+	for (off = 0; off < DATA_SIZE; off += n) {
+		n = DATA_SIZE - off < chunk ? DATA_SIZE - off : chunk;
+		if (compress_write(cs, data + off, n)) {
+			printf("ERROR: type %d: write failed\n", type);
+			test_rc = 1;
+		}
+	}
+	if (compress_close(cs)) {
+		printf("ERROR: type %d: close failed\n", type);
+		test_rc = 1;
+	}
+
+	rewind(f);
+	len = fread(in, 1, sizeof(in), f);
+	if (type != COMPRESS_NONE && len >= DATA_SIZE / 4) {
+		printf("ERROR: type %d: %zu bytes not compressed (%zu)\n",
+		       type, (size_t)DATA_SIZE, len);
+		test_rc = 1;
+	}
+
+	if (decode(type, in, len, out, sizeof(out)) != DATA_SIZE ||
+	    memcmp(out, data, DATA_SIZE)) {
+		printf("ERROR: type %d chunk %zu: data differs\n", type, chunk);
+		test_rc = 1;
+	}
+
+close:
+	fclose(f);
+}
+
+int main(void)
+{
+	static const size_t chunks[] = { 1, 7, 512, 4096, 65536, DATA_SIZE };
+	static uint8_t data[DATA_SIZE];
+	struct argconfig_opt_val *v;
+	size_t i, j;
+
+	/* a dump: zeroes, a repeated pattern, short runs and some noise */
+	srand(1);
+	for (i = 64 * 1024; i < 128 * 1024; i++)
+		data[i] = i % 16 < 4 ? 0xa5 : 0x5a;
+	for (i = 128 * 1024; i < 136 * 1024; i++)
+		data[i] = rand() % 4 ? rand() : data[i - 1];
+	for (i = 200 * 1024; i < DATA_SIZE; i += 1000)
+		data[i] = i;
+
+	for (v = compress_vals; v->str; v++)
+		for (j = 0; j < sizeof(chunks) / sizeof(chunks[0]); j++)
+			check_roundtrip(v->val.byte, data, chunks[j]);
+
+	return test_rc ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,119 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../util/histogram.h"
+
+static int test_rc;
+
+static void check_buckets(void)
+{
+	uint64_t val, hi;
+	unsigned int idx;
+	int bit;
+
+	for (bit = 0; bit < HIST_MAX_BITS; bit++) {
+		for (val = (1ULL << bit) - 1; val <= (1ULL << bit) + 1; val++) {
+			idx = hist_index(val);
+			hi = hist_value(idx);
+
+			if (idx >= HIST_NR_BUCKETS ||
+			    (val && idx < hist_index(val - 1))) {
+				printf("ERROR: value %llu, bad index %u\n",
+				       (unsigned long long)val, idx);
+				test_rc = 1;
+			}
+			if (hi < val || (hi - val) * (HIST_SUB_COUNT / 2) > val) {
+				printf("ERROR: value %llu, bucket %u ends at %llu\n",
+				       (unsigned long long)val, idx,
+				       (unsigned long long)hi);
+				test_rc = 1;
+			}
+			if (idx && hist_value(idx - 1) >= val) {
+				printf("ERROR: value %llu, bucket %u overlaps\n",
+				       (unsigned long long)val, idx);
+				test_rc = 1;
+			}
+		}
+	}
+
+	idx = hist_index(~0ULL);
+	if (idx != HIST_NR_BUCKETS - 1) {
+		printf("ERROR: clamped index %u, expected %u\n", idx,
+		       HIST_NR_BUCKETS - 1);
+		test_rc = 1;
+	}
+}
+
+static void check_pct(const struct histogram *h, double pct, uint64_t exp)
+{
+	uint64_t res = hist_percentile(h, pct);
+	uint64_t diff = res > exp ? res - exp : exp - res;
+
+	if (diff * (HIST_SUB_COUNT / 2) <= exp)
+		return;
+
+	printf("ERROR: p%g is %llu, expected ~%llu\n", pct,
+	       (unsigned long long)res, (unsigned long long)exp);
+	test_rc = 1;
+}
+
+static void check_percentiles(void)
+{
+	struct histogram *a = malloc(sizeof(*a));
+	struct histogram *b = malloc(sizeof(*b));
+	uint64_t val;
+
+	if (!a || !b) {
+		test_rc = 1;
+		goto out;
+	}
+
+	hist_init(a);
+	hist_init(b);
+
+	/* 1..100000, every other value in each half */
+	for (val = 1; val <= 100000; val++)
+		hist_record(val & 1 ? a : b, val);
+	hist_merge(a, b);
+
+	if (a->total != 100000 || a->min != 1 || a->max != 100000) {
+		printf("ERROR: total %llu min %llu max %llu\n",
+		       (unsigned long long)a->total,
+		       (unsigned long long)a->min,
+		       (unsigned long long)a->max);
+		test_rc = 1;
+	}
+	if (hist_mean(a) < 50000 || hist_mean(a) > 50001) {
+		printf("ERROR: mean %f\n", hist_mean(a));
+		test_rc = 1;
+	}
+
+	check_pct(a, 0, 1);
+	check_pct(a, 50, 50000);
+	check_pct(a, 90, 90000);
+	check_pct(a, 99, 99000);
+	check_pct(a, 99.9, 99900);
+	check_pct(a, 100, 100000);
+
+	/* a single outlier only shows up in the tail */
+	hist_init(b);
+	for (val = 0; val < 999; val++)
+		hist_record(b, 100);
+	hist_record(b, 1000000);
+	check_pct(b, 99.9, 100);
+	check_pct(b, 99.99, 1000000);
+
+out:
+	free(a);
+	free(b);
+}
+
+int main(void)
+{
+	check_buckets();
+	check_percentiles();
+
+	return test_rc ? EXIT_FAILURE : EXIT_SUCCESS;
+}
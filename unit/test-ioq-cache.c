@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libnvme.h>
+
+#include "../nvme-ioq.h"
+
+#include "mock.h"
+#include "util.h"
+
+#define DEPTH	8
+#define NR_CMDS	64
+
+static char sysfs_dir[] = "/tmp/test-ioq-cache-sysfs-XXXXXX";
+static char cache_dir[] = "/tmp/test-ioq-cache-XXXXXX";
+static struct nvme_id_ctrl expected_id;
+
+static void write_attr(const char *dir, const char *attr, const char *val)
+{
+	char path[PATH_MAX];
+	FILE *f;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, attr);
+	f = fopen(path, "w");
+	check(f, "failed to create %s: %m", path);
+	fprintf(f, "%s\n", val);
+	fclose(f);
+}
+
+/* what the kernel shows in /sys/class/nvme/<ctrl> */
+static void make_sysfs(void)
+{
+	char path[PATH_MAX];
+
+	check(mkdtemp(sysfs_dir), "mkdtemp failed: %m");
+	snprintf(path, sizeof(path), "mkdir -p %s/sys/class/nvme/NVME_TEST_FD",
+		 sysfs_dir);
+	check(!system(path), "failed to create the sysfs directory");
+	snprintf(path, sizeof(path), "%s/sys/class/nvme/NVME_TEST_FD",
+		 sysfs_dir);
+
+	write_attr(path, "serial", "SN-1234");
+	write_attr(path, "cntlid", "1");
+	write_attr(path, "firmware_rev", "1.0");
+
+	check(!setenv("LIBNVME_SYSFS_PATH", sysfs_dir, 1), "setenv failed");
+}
+
+static void fill_cache(struct libnvme_global_ctx *ctx)
+{
+	struct mock_cmd mock_admin_cmd = {
+		.opcode = nvme_admin_identify,
+		.data_len = sizeof(expected_id),
+		.cdw10 = NVME_IDENTIFY_CNS_CTRL,
+		.out_data = &expected_id,
+	};
+	struct libnvme_transport_handle *hdl;
+	struct libnvme_passthru_cmd cmd;
+	struct nvme_id_ctrl id;
+	int err;
+
+	check(!libnvme_open(ctx, "NVME_TEST_FD", &hdl),
+	      "opening test link failed");
+
+	arbitrary(&expected_id, sizeof(expected_id));
+	set_mock_admin_cmds(&mock_admin_cmd, 1);
+	nvme_init_identify_ctrl(&cmd, &id);
+	err = libnvme_exec_admin_passthru(hdl, &cmd);
+	end_mock_cmds();
+	check(err == 0, "identify returned error %d", err);
+
+	libnvme_close(hdl);
+}
+
+/*
+ * The workers of a queue share the handle and look up the cache at the
+ * same time, first thing after it was opened.
+ */
+static void test_ioq(struct libnvme_global_ctx *ctx)
+{
+	struct libnvme_transport_handle *hdl;
+	struct nvme_ioq_req *req;
+	struct nvme_ioq *q;
+	int i, err;
+
+	fill_cache(ctx);
+
+	check(!libnvme_open(ctx, "NVME_TEST_FD", &hdl),
+	      "opening test link failed");
+	err = nvme_ioq_open(hdl, DEPTH, sizeof(expected_id), 0, &q);
+	check(err == 0, "opening the queue returned error %d", err);
+
+	/* nothing reaches the device */
+	set_mock_admin_cmds(NULL, 0);
+	for (i = 0; i < NR_CMDS; i++) {
+		req = nvme_ioq_next(q);
+		if (req->state == NVME_IOQ_DONE) {
+			check(req->err == 0, "identify returned error %d",
+			      req->err);
+			cmp(req->buf, &expected_id, sizeof(expected_id),
+			    "incorrect cached identify data");
+		}
+		memset(req->buf, 0, sizeof(expected_id));
+		nvme_init_identify_ctrl(&req->cmd, req->buf);
+		req->admin = true;
+		nvme_ioq_submit(q, req);
+	}
+	while ((req = nvme_ioq_reap(q))) {
+		check(req->err == 0, "identify returned error %d", req->err);
+		cmp(req->buf, &expected_id, sizeof(expected_id),
+		    "incorrect cached identify data");
+	}
+	end_mock_cmds();
+
+	nvme_ioq_close(q);
+	libnvme_close(hdl);
+}
+
+int main(void)
+{
+	struct libnvme_global_ctx *ctx;
+	char cmd[2 * PATH_MAX];
+
+	/* before libnvme looks up the sysfs directories */
+	make_sysfs();
+	check(mkdtemp(cache_dir), "mkdtemp failed: %m");
+	check(!setenv("LIBNVME_CACHE_DIR", cache_dir, 1), "setenv failed");
+
+	ctx = libnvme_create_global_ctx(stdout, LIBNVME_DEFAULT_LOGLEVEL);
+	set_mock_fd(LIBNVME_TEST_FD);
+
+	printf("Running test ioq...");
+	fflush(stdout);
+	test_ioq(ctx);
+	puts(" OK");
+
+	libnvme_free_global_ctx(ctx);
+
+	snprintf(cmd, sizeof(cmd), "rm -rf %s %s", sysfs_dir, cache_dir);
+	check(!system(cmd), "failed to remove %s and %s", sysfs_dir,
+	      cache_dir);
+}
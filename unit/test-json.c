@@ -0,0 +1,142 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../util/json.h"
+
+static int test_rc;
+
+static void check_str(const char *name, const char *exp, const char *res)
+{
+	if (!strcmp(exp, res))
+		return;
+
+	printf("ERROR: %s, got:\n%s\nexpected:\n%s\n", name, res, exp);
+	test_rc = 1;
+}
+
+/*
+ * Builds the same document either as a plain or as a stream object, with
+ * members added to objects after they were attached and after the stream
+ * array, and returns what is printed.
+ */
+static char *build(bool stream, bool flush, int nr)
+{
+	struct json_object *r, *hdr, *records, *e, *sub;
+	char *buf = NULL;
+	size_t len = 0;
+	FILE *fp;
+	int i;
+
+	fp = open_memstream(&buf, &len);
+	if (!fp)
+		return NULL;
+
+	if (stream)
+		r = json_create_stream_object(fp);
+	else
+		r = json_create_object();
+
+	json_object_add_value_uint(r, "nr", nr);
+	hdr = json_create_object();
+	json_object_add_value_object(r, "hdr", hdr);
+	json_object_add_value_string(hdr, "name", "after attach");
+	records = json_stream_add_array(r, "records");
+	json_object_add_value_int(r, "after", 1);
+	json_object_add_value_object(r, "empty", json_create_object());
+
+	for (i = 0; i < nr; i++) {
+		e = json_create_object();
+		json_array_add_value_object(records, e);
+		json_object_add_value_int(e, "index", i);
+		sub = json_create_array();
+		json_object_add_value_array(e, "sub", sub);
+		if (i % 2)
+			json_array_add_value_string(sub, "odd");
+		if (flush)
+			json_stream_flush(records);
+	}
+
+	if (stream)
+		util_json_print_object(r);
+	else
+		fputs(json_object_to_json_string_ext(r,
+			JSON_C_TO_STRING_PRETTY | JSON_C_TO_STRING_NOSLASHESCAPE), fp);
+	json_free_object(r);
+	fclose(fp);
+
+	return buf;
+}
+
+static void check_stream(int nr)
+{
+	char *exp = build(false, false, nr);
+	char *res;
+
+	res = build(true, false, nr);
+	check_str("stream", exp, res);
+	free(res);
+
+	res = build(true, true, nr);
+	check_str("stream flushed", exp, res);
+	free(res);
+
+	free(exp);
+}
+
+static void check_empty(void)
+{
+	char *buf = NULL;
+	size_t len = 0;
+	struct json_object *r;
+	FILE *fp;
+
+	fp = open_memstream(&buf, &len);
+	r = json_create_stream_object(fp);
+	util_json_print_object(r);
+	json_free_object(r);
+	fclose(fp);
+
+	check_str("empty stream", "{}", buf);
+	free(buf);
+}
+
+static void check_ndjson(void)
+{
+	struct json_object *r, *records, *e;
+	char *buf = NULL;
+	size_t len = 0;
+	FILE *fp;
+	int i;
+
+	fp = open_memstream(&buf, &len);
+	r = json_create_object();
+	records = json_create_ndjson_array(fp);
+	json_object_add_value_array(r, "records", records);
+
+	for (i = 0; i < 2; i++) {
+		e = json_create_object();
+		json_array_add_value_object(records, e);
+		json_object_add_value_int(e, "index", i);
+		json_stream_flush(records);
+	}
+
+	json_free_object(r);
+	fclose(fp);
+
+	check_str("ndjson", "{\"index\":0}\n{\"index\":1}\n", buf);
+	free(buf);
+}
+
+int main(void)
+{
+	check_stream(0);
+	check_stream(1);
+	check_stream(4);
+	check_empty();
+	check_ndjson();
+
+	return test_rc ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,178 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <errno.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <libnvme.h>
+
+#include "../nvme-log-seg.h"
+
+#include "mock.h"
+#include "util.h"
+
+#define XFER		4096
+#define NR_WIN		3
+#define LPO		0x10000
+
+volatile sig_atomic_t nvme_sigint_received;
+
+/* nvme-print is not linked in */
+void nvme_show_message(bool error, const char *msg, ...)
+{
+	va_list ap;
+
+	va_start(ap, msg);
+	vfprintf(stderr, msg, ap);
+	va_end(ap);
+	fputc('\n', stderr);
+}
+
+void nvme_show_perror(const char *msg, ...)
+{
+	perror(msg);
+}
+
+void nvme_show_err(int err, const char *fmt, ...)
+{
+	fprintf(stderr, "%s: %d\n", fmt, err);
+}
+
+static struct libnvme_transport_handle *test_hdl;
+static char dir[] = "/tmp/test-log-seg-XXXXXX";
+static __u8 log_page[NR_WIN * XFER];
+
+static struct mock_cmd window(__u32 win, bool rae)
+{
+	__u32 len = rae ? XFER : 4;
+	__u64 lpo = LPO + (__u64)win * XFER;
+
+	return (struct mock_cmd) {
+		.opcode = nvme_admin_get_log_page,
+		.nsid = NVME_NSID_ALL,
+		.data_len = len,
+		.cdw10 = (len / 4 - 1) << 16 /* NUMDL */
+		       | rae << 15 /* RAE */
+		       | NVME_LOG_LID_TELEMETRY_CTRL,
+		.cdw12 = lpo & 0xffffffff,
+		.cdw13 = lpo >> 32,
+		.out_data = log_page + win * XFER,
+	};
+}
+
+static void read_log(const char *file, bool rae, int expected_err)
+{
+	struct nvme_log_seg s = {
+		.nsid	= NVME_NSID_ALL,
+		.lid	= NVME_LOG_LID_TELEMETRY_CTRL,
+		.rae	= rae,
+		.lpo	= LPO,
+		.len	= sizeof(log_page),
+		.xfer	= XFER,
+		.depth	= 1,
+		.file	= file,
+	};
+	int err;
+
+	err = nvme_get_log_segmented(test_hdl, &s);
+	end_mock_cmds();
+	check(err == expected_err, "got error %d, expected %d", err,
+	      expected_err);
+}
+
+static void check_file(const char *file)
+{
+	static __u8 buf[sizeof(log_page)];
+	FILE *f;
+
+	f = fopen(file, "r");
+	check(f, "failed to open %s: %m", file);
+	check(fread(buf, 1, sizeof(buf), f) == sizeof(buf), "short file");
+	fclose(f);
+	cmp(buf, log_page, sizeof(buf), "incorrect log data");
+}
+
+static void test_rae(void)
+{
+	char file[sizeof(dir) + 16];
+	struct mock_cmd mock_admin_cmds[] = {
+		window(0, true),
+		window(1, true),
+		window(2, true),
+		/* only once the whole log is read */
+		window(0, false),
+	};
+
+	snprintf(file, sizeof(file), "%s/rae", dir);
+	arbitrary(log_page, sizeof(log_page));
+	set_mock_admin_cmds(mock_admin_cmds, NR_WIN + 1);
+	read_log(file, false, 0);
+	check_file(file);
+
+	/* --rae keeps the event */
+	set_mock_admin_cmds(mock_admin_cmds, NR_WIN);
+	read_log(file, true, 0);
+	check_file(file);
+}
+
+static void test_resume(void)
+{
+	char file[sizeof(dir) + 16];
+	struct mock_cmd mock_admin_cmds[] = {
+		window(0, true),
+		window(1, true),
+		window(2, true),
+	};
+	struct mock_cmd mock_resume_cmds[] = {
+		window(1, true),
+		window(0, false),
+	};
+
+	snprintf(file, sizeof(file), "%s/resume", dir);
+	arbitrary(log_page, sizeof(log_page));
+	mock_admin_cmds[1].err = NVME_SC_INTERNAL;
+	set_mock_admin_cmds(mock_admin_cmds, NR_WIN);
+	read_log(file, false, NVME_SC_INTERNAL);
+
+	/* the windows read again still retain the event */
+	set_mock_admin_cmds(mock_resume_cmds, 2);
+	read_log(file, false, 0);
+	check_file(file);
+}
+
+static void run_test(const char *test_name, void (*test_fn)(void))
+{
+	printf("Running test %s...", test_name);
+	fflush(stdout);
+	test_fn();
+	puts(" OK");
+}
+
+#define RUN_TEST(name) run_test(#name, test_ ## name)
+
+int main(void)
+{
+	struct libnvme_global_ctx *ctx;
+	char cmd[sizeof(dir) + 16];
+
+	check(mkdtemp(dir), "mkdtemp failed: %m");
+	ctx = libnvme_create_global_ctx(stdout, LIBNVME_DEFAULT_LOGLEVEL);
+
+	set_mock_fd(LIBNVME_TEST_FD);
+	check(!libnvme_open(ctx, "NVME_TEST_FD", &test_hdl),
+	      "opening test link failed");
+
+	RUN_TEST(rae);
+	RUN_TEST(resume);
+
+	libnvme_close(test_hdl);
+	libnvme_free_global_ctx(ctx);
+
+	snprintf(cmd, sizeof(cmd), "rm -rf %s", dir);
+	check(!system(cmd), "failed to remove %s", dir);
+}
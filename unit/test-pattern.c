@@ -0,0 +1,197 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../util/pattern.h"
+
+#define LBS	512
+#define NLB	16
+
+static int test_rc;
+
+static void check_roundtrip(const char *name, struct pattern *p)
+{
+	static uint8_t buf[LBS * NLB];
+	struct pattern_miscompare m;
+	size_t off;
+
+	pattern_fill(p, buf, 1000, NLB);
+	if (!pattern_check(p, buf, 1000, NLB, &m)) {
+		printf("ERROR: %s: miscompare on clean data at %zu\n", name,
+		       m.offset);
+		test_rc = 1;
+	}
+
+	/* a block checked against the wrong LBA */
+	if (p->type != PATTERN_ZERO && p->type != PATTERN_USER &&
+	    pattern_check(p, buf, 1001, NLB, &m)) {
+		printf("ERROR: %s: shifted LBA not detected\n", name);
+		test_rc = 1;
+	}
+
+	for (off = 0; off < sizeof(buf); off += 997) {
+		buf[off] ^= 0x10;
+		if (pattern_check(p, buf, 1000, NLB, &m) ||
+		    m.offset != (off & ~7UL) || m.expected == m.actual) {
+			printf("ERROR: %s: corruption at %zu reported at %zu\n",
+			       name, off, m.offset);
+			test_rc = 1;
+		}
+		buf[off] ^= 0x10;
+	}
+}
+
+static void check_random(void)
+{
+	static uint8_t a[LBS], b[LBS];
+	struct pattern p;
+
+	pattern_init(&p, PATTERN_RANDOM, 1, NULL, 0, LBS);
+	pattern_fill(&p, a, 7, 1);
+	pattern_fill(&p, b, 7, 1);
+	if (memcmp(a, b, LBS)) {
+		printf("ERROR: random pattern not reproducible\n");
+		test_rc = 1;
+	}
+	pattern_fill(&p, b, 8, 1);
+	if (!memcmp(a, b, LBS)) {
+		printf("ERROR: random pattern does not depend on the LBA\n");
+		test_rc = 1;
+	}
+	p.seed = 2;
+	pattern_fill(&p, b, 7, 1);
+	if (!memcmp(a, b, LBS)) {
+		printf("ERROR: random pattern does not depend on the seed\n");
+		test_rc = 1;
+	}
+	pattern_free(&p);
+}
+
+static void check_lba_tag(void)
+{
+	static uint8_t buf[LBS * 2];
+	struct pattern_miscompare m;
+	struct pattern p;
+
+	pattern_init(&p, PATTERN_LBA, 0x1234, NULL, 0, LBS);
+	pattern_fill(&p, buf, 5, 2);
+	if (buf[0] != 5 || buf[8] != 0x34 || buf[9] != 0x12) {
+		printf("ERROR: lba pattern layout\n");
+		test_rc = 1;
+	}
+
+	p.seed = 0x4321;
+	if (pattern_check(&p, buf, 5, 2, &m) || m.offset != 8 ||
+	    m.expected != 0x4321 || m.actual != 0x1234) {
+		printf("ERROR: wrong tag not detected\n");
+		test_rc = 1;
+	}
+
+	p.any_tag = true;
+	if (!pattern_check(&p, buf, 5, 2, &m)) {
+		printf("ERROR: any tag rejected at %zu\n", m.offset);
+		test_rc = 1;
+	}
+
+	/* any tag still has to be the same for the whole block */
+	buf[LBS + 200] ^= 1;
+	if (pattern_check(&p, buf, 5, 2, &m) || m.offset != LBS + 200) {
+		printf("ERROR: inconsistent tag reported at %zu\n", m.offset);
+		test_rc = 1;
+	}
+	pattern_free(&p);
+}
+
+/* extended LBAs: the metadata after each block is not part of the pattern */
+static void check_stride(void)
+{
+	static uint8_t buf[(LBS + 8) * 2];
+	struct pattern_miscompare m;
+	struct pattern p;
+
+	memset(buf, 0xa5, sizeof(buf));
+	pattern_init(&p, PATTERN_RANDOM, 3, NULL, 0, LBS);
+	p.stride = LBS + 8;
+	pattern_fill(&p, buf, 9, 2);
+	if (buf[LBS] != 0xa5 || buf[2 * LBS + 15] != 0xa5) {
+		printf("ERROR: pattern written over the metadata\n");
+		test_rc = 1;
+	}
+
+	buf[LBS + 3] ^= 1;
+	if (!pattern_check(&p, buf, 9, 2, &m)) {
+		printf("ERROR: metadata checked at %zu\n", m.offset);
+		test_rc = 1;
+	}
+
+	buf[LBS + 8 + 100] ^= 1;
+	if (pattern_check(&p, buf, 9, 2, &m) || m.offset != LBS + 8 + 96) {
+		printf("ERROR: corruption of the second block reported at %zu\n",
+		       m.offset);
+		test_rc = 1;
+	}
+	pattern_free(&p);
+}
+
+static void check_hex(void)
+{
+	uint8_t buf[PATTERN_MAX_USER];
+	char str[2 * PATTERN_MAX_USER + 3];
+	size_t len;
+
+	if (pattern_parse_hex("0xdeADbeef", buf, &len) || len != 4 ||
+	    buf[0] != 0xde || buf[3] != 0xef) {
+		printf("ERROR: failed to parse hex pattern\n");
+		test_rc = 1;
+	}
+	if (!pattern_parse_hex("abc", buf, &len) ||
+	    !pattern_parse_hex("0x", buf, &len) ||
+	    !pattern_parse_hex("zz", buf, &len)) {
+		printf("ERROR: invalid hex pattern accepted\n");
+		test_rc = 1;
+	}
+
+	memset(str, 'a', sizeof(str) - 1);
+	str[sizeof(str) - 1] = '\0';
+	if (!pattern_parse_hex(str + 1, buf, &len)) {
+		printf("ERROR: oversized hex pattern accepted\n");
+		test_rc = 1;
+	}
+}
+
+int main(void)
+{
+	const uint8_t user[] = { 0xde, 0xad, 0xbe, 0xef, 0x55 };
+	struct pattern p;
+
+	pattern_init(&p, PATTERN_ZERO, 0, NULL, 0, LBS);
+	check_roundtrip("zero", &p);
+	pattern_free(&p);
+
+	pattern_init(&p, PATTERN_RANDOM, 42, NULL, 0, LBS);
+	check_roundtrip("random", &p);
+	pattern_free(&p);
+
+	pattern_init(&p, PATTERN_LBA, 1700000000, NULL, 0, LBS);
+	check_roundtrip("lba", &p);
+	pattern_free(&p);
+
+	pattern_init(&p, PATTERN_USER, 0, user, sizeof(user), LBS);
+	check_roundtrip("user", &p);
+	pattern_free(&p);
+
+	if (pattern_init(&p, PATTERN_USER, 0, user, 0, LBS) != -22 ||
+	    pattern_init(&p, PATTERN_ZERO, 0, NULL, 0, 520) != -22) {
+		printf("ERROR: invalid pattern parameters accepted\n");
+		test_rc = 1;
+	}
+
+	check_random();
+	check_lba_tag();
+	check_stride();
+	check_hex();
+
+	return test_rc ? EXIT_FAILURE : EXIT_SUCCESS;
+}
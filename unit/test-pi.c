@@ -0,0 +1,248 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../util/pi.h"
+
+#define LBS	512
+#define NLB	8
+#define MAX_MS	64
+
+static int test_rc;
+
+/* bit at a time references for the table driven CRCs */
+static uint16_t ref_crc16(const uint8_t *p, size_t len)
+{
+	uint16_t crc = 0;
+	int i;
+
+	while (len--) {
+		crc ^= *p++ << 8;
+		for (i = 0; i < 8; i++)
+			crc = crc & 0x8000 ? (crc << 1) ^ 0x8bb7 : crc << 1;
+	}
+	return crc;
+}
+
+static uint32_t ref_crc32c(const uint8_t *p, size_t len)
+{
+	uint32_t crc = ~0U;
+	int i;
+
+	while (len--) {
+		crc ^= *p++;
+		for (i = 0; i < 8; i++)
+			crc = crc & 1 ? (crc >> 1) ^ 0x82f63b78 : crc >> 1;
+	}
+	return ~crc;
+}
+
+static uint64_t ref_crc64(const uint8_t *p, size_t len)
+{
+	uint64_t crc = ~0ULL;
+	int i;
+
+	while (len--) {
+		crc ^= *p++;
+		for (i = 0; i < 8; i++)
+			crc = crc & 1 ? (crc >> 1) ^ 0x9a6c9329ac4bc9b5ULL : crc >> 1;
+	}
+	return ~crc;
+}
+
+static void check_crc(void)
+{
+	static const char check[] = "123456789";
+	static uint8_t buf[4096];
+	size_t len, split;
+
+	if (crc16_t10dif(0, check, 9) != 0xd0db ||
+	    crc32c(0, check, 9) != 0xe3069283 ||
+	    crc64_nvme(0, check, 9) != 0xae8b14860a799888ULL) {
+		printf("ERROR: wrong CRC check values\n");
+		test_rc = 1;
+	}
+
+	/* guard of 4 KiB of ones, NVM Command Set specification examples */
+	memset(buf, 0xff, sizeof(buf));
+	if (crc32c(0, buf, sizeof(buf)) != 0x25c1fe13 ||
+	    crc64_nvme(0, buf, sizeof(buf)) != 0xc0ddba7302eca3acULL) {
+		printf("ERROR: wrong CRC of 4 KiB of ones\n");
+		test_rc = 1;
+	}
+
+	srand(1);
+	for (len = 0; len < sizeof(buf); len++)
+		buf[len] = rand();
+
+	for (len = 0; len < 80; len++) {
+		split = len / 3;
+		if (crc16_t10dif(0, buf + 1, len) != ref_crc16(buf + 1, len) ||
+		    crc32c(0, buf + 1, len) != ref_crc32c(buf + 1, len) ||
+		    crc64_nvme(0, buf + 1, len) != ref_crc64(buf + 1, len)) {
+			printf("ERROR: CRC mismatch for %zu bytes\n", len);
+			test_rc = 1;
+		}
+		if (crc16_t10dif(crc16_t10dif(0, buf, split), buf + split, len - split) !=
+		    ref_crc16(buf, len) ||
+		    crc32c(crc32c(0, buf, split), buf + split, len - split) !=
+		    ref_crc32c(buf, len) ||
+		    crc64_nvme(crc64_nvme(0, buf, split), buf + split, len - split) !=
+		    ref_crc64(buf, len)) {
+			printf("ERROR: chained CRC mismatch for %zu bytes\n", len);
+			test_rc = 1;
+		}
+	}
+}
+
+static void expect_error(const char *name, struct pi *pi, uint8_t *data,
+			 uint8_t *meta, uint64_t ref, enum pi_field field,
+			 uint64_t block)
+{
+	struct pi_error e;
+
+	if (pi_verify(pi, data, meta, ref, NLB, &e) || e.field != field ||
+	    e.block != block || e.expected == e.actual) {
+		printf("ERROR: %s: %s error in block %d not detected\n", name,
+		       pi_field_name(field), (int)block);
+		test_rc = 1;
+	}
+}
+
+static void check_roundtrip(enum pi_format format, int type, int sts,
+			    bool first, size_t ms, bool ext)
+{
+	static uint8_t data[(LBS + MAX_MS) * NLB], mbuf[MAX_MS * NLB];
+	uint8_t *meta = ext ? NULL : mbuf;
+	size_t stride = ext ? LBS + ms : LBS;
+	char name[64];
+	struct pi_error e;
+	uint8_t *tags;
+	struct pi pi;
+	size_t i;
+
+	snprintf(name, sizeof(name), "format %d type %d sts %d ms %zu%s%s",
+		 format, type, sts, ms, first ? " first" : "",
+		 ext ? " extended" : "");
+
+	if (pi_init(&pi, format, type, sts, first, LBS, ms, ext)) {
+		printf("ERROR: %s: rejected\n", name);
+		test_rc = 1;
+		return;
+	}
+	pi.app_tag = 0x1234;
+	pi.storage_tag = 0x5a5a5a5a5a5aULL & ((1ULL << sts) - 1);
+	pi.check_storage = sts > 0;
+
+	for (i = 0; i < sizeof(data); i++)
+		data[i] = rand();
+	for (i = 0; i < sizeof(mbuf); i++)
+		mbuf[i] = rand();
+
+	pi_generate(&pi, data, meta, 100, NLB);
+	if (!pi_verify(&pi, data, meta, 100, NLB, &e)) {
+		printf("ERROR: %s: %s error in block %d on clean data\n", name,
+		       pi_field_name(e.field), (int)e.block);
+		test_rc = 1;
+		return;
+	}
+
+	/* the guard covers the data and the metadata in front of the PI */
+	data[3 * stride + 17] ^= 1;
+	expect_error(name, &pi, data, meta, 100, PI_FIELD_GUARD, 3);
+	data[3 * stride + 17] ^= 1;
+
+	if (pi.pi_off) {
+		tags = ext ? data + 2 * stride + LBS : mbuf + 2 * ms;
+		tags[0] ^= 0x80;
+		expect_error(name, &pi, data, meta, 100, PI_FIELD_GUARD, 2);
+		tags[0] ^= 0x80;
+	}
+
+	pi.app_tag = 0x1235;
+	expect_error(name, &pi, data, meta, 100, PI_FIELD_APP_TAG, 0);
+	pi.app_mask = 0xfffe;
+	if (!pi_verify(&pi, data, meta, 100, NLB, &e)) {
+		printf("ERROR: %s: masked app tag bit checked\n", name);
+		test_rc = 1;
+	}
+	pi.app_tag = 0x1234;
+	pi.app_mask = 0xffff;
+
+	if (type != 3)
+		expect_error(name, &pi, data, meta, 101, PI_FIELD_REF_TAG, 0);
+	else if (!pi_verify(&pi, data, meta, 101, NLB, &e)) {
+		printf("ERROR: %s: type 3 reference tag checked\n", name);
+		test_rc = 1;
+	}
+
+	if (sts) {
+		pi.storage_tag ^= 1;
+		expect_error(name, &pi, data, meta, 100, PI_FIELD_STORAGE_TAG, 0);
+		pi.storage_tag ^= 1;
+	}
+
+	/* an app tag of FFFFh turns off checking for the block */
+	pi.app_tag = 0xffff;
+	pi_generate(&pi, data, meta, type == 3 ? ~0ULL : 100, NLB);
+	data[5 * stride] ^= 1;
+	if (!pi_verify(&pi, data, meta, 100, NLB, &e)) {
+		printf("ERROR: %s: escape tag not honoured\n", name);
+		test_rc = 1;
+	}
+}
+
+static void check_layout(void)
+{
+	static uint8_t data[LBS], meta[16];
+	struct pi pi;
+
+	memset(data, 0, sizeof(data));
+	pi_init(&pi, PI_GUARD_16, 1, 8, false, LBS, 16, false);
+	pi.app_tag = 0x1234;
+	pi.storage_tag = 0xab;
+	pi_generate(&pi, data, meta, 0x00cdef01, 1);
+
+	/* CRC-16 of zeroes is zero, the storage tag in the upper byte */
+	if (meta[8] || meta[9] || meta[10] != 0x12 || meta[11] != 0x34 ||
+	    meta[12] != 0xab || meta[13] != 0xcd || meta[14] != 0xef ||
+	    meta[15] != 0x01) {
+		printf("ERROR: 16b guard PI layout\n");
+		test_rc = 1;
+	}
+
+	pi_init(&pi, PI_GUARD_64, 1, 0, true, LBS, 16, false);
+	pi_generate(&pi, data, meta, 0x123456789abcULL, 1);
+	if (meta[10] != 0x12 || meta[15] != 0xbc) {
+		printf("ERROR: 64b guard PI layout\n");
+		test_rc = 1;
+	}
+}
+
+int main(void)
+{
+	struct pi pi;
+
+	check_crc();
+	check_layout();
+
+	check_roundtrip(PI_GUARD_16, 1, 0, false, 8, false);
+	check_roundtrip(PI_GUARD_16, 2, 16, false, 16, false);
+	check_roundtrip(PI_GUARD_16, 3, 0, true, 16, true);
+	check_roundtrip(PI_GUARD_32, 1, 24, false, 32, false);
+	check_roundtrip(PI_GUARD_32, 1, 0, true, 16, true);
+	check_roundtrip(PI_GUARD_64, 1, 0, false, 16, false);
+	check_roundtrip(PI_GUARD_64, 2, 40, false, 64, true);
+	check_roundtrip(PI_GUARD_64, 3, 16, true, 24, false);
+
+	if (!pi_init(&pi, PI_GUARD_64, 1, 0, false, LBS, 8, false) ||
+	    !pi_init(&pi, PI_GUARD_16, 0, 0, false, LBS, 8, false) ||
+	    !pi_init(&pi, PI_GUARD_16, 1, 33, false, LBS, 8, false)) {
+		printf("ERROR: invalid PI parameters accepted\n");
+		test_rc = 1;
+	}
+
+	return test_rc ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,143 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include <string.h>
+
+#include "cbor.h"
+
+#define CBOR_INDEFINITE		31
+#define CBOR_BREAK		0xff
+#define CBOR_FALSE		20
+#define CBOR_TRUE		21
+#define CBOR_NULL		22
+
+size_t cbor_encode_head(uint8_t *buf, enum cbor_major major, uint64_t val)
+{
+	uint8_t mt = major << 5;
+	size_t len, i;
+
+	if (val < 24) {
+		buf[0] = mt | val;
+		return 1;
+	}
+
+	if (val <= UINT8_MAX) {
+		buf[0] = mt | 24;
+		len = 1;
+	} else if (val <= UINT16_MAX) {
+		buf[0] = mt | 25;
+		len = 2;
+	} else if (val <= UINT32_MAX) {
+		buf[0] = mt | 26;
+		len = 4;
+	} else {
+		buf[0] = mt | 27;
+		len = 8;
+	}
+
+	for (i = 0; i < len; i++)
+		buf[len - i] = val >> (8 * i);
+
+	return len + 1;
+}
+
+static void cbor_put_head(FILE *fp, enum cbor_major major, uint64_t val)
+{
+	uint8_t buf[9];
+
+	fwrite(buf, 1, cbor_encode_head(buf, major, val), fp);
+}
+
+void cbor_put_uint(FILE *fp, uint64_t val)
+{
+	cbor_put_head(fp, CBOR_MAJOR_UINT, val);
+}
+
+void cbor_put_int(FILE *fp, int64_t val)
+{
+	if (val < 0)
+		cbor_put_head(fp, CBOR_MAJOR_NINT, -(val + 1));
+	else
+		cbor_put_head(fp, CBOR_MAJOR_UINT, val);
+}
+
+/*
+ * 128-bit counters as found in log pages (little endian). Values that fit
+ * into 64 bits are plain integers, everything else is a positive bignum.
+ */
+void cbor_put_uint128(FILE *fp, const uint8_t *le)
+{
+	uint8_t be[16];
+	uint64_t val = 0;
+	int len = 16;
+	int i;
+
+	while (len > 0 && !le[len - 1])
+		len--;
+
+	if (len <= 8) {
+		for (i = len - 1; i >= 0; i--)
+			val = val << 8 | le[i];
+		cbor_put_uint(fp, val);
+		return;
+	}
+
+	for (i = 0; i < len; i++)
+		be[i] = le[len - 1 - i];
+
+	cbor_put_tag(fp, CBOR_TAG_POS_BIGNUM);
+	cbor_put_bytes(fp, be, len);
+}
+
+void cbor_put_bytes(FILE *fp, const void *buf, size_t len)
+{
+	cbor_put_head(fp, CBOR_MAJOR_BYTES, len);
+	fwrite(buf, 1, len, fp);
+}
+
+void cbor_put_text(FILE *fp, const char *str)
+{
+	size_t len = str ? strlen(str) : 0;
+
+	cbor_put_head(fp, CBOR_MAJOR_TEXT, len);
+	fwrite(str, 1, len, fp);
+}
+
+/* Fixed size, space padded fields such as the serial or model number */
+void cbor_put_textn(FILE *fp, const char *str, size_t len)
+{
+	len = strnlen(str, len);
+	while (len && str[len - 1] == ' ')
+		len--;
+
+	cbor_put_head(fp, CBOR_MAJOR_TEXT, len);
+	fwrite(str, 1, len, fp);
+}
+
+void cbor_put_bool(FILE *fp, bool val)
+{
+	fputc(CBOR_MAJOR_SIMPLE << 5 | (val ? CBOR_TRUE : CBOR_FALSE), fp);
+}
+
+void cbor_put_null(FILE *fp)
+{
+	fputc(CBOR_MAJOR_SIMPLE << 5 | CBOR_NULL, fp);
+}
+
+void cbor_put_tag(FILE *fp, uint64_t tag)
+{
+	cbor_put_head(fp, CBOR_MAJOR_TAG, tag);
+}
+
+void cbor_open_map(FILE *fp)
+{
+	fputc(CBOR_MAJOR_MAP << 5 | CBOR_INDEFINITE, fp);
+}
+
+void cbor_open_array(FILE *fp)
+{
+	fputc(CBOR_MAJOR_ARRAY << 5 | CBOR_INDEFINITE, fp);
+}
+
+void cbor_put_break(FILE *fp)
+{
+	fputc(CBOR_BREAK, fp);
+}
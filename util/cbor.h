@@ -0,0 +1,45 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+#ifndef __CBOR_H__
+#define __CBOR_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Minimal RFC 8949 (CBOR) encoder. Items are written straight to a FILE,
+ * maps and arrays use the indefinite-length encoding so their size does
+ * not need to be known up front; close them with cbor_put_break().
+ */
+
+enum cbor_major {
+	CBOR_MAJOR_UINT		= 0,
+	CBOR_MAJOR_NINT		= 1,
+	CBOR_MAJOR_BYTES	= 2,
+	CBOR_MAJOR_TEXT		= 3,
+	CBOR_MAJOR_ARRAY	= 4,
+	CBOR_MAJOR_MAP		= 5,
+	CBOR_MAJOR_TAG		= 6,
+	CBOR_MAJOR_SIMPLE	= 7,
+};
+
+#define CBOR_TAG_POS_BIGNUM	2
+#define CBOR_SELF_DESCRIBE	55799
+
+size_t cbor_encode_head(uint8_t *buf, enum cbor_major major, uint64_t val);
+
+void cbor_put_uint(FILE *fp, uint64_t val);
+void cbor_put_int(FILE *fp, int64_t val);
+void cbor_put_uint128(FILE *fp, const uint8_t *le);
+void cbor_put_bytes(FILE *fp, const void *buf, size_t len);
+void cbor_put_text(FILE *fp, const char *str);
+void cbor_put_textn(FILE *fp, const char *str, size_t len);
+void cbor_put_bool(FILE *fp, bool val);
+void cbor_put_null(FILE *fp);
+void cbor_put_tag(FILE *fp, uint64_t tag);
+void cbor_open_map(FILE *fp);
+void cbor_open_array(FILE *fp);
+void cbor_put_break(FILE *fp);
+
+#endif /* __CBOR_H__ */
@@ -0,0 +1,390 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include <errno.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef CONFIG_ZLIB
+#include <zlib.h>
+#endif
+#ifdef CONFIG_ZSTD
+#include <zstd.h>
+#endif
+
+#include "compress.h"
+
+#define COMPRESS_BUF_SIZE	(64 * 1024)
+
+/* shorter runs are cheaper as part of a literal record */
+#define RLE_MIN_RUN		4
+#define RLE_MAX_LITERAL		4096
+/* a record header is at most this long */
+#define RLE_MAX_HDR		10
+
+struct argconfig_opt_val compress_vals[] = {
+	VAL_BYTE("none", COMPRESS_NONE),
+	VAL_BYTE("rle", COMPRESS_RLE),
+#ifdef CONFIG_ZLIB
+	VAL_BYTE("gzip", COMPRESS_GZIP),
+#endif
+#ifdef CONFIG_ZSTD
+	VAL_BYTE("zstd", COMPRESS_ZSTD),
+#endif
+	VAL_END()
+};
+
+struct compress_stream {
+	int fd;
+	enum compress_type type;
+	int err;
+	uint8_t *out;
+	size_t out_len;
+
+	/* rle */
+	uint8_t *lit;
+	size_t lit_len;
+	uint8_t run_byte;
+	uint64_t run_len;
+
+#ifdef CONFIG_ZLIB
+	z_stream z;
+#endif
+#ifdef CONFIG_ZSTD
+	ZSTD_CStream *zstd;
+#endif
+};
+
+const char *compress_suffix(enum compress_type type)
+{
+	switch (type) {
+	case COMPRESS_RLE:
+		return ".rle";
+	case COMPRESS_GZIP:
+		return ".gz";
+	case COMPRESS_ZSTD:
+		return ".zst";
+	default:
+		return "";
+	}
+}
+
+static int write_all(int fd, const uint8_t *buf, size_t len)
+{
+	ssize_t n;
+
+	while (len) {
+		n = write(fd, buf, len);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return -errno;
+		}
+		buf += n;
+		len -= n;
+	}
+
+	return 0;
+}
+
+static int flush_out(struct compress_stream *cs)
+{
+	int err;
+
+	err = write_all(cs->fd, cs->out, cs->out_len);
+	cs->out_len = 0;
+
+	return err;
+}
+
+static int rle_put(struct compress_stream *cs, uint64_t n, const uint8_t *data,
+		   size_t len)
+{
+	int err;
+
+	if (cs->out_len + RLE_MAX_HDR + len > COMPRESS_BUF_SIZE) {
+		err = flush_out(cs);
+		if (err)
+			return err;
+	}
+
+	do {
+		cs->out[cs->out_len] = n & 0x7f;
+		n >>= 7;
+		if (n)
+			cs->out[cs->out_len] |= 0x80;
+		cs->out_len++;
+	} while (n);
+
+	memcpy(cs->out + cs->out_len, data, len);
+	cs->out_len += len;
+
+	return 0;
+}
+
+static int rle_flush_literal(struct compress_stream *cs)
+{
+	int err;
+
+	if (!cs->lit_len)
+		return 0;
+
+	err = rle_put(cs, cs->lit_len << 1, cs->lit, cs->lit_len);
+	cs->lit_len = 0;
+
+	return err;
+}
+
+/* ends the current run, short ones join the literal */
+static int rle_flush_run(struct compress_stream *cs)
+{
+	int err;
+
+	if (cs->run_len >= RLE_MIN_RUN) {
+		err = rle_flush_literal(cs);
+		if (err)
+			return err;
+		err = rle_put(cs, cs->run_len << 1 | 1, &cs->run_byte, 1);
+		cs->run_len = 0;
+		return err;
+	}
+
+	while (cs->run_len) {
+		if (cs->lit_len == RLE_MAX_LITERAL) {
+			err = rle_flush_literal(cs);
+			if (err)
+				return err;
+		}
+		cs->lit[cs->lit_len++] = cs->run_byte;
+		cs->run_len--;
+	}
+
+	return 0;
+}
+
+static int rle_write(struct compress_stream *cs, const uint8_t *p, size_t len)
+{
+	const uint8_t *end = p + len;
+	const uint8_t *q;
+	int err;
+
+	while (p < end) {
+		if (cs->run_len && *p == cs->run_byte) {
+			for (q = p; q < end && *q == cs->run_byte; q++)
+				;
+			cs->run_len += q - p;
+			p = q;
+			continue;
+		}
+
+		err = rle_flush_run(cs);
+		if (err)
+			return err;
+		cs->run_byte = *p++;
+		cs->run_len = 1;
+	}
+
+	return 0;
+}
+
+static int rle_finish(struct compress_stream *cs)
+{
+	int err;
+
+	err = rle_flush_run(cs);
+	if (err)
+		return err;
+
+	return rle_flush_literal(cs);
+}
+
+#ifdef CONFIG_ZLIB
+static int gzip_write(struct compress_stream *cs, const uint8_t *p, size_t len,
+		      int flush)
+{
+	int ret, err;
+
+	/* avail_in is an unsigned int */
+	do {
+		size_t n = len < (1U << 30) ? len : (1U << 30);
+
+		cs->z.next_in = (uint8_t *)p;
+		cs->z.avail_in = n;
+		p += n;
+		len -= n;
+
+		do {
+			cs->z.next_out = cs->out;
+			cs->z.avail_out = COMPRESS_BUF_SIZE;
+			ret = deflate(&cs->z, len ? Z_NO_FLUSH : flush);
+			if (ret == Z_STREAM_ERROR)
+				return -EIO;
+			cs->out_len = COMPRESS_BUF_SIZE - cs->z.avail_out;
+			err = flush_out(cs);
+			if (err)
+				return err;
+		} while (!cs->z.avail_out);
+	} while (len);
+
+	return 0;
+}
+#endif
+
+#ifdef CONFIG_ZSTD
+static int zstd_write(struct compress_stream *cs, const uint8_t *p, size_t len,
+		      bool end)
+{
+	ZSTD_inBuffer in = { p, len, 0 };
+	ZSTD_outBuffer out;
+	size_t ret;
+	int err;
+
+	do {
+		out = (ZSTD_outBuffer){ cs->out, COMPRESS_BUF_SIZE, 0 };
+		if (end)
+			ret = ZSTD_endStream(cs->zstd, &out);
+		else
+			ret = ZSTD_compressStream(cs->zstd, &out, &in);
+		if (ZSTD_isError(ret))
+			return -EIO;
+		cs->out_len = out.pos;
+		err = flush_out(cs);
+		if (err)
+			return err;
+	} while (end ? ret : in.pos < in.size);
+
+	return 0;
+}
+#endif
+
+struct compress_stream *compress_open(int fd, enum compress_type type)
+{
+	struct compress_stream *cs;
+
+	cs = calloc(1, sizeof(*cs));
+	if (!cs)
+		return NULL;
+	cs->fd = fd;
+	cs->type = type;
+
+	if (type != COMPRESS_NONE) {
+		cs->out = malloc(COMPRESS_BUF_SIZE);
+		if (!cs->out)
+			goto free;
+	}
+
+	switch (type) {
+	case COMPRESS_NONE:
+		break;
+	case COMPRESS_RLE:
+		cs->lit = malloc(RLE_MAX_LITERAL);
+		if (!cs->lit)
+			goto free;
+		memcpy(cs->out, COMPRESS_RLE_MAGIC, strlen(COMPRESS_RLE_MAGIC));
+		cs->out_len = strlen(COMPRESS_RLE_MAGIC);
+		break;
+#ifdef CONFIG_ZLIB
+	case COMPRESS_GZIP:
+		/*
+		 * Dumps are mostly zeroes and repeated patterns, the fastest
+		 * level keeps up with the device and shrinks them almost as
+		 * much as the default one.
+		 */
+		if (deflateInit2(&cs->z, Z_BEST_SPEED, Z_DEFLATED, 15 + 16, 8,
+				 Z_DEFAULT_STRATEGY) != Z_OK) {
+			errno = ENOMEM;
+			goto free;
+		}
+		break;
+#endif
+#ifdef CONFIG_ZSTD
+	case COMPRESS_ZSTD:
+		cs->zstd = ZSTD_createCStream();
+		if (!cs->zstd ||
+		    ZSTD_isError(ZSTD_initCStream(cs->zstd, ZSTD_CLEVEL_DEFAULT))) {
+			ZSTD_freeCStream(cs->zstd);
+			errno = ENOMEM;
+			goto free;
+		}
+		break;
+#endif
+	default:
+		errno = EOPNOTSUPP;
+		goto free;
+	}
+
+	return cs;
+
+free:
+	free(cs->lit);
+	free(cs->out);
+	free(cs);
+	return NULL;
+}
+
+int compress_write(struct compress_stream *cs, const void *buf, size_t len)
+{
+	int err;
+
+	if (cs->err)
+		return cs->err;
+
+	switch (cs->type) {
+	case COMPRESS_RLE:
+		err = rle_write(cs, buf, len);
+		break;
+#ifdef CONFIG_ZLIB
+	case COMPRESS_GZIP:
+		err = gzip_write(cs, buf, len, Z_NO_FLUSH);
+		break;
+#endif
+#ifdef CONFIG_ZSTD
+	case COMPRESS_ZSTD:
+		err = zstd_write(cs, buf, len, false);
+		break;
+#endif
+	default:
+		err = write_all(cs->fd, buf, len);
+		break;
+	}
+
+	cs->err = err;
+
+	return err;
+}
+
+int compress_close(struct compress_stream *cs)
+{
+	int err = cs->err;
+
+	switch (cs->type) {
+	case COMPRESS_RLE:
+		if (!err)
+			err = rle_finish(cs);
+		if (!err)
+			err = flush_out(cs);
+		free(cs->lit);
+		break;
+#ifdef CONFIG_ZLIB
+	case COMPRESS_GZIP:
+		if (!err)
+			err = gzip_write(cs, NULL, 0, Z_FINISH);
+		deflateEnd(&cs->z);
+		break;
+#endif
+#ifdef CONFIG_ZSTD
+	case COMPRESS_ZSTD:
+		if (!err)
+			err = zstd_write(cs, NULL, 0, true);
+		ZSTD_freeCStream(cs->zstd);
+		break;
+#endif
+	default:
+		break;
+	}
+
+	free(cs->out);
+	free(cs);
+
+	return err;
+}
@@ -0,0 +1,48 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+#ifndef __COMPRESS_H__
+#define __COMPRESS_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "argconfig.h"
+
+/*
+ * Streaming compression of dumps written to a file. The data is fed in
+ * the chunks it arrives in from the device and lands on disk compressed,
+ * without keeping the whole dump in memory:
+ *
+ *   none	written as is
+ *   rle	built-in run-length encoding, always available
+ *   gzip	zlib, if nvme was built with it
+ *   zstd	libzstd, if nvme was built with it
+ *
+ * The rle stream starts with the magic "NVRL" followed by records. Each
+ * record starts with an unsigned LEB128 number n: if bit 0 of n is set,
+ * one byte follows which is repeated n >> 1 times, otherwise n >> 1
+ * literal bytes follow.
+ */
+
+#define COMPRESS_RLE_MAGIC	"NVRL"
+
+enum compress_type {
+	COMPRESS_NONE,
+	COMPRESS_RLE,
+	COMPRESS_GZIP,
+	COMPRESS_ZSTD,
+};
+
+extern struct argconfig_opt_val compress_vals[];
+
+struct compress_stream;
+
+/* file name suffix of @type, "" for none */
+const char *compress_suffix(enum compress_type type);
+
+/* returns NULL and sets errno on error, @fd is not closed by the stream */
+struct compress_stream *compress_open(int fd, enum compress_type type);
+int compress_write(struct compress_stream *cs, const void *buf, size_t len);
+/* flushes and frees @cs, returns the first error seen on it */
+int compress_close(struct compress_stream *cs);
+
+#endif /* __COMPRESS_H__ */
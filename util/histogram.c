@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include <string.h>
+
+#include "histogram.h"
+
+#define HIST_HALF	(HIST_SUB_COUNT / 2)
+#define HIST_MAX_VAL	((1ULL << HIST_MAX_BITS) - 1)
+
+void hist_init(struct histogram *h)
+{
+	memset(h, 0, sizeof(*h));
+	h->min = UINT64_MAX;
+}
+
+unsigned int hist_index(uint64_t val)
+{
+	unsigned int shift;
+
+	if (val < HIST_SUB_COUNT)
+		return val;
+
+	if (val > HIST_MAX_VAL)
+		val = HIST_MAX_VAL;
+
+	/* (val >> shift) lands in [HIST_HALF, HIST_SUB_COUNT) */
+	shift = 63 - __builtin_clzll(val) - (HIST_SUB_BITS - 1);
+
+	return HIST_SUB_COUNT + (shift - 1) * HIST_HALF +
+		(val >> shift) - HIST_HALF;
+}
+
+/* highest value that is counted in bucket @idx */
+uint64_t hist_value(unsigned int idx)
+{
+	unsigned int shift;
+	uint64_t sub;
+
+	if (idx < HIST_SUB_COUNT)
+		return idx;
+
+	idx -= HIST_SUB_COUNT;
+	shift = idx / HIST_HALF + 1;
+	sub = idx % HIST_HALF + HIST_HALF;
+
+	return ((sub + 1) << shift) - 1;
+}
+
+void hist_record(struct histogram *h, uint64_t val)
+{
+	h->counts[hist_index(val)]++;
+	h->total++;
+	h->sum += val;
+	if (val < h->min)
+		h->min = val;
+	if (val > h->max)
+		h->max = val;
+}
+
+void hist_merge(struct histogram *dst, const struct histogram *src)
+{
+	unsigned int i;
+
+	for (i = 0; i < HIST_NR_BUCKETS; i++)
+		dst->counts[i] += src->counts[i];
+	dst->total += src->total;
+	dst->sum += src->sum;
+	if (src->min < dst->min)
+		dst->min = src->min;
+	if (src->max > dst->max)
+		dst->max = src->max;
+}
+
+uint64_t hist_percentile(const struct histogram *h, double pct)
+{
+	uint64_t rank, seen = 0;
+	unsigned int i;
+
+	if (!h->total)
+		return 0;
+
+	if (pct >= 100.0)
+		return h->max;
+
+	rank = (uint64_t)(pct / 100.0 * h->total + 0.5);
+	if (!rank)
+		rank = 1;
+
+	for (i = 0; i < HIST_NR_BUCKETS; i++) {
+		seen += h->counts[i];
+		if (seen >= rank)
+			break;
+	}
+
+	/* never report more than was actually recorded */
+	if (hist_value(i) > h->max)
+		return h->max;
+
+	return hist_value(i);
+}
+
+double hist_mean(const struct histogram *h)
+{
+	if (!h->total)
+		return 0;
+
+	return h->sum / h->total;
+}
@@ -0,0 +1,42 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+#ifndef __HISTOGRAM_H__
+#define __HISTOGRAM_H__
+
+#include <stdint.h>
+
+/*
+ * Log-linear histogram in the style of HdrHistogram. Values below
+ * HIST_SUB_COUNT are counted exactly, above that each power of two is
+ * split into HIST_SUB_COUNT / 2 buckets, which bounds the relative error
+ * of a reported value to 1 / (HIST_SUB_COUNT / 2), i.e. ~1.6%. Values
+ * up to 2^HIST_MAX_BITS - 1 are tracked, larger ones are clamped.
+ *
+ * Recording is a couple of shifts and an increment, so it is cheap
+ * enough to be done per I/O. Histograms are meant to be owned by a
+ * single thread and merged at the end.
+ */
+
+#define HIST_SUB_BITS	7
+#define HIST_SUB_COUNT	(1 << HIST_SUB_BITS)
+#define HIST_MAX_BITS	40
+#define HIST_NR_BUCKETS	(HIST_SUB_COUNT + \
+			 (HIST_MAX_BITS - HIST_SUB_BITS) * (HIST_SUB_COUNT / 2))
+
+struct histogram {
+	uint64_t counts[HIST_NR_BUCKETS];
+	uint64_t total;
+	uint64_t min;
+	uint64_t max;
+	long double sum;
+};
+
+void hist_init(struct histogram *h);
+void hist_record(struct histogram *h, uint64_t val);
+void hist_merge(struct histogram *dst, const struct histogram *src);
+uint64_t hist_percentile(const struct histogram *h, double pct);
+double hist_mean(const struct histogram *h);
+
+unsigned int hist_index(uint64_t val);
+uint64_t hist_value(unsigned int idx);
+
+#endif /* __HISTOGRAM_H__ */
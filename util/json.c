@@ -2,6 +2,8 @@
 #include <stdio.h>
 #include <errno.h>
 #include <stdarg.h>
+#include <stdbool.h>
+#include <string.h>
 
 #include "json.h"
 #include "types.h"
@@ -58,6 +60,329 @@ struct json_object *util_json_object_new_uint128(nvme_uint128_t  val)
 	return obj;
 }
 
+#define JSON_STREAM_FLAGS (JSON_C_TO_STRING_PRETTY | JSON_C_TO_STRING_NOSLASHESCAPE)
+#define JSON_STREAM_INDENT 2
+
+struct json_stream;
+
+struct json_stream_node {
+	struct json_stream *s;
+	struct json_object *o;
+	struct json_stream_node *up;
+	struct json_stream_node *next;
+	int level;
+	bool open;
+	bool closed;
+	bool children;
+};
+
+struct json_stream {
+	FILE *fp;
+	bool ndjson;
+	struct json_stream_node root;
+	struct json_stream_node *top;
+	struct json_stream_node *nodes;
+};
+
+static struct json_stream_node *json_stream_node(struct json_object *o)
+{
+	struct json_stream_node *n;
+
+	if (!o || (!json_object_is_type(o, json_type_object) &&
+		   !json_object_is_type(o, json_type_array)))
+		return NULL;
+
+	n = json_object_get_userdata(o);
+	if (!n || n->o != o)
+		return NULL;
+
+	return n;
+}
+
+static void json_stream_indent(FILE *fp, int level)
+{
+	fprintf(fp, "%*s", level * JSON_STREAM_INDENT, "");
+}
+
+/*
+ * json-c only pretty prints relative to indentation level 0, shift every
+ * line after the first one to the level the value lives at. Line breaks
+ * inside of strings are escaped, so every '\n' is a structural one.
+ */
+static void json_stream_write(FILE *fp, struct json_object *v, int level)
+{
+	const char *str, *nl;
+
+	if (!v) {
+		fputs("null", fp);
+		return;
+	}
+
+	str = json_object_to_json_string_ext(v, JSON_STREAM_FLAGS);
+	while ((nl = strchr(str, '\n'))) {
+		fwrite(str, 1, nl - str + 1, fp);
+		json_stream_indent(fp, level);
+		str = nl + 1;
+	}
+	fputs(str, fp);
+}
+
+/* Start a member of @n the way json-c does, up to and including the key */
+static void json_stream_key(struct json_stream_node *n, const char *k)
+{
+	FILE *fp = n->s->fp;
+	struct json_object *key;
+
+	if (n->children)
+		fputc(',', fp);
+	fputc('\n', fp);
+	json_stream_indent(fp, n->level + 1);
+	n->children = true;
+
+	if (!k)
+		return;
+
+	key = json_object_new_string(k);
+	json_stream_write(fp, key, 0);
+	json_object_put(key);
+	fputc(':', fp);
+}
+
+static bool json_stream_first(struct json_object *o, const char **k,
+			      struct json_object **v)
+{
+	json_object_object_foreach(o, key, val) {
+		*k = key;
+		*v = val;
+		return true;
+	}
+
+	return false;
+}
+
+/*
+ * A stream container that is written as part of its parent can't be
+ * streamed anymore.
+ */
+static void json_stream_written(struct json_stream *s, struct json_object *v)
+{
+	struct json_stream_node *n = json_stream_node(v);
+
+	if (n && n->s == s)
+		n->closed = true;
+}
+
+/* Write and drop the members of the open node @n up to @stop */
+static void json_stream_drain(struct json_stream_node *n,
+			      struct json_object *stop)
+{
+	struct json_stream *s = n->s;
+	struct json_object *v;
+	const char *k;
+	size_t i, len;
+
+	if (json_object_is_type(n->o, json_type_array)) {
+		len = json_object_array_length(n->o);
+		for (i = 0; i < len; i++) {
+			v = json_object_array_get_idx(n->o, i);
+			if (stop && v == stop)
+				break;
+
+			if (s->ndjson) {
+				if (v)
+					fputs(json_object_to_json_string_ext(v,
+						JSON_STREAM_FLAGS &
+						~JSON_C_TO_STRING_PRETTY), s->fp);
+				else
+					fputs("null", s->fp);
+				fputc('\n', s->fp);
+				continue;
+			}
+
+			json_stream_key(n, NULL);
+			json_stream_write(s->fp, v, n->level + 1);
+			json_stream_written(s, v);
+		}
+		if (i)
+			json_object_array_del_idx(n->o, 0, i);
+		return;
+	}
+
+	while (json_stream_first(n->o, &k, &v) && (!stop || v != stop)) {
+		json_stream_key(n, k);
+		json_stream_write(s->fp, v, n->level + 1);
+		json_stream_written(s, v);
+		json_object_object_del(n->o, k);
+	}
+}
+
+static void json_stream_close(struct json_stream *s)
+{
+	struct json_stream_node *n = s->top;
+
+	json_stream_drain(n, NULL);
+
+	if (n->children) {
+		fputc('\n', s->fp);
+		json_stream_indent(s->fp, n->level);
+	}
+	fputc(json_object_is_type(n->o, json_type_array) ? ']' : '}', s->fp);
+
+	n->open = false;
+	n->closed = true;
+	s->top = n->up;
+}
+
+/*
+ * Write everything in front of @n and its opening bracket. The node keeps
+ * its own reference, so it is removed from its parent once it is open.
+ */
+static void json_stream_open(struct json_stream_node *n)
+{
+	struct json_stream *s = n->s;
+	struct json_stream_node *up = n->up;
+	struct json_object *v;
+	const char *k;
+
+	if (n->open || n->closed)
+		return;
+
+	if (up) {
+		json_stream_open(up);
+		if (!up->open)
+			return;
+
+		while (s->top != up)
+			json_stream_close(s);
+
+		json_stream_drain(up, n->o);
+		if (!json_stream_first(up->o, &k, &v) || v != n->o)
+			return;
+
+		json_stream_key(up, k);
+	}
+
+	fputc(json_object_is_type(n->o, json_type_array) ? '[' : '{', s->fp);
+	n->open = true;
+	s->top = n;
+
+	if (up)
+		json_object_object_del(up->o, k);
+}
+
+struct json_object *util_json_stream_array(struct json_object *o, const char *k)
+{
+	struct json_stream_node *up = json_stream_node(o);
+	struct json_stream_node *n;
+	struct json_object *a;
+
+	a = json_object_new_array();
+	if (!a)
+		return NULL;
+
+	if (json_object_object_add(o, k, a)) {
+		json_object_put(a);
+		return NULL;
+	}
+
+	if (!up || up->closed || up->s->ndjson)
+		return a;
+
+	n = calloc(1, sizeof(*n));
+	if (!n)
+		return a;
+
+	n->s = up->s;
+	n->o = json_object_get(a);
+	n->up = up;
+	n->level = up->level + 1;
+	n->next = n->s->nodes;
+	n->s->nodes = n;
+	json_object_set_userdata(a, n, NULL);
+
+	return a;
+}
+
+void util_json_stream_flush(struct json_object *o)
+{
+	struct json_stream_node *n = json_stream_node(o);
+
+	if (!n)
+		return;
+
+	if (n->s->ndjson) {
+		json_stream_drain(n, NULL);
+		return;
+	}
+
+	json_stream_open(n);
+	if (!n->open)
+		return;
+
+	while (n->s->top != n)
+		json_stream_close(n->s);
+	json_stream_drain(n, NULL);
+}
+
+static void json_stream_free(struct json_object *o, void *userdata)
+{
+	struct json_stream_node *root = userdata;
+	struct json_stream *s = root->s;
+	struct json_stream_node *n;
+
+	while ((n = s->nodes)) {
+		s->nodes = n->next;
+		json_object_set_userdata(n->o, NULL, NULL);
+		json_object_put(n->o);
+		free(n);
+	}
+
+	free(s);
+}
+
+struct json_object *util_json_stream_new(FILE *fp, bool ndjson)
+{
+	struct json_object *o;
+	struct json_stream *s;
+
+	s = calloc(1, sizeof(*s));
+	if (!s)
+		return NULL;
+
+	o = ndjson ? json_object_new_array() : json_object_new_object();
+	if (!o) {
+		free(s);
+		return NULL;
+	}
+
+	s->fp = fp;
+	s->ndjson = ndjson;
+	s->root.s = s;
+	s->root.o = o;
+	json_object_set_userdata(o, &s->root, json_stream_free);
+
+	return o;
+}
+
+void util_json_print_object(struct json_object *o)
+{
+	struct json_stream_node *n = json_stream_node(o);
+
+	if (!n) {
+		printf("%s", json_object_to_json_string_ext(o, JSON_STREAM_FLAGS));
+		return;
+	}
+
+	if (n->s->ndjson) {
+		json_stream_drain(n, NULL);
+		return;
+	}
+
+	json_stream_open(n);
+	while (n->open)
+		json_stream_close(n->s);
+}
+
 uint64_t util_json_object_get_uint64(struct json_object *obj)
 {
 	uint64_t val = 0;
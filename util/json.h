@@ -3,12 +3,16 @@
 #define __JSON__H
 
 #ifdef CONFIG_JSONC
+#include <stdbool.h>
+#include <stdio.h>
 #include <json.h>
 #include "util/types.h"
 
 /* Wrappers around json-c's API */
 
 #define json_create_object(o) json_object_new_object(o)
+#define json_create_stream_object(fp) util_json_stream_new(fp, false)
+#define json_create_ndjson_array(fp) util_json_stream_new(fp, true)
 #define json_free_object(o) json_object_put(o)
 #define json_free_array(a) json_object_put(a)
 #define json_object_add_value_uint(o, k, v) json_object_object_add(o, k, json_object_new_uint64(v))
@@ -37,11 +41,33 @@ static inline int json_array_add_value_string(struct json_object *o, const char
 	return json_object_array_add(o, v ? json_object_new_string(v) : NULL);
 }
 
-#define json_print_object(o, u)						\
+#define json_print_object(o, u) util_json_print_object(o)
+#define json_print_object_plain(o)					\
 	printf("%s", json_object_to_json_string_ext(o,			\
-		JSON_C_TO_STRING_PRETTY |				\
+		JSON_C_TO_STRING_PLAIN |				\
 		JSON_C_TO_STRING_NOSLASHESCAPE))
 
+#define json_stream_add_array(o, k) util_json_stream_array(o, k)
+#define json_stream_flush(o) util_json_stream_flush(o)
+
+/*
+ * Stream objects are built like any other object but can be written out
+ * before json_print_object(). Arrays added to them with
+ * json_stream_add_array() are stream arrays: json_stream_flush() writes the
+ * elements added so far, together with every member added to the enclosing
+ * objects before the array, and frees them. Everything written has to be
+ * complete, so only flush after the last change to the elements added.
+ * Members that are not flushed are written by json_print_object(), which
+ * gives the same output as for a plain object.
+ *
+ * NDJSON arrays print every element on a line of its own when flushed and
+ * never print the array itself.
+ */
+struct json_object *util_json_stream_new(FILE *fp, bool ndjson);
+struct json_object *util_json_stream_array(struct json_object *o, const char *k);
+void util_json_stream_flush(struct json_object *o);
+void util_json_print_object(struct json_object *o);
+
 struct json_object *util_json_object_new_double(long double d);
 struct json_object *util_json_object_new_uint64(uint64_t i);
 struct json_object *util_json_object_new_uint128(nvme_uint128_t val);
@@ -53,6 +79,8 @@ struct json_object;
 
 #define json_object_add_value_string(o, k, v)
 #define json_create_object(o) NULL
+#define json_create_stream_object(fp) NULL
+#define json_create_ndjson_array(fp) NULL
 #define json_free_object(o) ((void)(o))
 #define json_object_add_value_uint(o, k, v) ((void)(v))
 #define json_object_add_value_int(o, k, v) ((void)(v))
@@ -62,10 +90,13 @@ struct json_object;
 #define json_object_add_value_float(o, k, v)
 #define json_array_add_value_object(o, k) ((void)(k))
 #define json_print_object(o, u) ((void)(o))
+#define json_print_object_plain(o) ((void)(o))
 #define json_object_object_add(o, k, v) ((void)(v))
 #define json_object_new_int(v)
 #define json_object_new_array(a) NULL
 #define json_object_array_add(o, k) ((void)(k))
+#define json_stream_add_array(o, k) NULL
+#define json_stream_flush(o) ((void)(o))
 #endif /* CONFIG_JSONC */
 
 #define json_create_array(a) json_object_new_array(a)
@@ -0,0 +1,261 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include <ctype.h>
+#include <endian.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "pattern.h"
+
+#define VEC_WORDS	2
+#define VEC_BYTES	(VEC_WORDS * sizeof(uint64_t))
+
+typedef uint64_t vec_t __attribute__((vector_size(VEC_BYTES)));
+
+#define GOLDEN		0x9e3779b97f4a7c15ULL
+#define LBA_MUL		0xd1b54a32d192ed03ULL
+
+static inline vec_t vec_load(const void *p)
+{
+	vec_t v;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline void vec_store(void *p, vec_t v)
+{
+	memcpy(p, &v, sizeof(v));
+}
+
+static inline vec_t vec_le(vec_t v)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	int i;
+
+	for (i = 0; i < VEC_WORDS; i++)
+		v[i] = __builtin_bswap64(v[i]);
+#endif
+	return v;
+}
+
+static inline bool vec_any(vec_t v)
+{
+	return (v[0] | v[1]) != 0;
+}
+
+/* splitmix64 finaliser on each lane */
+static inline vec_t vec_mix(vec_t z)
+{
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+/* counters for the first vector of a random block */
+static inline vec_t random_ctr(const struct pattern *p, uint64_t lba)
+{
+	uint64_t key = p->seed ^ (lba * LBA_MUL);
+	vec_t ctr = { key, key + GOLDEN };
+
+	return ctr;
+}
+
+static inline vec_t lba_vec(uint64_t lba, uint64_t tag)
+{
+	vec_t v = { lba, tag };
+
+	return vec_le(v);
+}
+
+int pattern_init(struct pattern *p, enum pattern_type type, uint64_t seed,
+		 const uint8_t *user, size_t user_len, size_t lbs)
+{
+	uint8_t *block;
+	size_t i;
+
+	memset(p, 0, sizeof(*p));
+	if (!lbs || lbs % VEC_BYTES)
+		return -EINVAL;
+
+	p->type = type;
+	p->seed = seed;
+	p->lbs = lbs;
+	p->stride = lbs;
+
+	switch (type) {
+	case PATTERN_ZERO:
+		p->block = calloc(1, lbs);
+		if (!p->block)
+			return -ENOMEM;
+		break;
+	case PATTERN_USER:
+		if (!user_len || user_len > PATTERN_MAX_USER)
+			return -EINVAL;
+		p->block = malloc(lbs);
+		if (!p->block)
+			return -ENOMEM;
+		block = (uint8_t *)p->block;
+		for (i = 0; i < lbs; i++)
+			block[i] = user[i % user_len];
+		break;
+	default:
+		break;
+	}
+
+	return 0;
+}
+
+void pattern_free(struct pattern *p)
+{
+	free(p->block);
+	p->block = NULL;
+}
+
+static void fill_block(const struct pattern *p, uint8_t *dst, uint64_t lba)
+{
+	const vec_t step = { 2 * GOLDEN, 2 * GOLDEN };
+	vec_t v;
+	size_t i;
+
+	switch (p->type) {
+	case PATTERN_RANDOM:
+		v = random_ctr(p, lba);
+		for (i = 0; i < p->lbs; i += VEC_BYTES) {
+			vec_store(dst + i, vec_le(vec_mix(v)));
+			v += step;
+		}
+		break;
+	case PATTERN_LBA:
+		v = lba_vec(lba, p->seed);
+		for (i = 0; i < p->lbs; i += VEC_BYTES)
+			vec_store(dst + i, v);
+		break;
+	default:
+		memcpy(dst, p->block, p->lbs);
+		break;
+	}
+}
+
+void pattern_fill(const struct pattern *p, void *buf, uint64_t lba,
+		  uint64_t nlb)
+{
+	uint8_t *dst = buf;
+	uint64_t i;
+
+	for (i = 0; i < nlb; i++, dst += p->stride)
+		fill_block(p, dst, lba + i);
+}
+
+static void miscompare(struct pattern_miscompare *m, size_t offset,
+		       vec_t exp, vec_t got)
+{
+	int i;
+
+	for (i = 0; i < VEC_WORDS && exp[i] == got[i]; i++)
+		;
+
+	m->offset = offset + i * sizeof(uint64_t);
+	m->expected = le64toh(exp[i]);
+	m->actual = le64toh(got[i]);
+}
+
+/* Returns the offset of the first vector which differs, or lbs */
+static size_t check_block(const struct pattern *p, const uint8_t *src,
+			  uint64_t lba, vec_t *exp)
+{
+	const vec_t step = { 2 * GOLDEN, 2 * GOLDEN };
+	const uint8_t *ref = (const uint8_t *)p->block;
+	uint64_t tag;
+	vec_t v;
+	size_t i;
+
+	switch (p->type) {
+	case PATTERN_RANDOM:
+		v = random_ctr(p, lba);
+		for (i = 0; i < p->lbs; i += VEC_BYTES) {
+			*exp = vec_le(vec_mix(v));
+			if (vec_any(*exp ^ vec_load(src + i)))
+				return i;
+			v += step;
+		}
+		break;
+	case PATTERN_LBA:
+		tag = p->seed;
+		if (p->any_tag)
+			memcpy(&tag, src + sizeof(uint64_t), sizeof(tag));
+		else
+			tag = htole64(tag);
+		*exp = lba_vec(lba, le64toh(tag));
+		for (i = 0; i < p->lbs; i += VEC_BYTES)
+			if (vec_any(*exp ^ vec_load(src + i)))
+				return i;
+		break;
+	default:
+		for (i = 0; i < p->lbs; i += VEC_BYTES) {
+			*exp = vec_load(ref + i);
+			if (vec_any(*exp ^ vec_load(src + i)))
+				return i;
+		}
+		break;
+	}
+
+	return p->lbs;
+}
+
+/*
+ * Check @nlb blocks starting at @lba. On a mismatch the first differing
+ * word is reported in @m and false is returned.
+ */
+bool pattern_check(const struct pattern *p, const void *buf, uint64_t lba,
+		   uint64_t nlb, struct pattern_miscompare *m)
+{
+	const uint8_t *src = buf;
+	size_t off;
+	uint64_t i;
+	vec_t exp;
+
+	for (i = 0; i < nlb; i++, src += p->stride) {
+		off = check_block(p, src, lba + i, &exp);
+		if (off < p->lbs) {
+			miscompare(m, i * p->stride + off, exp,
+				   vec_load(src + off));
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static int hex_val(char c)
+{
+	return isdigit((unsigned char)c) ? c - '0' : tolower((unsigned char)c) - 'a' + 10;
+}
+
+/* Parse "[0x]<hex digits>" into at most PATTERN_MAX_USER bytes */
+int pattern_parse_hex(const char *str, uint8_t *buf, size_t *len)
+{
+	size_t n = 0;
+	int hi, lo;
+
+	if (!strncasecmp(str, "0x", 2))
+		str += 2;
+
+	while (*str) {
+		if (n == PATTERN_MAX_USER || !isxdigit((unsigned char)str[0]) ||
+		    !isxdigit((unsigned char)str[1]))
+			return -EINVAL;
+
+		hi = hex_val(str[0]);
+		lo = hex_val(str[1]);
+		buf[n++] = hi << 4 | lo;
+		str += 2;
+	}
+
+	if (!n)
+		return -EINVAL;
+
+	*len = n;
+	return 0;
+}
@@ -0,0 +1,68 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+#ifndef __PATTERN_H__
+#define __PATTERN_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Data patterns for writing logical blocks and checking them on the
+ * host. Each block is generated from its LBA alone, so any part of a
+ * range can be checked on its own:
+ *
+ *   zero	all zeroes
+ *   random	pseudo random data derived from the seed and the LBA
+ *   lba	the LBA followed by a 64-bit tag (e.g. a timestamp),
+ *		repeated over the whole block
+ *   user	a user supplied byte pattern, restarting at every block
+ *
+ * Only the data of a block is part of the pattern. When the metadata is
+ * interleaved with the data (extended LBAs), the blocks are @stride bytes
+ * apart in the buffer and the bytes after the first @lbs of each one
+ * are neither written nor checked.
+ *
+ * Words are stored little endian so data written on one host can be
+ * checked on another. The kernels work on 16 byte vectors (GCC vector
+ * extensions) which the compiler maps onto SSE or NEON registers, or
+ * wider ones such as AVX2 when the target allows, and onto plain 64-bit
+ * operations elsewhere.
+ */
+
+#define PATTERN_MAX_USER	64
+
+enum pattern_type {
+	PATTERN_NONE,
+	PATTERN_ZERO,
+	PATTERN_RANDOM,
+	PATTERN_LBA,
+	PATTERN_USER,
+};
+
+struct pattern {
+	enum pattern_type type;
+	uint64_t seed;		/* random: seed, lba: tag */
+	bool any_tag;		/* lba: accept any tag constant within a block */
+	size_t lbs;		/* data bytes per block */
+	size_t stride;		/* distance between blocks, lbs by default */
+	uint64_t *block;	/* zero, user: one block of data */
+};
+
+struct pattern_miscompare {
+	size_t offset;		/* byte offset into the buffer */
+	uint64_t expected;
+	uint64_t actual;
+};
+
+int pattern_init(struct pattern *p, enum pattern_type type, uint64_t seed,
+		 const uint8_t *user, size_t user_len, size_t lbs);
+void pattern_free(struct pattern *p);
+
+void pattern_fill(const struct pattern *p, void *buf, uint64_t lba,
+		  uint64_t nlb);
+bool pattern_check(const struct pattern *p, const void *buf, uint64_t lba,
+		   uint64_t nlb, struct pattern_miscompare *m);
+
+int pattern_parse_hex(const char *str, uint8_t *buf, size_t *len);
+
+#endif /* __PATTERN_H__ */
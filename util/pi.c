@@ -0,0 +1,329 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include <endian.h>
+#include <errno.h>
+#include <string.h>
+
+#include "pi.h"
+
+#define CRC16_T10DIF_POLY	0x8bb7			/* MSB first */
+#define CRC32C_POLY		0x82f63b78		/* reflected */
+#define CRC64_NVME_POLY		0x9a6c9329ac4bc9b5ULL	/* reflected */
+
+static uint16_t crc16_table[8][256];
+static uint32_t crc32c_table[8][256];
+static uint64_t crc64_table[8][256];
+
+__attribute__((constructor))
+static void crc_init_tables(void)
+{
+	uint64_t c64;
+	uint32_t c32;
+	uint16_t c16;
+	int i, j;
+
+	for (i = 0; i < 256; i++) {
+		c16 = i << 8;
+		c32 = i;
+		c64 = i;
+		for (j = 0; j < 8; j++) {
+			c16 = c16 & 0x8000 ? (c16 << 1) ^ CRC16_T10DIF_POLY : c16 << 1;
+			c32 = c32 & 1 ? (c32 >> 1) ^ CRC32C_POLY : c32 >> 1;
+			c64 = c64 & 1 ? (c64 >> 1) ^ CRC64_NVME_POLY : c64 >> 1;
+		}
+		crc16_table[0][i] = c16;
+		crc32c_table[0][i] = c32;
+		crc64_table[0][i] = c64;
+	}
+
+	/* table k advances a byte over k more zero bytes */
+	for (j = 1; j < 8; j++) {
+		for (i = 0; i < 256; i++) {
+			c16 = crc16_table[j - 1][i];
+			crc16_table[j][i] = (c16 << 8) ^ crc16_table[0][c16 >> 8];
+			c32 = crc32c_table[j - 1][i];
+			crc32c_table[j][i] = (c32 >> 8) ^ crc32c_table[0][c32 & 0xff];
+			c64 = crc64_table[j - 1][i];
+			crc64_table[j][i] = (c64 >> 8) ^ crc64_table[0][c64 & 0xff];
+		}
+	}
+}
+
+/* CRC-16/T10-DIF: no reflection, initial value 0, no final xor */
+uint16_t crc16_t10dif(uint16_t crc, const void *buf, size_t len)
+{
+	const uint16_t (*t)[256] = crc16_table;
+	const uint8_t *p = buf;
+
+	for (; len >= 8; len -= 8, p += 8)
+		crc = t[7][p[0] ^ (crc >> 8)] ^ t[6][p[1] ^ (crc & 0xff)] ^
+		      t[5][p[2]] ^ t[4][p[3]] ^ t[3][p[4]] ^ t[2][p[5]] ^
+		      t[1][p[6]] ^ t[0][p[7]];
+
+	while (len--)
+		crc = (crc << 8) ^ t[0][(crc >> 8) ^ *p++];
+
+	return crc;
+}
+
+/* CRC-32C (Castagnoli): reflected, initial value and final xor ~0 */
+uint32_t crc32c(uint32_t crc, const void *buf, size_t len)
+{
+	const uint32_t (*t)[256] = crc32c_table;
+	const uint8_t *p = buf;
+	uint32_t x;
+
+	crc = ~crc;
+	for (; len >= 8; len -= 8, p += 8) {
+		memcpy(&x, p, sizeof(x));
+		x = le32toh(x) ^ crc;
+		crc = t[7][x & 0xff] ^ t[6][(x >> 8) & 0xff] ^
+		      t[5][(x >> 16) & 0xff] ^ t[4][x >> 24] ^
+		      t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+	}
+
+	while (len--)
+		crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xff];
+
+	return ~crc;
+}
+
+/* CRC-64/NVME: reflected, initial value and final xor ~0 */
+uint64_t crc64_nvme(uint64_t crc, const void *buf, size_t len)
+{
+	const uint64_t (*t)[256] = crc64_table;
+	const uint8_t *p = buf;
+	uint64_t x;
+
+	crc = ~crc;
+	for (; len >= 8; len -= 8, p += 8) {
+		memcpy(&x, p, sizeof(x));
+		x = le64toh(x) ^ crc;
+		crc = t[7][x & 0xff] ^ t[6][(x >> 8) & 0xff] ^
+		      t[5][(x >> 16) & 0xff] ^ t[4][(x >> 24) & 0xff] ^
+		      t[3][(x >> 32) & 0xff] ^ t[2][(x >> 40) & 0xff] ^
+		      t[1][(x >> 48) & 0xff] ^ t[0][x >> 56];
+	}
+
+	while (len--)
+		crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xff];
+
+	return ~crc;
+}
+
+static inline uint64_t mask(int bits)
+{
+	return bits >= 64 ? ~0ULL : (1ULL << bits) - 1;
+}
+
+/* width of the storage+ref field in bits */
+static int tag_bits(enum pi_format format)
+{
+	switch (format) {
+	case PI_GUARD_16:
+		return 32;
+	case PI_GUARD_32:
+		return 80;
+	default:
+		return 48;
+	}
+}
+
+int pi_init(struct pi *pi, enum pi_format format, int type, int sts,
+	    bool first, size_t lbs, size_t ms, bool ext)
+{
+	memset(pi, 0, sizeof(*pi));
+
+	if (format > PI_GUARD_64 || type < 1 || type > 3 || sts < 0 ||
+	    sts > 64 || sts > tag_bits(format))
+		return -EINVAL;
+
+	pi->pi_size = format == PI_GUARD_16 ? 8 : 16;
+	if (!lbs || ms < pi->pi_size)
+		return -EINVAL;
+
+	pi->format = format;
+	pi->type = type;
+	pi->sts = sts;
+	pi->lbs = lbs;
+	pi->ms = ms;
+	pi->ext = ext;
+	pi->pi_off = first ? 0 : ms - pi->pi_size;
+	pi->ref_bits = tag_bits(format) - sts;
+	if (pi->ref_bits > 64)
+		pi->ref_bits = 64;
+	pi->app_mask = 0xffff;
+
+	return 0;
+}
+
+const char *pi_field_name(enum pi_field field)
+{
+	switch (field) {
+	case PI_FIELD_GUARD:
+		return "guard";
+	case PI_FIELD_APP_TAG:
+		return "application tag";
+	case PI_FIELD_REF_TAG:
+		return "reference tag";
+	default:
+		return "storage tag";
+	}
+}
+
+static uint64_t pi_guard(const struct pi *pi, const uint8_t *data,
+			 const uint8_t *meta)
+{
+	switch (pi->format) {
+	case PI_GUARD_16:
+		return crc16_t10dif(crc16_t10dif(0, data, pi->lbs), meta,
+				    pi->pi_off);
+	case PI_GUARD_32:
+		return crc32c(crc32c(0, data, pi->lbs), meta, pi->pi_off);
+	default:
+		return crc64_nvme(crc64_nvme(0, data, pi->lbs), meta,
+				  pi->pi_off);
+	}
+}
+
+/* big endian field of @len bytes holding the 128-bit value hi:lo */
+static void put_be(uint8_t *p, size_t len, uint64_t hi, uint64_t lo)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++, lo = (lo >> 8) | (hi << 56), hi >>= 8)
+		p[len - 1 - i] = lo;
+}
+
+static void get_be(const uint8_t *p, size_t len, uint64_t *hi, uint64_t *lo)
+{
+	size_t i;
+
+	*hi = *lo = 0;
+	for (i = 0; i < len; i++) {
+		*hi = (*hi << 8) | (*lo >> 56);
+		*lo = (*lo << 8) | p[i];
+	}
+}
+
+static void put_tags(const struct pi *pi, uint8_t *p, uint64_t ref)
+{
+	int shift = tag_bits(pi->format) - pi->sts;
+	uint64_t st = pi->storage_tag & mask(pi->sts);
+	uint64_t hi = 0, lo = ref & mask(pi->ref_bits);
+	size_t len = tag_bits(pi->format) / 8;
+
+	if (pi->sts) {
+		if (shift >= 64) {
+			hi = st << (shift - 64);
+		} else {
+			lo |= st << shift;
+			if (shift)
+				hi = st >> (64 - shift);
+		}
+	}
+
+	put_be(p, len, hi, lo);
+}
+
+static void get_tags(const struct pi *pi, const uint8_t *p, uint64_t *ref,
+		     uint64_t *st)
+{
+	int shift = tag_bits(pi->format) - pi->sts;
+	size_t len = tag_bits(pi->format) / 8;
+	uint64_t hi, lo;
+
+	get_be(p, len, &hi, &lo);
+	*ref = lo & mask(pi->ref_bits);
+	if (!pi->sts)
+		*st = 0;
+	else if (shift >= 64)
+		*st = hi >> (shift - 64);
+	else
+		*st = (lo >> shift) | (shift ? hi << (64 - shift) : 0);
+	*st &= mask(pi->sts);
+}
+
+static size_t guard_size(const struct pi *pi)
+{
+	return pi->format == PI_GUARD_16 ? 2 : pi->format == PI_GUARD_32 ? 4 : 8;
+}
+
+/*
+ * Generate the PI of @nlb blocks. @ref_tag is the reference tag of the
+ * first block; it increments per block for Type 1 and 2. With extended
+ * LBAs @meta is unused, the metadata follows each block in @data.
+ */
+void pi_generate(const struct pi *pi, void *data, void *meta,
+		 uint64_t ref_tag, uint64_t nlb)
+{
+	size_t stride = pi->ext ? pi->lbs + pi->ms : pi->lbs;
+	size_t gs = guard_size(pi);
+	uint8_t *d = data, *m, *p;
+	uint64_t i;
+
+	for (i = 0; i < nlb; i++, d += stride) {
+		m = pi->ext ? d + pi->lbs : (uint8_t *)meta + i * pi->ms;
+		p = m + pi->pi_off;
+
+		put_be(p, gs, 0, pi_guard(pi, d, m));
+		put_be(p + gs, 2, 0, pi->app_tag);
+		put_tags(pi, p + gs + 2, pi->type == 3 ? ref_tag : ref_tag + i);
+	}
+}
+
+static bool pi_mismatch(struct pi_error *e, uint64_t block,
+			enum pi_field field, uint64_t expected, uint64_t actual)
+{
+	if (expected == actual)
+		return false;
+
+	e->block = block;
+	e->field = field;
+	e->expected = expected;
+	e->actual = actual;
+	return true;
+}
+
+/*
+ * Check the PI of @nlb blocks the way the controller would with all
+ * PRCHK bits set; the storage tag only with check_storage. Blocks with
+ * the escape tags (an application tag of FFFFh, for Type 3 also a
+ * reference tag of all ones) are skipped.
+ */
+bool pi_verify(const struct pi *pi, const void *data, const void *meta,
+	       uint64_t ref_tag, uint64_t nlb, struct pi_error *e)
+{
+	size_t stride = pi->ext ? pi->lbs + pi->ms : pi->lbs;
+	size_t gs = guard_size(pi);
+	const uint8_t *d = data, *m, *p;
+	uint64_t hi, guard, app, ref, st;
+	uint64_t i;
+
+	for (i = 0; i < nlb; i++, d += stride) {
+		m = pi->ext ? d + pi->lbs : (const uint8_t *)meta + i * pi->ms;
+		p = m + pi->pi_off;
+
+		get_be(p + gs, 2, &hi, &app);
+		get_tags(pi, p + gs + 2, &ref, &st);
+		if (app == 0xffff &&
+		    (pi->type != 3 || ref == mask(pi->ref_bits)))
+			continue;
+
+		get_be(p, gs, &hi, &guard);
+		if (pi_mismatch(e, i, PI_FIELD_GUARD, pi_guard(pi, d, m), guard))
+			return false;
+		if (pi_mismatch(e, i, PI_FIELD_APP_TAG,
+				pi->app_tag & pi->app_mask, app & pi->app_mask))
+			return false;
+		if (pi->type != 3 &&
+		    pi_mismatch(e, i, PI_FIELD_REF_TAG,
+				(ref_tag + i) & mask(pi->ref_bits), ref))
+			return false;
+		if (pi->check_storage &&
+		    pi_mismatch(e, i, PI_FIELD_STORAGE_TAG,
+				pi->storage_tag & mask(pi->sts), st))
+			return false;
+	}
+
+	return true;
+}
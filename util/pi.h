@@ -0,0 +1,78 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+#ifndef __PI_H__
+#define __PI_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * End-to-end protection information computed and checked on the host,
+ * for transfers with PRACT cleared. The layouts follow the NVM Command
+ * Set specification; all fields are big endian:
+ *
+ *   16b guard (8 bytes)	guard:16 app:16 storage+ref:32
+ *   32b guard (16 bytes)	guard:32 app:16 storage+ref:80
+ *   64b guard (16 bytes)	guard:64 app:16 storage+ref:48
+ *
+ * The storage tag takes the upper STS bits of the storage+ref field and
+ * the reference tag the rest (at most 64 bits). The guard covers the
+ * logical block data and, when the PI is in the last bytes of larger
+ * metadata, the metadata bytes in front of it.
+ *
+ * The CRCs are table driven and process 8 bytes per step (slicing by 8).
+ */
+
+/* guard formats, same values as the NVMe PIF field */
+enum pi_format {
+	PI_GUARD_16	= 0,
+	PI_GUARD_32	= 1,
+	PI_GUARD_64	= 2,
+};
+
+enum pi_field {
+	PI_FIELD_GUARD,
+	PI_FIELD_APP_TAG,
+	PI_FIELD_REF_TAG,
+	PI_FIELD_STORAGE_TAG,
+};
+
+struct pi {
+	enum pi_format format;
+	int type;		/* 1, 2 or 3 */
+	int sts;		/* storage tag size in bits */
+	size_t lbs;		/* data bytes per block */
+	size_t ms;		/* metadata bytes per block */
+	bool ext;		/* metadata interleaved with the data */
+	size_t pi_size;
+	size_t pi_off;		/* offset of the PI in the metadata */
+	int ref_bits;
+
+	uint16_t app_tag;
+	uint16_t app_mask;	/* bits of the app tag to check */
+	uint64_t storage_tag;
+	bool check_storage;
+};
+
+struct pi_error {
+	uint64_t block;		/* index of the block in the buffer */
+	enum pi_field field;
+	uint64_t expected;
+	uint64_t actual;
+};
+
+uint16_t crc16_t10dif(uint16_t crc, const void *buf, size_t len);
+uint32_t crc32c(uint32_t crc, const void *buf, size_t len);
+uint64_t crc64_nvme(uint64_t crc, const void *buf, size_t len);
+
+int pi_init(struct pi *pi, enum pi_format format, int type, int sts,
+	    bool first, size_t lbs, size_t ms, bool ext);
+
+void pi_generate(const struct pi *pi, void *data, void *meta,
+		 uint64_t ref_tag, uint64_t nlb);
+bool pi_verify(const struct pi *pi, const void *data, const void *meta,
+	       uint64_t ref_tag, uint64_t nlb, struct pi_error *e);
+
+const char *pi_field_name(enum pi_field field);
+
+#endif /* __PI_H__ */